@@ -115,8 +115,9 @@ bool BlockchainExplorerDataBuilder::fillBlockDetails(const Block &block, BlockDe
   blockDetails.isOrphaned = hash != tmpHash;
 
   blockDetails.proofOfWork = boost::value_initialized<Crypto::Hash>();
-  if (calculate_pow) {
-    Crypto::cn_context context;
+  if (calculate_pow && !m_core.getBlockProofOfWork(hash, blockDetails.proofOfWork)) {
+    // not stored for blocks accepted in the checkpoint zone, calculate it now
+    static thread_local Crypto::cn_context context;
     if (!get_block_longhash(context, block, blockDetails.proofOfWork)) {
       return false;
     }
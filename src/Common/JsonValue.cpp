@@ -6,9 +6,14 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "JsonValue.h"
+#include <algorithm>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <sstream>
+#include <stdexcept>
 
 namespace Common {
 
@@ -562,26 +567,306 @@ size_t JsonValue::erase(const Key& key) {
   return getObject().erase(key);
 }
 
-JsonValue JsonValue::fromString(const std::string& source) {
-  JsonValue jsonValue;
-  std::istringstream stream(source);
-  stream >> jsonValue;
-  if (stream.fail()) {
-    throw std::runtime_error("Unable to parse JsonValue");
-  }
+namespace {
 
-  return jsonValue;
+// Bounds the recursion, deeper documents are rejected instead of exhausting the stack
+const size_t MAX_NESTING_DEPTH = 512;
+// Members of objects up to this size are checked for a repeated name as they are read, larger objects once complete
+const size_t SMALL_OBJECT_SIZE = 16;
+
+bool isWhiteSpace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
 }
 
-JsonValue JsonValue::fromStringWithWhiteSpaces(const std::string& source) {
-  JsonValue jsonValue;
-  std::istringstream stream(source);
-  stream >> std::noskipws >> jsonValue;
-  if (stream.fail()) {
-    throw std::runtime_error("Unable to parse JsonValue");
+bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+}
+
+// Recursive descent parser over a contiguous buffer. Elements and members of the containers being read are
+// collected on stacks shared by all nesting levels and moved into an exactly sized container once it is complete,
+// so parsing allocates about once per container and string whatever their size.
+class JsonParser {
+public:
+  JsonParser(const char* begin, const char* end) : cursor(begin), end(end) {
+  }
+
+  JsonValue parse() {
+    return readValue(0);
+  }
+
+private:
+  const char* cursor;
+  const char* const end;
+  std::vector<JsonValue> elements;
+  std::vector<JsonValue::Object::value_type> members;
+
+  char readNonWsChar() {
+    while (cursor != end && isWhiteSpace(*cursor)) {
+      ++cursor;
+    }
+
+    if (cursor == end) {
+      throw std::runtime_error("Unable to parse: unexpected end of stream");
+    }
+
+    return *cursor++;
+  }
+
+  JsonValue readValue(size_t depth) {
+    char c = readNonWsChar();
+    if (c == '[') {
+      return readArray(depth + 1);
+    } else if (c == 't') {
+      readLiteral("rue", 3);
+      return JsonValue(true);
+    } else if (c == 'f') {
+      readLiteral("alse", 4);
+      return JsonValue(false);
+    } else if ((c == '-') || isDigit(c)) {
+      return readNumber();
+    } else if (c == 'n') {
+      readLiteral("ull", 3);
+      return JsonValue(nullptr);
+    } else if (c == '{') {
+      return readObject(depth + 1);
+    } else if (c == '"') {
+      return JsonValue(readStringToken());
+    } else {
+      throw std::runtime_error("Unable to parse");
+    }
+  }
+
+  void readLiteral(const char* rest, size_t size) {
+    if (static_cast<size_t>(end - cursor) < size || memcmp(cursor, rest, size) != 0) {
+      throw std::runtime_error("Unable to parse");
+    }
+
+    cursor += size;
+  }
+
+  JsonValue readArray(size_t depth) {
+    if (depth > MAX_NESTING_DEPTH) {
+      throw std::runtime_error("Unable to parse: nesting is too deep");
+    }
+
+    size_t first = elements.size();
+    char c = readNonWsChar();
+    if (c != ']') {
+      --cursor;
+      for (;;) {
+        JsonValue element = readValue(depth);
+        elements.emplace_back(std::move(element));
+        c = readNonWsChar();
+        if (c == ']') {
+          break;
+        }
+
+        if (c != ',') {
+          throw std::runtime_error("Unable to parse");
+        }
+      }
+    }
+
+    JsonValue::Array array(std::make_move_iterator(elements.begin() + first), std::make_move_iterator(elements.end()));
+    elements.erase(elements.begin() + first, elements.end());
+    return JsonValue(std::move(array));
+  }
+
+  JsonValue readObject(size_t depth) {
+    if (depth > MAX_NESTING_DEPTH) {
+      throw std::runtime_error("Unable to parse: nesting is too deep");
+    }
+
+    size_t first = members.size();
+    bool checked = true;
+    char c = readNonWsChar();
+    if (c != '}') {
+      for (;;) {
+        if (c != '"') {
+          throw std::runtime_error("Unable to parse");
+        }
+
+        std::string name = readStringToken();
+        if (readNonWsChar() != ':') {
+          throw std::runtime_error("Unable to parse");
+        }
+
+        JsonValue value = readValue(depth);
+        auto member = members.end();
+        if (members.size() - first < SMALL_OBJECT_SIZE) {
+          member = std::find_if(members.begin() + first, members.end(),
+            [&name](const JsonValue::Object::value_type& item) { return item.first == name; });
+        } else {
+          checked = false;
+        }
+
+        if (member != members.end()) {
+          member->second = std::move(value);
+        } else {
+          members.emplace_back(std::move(name), std::move(value));
+        }
+
+        c = readNonWsChar();
+        if (c == '}') {
+          break;
+        }
+
+        if (c != ',') {
+          throw std::runtime_error("Unable to parse");
+        }
+
+        c = readNonWsChar();
+      }
+    }
+
+    if (!checked) {
+      removeRepeatedNames(first);
+    }
+
+    JsonValue::Object object;
+    object.members.assign(std::make_move_iterator(members.begin() + first), std::make_move_iterator(members.end()));
+    members.erase(members.begin() + first, members.end());
+    return JsonValue(std::move(object));
   }
 
-  return jsonValue;
+  // The last value given for a name wins and takes the place of the first one
+  void removeRepeatedNames(size_t first) {
+    size_t count = members.size() - first;
+    std::vector<size_t> order(count);
+    for (size_t i = 0; i < count; ++i) {
+      order[i] = first + i;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return members[a].first < members[b].first; });
+    std::vector<bool> removed(count, false);
+    for (size_t i = 0; i < count;) {
+      size_t next = i + 1;
+      while (next < count && members[order[next]].first == members[order[i]].first) {
+        removed[order[next] - first] = true;
+        ++next;
+      }
+
+      if (next - i > 1) {
+        members[order[i]].second = std::move(members[order[next - 1]].second);
+      }
+
+      i = next;
+    }
+
+    size_t kept = first;
+    for (size_t i = first; i < members.size(); ++i) {
+      if (!removed[i - first]) {
+        if (kept != i) {
+          members[kept] = std::move(members[i]);
+        }
+
+        ++kept;
+      }
+    }
+
+    members.erase(members.begin() + kept, members.end());
+  }
+
+  JsonValue readNumber() {
+    const char* begin = cursor - 1;
+    size_t dots = 0;
+    while (cursor != end && (isDigit(*cursor) || *cursor == '.')) {
+      if (*cursor == '.') {
+        ++dots;
+      }
+
+      ++cursor;
+    }
+
+    if (dots > 0) {
+      if (dots > 1) {
+        throw std::runtime_error("Unable to parse");
+      }
+
+      if (cursor != end && *cursor == 'e') {
+        ++cursor;
+        if (cursor != end && (*cursor == '+' || *cursor == '-')) {
+          ++cursor;
+        }
+
+        if (cursor == end || !isDigit(*cursor)) {
+          throw std::runtime_error("Unable to parse");
+        }
+
+        do {
+          ++cursor;
+        } while (cursor != end && isDigit(*cursor));
+      }
+
+      JsonValue::Real value;
+      std::istringstream(std::string(begin, cursor)) >> value;
+      return JsonValue(value);
+    }
+
+    bool negative = *begin == '-';
+    const char* digits = begin + (negative ? 1 : 0);
+    if (digits == cursor || (cursor - digits > 1 && *digits == '0') || (negative && *digits == '0')) {
+      throw std::runtime_error("Unable to parse");
+    }
+
+    // out of range values are clamped, as formatted stream input does
+    uint64_t limit = negative ? static_cast<uint64_t>(std::numeric_limits<JsonValue::Integer>::max()) + 1 :
+      static_cast<uint64_t>(std::numeric_limits<JsonValue::Integer>::max());
+    uint64_t magnitude = 0;
+    for (const char* digit = digits; digit != cursor; ++digit) {
+      unsigned d = static_cast<unsigned>(*digit - '0');
+      if (magnitude > (limit - d) / 10) {
+        magnitude = limit;
+        break;
+      }
+
+      magnitude = magnitude * 10 + d;
+    }
+
+    JsonValue::Integer value = negative ? static_cast<JsonValue::Integer>(0 - magnitude) : static_cast<JsonValue::Integer>(magnitude);
+    return JsonValue(value);
+  }
+
+  // Escape sequences are kept as they are, a string without any is copied out of the buffer in one piece
+  std::string readStringToken() {
+    const char* begin = cursor;
+    const char* quote = static_cast<const char*>(memchr(begin, '"', end - begin));
+    if (quote == nullptr) {
+      throw std::runtime_error("Unable to parse: unexpected end of stream");
+    }
+
+    if (memchr(begin, '\\', quote - begin) != nullptr) {
+      quote = begin;
+      while (quote != end && *quote != '"') {
+        if (*quote == '\\' && ++quote == end) {
+          break;
+        }
+
+        ++quote;
+      }
+
+      if (quote == end) {
+        throw std::runtime_error("Unable to parse: unexpected end of stream");
+      }
+    }
+
+    cursor = quote + 1;
+    return std::string(begin, quote);
+  }
+};
+
+JsonValue JsonValue::fromString(const std::string& source) {
+  return fromString(source.data(), source.size());
+}
+
+JsonValue JsonValue::fromString(const char* data, size_t size) {
+  return JsonParser(data, data + size).parse();
+}
+
+JsonValue JsonValue::fromStringWithWhiteSpaces(const std::string& source) {
+  return fromString(source);
 }
 
 std::string JsonValue::toString() const {
@@ -648,74 +933,9 @@ std::ostream& operator<<(std::ostream& out, const JsonValue& jsonValue) {
   return out;
 }
 
-
-namespace {
-
-char readChar(std::istream& in) {
-  char c = static_cast<char>(in.get());
-  if (!in) {
-    throw std::runtime_error("Unable to parse: unexpected end of stream");
-  }
-
-  return c;
-}
-
-char readNonWsChar(std::istream& in) {
-  char c;
-
-  do {
-    c = readChar(in);
-  } while (isspace(c));
-
-  return c;
-}
-
-std::string readStringToken(std::istream& in) {
-  char c;
-  std::string value;
-
-  while (in) {
-    c = readChar(in);
-
-    if (c == '"') {
-      break;
-    }
-
-    if (c == '\\') {
-      value += c;
-      c = readChar(in);
-    }
-
-    value += c;
-  }
-
-  return value;
-}
-
-}
-
-
 std::istream& operator>>(std::istream& in, JsonValue& jsonValue) {
-  char c = readNonWsChar(in);
-
-  if (c == '[') {
-    jsonValue.readArray(in);
-  } else if (c == 't') {
-    jsonValue.readTrue(in);
-  } else if (c == 'f') {
-    jsonValue.readFalse(in);
-  } else if ((c == '-') || (c >= '0' && c <= '9')) {
-    jsonValue.readNumber(in, c);
-  } else if (c == 'n') {
-    jsonValue.readNull(in);
-  } else if (c == '{') {
-    jsonValue.readObject(in);
-  } else if (c == '"') {
-    jsonValue.readString(in);
-  } else {
-    throw std::runtime_error("Unable to parse");
-  }
-
+  std::string source((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  jsonValue = JsonValue::fromString(source);
   return in;
 }
 
@@ -735,208 +955,74 @@ void JsonValue::destructValue() {
   }
 }
 
-void JsonValue::readArray(std::istream& in) {
-  JsonValue::Array value;
-  char c = readNonWsChar(in);
-
-  if(c != ']') {
-    in.putback(c);
-    for (;;) {
-      value.resize(value.size() + 1);
-      in >> value.back();
-      c = readNonWsChar(in);
+JsonValue::Object::iterator JsonValue::Object::find(const Key& key) {
+  return std::find_if(members.begin(), members.end(), [&key](const value_type& member) { return member.first == key; });
+}
 
-      if (c == ']') {
-        break;
-      }
+JsonValue::Object::const_iterator JsonValue::Object::find(const Key& key) const {
+  return std::find_if(members.begin(), members.end(), [&key](const value_type& member) { return member.first == key; });
+}
 
-      if (c != ',') {
-        throw std::runtime_error("Unable to parse");
-      }
-    }
-  }
+size_t JsonValue::Object::count(const Key& key) const {
+  return find(key) != members.end() ? 1 : 0;
+}
 
-  if (type != JsonValue::ARRAY) {
-    destructValue();
-    type = JsonValue::NIL;
-    new(valueArray)JsonValue::Array;
-    type = JsonValue::ARRAY;
+JsonValue& JsonValue::Object::at(const Key& key) {
+  auto member = find(key);
+  if (member == members.end()) {
+    throw std::out_of_range("JsonValue has no member " + key);
   }
 
-  reinterpret_cast<JsonValue::Array*>(valueArray)->swap(value);
+  return member->second;
 }
 
-void JsonValue::readTrue(std::istream& in) {
-  char data[3];
-  in.read(data, 3);
-  if (data[0] != 'r' || data[1] != 'u' || data[2] != 'e') {
-    throw std::runtime_error("Unable to parse");
-  }
-
-  if (type != JsonValue::BOOL) {
-    destructValue();
-    type = JsonValue::BOOL;
+const JsonValue& JsonValue::Object::at(const Key& key) const {
+  auto member = find(key);
+  if (member == members.end()) {
+    throw std::out_of_range("JsonValue has no member " + key);
   }
 
-  valueBool = true;
+  return member->second;
 }
 
-void JsonValue::readFalse(std::istream& in) {
-  char data[4];
-  in.read(data, 4);
-  if (data[0] != 'a' || data[1] != 'l' || data[2] != 's' || data[3] != 'e') {
-    throw std::runtime_error("Unable to parse");
-  }
-
-  if (type != JsonValue::BOOL) {
-    destructValue();
-    type = JsonValue::BOOL;
+JsonValue& JsonValue::Object::operator[](const Key& key) {
+  auto member = find(key);
+  if (member != members.end()) {
+    return member->second;
   }
 
-  valueBool = false;
+  members.emplace_back(key, JsonValue());
+  return members.back().second;
 }
 
-void JsonValue::readNull(std::istream& in) {
-  char data[3];
-  in.read(data, 3);
-  if (data[0] != 'u' || data[1] != 'l' || data[2] != 'l') {
-    throw std::runtime_error("Unable to parse");
+std::pair<JsonValue::Object::iterator, bool> JsonValue::Object::emplace(const Key& key, const JsonValue& value) {
+  auto member = find(key);
+  if (member != members.end()) {
+    return std::make_pair(member, false);
   }
 
-  if (type != JsonValue::NIL) {
-    destructValue();
-    type = JsonValue::NIL;
-  }
-}
-
-void JsonValue::readNumber(std::istream& in, char c) {
-  std::string text;
-  text += c;
-  size_t dots = 0;
-  for (;;) {
-    int i = in.peek();
-    if (i >= '0' && i <= '9') {
-      in.read(&c, 1);
-      text += c;
-    } else  if (i == '.') {
-      in.read(&c, 1);
-      text += '.';
-      ++dots;
-    } else {
-      break;
-    }
-  }
-
-  if (dots > 0) {
-    if (dots > 1) {
-      throw std::runtime_error("Unable to parse");
-    }
-
-    int i = in.peek();
-    if (in.peek() == 'e') {
-      in.read(&c, 1);
-      text += c;
-      i = in.peek();
-      if (i == '+') {
-        in.read(&c, 1);
-        text += c;
-        i = in.peek();
-      } else if (i == '-') {
-        in.read(&c, 1);
-        text += c;
-        i = in.peek();
-      }
-
-      if (i < '0' || i > '9') {
-        throw std::runtime_error("Unable to parse");
-      }
-
-      do {
-        in.read(&c, 1);
-        text += c;
-        i = in.peek();
-      } while (i >= '0' && i <= '9');
-    }
-
-    Real value;
-    std::istringstream(text) >> value;
-    if (type != REAL) {
-      destructValue();
-      type = REAL;
-    }
-
-    valueReal = value;
-  } else {
-    if (text.size() > 1 && ((text[0] == '0') || (text[0] == '-' && text[1] == '0'))) {
-      throw std::runtime_error("Unable to parse");
-    }
-
-    Integer value;
-    std::istringstream(text) >> value;
-    if (type != INTEGER) {
-      destructValue();
-      type = INTEGER;
-    }
-
-    valueInteger = value;
-  }
+  members.emplace_back(key, value);
+  return std::make_pair(members.end() - 1, true);
 }
 
-void JsonValue::readObject(std::istream& in) {
-  char c = readNonWsChar(in);
-  JsonValue::Object value;
-
-  if (c != '}') {
-    std::string name;
-
-    for (;;) {
-      if (c != '"') {
-        throw std::runtime_error("Unable to parse");
-      }
-
-      name = readStringToken(in);
-      c = readNonWsChar(in);
-
-      if (c != ':') {
-        throw std::runtime_error("Unable to parse");
-      }
-
-      in >> value[name];
-      c = readNonWsChar(in);
-
-      if (c == '}') {
-        break;
-      }
-
-      if (c != ',') {
-        throw std::runtime_error("Unable to parse");
-      }
-
-      c = readNonWsChar(in);
-    }
+std::pair<JsonValue::Object::iterator, bool> JsonValue::Object::emplace(const Key& key, JsonValue&& value) {
+  auto member = find(key);
+  if (member != members.end()) {
+    return std::make_pair(member, false);
   }
 
-  if (type != JsonValue::OBJECT) {
-    destructValue();
-    type = JsonValue::NIL;
-    new(valueObject)JsonValue::Object;
-    type = JsonValue::OBJECT;
-  }
-
-  reinterpret_cast<JsonValue::Object*>(valueObject)->swap(value);
+  members.emplace_back(key, std::move(value));
+  return std::make_pair(members.end() - 1, true);
 }
 
-void JsonValue::readString(std::istream& in) {
-  String value = readStringToken(in);
-
-  if (type != JsonValue::STRING) {
-    destructValue();
-    type = JsonValue::NIL;
-    new(valueString)String;
-    type = JsonValue::STRING;
+size_t JsonValue::Object::erase(const Key& key) {
+  auto member = find(key);
+  if (member == members.end()) {
+    return 0;
   }
 
-  reinterpret_cast<String*>(valueString)->swap(value);
+  members.erase(member);
+  return 1;
 }
 
 }
@@ -9,21 +9,57 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace Common {
 
+class JsonParser;
+
 class JsonValue {
 public:
   typedef std::string Key;
 
+  // Members of a JSON object in insertion order, stored contiguously. Objects seen in RPC have a handful
+  // of members, so a linear scan finds a key faster than a tree walk and building one costs a single allocation.
+  // The interface follows std::map, keys are unique and emplace keeps an existing member.
+  class Object {
+  public:
+    typedef std::pair<Key, JsonValue> value_type;
+    typedef std::vector<value_type>::iterator iterator;
+    typedef std::vector<value_type>::const_iterator const_iterator;
+
+    iterator begin() { return members.begin(); }
+    const_iterator begin() const { return members.begin(); }
+    iterator end() { return members.end(); }
+    const_iterator end() const { return members.end(); }
+    bool empty() const { return members.empty(); }
+    size_t size() const { return members.size(); }
+    void reserve(size_t size) { members.reserve(size); }
+
+    iterator find(const Key& key);
+    const_iterator find(const Key& key) const;
+    size_t count(const Key& key) const;
+    // Throws std::out_of_range when there is no such member
+    JsonValue& at(const Key& key);
+    const JsonValue& at(const Key& key) const;
+    JsonValue& operator[](const Key& key);
+    std::pair<iterator, bool> emplace(const Key& key, const JsonValue& value);
+    std::pair<iterator, bool> emplace(const Key& key, JsonValue&& value);
+    size_t erase(const Key& key);
+    void swap(Object& other) { members.swap(other.members); }
+
+  private:
+    friend class JsonParser;
+
+    std::vector<value_type> members;
+  };
+
   typedef std::vector<JsonValue> Array;
   typedef bool Bool;
   typedef int64_t Integer;
   typedef std::nullptr_t Nil;
-  typedef std::map<Key, JsonValue> Object;
   typedef double Real;
   typedef std::string String;
 
@@ -121,11 +157,14 @@ public:
 
   size_t erase(const Key& key);
 
+  // Parses the first value in source, anything after it is ignored. Strings are kept escaped as in the source.
   static JsonValue fromString(const std::string& source);
+  static JsonValue fromString(const char* data, size_t size);
   static JsonValue fromStringWithWhiteSpaces(const std::string& source);
   std::string toString() const;
 
   friend std::ostream& operator<<(std::ostream& out, const JsonValue& jsonValue);
+  // Reads the rest of the stream and parses it with fromString
   friend std::istream& operator>>(std::istream& in, JsonValue& jsonValue);
 
 private:
@@ -140,14 +179,6 @@ private:
   };
 
   void destructValue();
-
-  void readArray(std::istream& in);
-  void readTrue(std::istream& in);
-  void readFalse(std::istream& in);
-  void readNull(std::istream& in);
-  void readNumber(std::istream& in, char c);
-  void readObject(std::istream& in);
-  void readString(std::istream& in);
 };
 
 }
@@ -0,0 +1,172 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace Common {
+
+namespace {
+
+const double RENDERED_QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+
+unsigned floorLog2(uint64_t value) {
+  unsigned result = 0;
+  for (unsigned shift = 32; shift != 0; shift /= 2) {
+    if (value >> shift != 0) {
+      value >>= shift;
+      result += shift;
+    }
+  }
+
+  return result;
+}
+
+std::string withLabel(const std::string& labels, const std::string& label) {
+  return "{" + (labels.empty() ? label : labels + "," + label) + "}";
+}
+
+std::string inBraces(const std::string& labels) {
+  return labels.empty() ? std::string() : "{" + labels + "}";
+}
+
+}
+
+MetricsHistogram::MetricsHistogram() : count(0), sum(0), max(0) {
+  for (auto& bucket : buckets) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+void MetricsHistogram::record(uint64_t value) {
+  buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  count.fetch_add(1, std::memory_order_relaxed);
+  sum.fetch_add(value, std::memory_order_relaxed);
+
+  uint64_t current = max.load(std::memory_order_relaxed);
+  while (current < value && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t MetricsHistogram::getQuantile(double quantile) const {
+  uint64_t total = getCount();
+  if (total == 0) {
+    return 0;
+  }
+
+  uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * total)));
+  uint64_t seen = 0;
+  for (unsigned i = 0; i < BUCKETS; ++i) {
+    seen += buckets[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      return std::min(bucketUpperBound(i), getMax());
+    }
+  }
+
+  // count is updated after the bucket, a concurrent record may be counted but not yet visible here
+  return getMax();
+}
+
+unsigned MetricsHistogram::bucketIndex(uint64_t value) {
+  if (value < SUB_BUCKETS) {
+    return static_cast<unsigned>(value);
+  }
+
+  unsigned exponent = floorLog2(value);
+  unsigned subBucket = static_cast<unsigned>(value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+  return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + subBucket;
+}
+
+uint64_t MetricsHistogram::bucketUpperBound(unsigned index) {
+  if (index < SUB_BUCKETS) {
+    return index;
+  }
+
+  unsigned shift = index / SUB_BUCKETS - 1;
+  uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+  return lower + ((static_cast<uint64_t>(1) << shift) - 1);
+}
+
+MetricsRegistry& MetricsRegistry::instance() {
+  static MetricsRegistry registry;
+  return registry;
+}
+
+MetricsCounter& MetricsRegistry::counter(const std::string& name, const std::string& labels) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& metric = counters[name][labels];
+  if (!metric) {
+    metric.reset(new MetricsCounter());
+  }
+
+  return *metric;
+}
+
+MetricsHistogram& MetricsRegistry::histogram(const std::string& name, const std::string& labels) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& metric = histograms[name][labels];
+  if (!metric) {
+    metric.reset(new MetricsHistogram());
+  }
+
+  return *metric;
+}
+
+std::string MetricsRegistry::render() const {
+  std::ostringstream out;
+  std::lock_guard<std::mutex> lock(mutex);
+
+  for (const auto& family : counters) {
+    out << "# TYPE " << family.first << " counter\n";
+    for (const auto& metric : family.second) {
+      out << family.first << inBraces(metric.first) << " " << metric.second->get() << "\n";
+    }
+  }
+
+  for (const auto& family : histograms) {
+    out << "# TYPE " << family.first << " summary\n";
+    for (const auto& metric : family.second) {
+      const MetricsHistogram& histogram = *metric.second;
+      if (histogram.getCount() == 0) {
+        continue;
+      }
+
+      for (double quantile : RENDERED_QUANTILES) {
+        std::ostringstream label;
+        label << "quantile=\"" << quantile << "\"";
+        out << family.first << withLabel(metric.first, label.str()) << " " << histogram.getQuantile(quantile) << "\n";
+      }
+
+      out << family.first << "_sum" << inBraces(metric.first) << " " << histogram.getSum() << "\n";
+      out << family.first << "_count" << inBraces(metric.first) << " " << histogram.getCount() << "\n";
+    }
+
+    out << "# TYPE " << family.first << "_max gauge\n";
+    for (const auto& metric : family.second) {
+      if (metric.second->getCount() != 0) {
+        out << family.first << "_max" << inBraces(metric.first) << " " << metric.second->getMax() << "\n";
+      }
+    }
+  }
+
+  return out.str();
+}
+
+}
@@ -0,0 +1,112 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace Common {
+
+class MetricsCounter {
+public:
+  MetricsCounter() : value(0) {}
+  MetricsCounter(const MetricsCounter&) = delete;
+  MetricsCounter& operator=(const MetricsCounter&) = delete;
+
+  void add(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+  uint64_t get() const { return value.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<uint64_t> value;
+};
+
+// Histogram with log-linear buckets: values below 16 are counted exactly and every further power of two
+// is split into 16 buckets, so quantiles are reported within 1/16 of the true value. Recording is lock free.
+class MetricsHistogram {
+public:
+  static const unsigned SUB_BUCKET_BITS = 4;
+  static const unsigned SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+  static const unsigned BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  MetricsHistogram();
+  MetricsHistogram(const MetricsHistogram&) = delete;
+  MetricsHistogram& operator=(const MetricsHistogram&) = delete;
+
+  void record(uint64_t value);
+
+  uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+  uint64_t getSum() const { return sum.load(std::memory_order_relaxed); }
+  uint64_t getMax() const { return max.load(std::memory_order_relaxed); }
+  // Upper bound of the bucket holding the given quantile, 0 when nothing was recorded
+  uint64_t getQuantile(double quantile) const;
+
+  static unsigned bucketIndex(uint64_t value);
+  static uint64_t bucketUpperBound(unsigned index);
+
+private:
+  std::atomic<uint64_t> buckets[BUCKETS];
+  std::atomic<uint64_t> count;
+  std::atomic<uint64_t> sum;
+  std::atomic<uint64_t> max;
+};
+
+// Records the time since construction in microseconds when destroyed
+class MetricsTimer {
+public:
+  explicit MetricsTimer(MetricsHistogram& histogram) : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+  MetricsTimer(const MetricsTimer&) = delete;
+  MetricsTimer& operator=(const MetricsTimer&) = delete;
+  ~MetricsTimer() { histogram.record(elapsed()); }
+
+  uint64_t elapsed() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  }
+
+private:
+  MetricsHistogram& histogram;
+  const std::chrono::steady_clock::time_point start;
+};
+
+// Process wide set of named metrics. Looking a metric up takes a lock, so hot paths keep the returned
+// reference, which stays valid for the lifetime of the process. Labels are passed preformatted,
+// e.g. method="getinfo", and have to come from a bounded set of values.
+class MetricsRegistry {
+public:
+  static MetricsRegistry& instance();
+
+  MetricsCounter& counter(const std::string& name, const std::string& labels = std::string());
+  MetricsHistogram& histogram(const std::string& name, const std::string& labels = std::string());
+
+  // Prometheus text format, histograms are rendered as summaries with the 0.5, 0.9, 0.99 and 0.999 quantiles.
+  // Histograms nothing was recorded to are left out.
+  std::string render() const;
+
+private:
+  MetricsRegistry() {}
+
+  mutable std::mutex mutex;
+  std::map<std::string, std::map<std::string, std::unique_ptr<MetricsCounter>>> counters;
+  std::map<std::string, std::map<std::string, std::unique_ptr<MetricsHistogram>>> histograms;
+};
+
+}
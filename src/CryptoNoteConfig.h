@@ -100,6 +100,7 @@ const uint64_t CRYPTONOTE_LOCKED_TX_ALLOWED_DELTA_SECONDS    = DIFFICULTY_TARGET
 const uint64_t CRYPTONOTE_MEMPOOL_TX_LIVETIME                = 60 * 60 * 24;     //seconds, one day
 const uint64_t CRYPTONOTE_MEMPOOL_TX_FROM_ALT_BLOCK_LIVETIME = 60 * 60 * 24 * 7; //seconds, one week
 const uint64_t CRYPTONOTE_NUMBER_OF_PERIODS_TO_FORGET_TX_DELETED_FROM_POOL = 7;  // CRYPTONOTE_NUMBER_OF_PERIODS_TO_FORGET_TX_DELETED_FROM_POOL * CRYPTONOTE_MEMPOOL_TX_LIVETIME = time to forget tx
+const uint64_t CRYPTONOTE_MEMPOOL_MAX_SIZE                   = 100;              //megabytes of transaction blobs, the lowest fee per byte is evicted beyond it
 
 const size_t   FUSION_TX_MAX_SIZE                            = CRYPTONOTE_BLOCK_GRANTED_FULL_REWARD_ZONE_V1 * 30 / 100;
 const size_t   FUSION_TX_MIN_INPUT_COUNT                     = 12;
@@ -166,7 +167,8 @@ const uint8_t  P2P_VERSION_1                                 = 1;
 const uint8_t  P2P_VERSION_2                                 = 2;
 const uint8_t  P2P_VERSION_3                                 = 3;
 const uint8_t  P2P_VERSION_4                                 = 4;
-const uint8_t  P2P_CURRENT_VERSION                           = P2P_VERSION_4;
+const uint8_t  P2P_VERSION_5                                 = 5;
+const uint8_t  P2P_CURRENT_VERSION                           = P2P_VERSION_5;
 const uint8_t  P2P_MINIMUM_VERSION                           = 1;
 
 // This defines the number of versions ahead we must see peers before
@@ -176,6 +178,19 @@ const uint8_t  P2P_UPGRADE_WINDOW                            = 2;
 // This defines the minimum P2P version required for lite blocks propogation
 const uint8_t  P2P_LITE_BLOCKS_PROPOGATION_VERSION           = 3;
 
+// This defines the minimum P2P version required for relaying transactions by hash announcements
+const uint8_t  P2P_TX_INVENTORY_VERSION                      = 5;
+const size_t   P2P_TX_INVENTORY_MAX_COUNT                    = 500;           // hashes per announcement or request
+const size_t   P2P_KNOWN_TXS_FILTER_SIZE                     = 10000;         // recent transactions remembered per peer
+const uint32_t P2P_TX_REQUEST_TIMEOUT                        = 5;             // seconds before asking another peer
+const size_t   P2P_TX_REQUESTS_PER_CONNECTION_MAX            = 2000;          // announced transactions awaited from one peer
+const size_t   P2P_TX_REQUESTS_MAX                           = 20000;         // announced transactions awaited in total
+const size_t   P2P_TX_ANNOUNCERS_MAX                         = 8;             // peers remembered per awaited transaction
+
+// This defines the minimum P2P version required for relaying blocks before their full validation
+const uint8_t  P2P_EARLY_BLOCK_RELAY_VERSION                 = 5;
+const size_t   P2P_REJECTED_BLOCKS_FILTER_SIZE               = 1000;          // blocks that failed validation after their proof of work passed
+
 const size_t   P2P_CONNECTION_MAX_WRITE_BUFFER_SIZE          = 64 * 1024 * 1024; // 64 MB
 const uint32_t P2P_DEFAULT_CONNECTIONS_COUNT                 = 12;
 const size_t   P2P_DEFAULT_ANCHOR_CONNECTIONS_COUNT          = 2;
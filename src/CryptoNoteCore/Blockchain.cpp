@@ -25,11 +25,13 @@
 #include <cmath>
 #include <boost/foreach.hpp>
 #include "Common/Math.h"
+#include "Common/Metrics.h"
 #include "Common/int-util.h"
 #include "Common/ShuffleGenerator.h"
 #include "Common/StdInputStream.h"
 #include "Common/StdOutputStream.h"
 #include "Rpc/CoreRpcServerCommandsDefinitions.h"
+#include "Serialization/BinaryArraySerializer.h"
 #include "Serialization/BinarySerializationTools.h"
 #include "CryptoNoteTools.h"
 #include "TransactionExtra.h"
@@ -40,6 +42,8 @@ using namespace Common;
 
 namespace {
 
+const size_t RAW_BLOCK_LAYOUTS_MAX = 100000;
+
 std::string appendPath(const std::string& path, const std::string& fileName) {
   std::string result = path;
   if (!result.empty()) {
@@ -219,6 +223,20 @@ public:
       m_bs.m_spent_key_images.dump(ar_out);
     }
 
+    logger(INFO) << operation << "proofs of work...";
+    std::string proofOfWorkFile = appendPath(m_bs.m_config_folder, "proofofwork.dat");
+    if (s.type() == ISerializer::INPUT) {
+      // caches written by older versions have no such file, missing entries are recalculated on demand
+      if (std::ifstream(proofOfWorkFile, std::ios::binary)) {
+        phmap::BinaryInputArchive ar_in(proofOfWorkFile.c_str());
+        m_bs.m_proofOfWork.load(ar_in);
+      }
+    }
+    else {
+      phmap::BinaryOutputArchive ar_out(proofOfWorkFile.c_str());
+      m_bs.m_proofOfWork.dump(ar_out);
+    }
+
     logger(INFO) << operation << "outputs...";
     s(m_bs.m_outputs, "outputs");
 
@@ -341,6 +359,8 @@ logger(logger, "Blockchain"),
 m_currency(currency),
 m_tx_pool(tx_pool),
 m_current_block_cumul_sz_limit(0),
+m_prevalidatedBlock(NULL_HASH),
+m_prevalidatedProofOfWork(NULL_HASH),
 m_upgradeDetectorV2(currency, m_blocks, BLOCK_MAJOR_VERSION_2, logger),
 m_upgradeDetectorV3(currency, m_blocks, BLOCK_MAJOR_VERSION_3, logger),
 m_upgradeDetectorV4(currency, m_blocks, BLOCK_MAJOR_VERSION_4, logger),
@@ -641,6 +661,9 @@ bool Blockchain::resetAndSetGenesisBlock(const Block& b) {
   m_spent_key_images.clear();
   m_alternative_chains.clear();
   m_outputs.clear();
+  m_proofOfWork.clear();
+  m_rawBlockLayouts.clear();
+  m_rawBlockLayoutUsage.clear();
 
   m_paymentIdIndex.clear();
   m_timestampIndex.clear();
@@ -653,8 +676,8 @@ bool Blockchain::resetAndSetGenesisBlock(const Block& b) {
 }
 
 Crypto::Hash Blockchain::getTailId(uint32_t& height) {
-  assert(!m_blocks.empty());
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  assert(!m_blocks.empty());
   height = getCurrentBlockchainHeight() - 1;
   return getTailId();
 }
@@ -827,6 +850,7 @@ difficulty_type Blockchain::getAvgDifficulty(uint32_t height) {
 }
 
 uint64_t Blockchain::getBlockTimestamp(uint32_t height) {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   assert(height < m_blocks.size());
   return m_blocks[height].bl.timestamp;
 }
@@ -1198,6 +1222,7 @@ bool Blockchain::get_last_n_blocks_sizes(std::vector<size_t>& sz, size_t count)
 }
 
 uint64_t Blockchain::getCurrentCumulativeBlocksizeLimit() {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_current_block_cumul_sz_limit;
 }
 
@@ -1440,6 +1465,61 @@ bool Blockchain::getBlocks(uint32_t start_offset, uint32_t count, std::list<Bloc
   return true;
 }
 
+bool Blockchain::getRawBlocks(uint32_t startIndex, uint32_t count, std::vector<block_complete_entry>& blocks) {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  if (startIndex >= m_blocks.size()) {
+    return false;
+  }
+
+  std::string entry;
+  for (uint32_t i = startIndex; i < startIndex + count && i < m_blocks.size(); i++) {
+    const RawBlockLayout& layout = getRawBlock(i, entry);
+
+    blocks.emplace_back();
+    blocks.back().block.assign(entry.data(), layout.blockSize);
+    blocks.back().txs.reserve(layout.transactions.size());
+    for (const auto& tx : layout.transactions) {
+      blocks.back().txs.emplace_back(entry.data() + tx.first, tx.second - tx.first);
+    }
+  }
+
+  return true;
+}
+
+bool Blockchain::getRawBlocksLite(uint32_t startIndex, uint32_t count, uint64_t timestamp, std::vector<BlockShortInfo>& entries) {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  if (startIndex >= m_blocks.size()) {
+    return false;
+  }
+
+  std::string entry;
+  for (uint32_t i = startIndex; i < startIndex + count && i < m_blocks.size(); i++) {
+    const RawBlockLayout& layout = getRawBlock(i, entry);
+
+    BlockShortInfo item;
+    item.blockId = m_blockIndex.getBlockId(i);
+
+    if (layout.timestamp >= timestamp) {
+      item.block.assign(entry.data(), layout.blockSize);
+
+      // the block blob ends with the hashes of its transactions, in the order they are stored
+      const char* hashes = entry.data() + layout.blockSize - layout.transactions.size() * sizeof(Crypto::Hash);
+      item.txPrefixes.resize(layout.transactions.size());
+      for (size_t j = 0; j < layout.transactions.size(); ++j) {
+        TransactionPrefixInfo& info = item.txPrefixes[j];
+        memcpy(&info.txHash, hashes + j * sizeof(Crypto::Hash), sizeof(Crypto::Hash));
+
+        BinaryArrayInputSerializer archive(entry.data() + layout.transactions[j].first, layout.transactions[j].second - layout.transactions[j].first);
+        CryptoNote::serialize(info.txPrefix, archive);
+      }
+    }
+
+    entries.push_back(std::move(item));
+  }
+
+  return true;
+}
+
 bool Blockchain::getTransactionsWithOutputGlobalIndexes(const std::vector<Crypto::Hash>& txs_ids, std::list<Crypto::Hash>& missed_txs, std::vector<std::pair<Transaction, std::vector<uint32_t>>>& txs) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
@@ -1590,10 +1670,10 @@ bool Blockchain::getRandomOutsByAmount(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_
 }
 
 uint32_t Blockchain::findBlockchainSupplement(const std::vector<Crypto::Hash>& qblock_ids) {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   assert(!qblock_ids.empty());
   assert(qblock_ids.back() == m_blockIndex.getBlockId(0));
 
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   uint32_t blockIndex;
   // assert above guarantees that method returns true
   m_blockIndex.findSupplement(qblock_ids, blockIndex);
@@ -1689,10 +1769,10 @@ void Blockchain::print_blockchain_outs(const std::string& file) {
 std::vector<Crypto::Hash> Blockchain::findBlockchainSupplement(const std::vector<Crypto::Hash>& remoteBlockIds, size_t maxCount,
   uint32_t& totalBlockCount, uint32_t& startBlockIndex) {
 
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   assert(!remoteBlockIds.empty());
   assert(remoteBlockIds.back() == m_blockIndex.getBlockId(0));
 
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   totalBlockCount = getCurrentBlockchainHeight();
   startBlockIndex = findBlockchainSupplement(remoteBlockIds);
 
@@ -1757,15 +1837,84 @@ bool Blockchain::get_out_by_msig_gindex(uint64_t amount, uint64_t gindex, Multis
 
 
 bool Blockchain::checkTransactionInputs(const Transaction& tx, uint32_t& max_used_block_height, Crypto::Hash& max_used_block_id, BlockInfo* tail) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  Crypto::Hash tx_prefix_hash = getObjectHash(*static_cast<const TransactionPrefix*>(&tx));
+  std::vector<std::vector<Crypto::PublicKey>> rings;
+  bool checkSignatures;
+
+  {
+    std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+
+    if (tail)
+      tail->id = getTailId(tail->height);
+
+    checkSignatures = !isInCheckpointZone(getCurrentBlockchainHeight());
+    if (!getTransactionInputRings(tx, tx_prefix_hash, rings, max_used_block_height)) {
+      return false;
+    }
+
+    if (!(max_used_block_height < m_blocks.size())) { logger(ERROR, BRIGHT_RED) << "internal error: max used block index=" << max_used_block_height << " is not less then blockchain size = " << m_blocks.size(); return false; }
+    get_block_hash(m_blocks[max_used_block_height].bl, max_used_block_id);
+  }
+
+  // ring signatures of pool transactions are verified without m_blockchain_lock, so they are checked in parallel
+  if (!checkSignatures) {
+    return true;
+  }
 
-  if (tail)
-    tail->id = getTailId(tail->height);
+  size_t ringIndex = 0;
+  for (size_t inputIndex = 0; inputIndex < tx.inputs.size(); ++inputIndex) {
+    if (tx.inputs[inputIndex].type() == typeid(KeyInput)) {
+      if (!checkInputRingSignature(boost::get<KeyInput>(tx.inputs[inputIndex]), tx_prefix_hash, rings[ringIndex++], tx.signatures[inputIndex])) {
+        logger(INFO, BRIGHT_WHITE) << "Failed to check input in transaction " << getObjectHash(tx);
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+* \pre m_blockchain_lock is locked
+*/
+bool Blockchain::getTransactionInputRings(const Transaction& tx, const Crypto::Hash& tx_prefix_hash, std::vector<std::vector<Crypto::PublicKey>>& rings, uint32_t& max_used_block_height) {
+  max_used_block_height = 0;
+  rings.clear();
+
+  Crypto::Hash transactionHash = getObjectHash(tx);
+  bool inCheckpointZone = isInCheckpointZone(getCurrentBlockchainHeight());
+  for (size_t inputIndex = 0; inputIndex < tx.inputs.size(); ++inputIndex) {
+    const auto& txin = tx.inputs[inputIndex];
+    assert(inputIndex < tx.signatures.size());
+    if (txin.type() == typeid(KeyInput)) {
+      const KeyInput& in_to_key = boost::get<KeyInput>(txin);
+      if (in_to_key.outputIndexes.empty()) { logger(ERROR, BRIGHT_RED) << "empty in_to_key.outputIndexes in transaction with id " << transactionHash; return false; }
+
+      if (have_tx_keyimg_as_spent(in_to_key.keyImage)) {
+        logger(DEBUGGING) <<
+          "Key image already spent in blockchain: " << Common::podToHex(in_to_key.keyImage);
+        return false;
+      }
+
+      rings.emplace_back();
+      if (!inCheckpointZone && !getInputRing(in_to_key, tx.signatures[inputIndex], rings.back(), &max_used_block_height)) {
+        logger(INFO, BRIGHT_WHITE) <<
+          "Failed to check input in transaction " << transactionHash;
+        return false;
+      }
+    } else if (txin.type() == typeid(MultisignatureInput)) {
+      if (!inCheckpointZone) {
+        if (!validateInput(::boost::get<MultisignatureInput>(txin), transactionHash, tx_prefix_hash, tx.signatures[inputIndex])) {
+          return false;
+        }
+      }
+    } else {
+      logger(INFO, BRIGHT_WHITE) <<
+        "Transaction << " << transactionHash << " contains input of unsupported type.";
+      return false;
+    }
+  }
 
-  bool res = checkTransactionInputs(tx, &max_used_block_height);
-  if (!res) return false;
-  if (!(max_used_block_height < m_blocks.size())) { logger(ERROR, BRIGHT_RED) << "internal error: max used block index=" << max_used_block_height << " is not less then blockchain size = " << m_blocks.size(); return false; }
-  get_block_hash(m_blocks[max_used_block_height].bl, max_used_block_id);
   return true;
 }
 
@@ -1866,11 +2015,27 @@ bool Blockchain::is_tx_spendtime_unlocked(uint64_t unlock_time, uint32_t height)
 bool Blockchain::check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::Signature>& sig, uint32_t* pmax_related_block_height) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
+  std::vector<Crypto::PublicKey> ring;
+  if (!getInputRing(txin, sig, ring, pmax_related_block_height)) {
+    return false;
+  }
+
+  if (isInCheckpointZone(getCurrentBlockchainHeight())) {
+    return true;
+  }
+
+  return checkInputRingSignature(txin, tx_prefix_hash, ring, sig);
+}
+
+/**
+* \pre m_blockchain_lock is locked
+*/
+bool Blockchain::getInputRing(const KeyInput& txin, const std::vector<Crypto::Signature>& sig, std::vector<Crypto::PublicKey>& ring, uint32_t* pmax_related_block_height) {
   struct outputs_visitor {
-    std::vector<const Crypto::PublicKey *>& m_results_collector;
+    std::vector<Crypto::PublicKey>& m_results_collector;
     Blockchain& m_bch;
     LoggerRef logger;
-    outputs_visitor(std::vector<const Crypto::PublicKey *>& results_collector, Blockchain& bch, ILogger& logger) :m_results_collector(results_collector), m_bch(bch), logger(logger, "outputs_visitor") {
+    outputs_visitor(std::vector<Crypto::PublicKey>& results_collector, Blockchain& bch, ILogger& logger) :m_results_collector(results_collector), m_bch(bch), logger(logger, "outputs_visitor") {
     }
 
     bool handle_output(const Transaction& tx, const TransactionOutput& out, size_t transactionOutputIndex) {
@@ -1887,20 +2052,15 @@ bool Blockchain::check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_pre
         return false;
       }
 
-      m_results_collector.push_back(&boost::get<KeyOutput>(out.target).key);
+      m_results_collector.push_back(boost::get<KeyOutput>(out.target).key);
       return true;
     }
   };
 
-  // additional key_image check, fix discovered by Monero Lab and suggested by "fluffypony" (bitcointalk.org)
-  if (!(scalarmultKey(txin.keyImage, Crypto::EllipticCurveScalar2KeyImage(Crypto::L)) == Crypto::EllipticCurveScalar2KeyImage(Crypto::I))) {
-    logger(ERROR) << "Transaction uses key image not in the valid domain";
-    return false;
-  }
-
-  //check ring signature
-  std::vector<const Crypto::PublicKey *> output_keys;
-  outputs_visitor vi(output_keys, *this, logger.getLogger());
+  // keys are copied, the transactions they come from may be evicted from the cache once the lock is released
+  ring.clear();
+  ring.reserve(txin.outputIndexes.size());
+  outputs_visitor vi(ring, *this, logger.getLogger());
   if (!scanOutputKeysForIndexes(txin, vi, pmax_related_block_height)) {
     logger(INFO, BRIGHT_WHITE) <<
       "Failed to get output keys for tx with amount = " << m_currency.formatAmount(txin.amount) <<
@@ -1908,15 +2068,28 @@ bool Blockchain::check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_pre
     return false;
   }
 
-  if (txin.outputIndexes.size() != output_keys.size()) {
+  if (txin.outputIndexes.size() != ring.size()) {
     logger(INFO, BRIGHT_WHITE) <<
-      "Output keys for tx with amount = " << txin.amount << " and count indexes " << txin.outputIndexes.size() << " returned wrong keys count " << output_keys.size();
+      "Output keys for tx with amount = " << txin.amount << " and count indexes " << txin.outputIndexes.size() << " returned wrong keys count " << ring.size();
     return false;
   }
 
-  if (!(sig.size() == output_keys.size())) { logger(ERROR, BRIGHT_RED) << "internal error: tx signatures count=" << sig.size() << " mismatch with outputs keys count for inputs=" << output_keys.size(); return false; }
-  if (isInCheckpointZone(getCurrentBlockchainHeight())) {
-    return true;
+  if (!(sig.size() == ring.size())) { logger(ERROR, BRIGHT_RED) << "internal error: tx signatures count=" << sig.size() << " mismatch with outputs keys count for inputs=" << ring.size(); return false; }
+  return true;
+}
+
+// Needs no lock, only the ring collected by getInputRing is used
+bool Blockchain::checkInputRingSignature(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::PublicKey>& ring, const std::vector<Crypto::Signature>& sig) {
+  // additional key_image check, fix discovered by Monero Lab and suggested by "fluffypony" (bitcointalk.org)
+  if (!(scalarmultKey(txin.keyImage, Crypto::EllipticCurveScalar2KeyImage(Crypto::L)) == Crypto::EllipticCurveScalar2KeyImage(Crypto::I))) {
+    logger(ERROR) << "Transaction uses key image not in the valid domain";
+    return false;
+  }
+
+  std::vector<const Crypto::PublicKey*> output_keys;
+  output_keys.reserve(ring.size());
+  for (const auto& key : ring) {
+    output_keys.push_back(&key);
   }
 
   bool check_tx_ring_signature = Crypto::check_ring_signature(tx_prefix_hash, txin.keyImage, output_keys, sig.data());
@@ -2112,9 +2285,54 @@ bool Blockchain::pushBlock(const Block& blockData, const Crypto::Hash& id, block
   return true;
 }
 
+bool Blockchain::prevalidateBlock(const Block& blockData, const Crypto::Hash& blockHash, size_t cumulativeSize) {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+
+  if (m_blockIndex.hasBlock(blockHash) || blockData.previousBlockHash != getTailId()) {
+    return false;
+  }
+
+  if (!checkBlockVersion(blockData, blockHash) || !checkParentBlockSize(blockData, blockHash)) {
+    return false;
+  }
+
+  if (blockData.majorVersion >= CryptoNote::BLOCK_MAJOR_VERSION_5) {
+    TransactionExtraMergeMiningTag mmTag;
+    if (getMergeMiningTagFromExtra(blockData.baseTransaction.extra, mmTag)) {
+      return false;
+    }
+  }
+
+  uint32_t height = static_cast<uint32_t>(m_blocks.size());
+  if (!check_block_timestamp_main(blockData) || !checkCumulativeBlockSize(blockHash, cumulativeSize, height) ||
+      !prevalidate_miner_transaction(blockData, height)) {
+    return false;
+  }
+
+  if (m_checkpoints.is_in_checkpoint_zone(height)) {
+    return m_checkpoints.check_block(height, blockHash);
+  }
+
+  difficulty_type currentDifficulty = getDifficultyForNextBlock(blockData.previousBlockHash);
+  Crypto::Hash proofOfWork;
+  if (currentDifficulty == 0 || !m_currency.checkProofOfWork(m_cn_context, blockData, currentDifficulty, proofOfWork)) {
+    return false;
+  }
+
+  // the difficulty depends on the parent only, which the hash commits to, so pushBlock takes this result
+  m_prevalidatedBlock = blockHash;
+  m_prevalidatedProofOfWork = proofOfWork;
+  return true;
+}
+
 bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction>& transactions, const Crypto::Hash& blockHash, block_verification_context& bvc) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
+  static Common::MetricsHistogram& difficultyMetric = Common::MetricsRegistry::instance().histogram("block_validation_duration_us", "stage=\"difficulty\"");
+  static Common::MetricsHistogram& proofOfWorkMetric = Common::MetricsRegistry::instance().histogram("block_validation_duration_us", "stage=\"pow\"");
+  static Common::MetricsHistogram& transactionsMetric = Common::MetricsRegistry::instance().histogram("block_validation_duration_us", "stage=\"transactions\"");
+  static Common::MetricsHistogram& totalMetric = Common::MetricsRegistry::instance().histogram("block_validation_duration_us", "stage=\"total\"");
+
   auto blockProcessingStart = std::chrono::steady_clock::now();
 
   if (m_blockIndex.hasBlock(blockHash)) {
@@ -2161,7 +2379,7 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
 
   auto targetTimeStart = std::chrono::steady_clock::now();
   difficulty_type currentDifficulty = getDifficultyForNextBlock(blockData.previousBlockHash);
-  auto target_calculating_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - targetTimeStart).count();
+  auto target_calculating_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - targetTimeStart).count();
 
   if (!(currentDifficulty)) {
     logger(ERROR, BRIGHT_RED) << "!!!!!!!!! difficulty overhead !!!!!!!!!";
@@ -2177,6 +2395,8 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
       bvc.m_verification_failed = true;
       return false;
     }
+  } else if (blockHash == m_prevalidatedBlock) {
+    proof_of_work = m_prevalidatedProofOfWork;
   } else {
     if (!m_currency.checkProofOfWork(m_cn_context, blockData, currentDifficulty, proof_of_work)) {
       logger(INFO, BRIGHT_WHITE) <<
@@ -2186,7 +2406,7 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
     }
   }
 
-  auto longhash_calculating_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - longhashTimeStart).count();
+  auto longhash_calculating_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - longhashTimeStart).count();
 
   if (!prevalidate_miner_transaction(blockData, static_cast<uint32_t>(m_blocks.size()))) {
     logger(INFO, BRIGHT_WHITE) <<
@@ -2195,6 +2415,7 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
     return false;
   }
 
+  auto transactionsTimeStart = std::chrono::steady_clock::now();
   Crypto::Hash minerTransactionHash = getObjectHash(blockData.baseTransaction);
 
   BlockEntry block;
@@ -2248,6 +2469,8 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
     return false;
   }
 
+  auto transactions_checking_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - transactionsTimeStart).count();
+
   block.height = static_cast<uint32_t>(m_blocks.size());
   block.block_cumulative_size = cumulative_block_size;
   block.cumulative_difficulty = currentDifficulty;
@@ -2257,8 +2480,15 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
   }
 
   pushBlock(block, blockHash);
+  if (proof_of_work != NULL_HASH) {
+    m_proofOfWork[blockHash] = proof_of_work;
+  }
 
-  auto block_processing_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - blockProcessingStart).count();
+  auto block_processing_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - blockProcessingStart).count();
+  difficultyMetric.record(target_calculating_time);
+  proofOfWorkMetric.record(longhash_calculating_time);
+  transactionsMetric.record(transactions_checking_time);
+  totalMetric.record(block_processing_time);
 
   if (block.height % 1000 == 0) {
     logger(INFO) << "Blockchain loaded to height: " << block.height;
@@ -2270,7 +2500,7 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
     << ENDL << "HEIGHT " << block.height << ", difficulty:\t" << currentDifficulty
     << ENDL << "block reward: " << m_currency.formatAmount(reward) << ", fee = " << m_currency.formatAmount(fee_summary)
     << ", coinbase_blob_size: " << coinbase_blob_size << ", cumulative size: " << cumulative_block_size
-    << ", " << block_processing_time << "(" << target_calculating_time << "/" << longhash_calculating_time << ")ms";
+    << ", " << block_processing_time / 1000 << "(" << target_calculating_time / 1000 << "/" << longhash_calculating_time / 1000 << ")ms";
 
   bvc.m_added_to_main_chain = true;
 
@@ -2281,6 +2511,8 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
 
   update_next_cumulative_size_limit();
 
+  m_tx_pool.on_blockchain_inc(getCurrentBlockchainHeight(), blockHash);
+
   return true;
 }
 
@@ -2314,6 +2546,8 @@ void Blockchain::popBlock() {
   m_upgradeDetectorV3.blockPopped();
   m_upgradeDetectorV4.blockPopped();
   m_upgradeDetectorV5.blockPopped();
+
+  m_tx_pool.on_blockchain_dec(getCurrentBlockchainHeight(), getTailId());
 }
 
 bool Blockchain::pushTransaction(BlockEntry& block, const Crypto::Hash& transactionHash, TransactionIndex transactionIndex) {
@@ -2577,6 +2811,12 @@ void Blockchain::removeLastBlock() {
   Crypto::Hash blockHash = getBlockIdByHeight(m_blocks.back().height);
   m_timestampIndex.remove(m_blocks.back().bl.timestamp, blockHash);
   m_generatedTransactionsIndex.remove(m_blocks.back().bl);
+  m_proofOfWork.erase(blockHash);
+  auto layoutIt = m_rawBlockLayouts.find(m_blocks.back().height);
+  if (layoutIt != m_rawBlockLayouts.end()) {
+    m_rawBlockLayoutUsage.erase(layoutIt->second.usage);
+    m_rawBlockLayouts.erase(layoutIt);
+  }
 
   m_blocks.pop_back();
   m_blockIndex.pop();
@@ -2584,6 +2824,67 @@ void Blockchain::removeLastBlock() {
   assert(m_blockIndex.size() == m_blocks.size());
 }
 
+const Blockchain::RawBlockLayout& Blockchain::getRawBlock(uint32_t index, std::string& entry) {
+  m_blocks.getRaw(index, entry);
+
+  auto it = m_rawBlockLayouts.find(index);
+  if (it != m_rawBlockLayouts.end()) {
+    m_rawBlockLayoutUsage.splice(m_rawBlockLayoutUsage.end(), m_rawBlockLayoutUsage, it->second.usage);
+    return it->second.layout;
+  }
+
+  // Blobs are not length prefixed in the stored entry, so it is walked once to find their boundaries
+  const uint8_t* begin = reinterpret_cast<const uint8_t*>(entry.data());
+  BinaryArrayInputSerializer archive(begin, entry.size());
+
+  RawBlockLayout layout;
+  Block block;
+  archive(block, "block");
+  layout.timestamp = block.timestamp;
+  layout.blockSize = static_cast<uint32_t>(archive.position() - begin);
+
+  uint32_t height;
+  uint64_t cumulativeSize;
+  difficulty_type cumulativeDifficulty;
+  uint64_t generatedCoins;
+  archive(height, "height");
+  archive(cumulativeSize, "block_cumulative_size");
+  archive(cumulativeDifficulty, "cumulative_difficulty");
+  archive(generatedCoins, "already_generated_coins");
+
+  size_t count;
+  archive.beginArray(count, "transactions");
+  if (count != block.transactionHashes.size() + 1) {
+    throw std::runtime_error("Stored block entry has inconsistent transaction count");
+  }
+
+  layout.transactions.reserve(block.transactionHashes.size());
+  for (size_t i = 0; i < count; ++i) {
+    Transaction tx;
+    std::vector<uint32_t> indexes;
+    uint32_t txBegin = static_cast<uint32_t>(archive.position() - begin);
+    archive(tx, "tx");
+    if (i != 0) {
+      layout.transactions.emplace_back(txBegin, static_cast<uint32_t>(archive.position() - begin));
+    }
+
+    archive(indexes, "indexes");
+  }
+
+  archive.endArray();
+
+  if (m_rawBlockLayouts.size() >= RAW_BLOCK_LAYOUTS_MAX) {
+    m_rawBlockLayouts.erase(m_rawBlockLayoutUsage.front());
+    m_rawBlockLayoutUsage.pop_front();
+  }
+
+  m_rawBlockLayoutUsage.push_back(index);
+  CachedRawBlockLayout& cached = m_rawBlockLayouts[index];
+  cached.layout = std::move(layout);
+  cached.usage = std::prev(m_rawBlockLayoutUsage.end());
+  return cached.layout;
+}
+
 bool Blockchain::checkUpgradeHeight(const UpgradeDetector& upgradeDetector) {
   uint32_t upgradeHeight = upgradeDetector.upgradeHeight();
   if (upgradeHeight != UpgradeDetectorBase::UNDEF_HEIGHT && upgradeHeight + 1 < m_blocks.size()) {
@@ -2671,6 +2972,19 @@ bool Blockchain::getBlockSize(const Crypto::Hash& hash, size_t& size) {
   return false;
 }
 
+bool Blockchain::getBlockProofOfWork(const Crypto::Hash& hash, Crypto::Hash& proofOfWork) {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+
+  // only blocks validated outside of the checkpoint zone have it stored
+  auto it = m_proofOfWork.find(hash);
+  if (it == m_proofOfWork.end()) {
+    return false;
+  }
+
+  proofOfWork = it->second;
+  return true;
+}
+
 bool Blockchain::getMultisigOutputReference(const MultisignatureInput& txInMultisig, std::pair<Crypto::Hash, size_t>& outputReference) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   MultisignatureOutputsContainer::const_iterator amountIter = m_multisignatureOutputs.find(txInMultisig.amount);
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <atomic>
+#include <list>
 #include <unordered_map>
 #include <parallel_hashmap/phmap.h>
 #include "google/sparse_hash_set"
@@ -54,6 +55,8 @@ namespace CryptoNote {
   struct COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_request;
   struct COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_response;
   struct COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount;
+  struct block_complete_entry;
+  struct BlockShortInfo;
 
   using CryptoNote::BlockInfo;
   class Blockchain : public CryptoNote::ITransactionValidator {
@@ -79,6 +82,8 @@ namespace CryptoNote {
     void setCheckpoints(Checkpoints&& chk_pts) { m_checkpoints = chk_pts; }
     bool getBlocks(uint32_t start_offset, uint32_t count, std::list<Block>& blocks, std::list<Transaction>& txs);
     bool getBlocks(uint32_t start_offset, uint32_t count, std::list<Block>& blocks);
+    bool getRawBlocks(uint32_t startIndex, uint32_t count, std::vector<block_complete_entry>& blocks);
+    bool getRawBlocksLite(uint32_t startIndex, uint32_t count, uint64_t timestamp, std::vector<BlockShortInfo>& entries);
     bool getTransactionsWithOutputGlobalIndexes(const std::vector<Crypto::Hash>& txs_ids, std::list<Crypto::Hash>& missed_txs, std::vector<std::pair<Transaction, std::vector<uint32_t>>>& txs);
     bool getAlternativeBlocks(std::list<Block>& blocks);
     uint32_t getAlternativeBlocksCount();
@@ -104,6 +109,10 @@ namespace CryptoNote {
     uint64_t getCoinsInCirculation(uint32_t height);
     uint8_t getBlockMajorVersionForHeight(uint32_t height) const;
     bool addNewBlock(const Block& bl, block_verification_context& bvc);
+    // The checks of a block on top of the chain that don't need its transactions: parent, version, timestamp, size,
+    // miner transaction form and proof of work. addNewBlock doesn't compute the proof of work of the last block
+    // that passed them again.
+    bool prevalidateBlock(const Block& b, const Crypto::Hash& blockHash, size_t cumulativeSize);
     bool resetAndSetGenesisBlock(const Block& b);
     bool haveBlock(const Crypto::Hash& id);
     size_t getTotalTransactions();
@@ -125,6 +134,7 @@ namespace CryptoNote {
     bool getBlockContainingTransaction(const Crypto::Hash& txId, Crypto::Hash& blockId, uint32_t& blockHeight);
     bool getAlreadyGeneratedCoins(const Crypto::Hash& hash, uint64_t& generatedCoins);
     bool getBlockSize(const Crypto::Hash& hash, size_t& size);
+    bool getBlockProofOfWork(const Crypto::Hash& hash, Crypto::Hash& proofOfWork);
     bool getMultisigOutputReference(const MultisignatureInput& txInMultisig, std::pair<Crypto::Hash, size_t>& outputReference);
     bool getGeneratedTransactionsNumber(uint32_t height, uint64_t& generatedTransactions);
     bool getOrphanBlockIdsByHeight(uint32_t height, std::vector<Crypto::Hash>& blockHashes);
@@ -234,7 +244,8 @@ namespace CryptoNote {
       Transaction tx;
       std::vector<uint32_t> m_global_output_indexes;
 
-      void serialize(ISerializer& s) {
+      template<class Serializer>
+      void serialize(Serializer& s) {
         s(tx, "tx");
         s(m_global_output_indexes, "indexes");
       }
@@ -248,7 +259,8 @@ namespace CryptoNote {
       uint64_t already_generated_coins;
       std::vector<TransactionEntry> transactions;
 
-      void serialize(ISerializer& s) {
+      template<class Serializer>
+      void serialize(Serializer& s) {
         s(bl, "block");
         s(height, "height");
         s(block_cumulative_size, "block_cumulative_size");
@@ -258,6 +270,13 @@ namespace CryptoNote {
       }
     };
 
+    // Where the block and transaction blobs lie within a stored BlockEntry
+    struct RawBlockLayout {
+      uint64_t timestamp;
+      uint32_t blockSize;
+      std::vector<std::pair<uint32_t, uint32_t>> transactions; // begin and end of each non-coinbase transaction
+    };
+
     typedef parallel_flat_hash_map<Crypto::KeyImage, uint32_t> key_images_container;
     typedef parallel_flat_hash_map<Crypto::Hash, BlockEntry> blocks_ext_by_hash;
     typedef parallel_flat_hash_map<uint64_t, std::vector<std::pair<TransactionIndex, uint16_t>>> outputs_container; //Crypto::Hash - tx hash, size_t - index of out in transaction
@@ -271,6 +290,8 @@ namespace CryptoNote {
 
     key_images_container m_spent_key_images;
     size_t m_current_block_cumul_sz_limit;
+    Crypto::Hash m_prevalidatedBlock;
+    Crypto::Hash m_prevalidatedProofOfWork;
     blocks_ext_by_hash m_alternative_chains; // Crypto::Hash -> block_extended_info
     outputs_container m_outputs;
 
@@ -280,6 +301,13 @@ namespace CryptoNote {
     typedef SwappedVector<BlockEntry> Blocks;
     typedef parallel_flat_hash_map<Crypto::Hash, uint32_t> BlockMap;
     typedef parallel_flat_hash_map<Crypto::Hash, TransactionIndex> TransactionMap;
+    typedef parallel_flat_hash_map<Crypto::Hash, Crypto::Hash> ProofOfWorkMap;
+    struct CachedRawBlockLayout {
+      RawBlockLayout layout;
+      std::list<uint32_t>::iterator usage;
+    };
+
+    typedef parallel_flat_hash_map<uint32_t, CachedRawBlockLayout> RawBlockLayoutMap;
     typedef BasicUpgradeDetector<Blocks> UpgradeDetector;
 
     friend class BlockCacheSerializer;
@@ -288,6 +316,9 @@ namespace CryptoNote {
     Blocks m_blocks;
     CryptoNote::BlockIndex m_blockIndex;
     TransactionMap m_transactionMap;
+    ProofOfWorkMap m_proofOfWork; // block hash -> long hash computed when the block was validated
+    RawBlockLayoutMap m_rawBlockLayouts; // height -> layout, filled on first raw read
+    std::list<uint32_t> m_rawBlockLayoutUsage; // heights of the cached layouts, least recently read first
     MultisignatureOutputsContainer m_multisignatureOutputs;
     UpgradeDetector m_upgradeDetectorV2;
     UpgradeDetector m_upgradeDetectorV3;
@@ -323,6 +354,9 @@ namespace CryptoNote {
     bool getBlockCumulativeSize(const Block& block, size_t& cumulativeSize);
     bool update_next_cumulative_size_limit();
     bool check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::Signature>& sig, uint32_t* pmax_related_block_height = NULL);
+    bool getInputRing(const KeyInput& txin, const std::vector<Crypto::Signature>& sig, std::vector<Crypto::PublicKey>& ring, uint32_t* pmax_related_block_height);
+    bool checkInputRingSignature(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::PublicKey>& ring, const std::vector<Crypto::Signature>& sig);
+    bool getTransactionInputRings(const Transaction& tx, const Crypto::Hash& tx_prefix_hash, std::vector<std::vector<Crypto::PublicKey>>& rings, uint32_t& max_used_block_height);
     bool checkTransactionInputs(const Transaction& tx, const Crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height = NULL);
     bool checkTransactionInputs(const Transaction& tx, uint32_t* pmax_used_block_height = NULL);
     const TransactionEntry& transactionByIndex(TransactionIndex index);
@@ -336,6 +370,7 @@ namespace CryptoNote {
     bool validateInput(const MultisignatureInput& input, const Crypto::Hash& transactionHash, const Crypto::Hash& transactionPrefixHash, const std::vector<Crypto::Signature>& transactionSignatures);
     bool checkCheckpoints(uint32_t& lastValidCheckpointHeight);
     void removeLastBlock();
+    const RawBlockLayout& getRawBlock(uint32_t index, std::string& entry);
     bool checkUpgradeHeight(const UpgradeDetector& upgradeDetector);
 
     bool storeBlockchainIndices();
@@ -26,6 +26,7 @@
 #include "../Common/CommandLine.h"
 #include "../Common/Util.h"
 #include "../Common/Math.h"
+#include "../Common/Metrics.h"
 #include "../Common/StringTools.h"
 #include "../crypto/crypto.h"
 #include "../CryptoNoteProtocol/CryptoNoteProtocolDefinitions.h"
@@ -47,6 +48,13 @@ using namespace  Common;
 
 namespace CryptoNote {
 
+namespace {
+
+// the extra nonce of a miner transaction follows the tagged transaction public key, after its own tag and size
+const size_t EXTRA_NONCE_OFFSET = 1 + sizeof(Crypto::PublicKey) + 2;
+
+}
+
 class BlockWithTransactions : public IBlock {
 public:
   virtual const Block& getBlock() const override {
@@ -77,7 +85,12 @@ Core::Core(const Currency& currency, i_cryptonote_protocol* pprotocol, Logging::
   m_blockchain(currency, m_mempool, logger, blockchainIndexesEnabled),
   m_miner(new miner(currency, *this, logger)),
   m_starter_message_showed(false),
-  m_checkpoints(logger) {
+  m_checkpoints(logger),
+  m_blockTemplateSkeletonValid(false),
+  m_blockTemplateSkeletonRevision(0),
+  m_blockTemplateExtraNonceSize(0),
+  m_blockTemplateMinerTxValid(false),
+  m_blockTemplateRevision(0) {
     set_cryptonote_protocol(pprotocol);
     m_blockchain.addObserver(this);
     m_mempool.addObserver(this);
@@ -180,12 +193,15 @@ std::time_t Core::getStartTime() const {
 //-----------------------------------------------------------------------------------------------
 bool Core::init(const CoreConfig& config, const MinerConfig& minerConfig, bool load_existing) {
   m_config_folder = config.configFolder;
-  bool r = m_mempool.init(m_config_folder);
-  if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to initialize memory pool"; return false; }
-
-  r = m_blockchain.init(m_config_folder, load_existing);
+  m_mempool.setMaxSize(config.txPoolMaxSize);
+  // the pool journal is replayed against the loaded chain, the transactions the chain returns to the pool while it
+  // loads are journaled then
+  bool r = m_blockchain.init(m_config_folder, load_existing);
   if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to initialize blockchain storage"; return false; }
 
+  r = m_mempool.init(m_config_folder);
+  if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to initialize memory pool"; return false; }
+
   r = m_miner->init(minerConfig);
   if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to initialize miner"; return false; }
 
@@ -485,10 +501,8 @@ size_t Core::getBlockchainTotalTransactions() {
 //}
 
 bool Core::add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block) {
-  //Locking on m_mempool and m_blockchain closes possibility to add tx to memory pool which is already in blockchain 
-  std::lock_guard<decltype(m_mempool)> lk(m_mempool);
-  LockedBlockchainStorage lbs(m_blockchain);
-
+  // Nothing is locked across the checks, the pool verifies inputs unlocked and rechecks them against the pool and
+  // the blockchain when inserting. A block with this tx pushed meanwhile spends its key images, so it's rejected then.
   if (m_blockchain.haveTransaction(tx_hash)) {
     logger(TRACE) << "tx " << tx_hash << " is already in blockchain";
     return true;
@@ -502,9 +516,28 @@ bool Core::add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t
   return m_mempool.add_tx(tx, tx_hash, blob_size, tvc, keeped_by_block);
 }
 
-bool Core::get_block_template(Block& b, const AccountPublicAddress& adr, difficulty_type& diffic, uint32_t& height, const BinaryArray& ex_nonce) {
-  size_t median_size;
-  uint64_t already_generated_coins;
+bool Core::updateBlockTemplateSkeleton() {
+  // read before building, a change during the build leaves the new skeleton outdated
+  uint64_t revision = m_blockTemplateRevision.load();
+  if (m_blockTemplateSkeletonValid && m_blockTemplateSkeletonRevision == revision && m_blockTemplateSkeleton.block.previousBlockHash == get_tail_id()) {
+    return true;
+  }
+
+  m_blockTemplateSkeletonValid = false;
+  m_blockTemplateMinerTxValid = false;
+  if (!buildBlockTemplateSkeleton(m_blockTemplateSkeleton)) {
+    return false;
+  }
+
+  m_blockTemplateSkeletonValid = true;
+  m_blockTemplateSkeletonRevision = revision;
+  return true;
+}
+
+bool Core::buildBlockTemplateSkeleton(BlockTemplateSkeleton& skeleton) {
+  Block& b = skeleton.block;
+  difficulty_type& diffic = skeleton.difficulty;
+  uint32_t& height = skeleton.height;
 
   {
     LockedBlockchainStorage blockchainLock(m_blockchain);
@@ -512,7 +545,6 @@ bool Core::get_block_template(Block& b, const AccountPublicAddress& adr, difficu
     b = boost::value_initialized<Block>();
     b.majorVersion = m_blockchain.getBlockMajorVersionForHeight(height);
     b.previousBlockHash = get_tail_id();
-    b.timestamp = time(NULL);
     diffic = m_blockchain.getDifficultyForNextBlock(b.previousBlockHash);
     if (!(diffic)) {
       logger(ERROR, BRIGHT_RED) << "difficulty overhead.";
@@ -547,44 +579,82 @@ bool Core::get_block_template(Block& b, const AccountPublicAddress& adr, difficu
     // Fix by Jagerman
     // https://github.com/graft-project/GraftNetwork/pull/118/commits
 
+    skeleton.minimalTimestamp = 0;
     if(height >= m_currency.timestampCheckWindow(b.majorVersion)) {
       std::vector<uint64_t> timestamps;
       for(uint32_t offset = height - static_cast<uint32_t>(m_currency.timestampCheckWindow(b.majorVersion)); offset < height; ++offset) {
         timestamps.push_back(m_blockchain.getBlockTimestamp(offset));
       }
-      uint64_t median_ts = Common::medianValue(timestamps);
-      if (b.timestamp < median_ts) {
-          b.timestamp = median_ts;
-      }
+      skeleton.minimalTimestamp = Common::medianValue(timestamps);
     }
 
-    median_size = m_blockchain.getCurrentCumulativeBlocksizeLimit() / 2;
-    already_generated_coins = m_blockchain.getCoinsInCirculation();
+    skeleton.medianSize = m_blockchain.getCurrentCumulativeBlocksizeLimit() / 2;
+    skeleton.alreadyGeneratedCoins = m_blockchain.getCoinsInCirculation();
   }
 
-  size_t txs_size;
-  uint64_t fee;
-  if (!m_mempool.fill_block_template(b, median_size, m_currency.maxBlockCumulativeSize(height), already_generated_coins, txs_size, fee)) {
+  return m_mempool.fill_block_template(b, skeleton.medianSize, m_currency.maxBlockCumulativeSize(height), skeleton.alreadyGeneratedCoins,
+    skeleton.transactionsSize, skeleton.fee);
+}
+
+bool Core::get_block_template(Block& b, const AccountPublicAddress& adr, difficulty_type& diffic, uint32_t& height, const BinaryArray& ex_nonce) {
+  // the core locks first and in the order of executeLocked, the skeleton is built under both of them anyway
+  std::lock_guard<decltype(m_mempool)> poolLock(m_mempool);
+  LockedBlockchainStorage blockchainLock(m_blockchain);
+  std::lock_guard<std::mutex> lock(m_blockTemplateLock);
+  if (!updateBlockTemplateSkeleton()) {
     return false;
   }
 
+  // the miner transaction depends on the address and the size of the extra nonce, requests that differ only in
+  // the extra nonce bytes get a copy with their bytes written in
+  if (!m_blockTemplateMinerTxValid || m_blockTemplateMinerAddress.spendPublicKey != adr.spendPublicKey ||
+      m_blockTemplateMinerAddress.viewPublicKey != adr.viewPublicKey || m_blockTemplateExtraNonceSize != ex_nonce.size()) {
+    m_blockTemplateMinerTxValid = false;
+    if (!constructBlockTemplateMinerTx(m_blockTemplateSkeleton, adr, ex_nonce, m_blockTemplateMinerTx)) {
+      return false;
+    }
+
+    m_blockTemplateMinerAddress = adr;
+    m_blockTemplateExtraNonceSize = ex_nonce.size();
+    m_blockTemplateMinerTxValid = true;
+  }
+
+  b = m_blockTemplateSkeleton.block;
+  b.timestamp = std::max<uint64_t>(time(NULL), m_blockTemplateSkeleton.minimalTimestamp);
+  b.baseTransaction = m_blockTemplateMinerTx;
+  if (!ex_nonce.empty()) {
+    std::copy(ex_nonce.begin(), ex_nonce.end(), b.baseTransaction.extra.begin() + EXTRA_NONCE_OFFSET);
+  }
+
+  diffic = m_blockTemplateSkeleton.difficulty;
+  height = m_blockTemplateSkeleton.height;
+  return true;
+}
+
+bool Core::constructBlockTemplateMinerTx(const BlockTemplateSkeleton& skeleton, const AccountPublicAddress& adr, const BinaryArray& ex_nonce, Transaction& minerTx) {
+  uint32_t height = skeleton.height;
+  size_t median_size = skeleton.medianSize;
+  uint64_t already_generated_coins = skeleton.alreadyGeneratedCoins;
+  size_t txs_size = skeleton.transactionsSize;
+  uint64_t fee = skeleton.fee;
+
   /*
      two-phase miner transaction generation: we don't know exact block size until we prepare block, but we don't know reward until we know
      block size, so first miner transaction generated with fake amount of money, and with phase we know think we know expected block size
      */
   //make blocks coin-base tx looks close to real coinbase tx to get truthful blob size
-  bool r = m_currency.constructMinerTx(b.majorVersion, height, median_size, already_generated_coins, txs_size, fee, adr, b.baseTransaction, ex_nonce, 14);
+  bool r = m_currency.constructMinerTx(skeleton.block.majorVersion, height, median_size, already_generated_coins, txs_size, fee, adr, minerTx, ex_nonce, 14);
   if (!r) { 
     logger(ERROR, BRIGHT_RED) << "Failed to construct miner tx, first chance"; 
     return false; 
   }
 
-  size_t cumulative_size = txs_size + getObjectBinarySize(b.baseTransaction);
+  size_t cumulative_size = txs_size + getObjectBinarySize(minerTx);
   for (size_t try_count = 0; try_count != 10; ++try_count) {
-    r = m_currency.constructMinerTx(b.majorVersion, height, median_size, already_generated_coins, cumulative_size, fee, adr, b.baseTransaction, ex_nonce, 14);
+    r = m_currency.constructMinerTx(skeleton.block.majorVersion, height, median_size, already_generated_coins, cumulative_size, fee, adr, minerTx, ex_nonce, 14);
 
     if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to construct miner tx, second chance"; return false; }
-    size_t coinbase_blob_size = getObjectBinarySize(b.baseTransaction);
+    size_t coinbase_blob_size = getObjectBinarySize(minerTx);
     if (coinbase_blob_size > cumulative_size - txs_size) {
       cumulative_size = txs_size + coinbase_blob_size;
       continue;
@@ -592,12 +662,12 @@ bool Core::get_block_template(Block& b, const AccountPublicAddress& adr, difficu
 
     if (coinbase_blob_size < cumulative_size - txs_size) {
       size_t delta = cumulative_size - txs_size - coinbase_blob_size;
-      b.baseTransaction.extra.insert(b.baseTransaction.extra.end(), delta, 0);
+      minerTx.extra.insert(minerTx.extra.end(), delta, 0);
       //here  could be 1 byte difference, because of extra field counter is varint, and it can become from 1-byte len to 2-bytes len.
-      if (cumulative_size != txs_size + getObjectBinarySize(b.baseTransaction)) {
-        if (!(cumulative_size + 1 == txs_size + getObjectBinarySize(b.baseTransaction))) { logger(ERROR, BRIGHT_RED) << "unexpected case: cumulative_size=" << cumulative_size << " + 1 is not equal txs_cumulative_size=" << txs_size << " + get_object_blobsize(b.baseTransaction)=" << getObjectBinarySize(b.baseTransaction); return false; }
-        b.baseTransaction.extra.resize(b.baseTransaction.extra.size() - 1);
-        if (cumulative_size != txs_size + getObjectBinarySize(b.baseTransaction)) {
+      if (cumulative_size != txs_size + getObjectBinarySize(minerTx)) {
+        if (!(cumulative_size + 1 == txs_size + getObjectBinarySize(minerTx))) { logger(ERROR, BRIGHT_RED) << "unexpected case: cumulative_size=" << cumulative_size << " + 1 is not equal txs_cumulative_size=" << txs_size << " + get_object_blobsize(minerTx)=" << getObjectBinarySize(minerTx); return false; }
+        minerTx.extra.resize(minerTx.extra.size() - 1);
+        if (cumulative_size != txs_size + getObjectBinarySize(minerTx)) {
           //fuck, not lucky, -1 makes varint-counter size smaller, in that case we continue to grow with cumulative_size
           logger(TRACE, BRIGHT_RED) <<
             "Miner tx creation have no luck with delta_extra size = " << delta << " and " << delta - 1;
@@ -605,10 +675,16 @@ bool Core::get_block_template(Block& b, const AccountPublicAddress& adr, difficu
           continue;
         }
         logger(DEBUGGING, BRIGHT_GREEN) <<
-          "Setting extra for block: " << b.baseTransaction.extra.size() << ", try_count=" << try_count;
+          "Setting extra for block: " << minerTx.extra.size() << ", try_count=" << try_count;
       }
     }
-    if (!(cumulative_size == txs_size + getObjectBinarySize(b.baseTransaction))) { logger(ERROR, BRIGHT_RED) << "unexpected case: cumulative_size=" << cumulative_size << " is not equal txs_cumulative_size=" << txs_size << " + get_object_blobsize(b.baseTransaction)=" << getObjectBinarySize(b.baseTransaction); return false; }
+    if (!(cumulative_size == txs_size + getObjectBinarySize(minerTx))) { logger(ERROR, BRIGHT_RED) << "unexpected case: cumulative_size=" << cumulative_size << " is not equal txs_cumulative_size=" << txs_size << " + get_object_blobsize(minerTx)=" << getObjectBinarySize(minerTx); return false; }
+
+    if (!ex_nonce.empty() && (minerTx.extra.size() < EXTRA_NONCE_OFFSET + ex_nonce.size() ||
+        !std::equal(ex_nonce.begin(), ex_nonce.end(), minerTx.extra.begin() + EXTRA_NONCE_OFFSET))) {
+      logger(ERROR, BRIGHT_RED) << "Failed to find extra nonce in miner tx extra";
+      return false;
+    }
 
     return true;
   }
@@ -706,11 +782,51 @@ bool Core::getPoolChangesLite(const Crypto::Hash& tailBlockId, const std::vector
 void Core::getPoolChanges(const std::vector<Crypto::Hash>& knownTxsIds, std::vector<Transaction>& addedTxs,
                           std::vector<Crypto::Hash>& deletedTxsIds) {
   std::vector<Crypto::Hash> addedTxsIds;
-  auto guard = m_mempool.obtainGuard();
   m_mempool.get_difference(knownTxsIds, addedTxsIds, deletedTxsIds);
+  // the pool isn't locked in between, transactions removed meanwhile are missed and just not reported
+  std::vector<Crypto::Hash> misses;
+  m_mempool.getTransactions(addedTxsIds, addedTxs, misses);
+}
+
+void Core::getPoolChangesIds(const std::vector<Crypto::Hash>& knownTxsIds, std::vector<Crypto::Hash>& addedTxsIds,
+                             std::vector<Crypto::Hash>& deletedTxsIds) {
+  m_mempool.get_difference(knownTxsIds, addedTxsIds, deletedTxsIds);
+}
+
+bool Core::getPoolChanges(const Crypto::Hash& tailBlockId, uint64_t knownPoolSequence, const std::vector<Crypto::Hash>& knownTxsIds,
+                          std::vector<Transaction>& addedTxs, std::vector<Crypto::Hash>& deletedTxsIds, uint64_t& poolSequence, bool& isFullResync) {
+  std::vector<Crypto::Hash> addedTxsIds;
+  getPoolChangesIds(knownPoolSequence, knownTxsIds, addedTxsIds, deletedTxsIds, poolSequence, isFullResync);
+  // removed meanwhile, the next delta reports them as deleted
   std::vector<Crypto::Hash> misses;
   m_mempool.getTransactions(addedTxsIds, addedTxs, misses);
-  assert(misses.empty());
+  return tailBlockId == m_blockchain.getTailId();
+}
+
+bool Core::getPoolChangesLite(const Crypto::Hash& tailBlockId, uint64_t knownPoolSequence, const std::vector<Crypto::Hash>& knownTxsIds,
+                              std::vector<TransactionPrefixInfo>& addedTxs, std::vector<Crypto::Hash>& deletedTxsIds, uint64_t& poolSequence, bool& isFullResync) {
+  std::vector<Transaction> added;
+  bool returnStatus = getPoolChanges(tailBlockId, knownPoolSequence, knownTxsIds, added, deletedTxsIds, poolSequence, isFullResync);
+
+  for (const auto& tx : added) {
+    TransactionPrefixInfo tpi;
+    tpi.txPrefix = tx;
+    tpi.txHash = getObjectHash(tx);
+
+    addedTxs.push_back(std::move(tpi));
+  }
+
+  return returnStatus;
+}
+
+void Core::getPoolChangesIds(uint64_t knownPoolSequence, const std::vector<Crypto::Hash>& knownTxsIds, std::vector<Crypto::Hash>& addedTxsIds,
+                             std::vector<Crypto::Hash>& deletedTxsIds, uint64_t& poolSequence, bool& isFullResync) {
+  if (knownPoolSequence == 0) {
+    m_mempool.get_difference(knownTxsIds, addedTxsIds, deletedTxsIds, poolSequence);
+    isFullResync = false;
+  } else {
+    isFullResync = !m_mempool.get_changes_since(knownPoolSequence, addedTxsIds, deletedTxsIds, poolSequence);
+  }
 }
 
 bool Core::handle_incoming_block_blob(const BinaryArray& block_blob, block_verification_context& bvc, bool control_miner, bool relay_block) {
@@ -730,6 +846,10 @@ bool Core::handle_incoming_block_blob(const BinaryArray& block_blob, block_verif
   return handle_incoming_block(b, bvc, control_miner, relay_block);
 }
 
+bool Core::prevalidateBlock(const Block& b, size_t cumulativeSize) {
+  return m_blockchain.prevalidateBlock(b, get_block_hash(b), cumulativeSize);
+}
+
 bool Core::handle_incoming_block(const Block& b, block_verification_context& bvc, bool control_miner, bool relay_block) {
   if (control_miner) {
     pause_mining();
@@ -779,6 +899,14 @@ size_t Core::getPoolTransactionsCount() {
   return m_mempool.get_transactions_count();
 }
 
+uint64_t Core::getPoolSize() {
+  return m_mempool.getSize();
+}
+
+uint64_t Core::getPoolMinimalFeePerByte() {
+  return m_mempool.getMinimalFeePerByte();
+}
+
 bool Core::have_block(const Crypto::Hash& id) {
   return m_blockchain.haveBlock(id);
 }
@@ -901,6 +1029,7 @@ bool Core::removeObserver(ICoreObserver* observer) {
 }
 
 void Core::blockchainUpdated() {
+  invalidateBlockTemplate();
   m_observerManager.notify(&ICoreObserver::blockchainUpdated);
 }
 
@@ -909,9 +1038,14 @@ void Core::txDeletedFromPool() {
 }
 
 void Core::poolUpdated() {
+  invalidateBlockTemplate();
   m_observerManager.notify(&ICoreObserver::poolUpdated);
 }
 
+void Core::invalidateBlockTemplate() {
+  ++m_blockTemplateRevision;
+}
+
 bool Core::queryBlocks(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp,
   uint32_t& resStartHeight, uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockFullInfo>& entries) {
 
@@ -1031,36 +1165,15 @@ bool Core::queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockIds, uint6
     return true;
   }
 
-  std::list<Block> blocks;
-  lbs->getBlocks(resFullOffset, blocksLeft, blocks);
-
-  for (auto& b : blocks) {
-    BlockShortInfo item;
-
-    item.blockId = get_block_hash(b);
-
-    if (b.timestamp >= timestamp) {
-      std::list<Transaction> txs;
-      std::list<Crypto::Hash> missedTxs;
-      lbs->getTransactions(b.transactionHashes, txs, missedTxs);
-
-      item.block = asString(toBinaryArray(b));
-
-      for (const auto& tx: txs) {
-        TransactionPrefixInfo info;
-        info.txPrefix = tx;
-        info.txHash = getObjectHash(tx);
-
-        item.txPrefixes.push_back(std::move(info));
-      }
-    }
-
-    entries.push_back(std::move(item));
-  }
+  lbs->getRawBlocksLite(resFullOffset, blocksLeft, timestamp, entries);
 
   return true;
 }
 
+bool Core::getRawBlocks(uint32_t startIndex, uint32_t count, std::vector<block_complete_entry>& blocks) {
+  return m_blockchain.getRawBlocks(startIndex, count, blocks);
+}
+
 bool Core::getBackwardBlocksSizes(uint32_t fromHeight, std::vector<size_t>& sizes, size_t count) {
   return m_blockchain.getBackwardBlocksSize(fromHeight, sizes, count);
 }
@@ -1069,6 +1182,10 @@ bool Core::getBlockSize(const Crypto::Hash& hash, size_t& size) {
   return m_blockchain.getBlockSize(hash, size);
 }
 
+bool Core::getBlockProofOfWork(const Crypto::Hash& hash, Crypto::Hash& proofOfWork) {
+  return m_blockchain.getBlockProofOfWork(hash, proofOfWork);
+}
+
 bool Core::getAlreadyGeneratedCoins(const Crypto::Hash& hash, uint64_t& generatedCoins) {
   return m_blockchain.getAlreadyGeneratedCoins(hash, generatedCoins);
 }
@@ -1096,7 +1213,9 @@ bool Core::scanOutputkeysForIndices(const KeyInput& txInToKey, std::list<std::pa
 }
 
 bool Core::getBlockTimestamp(uint32_t height, uint64_t& timestamp) {
-  if (height > getCurrentBlockchainHeight()) {
+  // the height is checked under the same lock, a block can't be popped between the check and the read
+  LockedBlockchainStorage lbs(m_blockchain);
+  if (height >= getCurrentBlockchainHeight()) {
     return false;
   }
 
@@ -1268,6 +1387,10 @@ bool Core::getPaymentId(const Transaction& transaction, Crypto::Hash& paymentId)
 }
 
 bool Core::handleIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height) {
+  static Common::MetricsHistogram& admissionMetric = Common::MetricsRegistry::instance().histogram("txpool_admission_duration_us");
+  // transactions of a block being pushed are accounted in block validation
+  std::unique_ptr<Common::MetricsTimer> admissionTimer(keptByBlock ? nullptr : new Common::MetricsTimer(admissionMetric));
+
   if (!check_tx_syntax(tx, txHash)) {
     logger(INFO) << "WRONG TRANSACTION BLOB, Failed to check tx " << txHash << " syntax, rejected";
     tvc.m_verification_failed = true;
@@ -1394,6 +1517,8 @@ bool Core::removeMessageQueue(MessageQueue<BlockchainMessage>& messageQueue) {
 void Core::rollbackBlockchain(const uint32_t height) {
   logger(INFO, BRIGHT_YELLOW) << "Rewinding blockchain to height: " << height;
   m_blockchain.rollbackBlockchainTo(height);
+  m_mempool.on_blockchain_dec(m_blockchain.getCurrentBlockchainHeight(), m_blockchain.getTailId());
+  invalidateBlockTemplate();
 }
 
 bool Core::saveBlockchain() {
@@ -18,7 +18,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <ctime>
+#include <mutex>
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/variables_map.hpp>
 #include "BlockchainExplorerData.h"
@@ -53,6 +55,7 @@ namespace CryptoNote {
      virtual bool handle_incoming_tx(const BinaryArray& tx_blob, tx_verification_context& tvc, bool keeped_by_block) override; //Deprecated. Should be removed with CryptoNoteProtocolHandler.
      bool handle_incoming_block_blob(const BinaryArray& block_blob, block_verification_context& bvc, bool control_miner, bool relay_block) override;
      bool handle_incoming_block(const Block& b, block_verification_context& bvc, bool control_miner, bool relay_block) override;
+     bool prevalidateBlock(const Block& b, size_t cumulativeSize) override;
      virtual i_cryptonote_protocol* get_protocol() override {return m_pprotocol;}
      const Currency& currency() const { return m_currency; }
 
@@ -74,6 +77,7 @@ namespace CryptoNote {
      virtual bool handle_get_objects(NOTIFY_REQUEST_GET_OBJECTS_request& arg, NOTIFY_RESPONSE_GET_OBJECTS_request& rsp) override; //Deprecated. Should be removed with CryptoNoteProtocolHandler.
      virtual bool getBackwardBlocksSizes(uint32_t fromHeight, std::vector<size_t>& sizes, size_t count) override;
      virtual bool getBlockSize(const Crypto::Hash& hash, size_t& size) override;
+     virtual bool getBlockProofOfWork(const Crypto::Hash& hash, Crypto::Hash& proofOfWork) override;
      virtual bool getAlreadyGeneratedCoins(const Crypto::Hash& hash, uint64_t& generatedCoins) override;
      virtual bool getBlockReward(uint8_t blockMajorVersion, size_t medianSize, size_t currentBlockSize, uint64_t alreadyGeneratedCoins, uint64_t fee,
                                  uint64_t& reward, int64_t& emissionChange) override;
@@ -127,6 +131,7 @@ namespace CryptoNote {
        uint32_t& start_height, uint32_t& current_height, uint32_t& full_offset, std::vector<BlockFullInfo>& entries) override;
      virtual bool queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp,
        uint32_t& resStartHeight, uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockShortInfo>& entries) override;
+     virtual bool getRawBlocks(uint32_t startIndex, uint32_t count, std::vector<block_complete_entry>& blocks) override;
      virtual Crypto::Hash getBlockIdByHeight(uint32_t height) override;
      void getTransactions(const std::vector<Crypto::Hash>& txs_ids, std::list<Transaction>& txs, std::list<Crypto::Hash>& missed_txs, bool checkTxPool = false) override;
      virtual bool getTransactionsWithOutputGlobalIndexes(const std::vector<Crypto::Hash>& txs_ids, std::list<Crypto::Hash>& missed_txs, std::vector<std::pair<Transaction, std::vector<uint32_t>>>& txs) override;
@@ -146,6 +151,9 @@ namespace CryptoNote {
      std::vector<Transaction> getPoolTransactions() override;
      bool getPoolTransaction(const Crypto::Hash& tx_hash, Transaction& transaction) override;
      virtual size_t getPoolTransactionsCount() override;
+     // bytes of transaction blobs
+     uint64_t getPoolSize();
+     uint64_t getPoolMinimalFeePerByte();
      virtual size_t getBlockchainTotalTransactions() override;
      //bool get_outs(uint64_t amount, std::list<Crypto::PublicKey>& pkeys);
      virtual std::vector<Crypto::Hash> findBlockchainSupplement(const std::vector<Crypto::Hash>& remoteBlockIds, size_t maxCount,
@@ -171,6 +179,16 @@ namespace CryptoNote {
                                   std::vector<TransactionPrefixInfo>& addedTxs, std::vector<Crypto::Hash>& deletedTxsIds) override;
      virtual void getPoolChanges(const std::vector<Crypto::Hash>& knownTxsIds, std::vector<Transaction>& addedTxs,
                                  std::vector<Crypto::Hash>& deletedTxsIds) override;
+     void getPoolChangesIds(const std::vector<Crypto::Hash>& knownTxsIds, std::vector<Crypto::Hash>& addedTxsIds,
+                            std::vector<Crypto::Hash>& deletedTxsIds);
+     // Changes after number knownPoolSequence of the pool journal, relative to knownTxsIds when it is 0. poolSequence
+     // gets the number to ask with next time, isFullResync is set when the added ones are the whole pool instead of a delta.
+     bool getPoolChanges(const Crypto::Hash& tailBlockId, uint64_t knownPoolSequence, const std::vector<Crypto::Hash>& knownTxsIds,
+                         std::vector<Transaction>& addedTxs, std::vector<Crypto::Hash>& deletedTxsIds, uint64_t& poolSequence, bool& isFullResync);
+     bool getPoolChangesLite(const Crypto::Hash& tailBlockId, uint64_t knownPoolSequence, const std::vector<Crypto::Hash>& knownTxsIds,
+                             std::vector<TransactionPrefixInfo>& addedTxs, std::vector<Crypto::Hash>& deletedTxsIds, uint64_t& poolSequence, bool& isFullResync);
+     void getPoolChangesIds(uint64_t knownPoolSequence, const std::vector<Crypto::Hash>& knownTxsIds, std::vector<Crypto::Hash>& addedTxsIds,
+                            std::vector<Crypto::Hash>& deletedTxsIds, uint64_t& poolSequence, bool& isFullResync);
 
      virtual void rollbackBlockchain(const uint32_t height) override;
 
@@ -187,6 +205,25 @@ namespace CryptoNote {
      bool is_tx_spendtime_unlocked(uint64_t unlock_time, uint32_t height);
 
    private:
+     // Part of a block template shared by all miners until the chain or the pool changes,
+     // only the miner transaction and the timestamp are made per request
+     struct BlockTemplateSkeleton {
+       Block block;
+       difficulty_type difficulty;
+       uint32_t height;
+       uint64_t minimalTimestamp;
+       size_t medianSize;
+       uint64_t alreadyGeneratedCoins;
+       size_t transactionsSize;
+       uint64_t fee;
+     };
+
+     // called with the pool, blockchain and m_blockTemplateLock locks held in this order, rebuilds the skeleton if the chain or the pool changed
+     bool updateBlockTemplateSkeleton();
+     bool buildBlockTemplateSkeleton(BlockTemplateSkeleton& skeleton);
+     bool constructBlockTemplateMinerTx(const BlockTemplateSkeleton& skeleton, const AccountPublicAddress& adr, const BinaryArray& ex_nonce, Transaction& minerTx);
+     void invalidateBlockTemplate();
+
      bool add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block);
      bool load_state_data();
      bool parse_tx_from_blob(Transaction& tx, Crypto::Hash& tx_hash, Crypto::Hash& tx_prefix_hash, const BinaryArray& blob);
@@ -226,5 +263,17 @@ namespace CryptoNote {
      std::atomic<bool> m_starter_message_showed;
      Tools::ObserverManager<ICoreObserver> m_observerManager;
      time_t start_time;
+
+     std::mutex m_blockTemplateLock;
+     BlockTemplateSkeleton m_blockTemplateSkeleton;
+     bool m_blockTemplateSkeletonValid;
+     uint64_t m_blockTemplateSkeletonRevision;
+     // miner transaction of the last request on top of the skeleton
+     Transaction m_blockTemplateMinerTx;
+     AccountPublicAddress m_blockTemplateMinerAddress;
+     size_t m_blockTemplateExtraNonceSize;
+     bool m_blockTemplateMinerTxValid;
+     // incremented by every chain or pool change, a skeleton built at an older revision is rebuilt
+     std::atomic<uint64_t> m_blockTemplateRevision;
    };
 }
@@ -19,10 +19,17 @@
 
 #include "Common/Util.h"
 #include "Common/CommandLine.h"
+#include "CryptoNoteConfig.h"
 
 namespace CryptoNote {
 
-CoreConfig::CoreConfig() {
+namespace {
+
+const command_line::arg_descriptor<uint64_t> arg_txpool_max_size = { "txpool-max-size", "Size of the transaction pool in megabytes above which the transactions paying the least per byte are evicted, 0 for no limit", parameters::CRYPTONOTE_MEMPOOL_MAX_SIZE };
+
+}
+
+CoreConfig::CoreConfig() : txPoolMaxSize(parameters::CRYPTONOTE_MEMPOOL_MAX_SIZE * 1024 * 1024) {
   configFolder = Tools::getDefaultDataDirectory();
 }
 
@@ -31,8 +38,13 @@ void CoreConfig::init(const boost::program_options::variables_map& options) {
     configFolder = command_line::get_arg(options, command_line::arg_data_dir);
     configFolderDefaulted = options[command_line::arg_data_dir.name].defaulted();
   }
+
+  if (options.count(arg_txpool_max_size.name) != 0 && !options[arg_txpool_max_size.name].defaulted()) {
+    txPoolMaxSize = command_line::get_arg(options, arg_txpool_max_size) * 1024 * 1024;
+  }
 }
 
 void CoreConfig::initOptions(boost::program_options::options_description& desc) {
+  command_line::add_arg(desc, arg_txpool_max_size);
 }
 } //namespace CryptoNote
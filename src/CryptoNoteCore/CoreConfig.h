@@ -32,6 +32,8 @@ public:
 
   std::string configFolder;
   bool configFolderDefaulted = true;
+  // bytes, 0 for no limit
+  uint64_t txPoolMaxSize;
 };
 
 } //namespace CryptoNote
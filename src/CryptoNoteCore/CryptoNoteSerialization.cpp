@@ -65,66 +65,65 @@ struct BinaryVariantTagGetter: boost::static_visitor<uint8_t> {
   uint8_t operator()(const CryptoNote::Block) { return  0xbb; }
 };
 
+template <typename Serializer>
 struct VariantSerializer : boost::static_visitor<> {
-  VariantSerializer(CryptoNote::ISerializer& serializer, const std::string& name) : s(serializer), name(name) {}
+  VariantSerializer(Serializer& serializer, Common::StringView name) : s(serializer), name(name) {}
 
   template <typename T>
   void operator() (T& param) { s(param, name); }
 
-  CryptoNote::ISerializer& s;
-  std::string name;
+  Serializer& s;
+  Common::StringView name;
 };
 
-void getVariantValue(CryptoNote::ISerializer& serializer, uint8_t tag, CryptoNote::TransactionInput& in) {
+// Reads straight into the variant, an alternative it already holds keeps its allocated storage
+template <typename T, typename Serializer, typename Variant>
+void readVariantValue(Serializer& serializer, Variant& variant, Common::StringView name) {
+  if (variant.type() != typeid(T)) {
+    variant = T();
+  }
+
+  serializer(boost::get<T>(variant), name);
+}
+
+template <typename Serializer>
+void getVariantValue(Serializer& serializer, uint8_t tag, CryptoNote::TransactionInput& in) {
   switch(tag) {
-  case 0xff: {
-    CryptoNote::BaseInput v;
-    serializer(v, "value");
-    in = v;
+  case 0xff:
+    readVariantValue<CryptoNote::BaseInput>(serializer, in, "value");
     break;
-  }
-  case 0x2: {
-    CryptoNote::KeyInput v;
-    serializer(v, "value");
-    in = v;
+  case 0x2:
+    readVariantValue<CryptoNote::KeyInput>(serializer, in, "value");
     break;
-  }
-  case 0x3: {
-    CryptoNote::MultisignatureInput v;
-    serializer(v, "value");
-    in = v;
+  case 0x3:
+    readVariantValue<CryptoNote::MultisignatureInput>(serializer, in, "value");
     break;
-  }
   default:
     throw std::runtime_error("Unknown variant tag");
   }
 }
 
-void getVariantValue(CryptoNote::ISerializer& serializer, uint8_t tag, CryptoNote::TransactionOutputTarget& out) {
+template <typename Serializer>
+void getVariantValue(Serializer& serializer, uint8_t tag, CryptoNote::TransactionOutputTarget& out) {
   switch(tag) {
-  case 0x2: {
-    CryptoNote::KeyOutput v;
-    serializer(v, "data");
-    out = v;
+  case 0x2:
+    readVariantValue<CryptoNote::KeyOutput>(serializer, out, "data");
     break;
-  }
-  case 0x3: {
-    CryptoNote::MultisignatureOutput v;
-    serializer(v, "data");
-    out = v;
+  case 0x3:
+    readVariantValue<CryptoNote::MultisignatureOutput>(serializer, out, "data");
     break;
-  }
   default:
     throw std::runtime_error("Unknown variant tag");
   }
 }
 
-template <typename T>
-bool serializePod(T& v, Common::StringView name, CryptoNote::ISerializer& serializer) {
+template <typename T, typename Serializer>
+bool serializePod(T& v, Common::StringView name, Serializer& serializer) {
   return serializer.binary(&v, sizeof(v), name);
 }
 
-bool serializeVarintVector(std::vector<uint32_t>& vector, CryptoNote::ISerializer& serializer, Common::StringView name) {
+template <typename Serializer>
+bool serializeVarintVector(std::vector<uint32_t>& vector, Serializer& serializer, Common::StringView name) {
   size_t size = vector.size();
   
   if (!serializer.beginArray(size, name)) {
@@ -142,6 +141,11 @@ bool serializeVarintVector(std::vector<uint32_t>& vector, CryptoNote::ISerialize
   return true;
 }
 
+// Checks the size against the remaining data before resizing
+bool serializeVarintVector(std::vector<uint32_t>& vector, CryptoNote::BinaryArrayInputSerializer& serializer, Common::StringView name) {
+  return serializer(vector, name);
+}
+
 }
 
 namespace Crypto {
@@ -182,7 +186,10 @@ bool serialize(EllipticCurvePoint& ecPoint, Common::StringView name, CryptoNote:
 
 namespace CryptoNote {
 
-void serialize(TransactionPrefix& txP, ISerializer& serializer) {
+namespace {
+
+template <typename Serializer>
+void doSerialize(TransactionPrefix& txP, Serializer& serializer) {
   serializer(txP.version, "version");
 
   if (CURRENT_TRANSACTION_VERSION < txP.version) {
@@ -195,8 +202,9 @@ void serialize(TransactionPrefix& txP, ISerializer& serializer) {
   serializeAsBinary(txP.extra, "extra", serializer);
 }
 
-void serialize(Transaction& tx, ISerializer& serializer) {
-  serialize(static_cast<TransactionPrefix&>(tx), serializer);
+template <typename Serializer>
+void doSerialize(Transaction& tx, Serializer& serializer) {
+  doSerialize(static_cast<TransactionPrefix&>(tx), serializer);
 
   size_t sigSize = tx.inputs.size();
   //TODO: make arrays without sizes
@@ -204,8 +212,12 @@ void serialize(Transaction& tx, ISerializer& serializer) {
   
   //if (serializer.type() == ISerializer::INPUT) {
   // ignore base transaction
-  if (serializer.type() == ISerializer::INPUT && !(sigSize == 1 && tx.inputs[0].type() == typeid(BaseInput))) {
-    tx.signatures.resize(sigSize);
+  if (serializer.type() == ISerializer::INPUT) {
+    if (sigSize == 1 && tx.inputs[0].type() == typeid(BaseInput)) {
+      tx.signatures.clear();
+    } else {
+      tx.signatures.resize(sigSize);
+    }
   }
 
   bool signaturesNotExpected = tx.signatures.empty();
@@ -233,24 +245,23 @@ void serialize(Transaction& tx, ISerializer& serializer) {
       }
 
     } else {
-      std::vector<Crypto::Signature> signatures(signatureSize);
-      for (Crypto::Signature& sig : signatures) {
+      tx.signatures[i].resize(signatureSize);
+      for (Crypto::Signature& sig : tx.signatures[i]) {
         serializePod(sig, "", serializer);
       }
-
-      tx.signatures[i] = std::move(signatures);
     }
   }
 //  serializer.endArray();
 }
 
-void serialize(TransactionInput& in, ISerializer& serializer) {
+template <typename Serializer>
+void doSerialize(TransactionInput& in, Serializer& serializer) {
   if (serializer.type() == ISerializer::OUTPUT) {
     BinaryVariantTagGetter tagGetter;
     uint8_t tag = boost::apply_visitor(tagGetter, in);
     serializer.binary(&tag, sizeof(tag), "type");
 
-    VariantSerializer visitor(serializer, "value");
+    VariantSerializer<Serializer> visitor(serializer, "value");
     boost::apply_visitor(visitor, in);
   } else {
     uint8_t tag;
@@ -260,38 +271,39 @@ void serialize(TransactionInput& in, ISerializer& serializer) {
   }
 }
 
-void serialize(BaseInput& gen, ISerializer& serializer) {
+template <typename Serializer>
+void doSerialize(BaseInput& gen, Serializer& serializer) {
   serializer(gen.blockIndex, "height");
 }
 
-void serialize(KeyInput& key, ISerializer& serializer) {
+template <typename Serializer>
+void doSerialize(KeyInput& key, Serializer& serializer) {
   serializer(key.amount, "amount");
   serializeVarintVector(key.outputIndexes, serializer, "key_offsets");
   serializer(key.keyImage, "k_image");
 }
 
-void serialize(MultisignatureInput& multisignature, ISerializer& serializer) {
+template <typename Serializer>
+void doSerialize(MultisignatureInput& multisignature, Serializer& serializer) {
   serializer(multisignature.amount, "amount");
   serializer(multisignature.signatureCount, "signatures");
   serializer(multisignature.outputIndex, "outputIndex");
 }
 
-void serialize(TransactionInputs & inputs, ISerializer & serializer) {
-  serializer(inputs, "vin");
-}
-
-void serialize(TransactionOutput& output, ISerializer& serializer) {
+template <typename Serializer>
+void doSerialize(TransactionOutput& output, Serializer& serializer) {
   serializer(output.amount, "amount");
   serializer(output.target, "target");
 }
 
-void serialize(TransactionOutputTarget& output, ISerializer& serializer) {
+template <typename Serializer>
+void doSerialize(TransactionOutputTarget& output, Serializer& serializer) {
   if (serializer.type() == ISerializer::OUTPUT) {
     BinaryVariantTagGetter tagGetter;
     uint8_t tag = boost::apply_visitor(tagGetter, output);
     serializer.binary(&tag, sizeof(tag), "type");
 
-    VariantSerializer visitor(serializer, "data");
+    VariantSerializer<Serializer> visitor(serializer, "data");
     boost::apply_visitor(visitor, output);
   } else {
     uint8_t tag;
@@ -301,16 +313,19 @@ void serialize(TransactionOutputTarget& output, ISerializer& serializer) {
   }
 }
 
-void serialize(KeyOutput& key, ISerializer& serializer) {
+template <typename Serializer>
+void doSerialize(KeyOutput& key, Serializer& serializer) {
   serializer(key.key, "key");
 }
 
-void serialize(MultisignatureOutput& multisignature, ISerializer& serializer) {
+template <typename Serializer>
+void doSerialize(MultisignatureOutput& multisignature, Serializer& serializer) {
   serializer(multisignature.keys, "keys");
   serializer(multisignature.requiredSignatureCount, "required_signatures");
 }
 
-void serialize(ParentBlockSerializer& pbs, ISerializer& serializer) {
+template <typename Serializer>
+void doSerialize(ParentBlockSerializer& pbs, Serializer& serializer) {
   serializer(pbs.m_parentBlock.majorVersion, "majorVersion");
 
   serializer(pbs.m_parentBlock.minorVersion, "minorVersion");
@@ -382,7 +397,8 @@ void serialize(ParentBlockSerializer& pbs, ISerializer& serializer) {
   }
 }
 
-void serializeBlockHeader(BlockHeader& header, ISerializer& serializer) {
+template <typename Serializer>
+void doSerialize(BlockHeader& header, Serializer& serializer) {
   serializer(header.majorVersion, "major_version");
   if (header.majorVersion > BLOCK_MAJOR_VERSION_5) {
     throw std::runtime_error("Wrong major version");
@@ -402,22 +418,50 @@ void serializeBlockHeader(BlockHeader& header, ISerializer& serializer) {
   }
 }
 
-void serialize(BlockHeader& header, ISerializer& serializer) {
-  serializeBlockHeader(header, serializer);
-}
-
-void serialize(Block& block, ISerializer& serializer) {
-  serializeBlockHeader(block, serializer);
+template <typename Serializer>
+void doSerialize(Block& block, Serializer& serializer) {
+  doSerialize(static_cast<BlockHeader&>(block), serializer);
 
   if (block.majorVersion == BLOCK_MAJOR_VERSION_2 || block.majorVersion == BLOCK_MAJOR_VERSION_3) {
     auto parentBlockSerializer = makeParentBlockSerializer(block, false, false);
     serializer(parentBlockSerializer, "parent_block");
+  } else if (serializer.type() == ISerializer::INPUT) {
+    // the block may be read into one that had a parent block
+    block.parentBlock = ParentBlock();
   }
 
   serializer(block.baseTransaction, "miner_tx");
   serializer(block.transactionHashes, "tx_hashes");
 }
 
+}
+
+// The overloads for each serializer type share one definition
+#define SERIALIZE_WITH_DEFINITION(Type) \
+void serialize(Type& value, ISerializer& serializer) { doSerialize(value, serializer); } \
+void serialize(Type& value, BinaryArrayOutputSerializer& serializer) { doSerialize(value, serializer); } \
+void serialize(Type& value, BinaryArrayInputSerializer& serializer) { doSerialize(value, serializer); }
+
+SERIALIZE_WITH_DEFINITION(TransactionPrefix)
+SERIALIZE_WITH_DEFINITION(Transaction)
+SERIALIZE_WITH_DEFINITION(TransactionInput)
+SERIALIZE_WITH_DEFINITION(BaseInput)
+SERIALIZE_WITH_DEFINITION(KeyInput)
+SERIALIZE_WITH_DEFINITION(MultisignatureInput)
+SERIALIZE_WITH_DEFINITION(TransactionOutput)
+SERIALIZE_WITH_DEFINITION(TransactionOutputTarget)
+SERIALIZE_WITH_DEFINITION(KeyOutput)
+SERIALIZE_WITH_DEFINITION(MultisignatureOutput)
+SERIALIZE_WITH_DEFINITION(ParentBlockSerializer)
+SERIALIZE_WITH_DEFINITION(BlockHeader)
+SERIALIZE_WITH_DEFINITION(Block)
+
+#undef SERIALIZE_WITH_DEFINITION
+
+void serialize(TransactionInputs & inputs, ISerializer & serializer) {
+  serializer(inputs, "vin");
+}
+
 void serialize(AccountPublicAddress& address, ISerializer& serializer) {
   serializer(address.spendPublicKey, "m_spend_public_key");
   serializer(address.viewPublicKey, "m_view_public_key");
@@ -19,6 +19,7 @@
 
 #include "CryptoNoteBasic.h"
 #include "crypto/chacha8.h"
+#include "Serialization/BinaryArraySerializer.h"
 #include "Serialization/ISerializer.h"
 #include "crypto/crypto.h"
 
@@ -33,6 +34,30 @@ bool serialize(Signature& sig, Common::StringView name, CryptoNote::ISerializer&
 bool serialize(EllipticCurveScalar& ecScalar, Common::StringView name, CryptoNote::ISerializer& serializer);
 bool serialize(EllipticCurvePoint& ecPoint, Common::StringView name, CryptoNote::ISerializer& serializer);
 
+inline bool serialize(PublicKey& pubKey, Common::StringView name, CryptoNote::BinaryArrayOutputSerializer& serializer) {
+  return serializer.binary(&pubKey, sizeof(pubKey), name);
+}
+
+inline bool serialize(PublicKey& pubKey, Common::StringView name, CryptoNote::BinaryArrayInputSerializer& serializer) {
+  return serializer.binary(&pubKey, sizeof(pubKey), name);
+}
+
+inline bool serialize(Hash& h, Common::StringView name, CryptoNote::BinaryArrayOutputSerializer& serializer) {
+  return serializer.binary(&h, sizeof(h), name);
+}
+
+inline bool serialize(Hash& h, Common::StringView name, CryptoNote::BinaryArrayInputSerializer& serializer) {
+  return serializer.binary(&h, sizeof(h), name);
+}
+
+inline bool serialize(KeyImage& keyImage, Common::StringView name, CryptoNote::BinaryArrayOutputSerializer& serializer) {
+  return serializer.binary(&keyImage, sizeof(keyImage), name);
+}
+
+inline bool serialize(KeyImage& keyImage, Common::StringView name, CryptoNote::BinaryArrayInputSerializer& serializer) {
+  return serializer.binary(&keyImage, sizeof(keyImage), name);
+}
+
 }
 
 namespace CryptoNote {
@@ -61,6 +86,35 @@ void serialize(Block& block, ISerializer& serializer);
 void serialize(ParentBlockSerializer& pbs, ISerializer& serializer);
 void serialize(TransactionExtraMergeMiningTag& tag, ISerializer& serializer);
 
+// Blocks and transactions have the same definitions instantiated for the non-virtual binary serializers,
+// toBinaryArray, fromBinaryArray and getObjectHash use them.
+void serialize(TransactionPrefix& txP, BinaryArrayOutputSerializer& serializer);
+void serialize(TransactionPrefix& txP, BinaryArrayInputSerializer& serializer);
+void serialize(Transaction& tx, BinaryArrayOutputSerializer& serializer);
+void serialize(Transaction& tx, BinaryArrayInputSerializer& serializer);
+void serialize(TransactionInput& in, BinaryArrayOutputSerializer& serializer);
+void serialize(TransactionInput& in, BinaryArrayInputSerializer& serializer);
+void serialize(BaseInput& gen, BinaryArrayOutputSerializer& serializer);
+void serialize(BaseInput& gen, BinaryArrayInputSerializer& serializer);
+void serialize(KeyInput& key, BinaryArrayOutputSerializer& serializer);
+void serialize(KeyInput& key, BinaryArrayInputSerializer& serializer);
+void serialize(MultisignatureInput& multisignature, BinaryArrayOutputSerializer& serializer);
+void serialize(MultisignatureInput& multisignature, BinaryArrayInputSerializer& serializer);
+void serialize(TransactionOutput& output, BinaryArrayOutputSerializer& serializer);
+void serialize(TransactionOutput& output, BinaryArrayInputSerializer& serializer);
+void serialize(TransactionOutputTarget& output, BinaryArrayOutputSerializer& serializer);
+void serialize(TransactionOutputTarget& output, BinaryArrayInputSerializer& serializer);
+void serialize(KeyOutput& key, BinaryArrayOutputSerializer& serializer);
+void serialize(KeyOutput& key, BinaryArrayInputSerializer& serializer);
+void serialize(MultisignatureOutput& multisignature, BinaryArrayOutputSerializer& serializer);
+void serialize(MultisignatureOutput& multisignature, BinaryArrayInputSerializer& serializer);
+void serialize(BlockHeader& header, BinaryArrayOutputSerializer& serializer);
+void serialize(BlockHeader& header, BinaryArrayInputSerializer& serializer);
+void serialize(Block& block, BinaryArrayOutputSerializer& serializer);
+void serialize(Block& block, BinaryArrayInputSerializer& serializer);
+void serialize(ParentBlockSerializer& pbs, BinaryArrayOutputSerializer& serializer);
+void serialize(ParentBlockSerializer& pbs, BinaryArrayInputSerializer& serializer);
+
 void serialize(AccountPublicAddress& address, ISerializer& serializer);
 void serialize(AccountKeys& keys, ISerializer& s);
 
@@ -19,6 +19,72 @@
 #include "CryptoNoteFormatUtils.h"
 
 namespace CryptoNote {
+
+namespace {
+
+template<class T>
+bool toBinaryArrayDirect(const T& object, BinaryArray& binaryArray) {
+  try {
+    BinaryArrayOutputSerializer serializer(binaryArray);
+    serialize(const_cast<T&>(object), serializer);
+  } catch (std::exception&) {
+    return false;
+  }
+
+  return true;
+}
+
+template<class T>
+bool fromBinaryArrayDirect(T& object, const BinaryArray& binaryArray) {
+  bool result = false;
+  try {
+    BinaryArrayInputSerializer serializer(binaryArray.data(), binaryArray.size());
+    serialize(object, serializer);
+    result = serializer.endOfStream(); // check that all data was consumed
+  } catch (std::exception&) {
+  }
+
+  return result;
+}
+
+}
+
+bool toBinaryArray(const TransactionPrefix& object, BinaryArray& binaryArray) {
+  return toBinaryArrayDirect(object, binaryArray);
+}
+
+bool toBinaryArray(const Transaction& object, BinaryArray& binaryArray) {
+  return toBinaryArrayDirect(object, binaryArray);
+}
+
+bool toBinaryArray(const BlockHeader& object, BinaryArray& binaryArray) {
+  return toBinaryArrayDirect(object, binaryArray);
+}
+
+bool toBinaryArray(const Block& object, BinaryArray& binaryArray) {
+  return toBinaryArrayDirect(object, binaryArray);
+}
+
+bool toBinaryArray(const ParentBlockSerializer& object, BinaryArray& binaryArray) {
+  return toBinaryArrayDirect(object, binaryArray);
+}
+
+bool fromBinaryArray(TransactionPrefix& object, const BinaryArray& binaryArray) {
+  return fromBinaryArrayDirect(object, binaryArray);
+}
+
+bool fromBinaryArray(Transaction& object, const BinaryArray& binaryArray) {
+  return fromBinaryArrayDirect(object, binaryArray);
+}
+
+bool fromBinaryArray(BlockHeader& object, const BinaryArray& binaryArray) {
+  return fromBinaryArrayDirect(object, binaryArray);
+}
+
+bool fromBinaryArray(Block& object, const BinaryArray& binaryArray) {
+  return fromBinaryArrayDirect(object, binaryArray);
+}
+
 template<>
 bool toBinaryArray(const BinaryArray& object, BinaryArray& binaryArray) {
   try {
@@ -30,6 +30,18 @@ namespace CryptoNote {
 void getBinaryArrayHash(const BinaryArray& binaryArray, Crypto::Hash& hash);
 Crypto::Hash getBinaryArrayHash(const BinaryArray& binaryArray);
 
+// Blocks and transactions go through BinaryArrayOutputSerializer and BinaryArrayInputSerializer,
+// the bytes are the same as those of the stream serializers
+bool toBinaryArray(const TransactionPrefix& object, BinaryArray& binaryArray);
+bool toBinaryArray(const Transaction& object, BinaryArray& binaryArray);
+bool toBinaryArray(const BlockHeader& object, BinaryArray& binaryArray);
+bool toBinaryArray(const Block& object, BinaryArray& binaryArray);
+bool toBinaryArray(const ParentBlockSerializer& object, BinaryArray& binaryArray);
+bool fromBinaryArray(TransactionPrefix& object, const BinaryArray& binaryArray);
+bool fromBinaryArray(Transaction& object, const BinaryArray& binaryArray);
+bool fromBinaryArray(BlockHeader& object, const BinaryArray& binaryArray);
+bool fromBinaryArray(Block& object, const BinaryArray& binaryArray);
+
 template<class T>
 bool toBinaryArray(const T& object, BinaryArray& binaryArray) {
   try {
@@ -30,10 +30,8 @@
 #include <string>
 #include <vector>
 
-#include "Common/StdInputStream.h"
-#include "Common/StdOutputStream.h"
-#include "Serialization/BinaryInputStreamSerializer.h"
-#include "Serialization/BinaryOutputStreamSerializer.h"
+#include "Common/Metrics.h"
+#include "Serialization/BinaryArraySerializer.h"
 
 template<class T> class SwappedVector {
 public:
@@ -159,6 +157,8 @@ public:
   const_iterator begin();
   const_iterator end();
   const T& operator[](uint64_t index);
+  // Stored bytes of the item, read from the file without parsing it or touching the cache
+  void getRaw(uint64_t index, std::string& data);
   const T& front();
   const T& back();
   void clear();
@@ -187,13 +187,18 @@ private:
   uint64_t m_itemsFileSize;
   std::map<uint64_t, ItemEntry> m_items;
   std::list<CacheEntry> m_cache;
+  std::string m_readBuffer;
   uint64_t m_cacheHits;
   uint64_t m_cacheMisses;
+  Common::MetricsCounter& m_cacheHitsMetric;
+  Common::MetricsCounter& m_cacheMissesMetric;
 
   T* prepare(uint64_t index);
 };
 
-template<class T> SwappedVector<T>::SwappedVector() {
+template<class T> SwappedVector<T>::SwappedVector() :
+  m_cacheHitsMetric(Common::MetricsRegistry::instance().counter("swapped_vector_cache_hits_total")),
+  m_cacheMissesMetric(Common::MetricsRegistry::instance().counter("swapped_vector_cache_misses_total")) {
 }
 
 template<class T> SwappedVector<T>::~SwappedVector() {
@@ -292,6 +297,7 @@ template<class T> const T& SwappedVector<T>::operator[](uint64_t index) {
     }
 
     ++m_cacheHits;
+    m_cacheHitsMetric.add();
     return itemIter->second.item;
   }
 
@@ -299,23 +305,45 @@ template<class T> const T& SwappedVector<T>::operator[](uint64_t index) {
     throw std::runtime_error("SwappedVector::operator[]");
   }
 
-  if (!m_itemsFile) {
-    throw std::runtime_error("SwappedVector::operator[]");
-  }
+  getRaw(index, m_readBuffer);
 
-  m_itemsFile.seekg(m_offsets[index]);
+  // the item about to be evicted is read over, so its vectors are reused rather than allocated again
   T tempItem;
-  
-  Common::StdInputStream stream(m_itemsFile);
-  CryptoNote::BinaryInputStreamSerializer archive(stream);
+  if (m_items.size() == m_poolSize) {
+    auto cacheIter = m_cache.begin();
+    tempItem = std::move(cacheIter->itemIter->second.item);
+    m_items.erase(cacheIter->itemIter);
+    m_cache.erase(cacheIter);
+  }
+
+  CryptoNote::BinaryArrayInputSerializer archive(m_readBuffer.data(), m_readBuffer.size());
   serialize(tempItem, archive);
 
   T* item = prepare(index);
   std::swap(tempItem, *item);
   ++m_cacheMisses;
+  m_cacheMissesMetric.add();
   return *item;
 }
 
+template<class T> void SwappedVector<T>::getRaw(uint64_t index, std::string& data) {
+  if (index >= m_offsets.size()) {
+    throw std::runtime_error("SwappedVector::getRaw");
+  }
+
+  if (!m_itemsFile) {
+    throw std::runtime_error("SwappedVector::getRaw");
+  }
+
+  uint64_t end = index + 1 < m_offsets.size() ? m_offsets[index + 1] : m_itemsFileSize;
+  data.resize(static_cast<size_t>(end - m_offsets[index]));
+  m_itemsFile.seekg(m_offsets[index]);
+  m_itemsFile.read(&data[0], data.size());
+  if (!m_itemsFile) {
+    throw std::runtime_error("SwappedVector::getRaw");
+  }
+}
+
 template<class T> const T& SwappedVector<T>::front() {
   return operator[](0);
 }
@@ -371,12 +399,16 @@ template<class T> void SwappedVector<T>::push_back(const T& item) {
       throw std::runtime_error("SwappedVector::push_back");
     }
 
-    m_itemsFile.seekp(m_itemsFileSize);
-
-    Common::StdOutputStream stream(m_itemsFile);
-    CryptoNote::BinaryOutputStreamSerializer archive(stream);
+    std::vector<uint8_t> data;
+    CryptoNote::BinaryArrayOutputSerializer archive(data);
     serialize(const_cast<T&>(item), archive);
 
+    m_itemsFile.seekp(m_itemsFileSize);
+    m_itemsFile.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if (!m_itemsFile) {
+      throw std::runtime_error("SwappedVector::push_back");
+    }
+
     itemsFileSize = m_itemsFile.tellp();
   }
 
@@ -27,6 +27,7 @@
 #include <boost/filesystem.hpp>
 
 #include "Common/int-util.h"
+#include "Common/Metrics.h"
 #include "Common/Util.h"
 #include "crypto/hash.h"
 
@@ -99,7 +100,26 @@ namespace CryptoNote {
 
   using CryptoNote::BlockInfo;
 
-  std::unordered_set<Crypto::Hash> m_validated_transactions;
+  namespace {
+
+  // changes kept for clients syncing by sequence number, older ones need a full resync
+  const size_t POOL_CHANGES_JOURNAL_SIZE = 50000;
+
+  }
+
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::ReadyTransactionComparator::operator()(const TransactionDetails* lhs, const TransactionDetails* rhs) const {
+    TransactionPriorityComparator priority;
+    if (priority(*lhs, *rhs)) {
+      return true;
+    }
+
+    if (priority(*rhs, *lhs)) {
+      return false;
+    }
+
+    return memcmp(&lhs->id, &rhs->id, sizeof(lhs->id)) < 0;
+  }
 
   //---------------------------------------------------------------------------------
   tx_memory_pool::tx_memory_pool(
@@ -115,7 +135,13 @@ namespace CryptoNote {
     m_timeProvider(timeProvider), 
     m_txCheckInterval(60, timeProvider),
     m_fee_index(boost::get<1>(m_transactions)),
+    m_size(0),
+    m_maxSize(parameters::CRYPTONOTE_MEMPOOL_MAX_SIZE * 1024 * 1024),
+    m_validationGeneration(0),
+    // numbering starts from the time, so numbers a client got before a restart fall out of the journal
+    m_lastChangeSequence(static_cast<uint64_t>(std::time(nullptr)) << 20),
     logger(log, "txpool"),
+    m_journal(timeProvider, currency.numberOfPeriodsToForgetTxDeletedFromPool() * currency.mempoolTxLiveTime(), log),
     m_paymentIdIndex(blockchainIndexesEnabled),
     m_timestampIndex(blockchainIndexesEnabled) {
   }
@@ -144,9 +170,20 @@ namespace CryptoNote {
     const uint64_t fee = inputs_amount - outputs_amount;
     bool isFusionTransaction = fee == 0 && m_currency.isFusionTransaction(tx, blobSize, m_core.getCurrentBlockchainHeight());
 
+    uint64_t validationGeneration;
+    {
+      std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+      validationGeneration = m_validationGeneration;
+    }
+
     //check key images for transaction if it is not kept by block
     if (!keptByBlock) {
       std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+      if (m_transactions.count(id) != 0) {
+        logger(TRACE) << "tx " << id << " is already in transaction pool";
+        return true;
+      }
+
       if (haveSpentInputs(tx)) {
         logger(INFO) << "Transaction with id= " << id << " used already spent inputs";
         tvc.m_verification_failed = true;
@@ -156,7 +193,7 @@ namespace CryptoNote {
 
     BlockInfo maxUsedBlock;
 
-    // check inputs
+    // check inputs, the pool isn't locked while signatures are verified so concurrent admissions run in parallel
     bool inputsValid = m_validator.checkTransactionInputs(tx, maxUsedBlock);
 
     if (!inputsValid) {
@@ -189,6 +226,23 @@ namespace CryptoNote {
       return true;
     }
 
+    // the same transaction may have been admitted by another thread during verification
+    if (m_transactions.count(id) != 0) {
+      logger(TRACE) << "tx " << id << " is already in transaction pool";
+      tvc.m_verification_failed = false;
+      tvc.m_should_be_relayed = false;
+      tvc.m_added_to_pool = false;
+      return true;
+    }
+
+    // inputs could have been spent meanwhile by a transaction admitted concurrently or by a new block,
+    // blocks are pushed under the pool lock so this check can't be outdated again
+    if (!keptByBlock && (haveSpentInputs(tx) || m_validator.haveSpentKeyImages(tx))) {
+      logger(INFO) << "Transaction with id= " << id << " used already spent inputs";
+      tvc.m_verification_failed = true;
+      return false;
+    }
+
     // add to pool
     {
       TransactionDetails txd;
@@ -203,13 +257,34 @@ namespace CryptoNote {
       txd.maxUsedBlock = maxUsedBlock;
       txd.lastFailedBlock.clear();
 
+      if (!makeRoom(blobSize, &txd)) {
+        logger(DEBUGGING) << "Transaction " << id << " pays too little per byte to get into the full pool";
+        tvc.m_verification_failed = true;
+        tvc.m_tx_fee_too_small = true;
+        return false;
+      }
+
       auto txd_p = m_transactions.insert(txd);
       if (!(txd_p.second)) {
         logger(ERROR, BRIGHT_RED) << "transaction already exists at inserting in memory pool";
         return false;
       }
+      m_size += blobSize;
+      if (m_journal.isOpen()) {
+        m_journal.add(id, toBinaryArray(*txd_p.first));
+      }
+
       m_paymentIdIndex.add(tx);
       m_timestampIndex.add(txd.receiveTime, txd.id);
+
+      // inputs checked against a chain that has changed since are checked again before getting into templates
+      if (!inputsValid) {
+        m_failedTransactions.insert(id);
+      } else if (validationGeneration != m_validationGeneration) {
+        m_pendingTransactions.insert(id);
+      } else {
+        addReadyTransaction(*txd_p.first);
+      }
     }
 
     tvc.m_added_to_pool = true;
@@ -294,20 +369,22 @@ namespace CryptoNote {
   }
 
   //---------------------------------------------------------------------------------
-  void tx_memory_pool::get_difference(const std::vector<Crypto::Hash>& known_tx_ids, std::vector<Crypto::Hash>& new_tx_ids, std::vector<Crypto::Hash>& deleted_tx_ids) const {
-    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+  void tx_memory_pool::get_difference(const std::vector<Crypto::Hash>& known_tx_ids, std::vector<Crypto::Hash>& new_tx_ids, std::vector<Crypto::Hash>& deleted_tx_ids) {
+    uint64_t sequence;
+    get_difference(known_tx_ids, new_tx_ids, deleted_tx_ids, sequence);
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::get_difference(const std::vector<Crypto::Hash>& known_tx_ids, std::vector<Crypto::Hash>& new_tx_ids, std::vector<Crypto::Hash>& deleted_tx_ids, uint64_t& sequence) {
+    validatePendingTransactions();
+
     std::unordered_set<Crypto::Hash> ready_tx_ids;
-    for (const auto& tx : m_transactions) {
-      TransactionCheckInfo checkInfo(tx);
-	  if (m_validated_transactions.find(tx.id) != m_validated_transactions.end()) {
-		  ready_tx_ids.insert(tx.id);
-		  logger(TRACE) << "MemPool - tx " << tx.id << " loaded from cache";
-	  }
-	  else if (is_transaction_ready_to_go(tx.tx, checkInfo)) {
-		  ready_tx_ids.insert(tx.id);
-		  m_validated_transactions.insert(tx.id);
-		  logger(TRACE) << "MemPool - tx " << tx.id << " added to cache";
-	  }
+    {
+      std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+      for (const TransactionDetails* txd : m_readyTransactions) {
+        ready_tx_ids.insert(txd->id);
+      }
+
+      sequence = m_lastChangeSequence;
     }
 
     std::unordered_set<Crypto::Hash> known_set(known_tx_ids.begin(), known_tx_ids.end());
@@ -326,21 +403,80 @@ namespace CryptoNote {
     deleted_tx_ids.assign(known_set.begin(), known_set.end());
   }
   //---------------------------------------------------------------------------------
+  bool tx_memory_pool::get_changes_since(uint64_t known_sequence, std::vector<Crypto::Hash>& new_tx_ids, std::vector<Crypto::Hash>& deleted_tx_ids, uint64_t& sequence) {
+    validatePendingTransactions();
+
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    sequence = m_lastChangeSequence;
+    uint64_t firstKnownSequence = m_changes.empty() ? m_lastChangeSequence : m_changes.front().sequence - 1;
+    if (known_sequence < firstKnownSequence || known_sequence > m_lastChangeSequence) {
+      new_tx_ids.reserve(m_readyTransactions.size());
+      for (const TransactionDetails* txd : m_readyTransactions) {
+        new_tx_ids.push_back(txd->id);
+      }
+
+      return false;
+    }
+
+    // only the first and the last change of a transaction matter: added and removed again was never seen,
+    // removed and added back is still known
+    std::unordered_map<Crypto::Hash, std::pair<bool, bool>> changes;
+    for (auto it = m_changes.begin() + static_cast<ptrdiff_t>(known_sequence - firstKnownSequence); it != m_changes.end(); ++it) {
+      auto result = changes.emplace(it->id, std::make_pair(it->added, it->added));
+      result.first->second.second = it->added;
+    }
+
+    for (const auto& change : changes) {
+      if (change.second.first && change.second.second) {
+        new_tx_ids.push_back(change.first);
+      } else if (!change.second.first && !change.second.second) {
+        deleted_tx_ids.push_back(change.first);
+      }
+    }
+
+    return true;
+  }
+  //---------------------------------------------------------------------------------
   bool tx_memory_pool::on_blockchain_inc(uint64_t new_block_height, const Crypto::Hash& top_block_id) {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
-    if (!m_validated_transactions.empty()) {
-      logger(DEBUGGING) << "MemPool - Block height incremented, cleared " << m_validated_transactions.size() << " cached transaction hashes. New height: " << new_block_height << " Top block: " << top_block_id;
-      m_validated_transactions.clear();
-	}
+    ++m_validationGeneration;
+
+    // failed transactions may use outputs of the new block or outputs it unlocked
+    m_pendingTransactions.insert(m_failedTransactions.begin(), m_failedTransactions.end());
+    m_failedTransactions.clear();
+
+    // ring members and unlocked outputs of ready transactions stay valid on a longer chain,
+    // only the key images spent by the new block have to be checked
+    size_t spent = 0;
+    for (auto it = m_readyTransactions.begin(); it != m_readyTransactions.end();) {
+      if (m_validator.haveSpentKeyImages((*it)->tx)) {
+        m_failedTransactions.insert((*it)->id);
+        journalChange((*it)->id, false);
+        it = m_readyTransactions.erase(it);
+        ++spent;
+      } else {
+        ++it;
+      }
+    }
+
+    logger(DEBUGGING) << "MemPool - Block height incremented, " << spent << " ready transactions became double spends. New height: " << new_block_height << " Top block: " << top_block_id;
     return true;
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::on_blockchain_dec(uint64_t new_block_height, const Crypto::Hash& top_block_id) {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
-    if (!m_validated_transactions.empty()) {
-      logger(DEBUGGING, YELLOW) << "MemPool - Block height decremented " << m_validated_transactions.size() << " cached transaction hashes. New height: " << new_block_height << " Top block: " << top_block_id;
-      m_validated_transactions.clear();
-	}
+    ++m_validationGeneration;
+
+    // ready transactions may use outputs of the removed blocks, everything is checked again
+    logger(DEBUGGING, YELLOW) << "MemPool - Block height decremented, " << m_readyTransactions.size() << " ready transactions are checked again. New height: " << new_block_height << " Top block: " << top_block_id;
+    for (const TransactionDetails* txd : m_readyTransactions) {
+      m_pendingTransactions.insert(txd->id);
+      journalChange(txd->id, false);
+    }
+
+    m_pendingTransactions.insert(m_failedTransactions.begin(), m_failedTransactions.end());
+    m_readyTransactions.clear();
+    m_failedTransactions.clear();
     return true;
   }
   //---------------------------------------------------------------------------------
@@ -378,10 +514,82 @@ namespace CryptoNote {
     return true;
   }
   //---------------------------------------------------------------------------------
+  void tx_memory_pool::validatePendingTransactions() {
+    std::vector<TransactionDetails> pending;
+    uint64_t validationGeneration;
+    {
+      std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+      if (m_pendingTransactions.empty()) {
+        return;
+      }
+
+      pending.reserve(m_pendingTransactions.size());
+      for (const auto& id : m_pendingTransactions) {
+        auto it = m_transactions.find(id);
+        if (it != m_transactions.end()) {
+          pending.push_back(*it);
+        }
+      }
+
+      m_pendingTransactions.clear();
+      validationGeneration = m_validationGeneration;
+    }
+
+    // checked on copies, ring signatures are verified without holding the pool lock
+    std::vector<bool> ready(pending.size());
+    for (size_t i = 0; i < pending.size(); ++i) {
+      ready[i] = is_transaction_ready_to_go(pending[i].tx, pending[i]);
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    for (size_t i = 0; i < pending.size(); ++i) {
+      auto it = m_transactions.find(pending[i].id);
+      if (it == m_transactions.end()) {
+        continue;
+      }
+
+      if (validationGeneration != m_validationGeneration) {
+        // the chain changed meanwhile, the result may be stale
+        m_pendingTransactions.insert(it->id);
+        continue;
+      }
+
+      const TransactionCheckInfo& checkInfo = pending[i];
+      m_transactions.modify(it, [&checkInfo](TransactionCheckInfo& item) {
+        item = checkInfo;
+      });
+
+      if (ready[i]) {
+        addReadyTransaction(*it);
+      } else {
+        m_failedTransactions.insert(it->id);
+      }
+    }
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::addReadyTransaction(const TransactionDetails& txd) {
+    if (m_readyTransactions.insert(&txd).second) {
+      journalChange(txd.id, true);
+    }
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::removeReadyTransaction(const TransactionDetails& txd) {
+    if (m_readyTransactions.erase(&txd) != 0) {
+      journalChange(txd.id, false);
+    }
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::journalChange(const Crypto::Hash& id, bool added) {
+    m_changes.push_back(PoolChange{ ++m_lastChangeSequence, id, added });
+    if (m_changes.size() > POOL_CHANGES_JOURNAL_SIZE) {
+      m_changes.pop_front();
+    }
+  }
+  //---------------------------------------------------------------------------------
   std::string tx_memory_pool::print_pool(bool short_format) const {
     std::stringstream ss;
-    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
-    for (const auto& txd : m_fee_index) {
+    // formatted from a snapshot, JSON of a large pool takes long
+    for (const auto& txd : getMemoryPool()) {
       ss << "id: " << txd.id << std::endl;
       
       if (!short_format) {
@@ -406,6 +614,8 @@ namespace CryptoNote {
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::fill_block_template(Block& bl, size_t median_size, size_t maxCumulativeSize,
                                            uint64_t already_generated_coins, size_t& total_size, uint64_t& fee) {
+    validatePendingTransactions();
+
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
 
     total_size = 0;
@@ -416,12 +626,14 @@ namespace CryptoNote {
     max_total_size = std::min(max_total_size, maxCumulativeSize) - m_currency.minerTxBlobReservedSize();
 
     BlockTemplate blockTemplate;
+    uint32_t height = m_core.getCurrentBlockchainHeight();
 
-    for (auto i = m_fee_index.begin(); i != m_fee_index.end(); ++i) {
-      if (counter == 127)
+    // only transactions checked against the current chain are walked, best fee first
+    for (const TransactionDetails* txdp : m_readyTransactions) {
+      if (counter == 127 || total_size >= max_total_size)
         break;
 
-      const auto& txd = *i;
+      const auto& txd = *txdp;
 
       size_t blockSizeLimit = (txd.fee == 0) ? median_size : max_total_size;
       if (blockSizeLimit < total_size + txd.blobSize) {
@@ -429,29 +641,12 @@ namespace CryptoNote {
       }
 
       tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
-      if (!m_core.check_tx_fee(txd.tx, getObjectHash(txd.tx), txd.blobSize, tvc, m_core.getCurrentBlockchainHeight())) {
+      if (!m_core.check_tx_fee(txd.tx, txd.id, txd.blobSize, tvc, height)) {
         logger(DEBUGGING) << "Transaction " << txd.id << " not included to block template because fee is insufficient";
         continue;
       }
 
-      TransactionCheckInfo checkInfo(txd);
-      bool ready = false;
-      if (m_validated_transactions.find(txd.id) != m_validated_transactions.end()) {
-        ready = true;
-        logger(DEBUGGING) << "Fill block template - tx added from cache: " << txd.id;
-      }
-      else if (is_transaction_ready_to_go(txd.tx, checkInfo)) {
-        ready = true;
-        m_validated_transactions.insert(txd.id);
-        logger(DEBUGGING) << "Fill block template - tx added to cache: " << txd.id;
-      }
-
-      // update item state
-      m_fee_index.modify(i, [&checkInfo](TransactionCheckInfo& item) {
-        item = checkInfo;
-      });
-
-      if (ready && blockTemplate.addTransaction(txd.id, txd.tx)) {
+      if (blockTemplate.addTransaction(txd.id, txd.tx)) {
         total_size += txd.blobSize;
         fee += txd.fee;
         ++counter;
@@ -469,42 +664,211 @@ namespace CryptoNote {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
 
     m_config_folder = config_folder;
+    if (!Tools::create_directories_if_necessary(m_config_folder)) {
+      logger(ERROR) << "Failed to create data directory: " << m_config_folder;
+      return false;
+    }
+
     std::string state_file_path = config_folder + "/" + m_currency.txPoolFileName();
+    std::string journal_file_path = boost::filesystem::path(state_file_path).replace_extension(".journal").string();
     boost::system::error_code ec;
-    if (!boost::filesystem::exists(state_file_path, ec)) {
-      return true;
+    // the chain is loaded first and returns the transactions of the blocks it pops to the pool, they are journaled here
+    std::unordered_map<Crypto::Hash, BinaryArray> returnedTransactions;
+    for (const auto& txd : m_transactions) {
+      returnedTransactions.emplace(txd.id, toBinaryArray(txd));
     }
 
-    if (!loadFromBinaryFile(*this, state_file_path)) {
-      logger(ERROR) << "Failed to load memory pool from file " << state_file_path;
-
-      m_transactions.clear();
-      m_spent_key_images.clear();
-      m_spentOutputs.clear();
-
+    // pools stored by earlier versions are moved to the journal
+    bool migrate = !boost::filesystem::exists(journal_file_path, ec) && boost::filesystem::exists(state_file_path, ec);
+    if (migrate) {
+      // the stored pool replaces the returned transactions, they are loaded again below
       m_paymentIdIndex.clear();
       m_timestampIndex.clear();
-    } else {
-      buildIndices();
+      if (!loadFromBinaryFile(*this, state_file_path)) {
+        logger(ERROR) << "Failed to load memory pool from file " << state_file_path;
+
+        m_readyTransactions.clear();
+        m_changes.clear();
+        ++m_lastChangeSequence;
+        m_pendingTransactions.clear();
+        m_failedTransactions.clear();
+        m_transactions.clear();
+        m_size = 0;
+        m_spent_key_images.clear();
+        m_spentOutputs.clear();
+        m_recentlyDeletedTransactions.clear();
+
+        m_paymentIdIndex.clear();
+        m_timestampIndex.clear();
+      } else {
+        buildIndices();
+      }
+    }
+
+    std::unordered_map<Crypto::Hash, BinaryArray> journalTransactions;
+    bool opened = m_journal.open(journal_file_path, [&](TransactionPoolJournal::RecordType type, const Crypto::Hash& id, const BinaryArray& payload) {
+      if (type == TransactionPoolJournal::RecordType::ADD) {
+        journalTransactions[id] = payload;
+        return;
+      }
+
+      journalTransactions.erase(id);
+      uint64_t deletionTime = 0;
+      for (size_t i = 0; i < sizeof(deletionTime); ++i) {
+        deletionTime |= static_cast<uint64_t>(payload[i]) << (8 * i);
+      }
+
+      if (deletionTime != 0) {
+        m_recentlyDeletedTransactions[id] = deletionTime;
+      } else {
+        m_recentlyDeletedTransactions.erase(id);
+      }
+    });
+
+    if (!opened) {
+      // the pool works without the journal, it just isn't kept over a restart
+      logger(ERROR) << "Failed to open memory pool journal " << journal_file_path;
+    } else if (migrate) {
+      for (const auto& txd : m_transactions) {
+        m_journal.add(txd.id, toBinaryArray(txd));
+      }
+
+      for (const auto& deleted : m_recentlyDeletedTransactions) {
+        m_journal.remove(deleted.first, deleted.second);
+      }
+
+      boost::filesystem::remove(state_file_path, ec);
+    }
+
+    for (const auto& item : returnedTransactions) {
+      m_journal.add(item.first, item.second);
+      // the stored pool replaced them
+      if (m_transactions.find(item.first) == m_transactions.end()) {
+        journalTransactions[item.first] = item.second;
+      }
     }
 
+    loadJournalTransactions(journalTransactions);
+
     removeExpiredTransactions();
+    // the limit may have been lowered since the pool was stored
+    makeRoom(0, nullptr);
 
     // Ignore deserialization error
     return true;
   }
   //---------------------------------------------------------------------------------
-  bool tx_memory_pool::deinit() {
-    if (!Tools::create_directories_if_necessary(m_config_folder)) {
-      logger(INFO) << "Failed to create data directory: " << m_config_folder;
+  void tx_memory_pool::setMaxSize(uint64_t maxSize) {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    m_maxSize = maxSize;
+  }
+  //---------------------------------------------------------------------------------
+  uint64_t tx_memory_pool::getSize() const {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    return m_size;
+  }
+  //---------------------------------------------------------------------------------
+  uint64_t tx_memory_pool::getMinimalFeePerByte() const {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    // full once a transaction of the largest size doesn't fit without evicting others
+    if (m_maxSize == 0 || m_size + m_currency.maxTransactionSizeLimit() <= m_maxSize) {
+      return 0;
+    }
+
+    for (auto it = m_fee_index.rbegin(); it != m_fee_index.rend(); ++it) {
+      if (!it->keptByBlock) {
+        return it->fee / it->blobSize + 1;
+      }
+    }
+
+    return 0;
+  }
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::makeRoom(uint64_t size, const TransactionDetails* txd) {
+    if (m_maxSize == 0 || m_size + size <= m_maxSize) {
+      return true;
+    }
+
+    static Common::MetricsCounter& evictedMetric = Common::MetricsRegistry::instance().counter("txpool_evicted_total");
+    static Common::MetricsCounter& evictedBytesMetric = Common::MetricsRegistry::instance().counter("txpool_evicted_bytes_total");
+
+    bool evictAny = txd == nullptr || txd->keptByBlock;
+    TransactionPriorityComparator priority;
+    std::vector<tx_container_t::nth_index<1>::type::iterator> evicted;
+    uint64_t freed = 0;
+    for (auto it = m_fee_index.rbegin(); it != m_fee_index.rend() && m_size + size > m_maxSize + freed; ++it) {
+      if (it->keptByBlock) {
+        continue;
+      }
+
+      // the rest pays at least as much as this one
+      if (!evictAny && !priority(*txd, *it)) {
+        return false;
+      }
+
+      evicted.push_back(std::prev(it.base()));
+      freed += it->blobSize;
+    }
+
+    if (!evictAny && m_size + size > m_maxSize + freed) {
       return false;
     }
 
-    std::string state_file_path = m_config_folder + "/" + m_currency.txPoolFileName();
+    for (auto it : evicted) {
+      logger(DEBUGGING) << "Tx " << it->id << " evicted from the full tx pool, fee " << m_currency.formatAmount(it->fee) << ", size " << it->blobSize;
+      evictedMetric.add();
+      evictedBytesMetric.add(it->blobSize);
+      removeTransaction(m_transactions.project<0>(it));
+    }
+
+    return true;
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::loadJournalTransactions(const std::unordered_map<Crypto::Hash, BinaryArray>& transactions) {
+    size_t loaded = 0;
+    size_t skipped = 0;
+    for (const auto& item : transactions) {
+      // returned by the chain and still in the pool
+      if (m_transactions.find(item.first) != m_transactions.end()) {
+        continue;
+      }
+
+      TransactionDetails txd;
+      if (!fromBinaryArray(txd, item.second) || txd.id != item.first) {
+        logger(WARNING) << "Failed to load transaction " << item.first << " from memory pool journal";
+        m_journal.remove(item.first, 0);
+        continue;
+      }
+
+      // signatures were checked when the transaction was added, only the inputs confirmed since are checked
+      if (m_validator.haveSpentKeyImages(txd.tx) || (!txd.keptByBlock && haveSpentInputs(txd.tx))) {
+        m_journal.remove(txd.id, 0);
+        ++skipped;
+        continue;
+      }
+
+      if (!addTransactionInputs(txd.id, txd.tx, txd.keptByBlock)) {
+        m_journal.remove(txd.id, 0);
+        continue;
+      }
+
+      m_size += txd.blobSize;
+      auto it = m_transactions.insert(std::move(txd)).first;
+      m_paymentIdIndex.add(it->tx);
+      m_timestampIndex.add(it->receiveTime, it->id);
+      // loaded transactions are checked against the chain before they are relayed or mined
+      m_pendingTransactions.insert(it->id);
+      ++loaded;
+    }
 
-    if (!storeToBinaryFile(*this, state_file_path)) {
-      logger(INFO) << "Failed to serialize memory pool to file " << state_file_path;
+    if (!transactions.empty()) {
+      logger(INFO) << "Loaded " << loaded << " transactions from memory pool journal, " << skipped << " already spent in the chain";
     }
+  }
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::deinit() {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    m_journal.close();
 
     m_paymentIdIndex.clear();
     m_timestampIndex.clear();
@@ -541,8 +905,18 @@ namespace CryptoNote {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
 
     if (s.type() == ISerializer::INPUT) {
+      // the ready set starts over, clients have to resync
+      m_readyTransactions.clear();
+      m_changes.clear();
+      ++m_lastChangeSequence;
+      m_pendingTransactions.clear();
+      m_failedTransactions.clear();
       m_transactions.clear();
       readSequence<TransactionDetails>(std::inserter(m_transactions, m_transactions.end()), "transactions", s);
+      m_size = 0;
+      for (const auto& txd : m_transactions) {
+        m_size += txd.blobSize;
+      }
     } else {
       writeSequence<TransactionDetails>(m_transactions.begin(), m_transactions.end(), "transactions", s);
     }
@@ -600,10 +974,12 @@ namespace CryptoNote {
     removeTransactionInputs(i->id, i->tx, i->keptByBlock);
     m_paymentIdIndex.remove(i->tx);
     m_timestampIndex.remove(i->receiveTime, i->id);
-    if (m_validated_transactions.find(i->id) != m_validated_transactions.end()) {
-      m_validated_transactions.erase(i->id);
-      logger(DEBUGGING) << "Removing transaction from MemPool cache " << i->id << ". Cache size: " << m_validated_transactions.size();
-    }
+    m_size -= i->blobSize;
+    auto deleted = m_recentlyDeletedTransactions.find(i->id);
+    m_journal.remove(i->id, deleted != m_recentlyDeletedTransactions.end() ? deleted->second : 0);
+    removeReadyTransaction(*i);
+    m_pendingTransactions.erase(i->id);
+    m_failedTransactions.erase(i->id);
     return m_transactions.erase(i);
   }
 
@@ -702,6 +1078,8 @@ namespace CryptoNote {
     for (auto it = m_transactions.begin(); it != m_transactions.end(); it++) {
       m_paymentIdIndex.add(it->tx);
       m_timestampIndex.add(it->receiveTime, it->id);
+      // loaded transactions are checked against the chain before they are relayed or mined
+      m_pendingTransactions.insert(it->id);
     }
   }
 
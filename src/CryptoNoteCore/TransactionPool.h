@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <deque>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
@@ -41,6 +42,7 @@
 #include "CryptoNoteCore/ITimeProvider.h"
 #include "CryptoNoteCore/ITransactionValidator.h"
 #include "CryptoNoteCore/ITxPoolObserver.h"
+#include "CryptoNoteCore/TransactionPoolJournal.h"
 #include "CryptoNoteCore/VerificationContext.h"
 #include "CryptoNoteCore/BlockchainIndices.h"
 #include "CryptoNoteCore/ICore.h"
@@ -96,10 +98,17 @@ namespace CryptoNote {
     bool addObserver(ITxPoolObserver* observer);
     bool removeObserver(ITxPoolObserver* observer);
 
-    // load/store operations
+    // load/store operations, the pool is replayed from its journal and every change is appended to it until deinit
     bool init(const std::string& config_folder);
     bool deinit();
 
+    // Total size of transaction blobs above which the transactions paying the least per byte are evicted,
+    // 0 for no limit. Transactions kept by block are never evicted.
+    void setMaxSize(uint64_t maxSize);
+    uint64_t getSize() const;
+    // Fee per byte a transaction has to pay above to get into the full pool, 0 while it isn't full
+    uint64_t getMinimalFeePerByte() const;
+
     bool have_tx(const Crypto::Hash &id) const;
     bool add_tx(const Transaction &tx, const Crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool keeped_by_block);
     bool add_tx(const Transaction &tx, tx_verification_context& tvc, bool keeped_by_block);
@@ -116,7 +125,13 @@ namespace CryptoNote {
     bool fill_block_template(Block &bl, size_t median_size, size_t maxCumulativeSize, uint64_t already_generated_coins, size_t &total_size, uint64_t &fee);
 
     void get_transactions(std::list<Transaction>& txs) const;
-    void get_difference(const std::vector<Crypto::Hash>& known_tx_ids, std::vector<Crypto::Hash>& new_tx_ids, std::vector<Crypto::Hash>& deleted_tx_ids) const;
+    void get_difference(const std::vector<Crypto::Hash>& known_tx_ids, std::vector<Crypto::Hash>& new_tx_ids, std::vector<Crypto::Hash>& deleted_tx_ids);
+    // sequence gets the number of the last change the difference includes
+    void get_difference(const std::vector<Crypto::Hash>& known_tx_ids, std::vector<Crypto::Hash>& new_tx_ids, std::vector<Crypto::Hash>& deleted_tx_ids, uint64_t& sequence);
+    // Transactions get_difference reports as added and deleted after change number known_sequence of the journal.
+    // Returns false when the journal doesn't reach back that far, then new_tx_ids gets all of them and the caller
+    // replaces its set. sequence gets the number of the last change either way.
+    bool get_changes_since(uint64_t known_sequence, std::vector<Crypto::Hash>& new_tx_ids, std::vector<Crypto::Hash>& deleted_tx_ids, uint64_t& sequence);
     size_t get_transactions_count() const;
     std::string print_pool(bool short_format) const;
 	
@@ -182,6 +197,11 @@ namespace CryptoNote {
       }
     };
 
+    // priority order, ties broken by id
+    struct ReadyTransactionComparator {
+      bool operator()(const TransactionDetails* lhs, const TransactionDetails* rhs) const;
+    };
+
     typedef hashed_unique<BOOST_MULTI_INDEX_MEMBER(TransactionDetails, Crypto::Hash, id)> main_index_t;
     typedef ordered_non_unique<identity<TransactionDetails>, TransactionPriorityComparator> fee_index_t;
 
@@ -201,7 +221,17 @@ namespace CryptoNote {
 
     tx_container_t::iterator removeTransaction(tx_container_t::iterator i);
     bool removeExpiredTransactions();
+    // Evicts the transactions paying the least per byte until size more bytes fit into the limit. Only those paying
+    // less than txd are evicted unless it's null or kept by block, false when that isn't enough for txd to fit.
+    bool makeRoom(uint64_t size, const TransactionDetails* txd);
     bool is_transaction_ready_to_go(const Transaction& tx, TransactionCheckInfo& txd) const;
+    // checks pending transactions against the current chain and sorts them into ready and failed
+    void validatePendingTransactions();
+    void addReadyTransaction(const TransactionDetails& txd);
+    void removeReadyTransaction(const TransactionDetails& txd);
+    void journalChange(const Crypto::Hash& id, bool added);
+    // loads the transactions of the journal left in it after replay, those already spent in the chain are removed
+    void loadJournalTransactions(const std::unordered_map<Crypto::Hash, BinaryArray>& transactions);
 
     void buildIndices();
 
@@ -219,9 +249,29 @@ namespace CryptoNote {
 
     tx_container_t m_transactions;  
     tx_container_t::nth_index<1>::type& m_fee_index;
+    uint64_t m_size;
+    uint64_t m_maxSize;
     std::unordered_map<Crypto::Hash, uint64_t> m_recentlyDeletedTransactions;
+    // incremented whenever the chain changes, tells if an input check done without the lock is still current
+    uint64_t m_validationGeneration;
+    // every pool transaction is in one of these: passed the input checks against the current chain,
+    // not checked since the chain or the pool changed, or failed them
+    std::set<const TransactionDetails*, ReadyTransactionComparator> m_readyTransactions;
+    std::unordered_set<Crypto::Hash> m_pendingTransactions;
+    std::unordered_set<Crypto::Hash> m_failedTransactions;
+
+    struct PoolChange {
+      uint64_t sequence;
+      Crypto::Hash id;
+      bool added;
+    };
+
+    // additions to and removals from the ready set, numbered without gaps up to m_lastChangeSequence
+    std::deque<PoolChange> m_changes;
+    uint64_t m_lastChangeSequence;
 
     Logging::LoggerRef logger;
+    TransactionPoolJournal m_journal;
 
     PaymentIdIndex m_paymentIdIndex;
     TimestampTransactionsIndex m_timestampIndex;
@@ -0,0 +1,374 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "TransactionPoolJournal.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <boost/filesystem.hpp>
+
+using namespace Logging;
+
+#undef ERROR
+
+namespace CryptoNote {
+
+namespace {
+
+const char JOURNAL_SIGNATURE[] = "KRBTXPJ1";
+const size_t JOURNAL_SIGNATURE_SIZE = sizeof(JOURNAL_SIGNATURE) - 1;
+// type, transaction id and payload size
+const size_t RECORD_HEADER_SIZE = 1 + sizeof(Crypto::Hash) + 4;
+const size_t RECORD_CHECKSUM_SIZE = 4;
+// larger payloads can only come from a damaged file
+const uint32_t MAX_PAYLOAD_SIZE = 16 * 1024 * 1024;
+// smaller files aren't compacted whatever part of them is stale
+const uint64_t MIN_COMPACTION_SIZE = 1024 * 1024;
+
+void writeUint32(uint8_t* data, uint32_t value) {
+  for (size_t i = 0; i < 4; ++i) {
+    data[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+uint32_t readUint32(const uint8_t* data) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    value |= static_cast<uint32_t>(data[i]) << (8 * i);
+  }
+
+  return value;
+}
+
+uint64_t readUint64(const uint8_t* data) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < 8; ++i) {
+    value |= static_cast<uint64_t>(data[i]) << (8 * i);
+  }
+
+  return value;
+}
+
+// ofstream::flush() only hands the data to the system, it's on the disk once the file is synced
+bool syncFile(const std::string& path) {
+#ifdef _WIN32
+  int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+  if (fd < 0) {
+    return false;
+  }
+
+  bool synced = _commit(fd) == 0;
+  _close(fd);
+#else
+  int fd = ::open(path.c_str(), O_WRONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  bool synced = ::fsync(fd) == 0;
+  ::close(fd);
+#endif
+  return synced;
+}
+
+// first bytes of the hash of the record header and payload
+void checksum(const uint8_t* data, size_t size, uint8_t* result) {
+  Crypto::Hash hash = Crypto::cn_fast_hash(data, size);
+  memcpy(result, &hash, RECORD_CHECKSUM_SIZE);
+}
+
+}
+
+TransactionPoolJournal::TransactionPoolJournal(ITimeProvider& timeProvider, uint64_t forgetTime, Logging::ILogger& log) :
+  m_timeProvider(timeProvider),
+  m_forgetTime(forgetTime),
+  logger(log, "txpool_journal"),
+  m_open(false),
+  m_fileSize(0),
+  m_compactedSize(0),
+  m_stop(false) {
+}
+
+TransactionPoolJournal::~TransactionPoolJournal() {
+  close();
+}
+
+bool TransactionPoolJournal::open(const std::string& path, const RecordHandler& handler) {
+  close();
+
+  m_path = path;
+  boost::system::error_code ec;
+  uint64_t liveSize = JOURNAL_SIGNATURE_SIZE;
+  if (boost::filesystem::exists(m_path, ec)) {
+    uint64_t goodSize = 0;
+    LastRecords lastRecords;
+    {
+      std::ifstream stream(m_path, std::ios::binary);
+      char signature[JOURNAL_SIGNATURE_SIZE];
+      if (stream.read(signature, JOURNAL_SIGNATURE_SIZE) && memcmp(signature, JOURNAL_SIGNATURE, JOURNAL_SIGNATURE_SIZE) == 0) {
+        goodSize = readRecords(stream, lastRecords, handler);
+      }
+    }
+
+    uint64_t fileSize = boost::filesystem::file_size(m_path, ec);
+    if (goodSize == 0) {
+      if (fileSize != 0) {
+        logger(WARNING) << "Unknown transaction pool journal format, starting a new one: " << m_path;
+      }
+
+      boost::filesystem::remove(m_path, ec);
+    } else if (goodSize < fileSize) {
+      // the last records were being written when the node stopped
+      logger(WARNING) << "Transaction pool journal is damaged after " << goodSize << " of " << fileSize << " bytes, the rest is dropped";
+      boost::filesystem::resize_file(m_path, goodSize, ec);
+      if (ec) {
+        logger(ERROR) << "Failed to truncate transaction pool journal " << m_path << ": " << ec.message();
+        return false;
+      }
+    }
+
+    for (const RecordInfo& record : liveRecords(lastRecords)) {
+      liveSize += record.size;
+    }
+  }
+
+  m_file.open(m_path, std::ios::binary | std::ios::app);
+  if (!m_file) {
+    logger(ERROR) << "Failed to open transaction pool journal " << m_path;
+    return false;
+  }
+
+  m_fileSize = boost::filesystem::file_size(m_path, ec);
+  if (m_fileSize == 0) {
+    m_file.write(JOURNAL_SIGNATURE, JOURNAL_SIGNATURE_SIZE);
+    m_file.flush();
+    m_fileSize = JOURNAL_SIGNATURE_SIZE;
+  }
+
+  // a journal replayed with much stale data in it is compacted right away
+  m_compactedSize = liveSize;
+  m_stop = false;
+  m_open = true;
+  m_writer = std::thread(&TransactionPoolJournal::writerThread, this);
+  return true;
+}
+
+void TransactionPoolJournal::close() {
+  if (!m_open) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+
+  m_haveRecords.notify_one();
+  m_writer.join();
+  m_file.close();
+  m_open = false;
+}
+
+bool TransactionPoolJournal::isOpen() const {
+  return m_open;
+}
+
+void TransactionPoolJournal::add(const Crypto::Hash& id, const std::vector<uint8_t>& payload) {
+  append(RecordType::ADD, id, payload.data(), payload.size());
+}
+
+void TransactionPoolJournal::remove(const Crypto::Hash& id, uint64_t deletionTime) {
+  uint8_t payload[8];
+  for (size_t i = 0; i < sizeof(payload); ++i) {
+    payload[i] = static_cast<uint8_t>(deletionTime >> (8 * i));
+  }
+
+  append(RecordType::REMOVE, id, payload, sizeof(payload));
+}
+
+void TransactionPoolJournal::append(RecordType type, const Crypto::Hash& id, const uint8_t* payload, size_t payloadSize) {
+  if (!m_open) {
+    return;
+  }
+
+  std::vector<uint8_t> record(RECORD_HEADER_SIZE + payloadSize + RECORD_CHECKSUM_SIZE);
+  record[0] = static_cast<uint8_t>(type);
+  memcpy(&record[1], &id, sizeof(id));
+  writeUint32(&record[1 + sizeof(id)], static_cast<uint32_t>(payloadSize));
+  if (payloadSize != 0) {
+    memcpy(&record[RECORD_HEADER_SIZE], payload, payloadSize);
+  }
+
+  checksum(record.data(), RECORD_HEADER_SIZE + payloadSize, &record[RECORD_HEADER_SIZE + payloadSize]);
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queue.insert(m_queue.end(), record.begin(), record.end());
+  }
+
+  m_haveRecords.notify_one();
+}
+
+void TransactionPoolJournal::writerThread() {
+  std::vector<uint8_t> batch;
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (;;) {
+    m_haveRecords.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+    // everything queued while the previous batch was written goes in one write
+    batch.clear();
+    batch.swap(m_queue);
+    bool stop = m_stop;
+    lock.unlock();
+
+    if (!batch.empty()) {
+      m_file.write(reinterpret_cast<const char*>(batch.data()), batch.size());
+      m_file.flush();
+      if (!m_file || !syncFile(m_path)) {
+        logger(ERROR) << "Failed to write transaction pool journal " << m_path;
+        m_file.clear();
+      }
+
+      m_fileSize += batch.size();
+    }
+
+    if (!stop && m_fileSize > MIN_COMPACTION_SIZE && m_fileSize > 2 * m_compactedSize) {
+      compact();
+    }
+
+    lock.lock();
+    if (stop && m_queue.empty()) {
+      break;
+    }
+  }
+}
+
+void TransactionPoolJournal::compact() {
+  m_file.close();
+
+  std::string tempPath = m_path + ".tmp";
+  bool compacted = false;
+  {
+    std::ifstream input(m_path, std::ios::binary);
+    LastRecords lastRecords;
+    input.seekg(JOURNAL_SIGNATURE_SIZE);
+    readRecords(input, lastRecords, [](RecordType, const Crypto::Hash&, const std::vector<uint8_t>&) {});
+    input.clear();
+
+    std::ofstream output(tempPath, std::ios::binary | std::ios::trunc);
+    output.write(JOURNAL_SIGNATURE, JOURNAL_SIGNATURE_SIZE);
+    std::vector<char> buffer;
+    for (const RecordInfo& record : liveRecords(lastRecords)) {
+      buffer.resize(static_cast<size_t>(record.size));
+      input.seekg(record.offset);
+      input.read(buffer.data(), buffer.size());
+      output.write(buffer.data(), buffer.size());
+    }
+
+    output.flush();
+    compacted = input && output;
+  }
+
+  // the renamed file replaces the records, it must be complete on the disk first
+  compacted = compacted && syncFile(tempPath);
+
+  boost::system::error_code ec;
+  if (compacted) {
+    boost::filesystem::rename(tempPath, m_path, ec);
+  }
+
+  if (!compacted || ec) {
+    logger(ERROR) << "Failed to compact transaction pool journal " << m_path;
+    boost::filesystem::remove(tempPath, ec);
+  }
+
+  m_file.open(m_path, std::ios::binary | std::ios::app);
+  m_fileSize = boost::filesystem::file_size(m_path, ec);
+  // a failed compaction isn't retried until the file doubles again
+  m_compactedSize = m_fileSize;
+  logger(DEBUGGING) << "Transaction pool journal compacted to " << m_fileSize << " bytes";
+}
+
+uint64_t TransactionPoolJournal::readRecords(std::istream& stream, LastRecords& lastRecords, const RecordHandler& handler) {
+  uint64_t offset = JOURNAL_SIGNATURE_SIZE;
+  std::vector<uint8_t> record;
+  std::vector<uint8_t> payload;
+  for (;;) {
+    record.resize(RECORD_HEADER_SIZE);
+    if (!stream.read(reinterpret_cast<char*>(record.data()), RECORD_HEADER_SIZE)) {
+      break;
+    }
+
+    RecordType type = static_cast<RecordType>(record[0]);
+    uint32_t payloadSize = readUint32(&record[1 + sizeof(Crypto::Hash)]);
+    if ((type != RecordType::ADD && type != RecordType::REMOVE) || payloadSize > MAX_PAYLOAD_SIZE ||
+      (type == RecordType::REMOVE && payloadSize != 8)) {
+      break;
+    }
+
+    record.resize(RECORD_HEADER_SIZE + payloadSize + RECORD_CHECKSUM_SIZE);
+    if (!stream.read(reinterpret_cast<char*>(&record[RECORD_HEADER_SIZE]), payloadSize + RECORD_CHECKSUM_SIZE)) {
+      break;
+    }
+
+    uint8_t expected[RECORD_CHECKSUM_SIZE];
+    checksum(record.data(), RECORD_HEADER_SIZE + payloadSize, expected);
+    if (memcmp(expected, &record[RECORD_HEADER_SIZE + payloadSize], RECORD_CHECKSUM_SIZE) != 0) {
+      break;
+    }
+
+    Crypto::Hash id;
+    memcpy(&id, &record[1], sizeof(id));
+    payload.assign(record.begin() + RECORD_HEADER_SIZE, record.begin() + RECORD_HEADER_SIZE + payloadSize);
+
+    RecordInfo info;
+    info.type = type;
+    info.offset = offset;
+    info.size = record.size();
+    info.deletionTime = type == RecordType::REMOVE ? readUint64(payload.data()) : 0;
+    lastRecords[id] = info;
+
+    handler(type, id, payload);
+    offset += record.size();
+  }
+
+  return offset;
+}
+
+std::vector<TransactionPoolJournal::RecordInfo> TransactionPoolJournal::liveRecords(const LastRecords& lastRecords) const {
+  uint64_t now = m_timeProvider.now();
+  std::vector<RecordInfo> records;
+  for (const auto& item : lastRecords) {
+    const RecordInfo& record = item.second;
+    // added and not removed since, or removed and still remembered by the pool
+    if (record.type == RecordType::ADD || (record.deletionTime != 0 && record.deletionTime + m_forgetTime >= now)) {
+      records.push_back(record);
+    }
+  }
+
+  std::sort(records.begin(), records.end(), [](const RecordInfo& lhs, const RecordInfo& rhs) { return lhs.offset < rhs.offset; });
+  return records;
+}
+
+}
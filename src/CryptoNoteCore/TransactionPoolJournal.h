@@ -0,0 +1,105 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "CryptoTypes.h"
+#include "crypto/crypto.h"
+#include "CryptoNoteCore/ITimeProvider.h"
+#include "Logging/LoggerRef.h"
+
+namespace CryptoNote {
+
+// Append-only file of transaction pool additions and removals. Records are framed and checksummed by the caller's
+// thread and written and synced to the disk by a background thread, so a crash loses at most the records not synced
+// yet and a torn last record is cut off on load. When the file has grown to twice its size after the last compaction, the background
+// thread rewrites it with the last record of every transaction still in the pool and the removals still remembered.
+class TransactionPoolJournal {
+public:
+  enum class RecordType : uint8_t {
+    ADD = 1,
+    REMOVE = 2
+  };
+
+  // Removals with a deletion time are kept by compaction until forgetTime seconds after it
+  TransactionPoolJournal(ITimeProvider& timeProvider, uint64_t forgetTime, Logging::ILogger& log);
+  TransactionPoolJournal(const TransactionPoolJournal&) = delete;
+  ~TransactionPoolJournal();
+  TransactionPoolJournal& operator=(const TransactionPoolJournal&) = delete;
+
+  typedef std::function<void(RecordType type, const Crypto::Hash& id, const std::vector<uint8_t>& payload)> RecordHandler;
+
+  // Passes the records of the file in their order to handler, then starts appending to it. Creates the file when
+  // it doesn't exist. False when it can't be opened for writing.
+  bool open(const std::string& path, const RecordHandler& handler);
+  // Writes the queued records and stops the background thread
+  void close();
+  bool isOpen() const;
+
+  // payload is the serialized transaction
+  void add(const Crypto::Hash& id, const std::vector<uint8_t>& payload);
+  // deletionTime is 0 for removals that aren't remembered
+  void remove(const Crypto::Hash& id, uint64_t deletionTime);
+
+private:
+  struct RecordInfo {
+    RecordType type;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t deletionTime;
+  };
+
+  typedef std::unordered_map<Crypto::Hash, RecordInfo> LastRecords;
+
+  void append(RecordType type, const Crypto::Hash& id, const uint8_t* payload, size_t payloadSize);
+  void writerThread();
+  void compact();
+  // Reads the records after the file header until the end of stream or the first damaged record and returns the
+  // offset after the last good one. lastRecords gets the last record of every transaction.
+  uint64_t readRecords(std::istream& stream, LastRecords& lastRecords, const RecordHandler& handler);
+  // The records compaction keeps, in the file order
+  std::vector<RecordInfo> liveRecords(const LastRecords& lastRecords) const;
+
+  ITimeProvider& m_timeProvider;
+  const uint64_t m_forgetTime;
+  Logging::LoggerRef logger;
+
+  std::string m_path;
+  bool m_open;
+  // used by the writer thread only while it runs
+  std::ofstream m_file;
+  uint64_t m_fileSize;
+  uint64_t m_compactedSize;
+
+  std::mutex m_mutex;
+  std::condition_variable m_haveRecords;
+  std::vector<uint8_t> m_queue;
+  bool m_stop;
+  std::thread m_writer;
+};
+
+}
@@ -28,6 +28,7 @@
 #include <boost/scope_exit.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <System/Dispatcher.h>
+#include <System/RemoteContext.h>
 
 #include "Common/ShuffleGenerator.h"
 #include "CryptoNoteCore/CryptoNoteBasicImpl.h"
@@ -70,7 +71,11 @@ CryptoNoteProtocolHandler::CryptoNoteProtocolHandler(const Currency& currency, S
   m_dandelionStemSelectInterval(CryptoNote::parameters::DANDELION_EPOCH),
   m_dandelionStemFluffInterval(CryptoNote::parameters::DANDELION_STEM_EMBARGO),
   logger(log, "protocol"),
-  m_stemPool() {
+  m_stemPool(),
+  m_rejectedTransactions(P2P_KNOWN_TXS_FILTER_SIZE),
+  m_rejectedTransactionsTop(NULL_HASH),
+  m_relayBeforeValidation(false),
+  m_rejectedBlocks(P2P_REJECTED_BLOCKS_FILTER_SIZE) {
   
   if (!m_p2p) {
     m_p2p = &m_p2p_stub;
@@ -255,6 +260,9 @@ int CryptoNoteProtocolHandler::handleCommand(bool is_notify, int command, const
     HANDLE_NOTIFY(NOTIFY_REQUEST_TX_POOL, &CryptoNoteProtocolHandler::handle_request_tx_pool)
     HANDLE_NOTIFY(NOTIFY_NEW_LITE_BLOCK, &CryptoNoteProtocolHandler::handle_notify_new_lite_block)
     HANDLE_NOTIFY(NOTIFY_MISSING_TXS, &CryptoNoteProtocolHandler::handle_notify_missing_txs)
+    HANDLE_NOTIFY(NOTIFY_TX_INVENTORY, &CryptoNoteProtocolHandler::handle_notify_tx_inventory)
+    HANDLE_NOTIFY(NOTIFY_REQUEST_TXS, &CryptoNoteProtocolHandler::handle_request_txs)
+    HANDLE_NOTIFY(NOTIFY_RESPONSE_TXS, &CryptoNoteProtocolHandler::handle_response_txs)
 
   default:
     handled = false;
@@ -276,6 +284,20 @@ int CryptoNoteProtocolHandler::handle_notify_new_block(int command, NOTIFY_NEW_B
     return 1;
   }
 
+  // parsed once here, the core takes the parsed block
+  Block b;
+  if (arg.b.block.size() > m_currency.maxBlockBlobSize()) {
+    logger(Logging::INFO) << context << "New block is too big: " << arg.b.block.size() << ", dropping connection";
+    m_p2p->drop_connection(context, true);
+    return 1;
+  }
+  if (!fromBinaryArray(b, asBinaryArray(arg.b.block))) {
+    logger(Logging::INFO) << context << "Failed to parse new block, dropping connection";
+    m_p2p->drop_connection(context, true);
+    return 1;
+  }
+
+  size_t cumulativeSize = getObjectBinarySize(b.baseTransaction);
   for (auto tx_blob_it = arg.b.txs.begin(); tx_blob_it != arg.b.txs.end(); tx_blob_it++) {
     CryptoNote::tx_verification_context tvc = boost::value_initialized<decltype(tvc)>();
 
@@ -289,20 +311,25 @@ int CryptoNoteProtocolHandler::handle_notify_new_block(int command, NOTIFY_NEW_B
       m_p2p->drop_connection(context, true);
       return 1;
     }
+
+    cumulativeSize += transactionBinary.size();
   }
 
+  NOTIFY_NEW_LITE_BLOCK::request liteArg;
+  liteArg.current_blockchain_height = arg.current_blockchain_height;
+  liteArg.block = arg.b.block;
+  liteArg.hop = arg.hop;
+
   block_verification_context bvc = boost::value_initialized<block_verification_context>();
-  m_core.handle_incoming_block_blob(asBinaryArray(arg.b.block), bvc, true, false);
-  if (bvc.m_verification_failed) {
-    logger(Logging::DEBUGGING) << context << "Block verification failed, dropping connection";
-    m_p2p->drop_connection(context, true);
+  bool relayedEarly;
+  if (!pushNewBlock(b, cumulativeSize, liteArg, context, bvc, relayedEarly)) {
     return 1;
   }
   if (bvc.m_added_to_main_chain) {
     ++arg.hop;
     //TODO: Add here announce protocol usage
     //relay_post_notify<NOTIFY_NEW_BLOCK>(*m_p2p, arg, &context.m_connection_id);
-    relay_block(arg);
+    relayBlock(arg, relayedEarly);
     // relay_block(arg, context);
 
     if (bvc.m_switched_to_alt_chain) {
@@ -324,8 +351,6 @@ int CryptoNoteProtocolHandler::handle_notify_new_transactions(int command, NOTIF
   if (context.m_state != CryptoNoteConnectionContext::state_normal)
     return 1;
 
-  std::vector<Crypto::Hash> txHashes;
-
   if (context.m_pending_lite_block) {
     logger(Logging::TRACE) << context
       << " Pending lite block detected, handling request as missing lite block transactions response";
@@ -334,51 +359,62 @@ int CryptoNoteProtocolHandler::handle_notify_new_transactions(int command, NOTIF
       _txs.push_back(asBinaryArray(tx));
     }
     return doPushLiteBlock(context.m_pending_lite_block->request, context, std::move(_txs));
-  } else {
-    for (auto tx_blob_it = arg.txs.begin(); tx_blob_it != arg.txs.end();) {
-      auto transactionBinary = asBinaryArray(*tx_blob_it);
-      Crypto::Hash transactionHash = Crypto::cn_fast_hash(transactionBinary.data(), transactionBinary.size());
-      logger(DEBUGGING) << "Transaction " << transactionHash << " came in NOTIFY_NEW_TRANSACTIONS"
-                        << " as " << (arg.stem ? "stem" : "fluff");
-      CryptoNote::tx_verification_context tvc = boost::value_initialized<decltype(tvc)>();
-      m_core.handle_incoming_tx(transactionBinary, tvc, false);
-      if (tvc.m_verification_failed) {
-        logger(Logging::DEBUGGING) << context << "Transaction verification failed";
-      }
-      if (!tvc.m_verification_failed && tvc.m_should_be_relayed) {
-        if (!arg.stem) {
-          if (m_stemPool.hasTransaction(transactionHash)) {
-            logger(Logging::DEBUGGING) << "Removing transaction " << transactionHash << " from stempool as already broadcasted";
-            m_stemPool.removeTransaction(transactionHash);
-          }
-        }
-        else {
-          txHashes.push_back(transactionHash);
-          if (!m_stemPool.hasTransaction(transactionHash)) {
-            logger(Logging::DEBUGGING) << "Adding transaction " << transactionHash << " to stempool";
-            m_stemPool.addTransaction(transactionHash, *tx_blob_it);
-          }
-          else { // tx made roundtrip as stem, fluff it
-            logger(Logging::DEBUGGING) << "Removing transaction " << transactionHash << " from stempool and fluff";
-            m_stemPool.removeTransaction(transactionHash);
-            txHashes.erase(std::remove(txHashes.begin(), txHashes.end(), transactionHash), txHashes.end());
-            arg.stem = false;
-          }
+  }
+
+  processNewTransactions(arg, context);
+  return true;
+}
+
+void CryptoNoteProtocolHandler::processNewTransactions(NOTIFY_NEW_TRANSACTIONS::request& arg, CryptoNoteConnectionContext& context) {
+  std::vector<Crypto::Hash> txHashes;
+
+  for (auto tx_blob_it = arg.txs.begin(); tx_blob_it != arg.txs.end();) {
+    auto transactionBinary = asBinaryArray(*tx_blob_it);
+    Crypto::Hash transactionHash = Crypto::cn_fast_hash(transactionBinary.data(), transactionBinary.size());
+    logger(DEBUGGING) << "Transaction " << transactionHash << " came in NOTIFY_NEW_TRANSACTIONS"
+                      << " as " << (arg.stem ? "stem" : "fluff");
+    if (context.version >= P2P_TX_INVENTORY_VERSION) {
+      context.m_known_txs.insert(transactionHash);
+    }
+
+    CryptoNote::tx_verification_context tvc = boost::value_initialized<decltype(tvc)>();
+    m_core.handle_incoming_tx(transactionBinary, tvc, false);
+    if (tvc.m_verification_failed) {
+      logger(Logging::DEBUGGING) << context << "Transaction verification failed";
+      m_rejectedTransactions.insert(transactionHash);
+    }
+    if (!tvc.m_verification_failed && tvc.m_should_be_relayed) {
+      if (!arg.stem) {
+        if (m_stemPool.hasTransaction(transactionHash)) {
+          logger(Logging::DEBUGGING) << "Removing transaction " << transactionHash << " from stempool as already broadcasted";
+          m_stemPool.removeTransaction(transactionHash);
         }
-        ++tx_blob_it;
       }
       else {
-        if (m_stemPool.hasTransaction(transactionHash)) {
-          logger(Logging::DEBUGGING) << "Removing transaction " << transactionHash << " from stempool as already broadcasted";
+        txHashes.push_back(transactionHash);
+        if (!m_stemPool.hasTransaction(transactionHash)) {
+          logger(Logging::DEBUGGING) << "Adding transaction " << transactionHash << " to stempool";
+          m_stemPool.addTransaction(transactionHash, *tx_blob_it);
+        }
+        else { // tx made roundtrip as stem, fluff it
+          logger(Logging::DEBUGGING) << "Removing transaction " << transactionHash << " from stempool and fluff";
           m_stemPool.removeTransaction(transactionHash);
+          txHashes.erase(std::remove(txHashes.begin(), txHashes.end(), transactionHash), txHashes.end());
+          arg.stem = false;
         }
-        tx_blob_it = arg.txs.erase(tx_blob_it);
       }
+      ++tx_blob_it;
+    }
+    else {
+      if (m_stemPool.hasTransaction(transactionHash)) {
+        logger(Logging::DEBUGGING) << "Removing transaction " << transactionHash << " from stempool as already broadcasted";
+        m_stemPool.removeTransaction(transactionHash);
+      }
+      tx_blob_it = arg.txs.erase(tx_blob_it);
     }
   }
 
   if (arg.txs.size()) {
-    //TODO: add announce usage here
     if (arg.stem && !m_dandelion_stem.empty()) {
       std::mt19937 rng = Random::generator();
       std::uniform_int_distribution<> dis(0, 100);
@@ -393,7 +429,7 @@ int CryptoNoteProtocolHandler::handle_notify_new_transactions(int command, NOTIF
                 m_stemPool.removeTransaction(h);
                 logger(Logging::DEBUGGING) << h;
               }
-              relay_post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, arg, &context.m_connection_id); // Fluff broadcast
+              relayFluffTransactions(arg, &context.m_connection_id); // Fluff broadcast
               break;
             }
           }
@@ -405,15 +441,13 @@ int CryptoNoteProtocolHandler::handle_notify_new_transactions(int command, NOTIF
           m_stemPool.removeTransaction(h);
           logger(Logging::DEBUGGING) << h;
         }
-        relay_post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, arg, &context.m_connection_id);
+        relayFluffTransactions(arg, &context.m_connection_id);
       }
     } else { // Fluff broadcast
       arg.stem = false;
-      relay_post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, arg, &context.m_connection_id);
+      relayFluffTransactions(arg, &context.m_connection_id);
     }
   }
-
-  return true;
 }
 
 int CryptoNoteProtocolHandler::handle_request_get_objects(int command, NOTIFY_REQUEST_GET_OBJECTS::request& arg, CryptoNoteConnectionContext& context) {
@@ -686,8 +720,7 @@ bool CryptoNoteProtocolHandler::fluffStemPool() {
         notification.txs.push_back(s.second);
       logger(Logging::DEBUGGING) << s.first;
     }
-    auto buf = LevinProtocol::encode(notification);
-    m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_TRANSACTIONS::ID, buf, nullptr);
+    relayFluffTransactions(notification, nullptr);
 
     m_stemPool.clearStemPool();
   }
@@ -701,12 +734,30 @@ bool CryptoNoteProtocolHandler::fluffStemPool() {
 bool CryptoNoteProtocolHandler::on_idle() {
   m_dandelionStemSelectInterval.call([&]() { return select_dandelion_stem(); });
   m_dandelionStemFluffInterval.call([&]() { return fluffStemPool(); });
+
+  uint32_t height;
+  Crypto::Hash top;
+  m_core.get_blockchain_top(height, top);
+  if (top != m_rejectedTransactionsTop) {
+    m_rejectedTransactions.clear();
+    m_rejectedTransactionsTop = top;
+  }
+
+  // the transactions relayed since the last call are announced together, once a second
+  announceTransactions();
+  retryTransactionRequests();
+
   return m_core.on_idle();
 }
 
 int CryptoNoteProtocolHandler::doPushLiteBlock(NOTIFY_NEW_LITE_BLOCK::request arg, CryptoNoteConnectionContext &context,
                                               std::vector<BinaryArray> missingTxs) {
   Block b;
+  if (arg.block.size() > m_currency.maxBlockBlobSize()) {
+    logger(Logging::WARNING) << context << "Lite block is too big: " << arg.block.size() << ", dropping connection";
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
   if (!fromBinaryArray(b, asBinaryArray(arg.block))) {
     logger(Logging::WARNING) << context << "Deserialization of Block Template failed, dropping connection";
     context.m_state = CryptoNoteConnectionContext::state_shutdown;
@@ -763,6 +814,7 @@ int CryptoNoteProtocolHandler::doPushLiteBlock(NOTIFY_NEW_LITE_BLOCK::request ar
   if (need_txs.empty()) {
     context.m_pending_lite_block = boost::none;
 
+    size_t cumulativeSize = getObjectBinarySize(b.baseTransaction);
     for (auto transactionBinary : have_txs) {
       CryptoNote::tx_verification_context tvc = boost::value_initialized<decltype(tvc)>();
 
@@ -772,19 +824,23 @@ int CryptoNoteProtocolHandler::doPushLiteBlock(NOTIFY_NEW_LITE_BLOCK::request ar
         m_p2p->drop_connection(context, true);
         return 1;
       }
+
+      cumulativeSize += transactionBinary.size();
     }
 
     block_verification_context bvc = boost::value_initialized<block_verification_context>();
-    m_core.handle_incoming_block_blob(asBinaryArray(arg.block), bvc, true, false);
-    if (bvc.m_verification_failed) {
-      logger(Logging::DEBUGGING) << context << "Lite block verification failed, dropping connection";
-      m_p2p->drop_connection(context, true);
+    bool relayedEarly;
+    if (!pushNewBlock(b, cumulativeSize, arg, context, bvc, relayedEarly)) {
       return 1;
     }
     if (bvc.m_added_to_main_chain) {
       ++arg.hop;
       //TODO: Add here announce protocol usage
-      relay_post_notify<NOTIFY_NEW_LITE_BLOCK>(*m_p2p, arg, &context.m_connection_id);
+      if (relayedEarly) {
+        relayLiteBlock(arg, &context.m_connection_id, false);
+      } else {
+        relay_post_notify<NOTIFY_NEW_LITE_BLOCK>(*m_p2p, arg, &context.m_connection_id);
+      }
 
       if (bvc.m_switched_to_alt_chain) {
         requestMissingPoolTransactions(context);
@@ -1026,7 +1082,195 @@ int CryptoNoteProtocolHandler::handle_notify_missing_txs(int command,  NOTIFY_MI
   return 1;
 }
 
+int CryptoNoteProtocolHandler::handle_notify_tx_inventory(int command, NOTIFY_TX_INVENTORY::request& arg,
+                                                          CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_TX_INVENTORY: txs.size() = " << arg.txs.size();
+  if (context.m_state != CryptoNoteConnectionContext::state_normal) {
+    return 1;
+  }
+
+  if (arg.txs.size() > P2P_TX_INVENTORY_MAX_COUNT) {
+    logger(Logging::DEBUGGING) << context << "NOTIFY_TX_INVENTORY: too many transactions " << arg.txs.size() << ", dropping connection";
+    m_p2p->drop_connection(context, true);
+    return 1;
+  }
+
+  time_t now = time(nullptr);
+  std::vector<Crypto::Hash> missingTxs;
+  for (const auto& hash : arg.txs) {
+    context.m_known_txs.insert(hash);
+
+    if (m_stemPool.hasTransaction(hash)) {
+      logger(Logging::DEBUGGING) << "Removing transaction " << hash << " from stempool as already broadcasted";
+      m_stemPool.removeTransaction(hash);
+      continue;
+    }
+
+    if (m_rejectedTransactions.contains(hash) || m_core.haveTransaction(hash)) {
+      continue;
+    }
+
+    // a peer that already was asked for the transaction isn't remembered again, nor more than a few peers per transaction
+    auto it = m_requestedTransactions.find(hash);
+    if (it != m_requestedTransactions.end()) {
+      TransactionRequest& request = it->second;
+      if (request.announcers.size() < P2P_TX_ANNOUNCERS_MAX &&
+          std::find(request.announcers.begin(), request.announcers.end(), context.m_connection_id) == request.announcers.end()) {
+        request.announcers.push_back(context.m_connection_id);
+      }
+
+      continue;
+    }
+
+    // the rest is ignored until the peer answers the outstanding requests, another peer can announce it meanwhile
+    if (context.m_requested_txs >= P2P_TX_REQUESTS_PER_CONNECTION_MAX || m_requestedTransactions.size() >= P2P_TX_REQUESTS_MAX) {
+      logger(Logging::DEBUGGING) << context << "NOTIFY_TX_INVENTORY: too many transactions requested, "
+        << context.m_requested_txs << " from the peer, " << m_requestedTransactions.size() << " in total";
+      break;
+    }
+
+    m_requestedTransactions.emplace(hash, TransactionRequest{ now, context.m_connection_id, { context.m_connection_id }, 1 });
+    ++context.m_requested_txs;
+    missingTxs.push_back(hash);
+  }
+
+  requestTransactions(missingTxs, context);
+
+  return 1;
+}
+
+int CryptoNoteProtocolHandler::handle_request_txs(int command, NOTIFY_REQUEST_TXS::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_REQUEST_TXS: txs.size() = " << arg.txs.size();
+  if (context.m_state != CryptoNoteConnectionContext::state_normal) {
+    return 1;
+  }
+
+  if (arg.txs.size() > P2P_TX_INVENTORY_MAX_COUNT) {
+    logger(Logging::DEBUGGING) << context << "NOTIFY_REQUEST_TXS: too many transactions " << arg.txs.size() << ", dropping connection";
+    m_p2p->drop_connection(context, true);
+    return 1;
+  }
+
+  // only the pool is looked up, the transactions that left it since they were announced are left out and the peer
+  // asks another one for them
+  NOTIFY_RESPONSE_TXS::request response;
+  for (const auto& transactionHash : arg.txs) {
+    Transaction tx;
+    if (!m_core.getPoolTransaction(transactionHash, tx)) {
+      continue;
+    }
+
+    BinaryArray transactionBinary = toBinaryArray(tx);
+    context.m_known_txs.insert(getBinaryArrayHash(transactionBinary));
+    response.txs.push_back(asString(transactionBinary));
+  }
+
+  if (!response.txs.empty() && !post_notify<NOTIFY_RESPONSE_TXS>(*m_p2p, response, context)) {
+    logger(Logging::DEBUGGING) << context << "Failed to post notification NOTIFY_RESPONSE_TXS";
+  }
+
+  return 1;
+}
+
+int CryptoNoteProtocolHandler::handle_response_txs(int command, NOTIFY_RESPONSE_TXS::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_RESPONSE_TXS: txs.size() = " << arg.txs.size();
+  if (context.m_state != CryptoNoteConnectionContext::state_normal) {
+    return 1;
+  }
+
+  // only the transactions requested from this peer are taken, it can't push anything else this way
+  NOTIFY_NEW_TRANSACTIONS::request notification;
+  notification.stem = false;
+  for (auto& tx : arg.txs) {
+    Crypto::Hash transactionHash = Crypto::cn_fast_hash(tx.data(), tx.size());
+    auto it = m_requestedTransactions.find(transactionHash);
+    if (it == m_requestedTransactions.end() || it->second.connection != context.m_connection_id) {
+      logger(Logging::DEBUGGING) << context << "Transaction " << transactionHash << " wasn't requested from the peer";
+      continue;
+    }
+
+    m_requestedTransactions.erase(it);
+    --context.m_requested_txs;
+    notification.txs.push_back(std::move(tx));
+  }
+
+  if (!notification.txs.empty()) {
+    processNewTransactions(notification, context);
+  }
+
+  return 1;
+}
+
 void CryptoNoteProtocolHandler::relay_block(NOTIFY_NEW_BLOCK::request& arg) {
+  relayBlock(arg, false);
+}
+
+bool CryptoNoteProtocolHandler::pushNewBlock(const Block& b, size_t cumulativeSize, const NOTIFY_NEW_LITE_BLOCK::request& arg,
+                                             CryptoNoteConnectionContext& context, block_verification_context& bvc, bool& relayedEarly) {
+  relayedEarly = false;
+  Crypto::Hash blockHash = get_block_hash(b);
+  if (m_rejectedBlocks.contains(blockHash)) {
+    logger(Logging::DEBUGGING) << context << "Block " << blockHash << " failed validation already";
+    return false;
+  }
+
+  // another peer sent it first and it may have been relayed already
+  if (!m_blocksInValidation.insert(blockHash).second) {
+    logger(Logging::TRACE) << context << "Block " << blockHash << " is being validated";
+    return false;
+  }
+
+  // released on every path, a block whose validation threw can be sent again
+  BOOST_SCOPE_EXIT_ALL(this, &blockHash) { m_blocksInValidation.erase(blockHash); };
+
+  relayedEarly = m_relayBeforeValidation && m_core.prevalidateBlock(b, cumulativeSize);
+  if (relayedEarly) {
+    NOTIFY_NEW_LITE_BLOCK::request liteArg = arg;
+    ++liteArg.hop;
+    relayLiteBlock(liteArg, &context.m_connection_id, true);
+
+    // the transaction checks take the most of the validation, the connections are served meanwhile
+    System::RemoteContext<void> validation(m_dispatcher, [this, &b, &bvc] {
+      m_core.handle_incoming_block(b, bvc, true, false);
+    });
+    validation.get();
+  } else {
+    m_core.handle_incoming_block(b, bvc, true, false);
+  }
+
+  if (!bvc.m_verification_failed) {
+    return true;
+  }
+
+  if (relayedEarly) {
+    m_rejectedBlocks.insert(blockHash);
+  }
+
+  // the proof of work of the block is right, a peer that relays blocks before validation might have been misled too
+  if (relayedEarly && context.version >= P2P_EARLY_BLOCK_RELAY_VERSION) {
+    logger(Logging::INFO) << context << "Block " << blockHash << " failed validation after it was relayed";
+  } else {
+    logger(Logging::DEBUGGING) << context << "Block verification failed, dropping connection";
+    m_p2p->drop_connection(context, true);
+  }
+
+  return false;
+}
+
+void CryptoNoteProtocolHandler::relayLiteBlock(NOTIFY_NEW_LITE_BLOCK::request& arg, const net_connection_id* excludeConnection, bool beforeValidation) {
+  BinaryArray buf = LevinProtocol::encode(arg);
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& ctx, PeerIdType peerId) {
+    if ((excludeConnection != nullptr && ctx.m_connection_id == *excludeConnection) ||
+        (ctx.m_state != CryptoNoteConnectionContext::state_normal && ctx.m_state != CryptoNoteConnectionContext::state_synchronizing) ||
+        (ctx.version >= P2P_EARLY_BLOCK_RELAY_VERSION) != beforeValidation) {
+      return;
+    }
+
+    m_p2p->invoke_notify_to_peer(NOTIFY_NEW_LITE_BLOCK::ID, buf, ctx);
+  });
+}
+
+void CryptoNoteProtocolHandler::relayBlock(NOTIFY_NEW_BLOCK::request& arg, bool skipEarlyRelayPeers) {
   // generate a lite block request from the received normal block
   NOTIFY_NEW_LITE_BLOCK::request lite_arg;
   lite_arg.current_blockchain_height = arg.current_blockchain_height;
@@ -1044,8 +1288,12 @@ void CryptoNoteProtocolHandler::relay_block(NOTIFY_NEW_BLOCK::request& arg) {
   std::list<boost::uuids::uuid> liteBlockConnections, normalBlockConnections;
 
   // sort the peers into their support categories
-  m_p2p->for_each_connection([this, &liteBlockConnections, &normalBlockConnections](
+  m_p2p->for_each_connection([this, &liteBlockConnections, &normalBlockConnections, skipEarlyRelayPeers](
     const CryptoNoteConnectionContext &ctx, uint64_t peerId) {
+    if (skipEarlyRelayPeers && ctx.version >= P2P_EARLY_BLOCK_RELAY_VERSION) {
+      return;
+    }
+
     if (ctx.version >= P2P_LITE_BLOCKS_PROPOGATION_VERSION) {
       logger(Logging::DEBUGGING) << ctx << "Peer supports lite-blocks... adding peer to lite block list";
       liteBlockConnections.push_back(ctx.m_connection_id);
@@ -1061,8 +1309,7 @@ void CryptoNoteProtocolHandler::relay_block(NOTIFY_NEW_BLOCK::request& arg) {
   }
 
   if (!normalBlockConnections.empty()) {
-    auto buf = LevinProtocol::encode(arg);
-    m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_BLOCK::ID, buf, nullptr);
+    m_p2p->externalRelayNotifyToList(NOTIFY_NEW_BLOCK::ID, buf, normalBlockConnections);
   }
 }
 
@@ -1096,8 +1343,7 @@ void CryptoNoteProtocolHandler::relay_transactions(NOTIFY_NEW_TRANSACTIONS::requ
               logger(Logging::DEBUGGING) << h;
             }
 
-            auto buf = LevinProtocol::encode(arg);
-            m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_TRANSACTIONS::ID, buf, nullptr);
+            m_dispatcher.remoteSpawn([this, arg] { relayFluffTransactions(arg, nullptr); });
             break;
           }
         }
@@ -1109,14 +1355,126 @@ void CryptoNoteProtocolHandler::relay_transactions(NOTIFY_NEW_TRANSACTIONS::requ
         m_stemPool.removeTransaction(h);
         logger(Logging::DEBUGGING) << h;
       }
-      auto buf = LevinProtocol::encode(arg);
-      m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_TRANSACTIONS::ID, buf, nullptr);
+      m_dispatcher.remoteSpawn([this, arg] { relayFluffTransactions(arg, nullptr); });
     }
   } else { // Fluff broadcast
     logger(Logging::DEBUGGING) << "Not stem or no stem peers, fluff broadcast of transactions...";
     arg.stem = false;
-    auto buf = LevinProtocol::encode(arg);
-    m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_TRANSACTIONS::ID, buf, nullptr);
+    m_dispatcher.remoteSpawn([this, arg] { relayFluffTransactions(arg, nullptr); });
+  }
+}
+
+void CryptoNoteProtocolHandler::relayFluffTransactions(const NOTIFY_NEW_TRANSACTIONS::request& arg, const net_connection_id* excludeConnection) {
+  std::vector<Crypto::Hash> txHashes;
+  txHashes.reserve(arg.txs.size());
+  for (const auto& tx : arg.txs) {
+    txHashes.push_back(Crypto::cn_fast_hash(tx.data(), tx.size()));
+  }
+
+  std::list<boost::uuids::uuid> fullRelayConnections;
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& ctx, PeerIdType peerId) {
+    if ((excludeConnection != nullptr && ctx.m_connection_id == *excludeConnection) ||
+        (ctx.m_state != CryptoNoteConnectionContext::state_normal && ctx.m_state != CryptoNoteConnectionContext::state_synchronizing)) {
+      return;
+    }
+
+    if (ctx.version < P2P_TX_INVENTORY_VERSION) {
+      fullRelayConnections.push_back(ctx.m_connection_id);
+      return;
+    }
+
+    for (const auto& hash : txHashes) {
+      if (!ctx.m_known_txs.contains(hash)) {
+        ctx.m_known_txs.insert(hash);
+        ctx.m_tx_announcements.push_back(hash);
+      }
+    }
+  });
+
+  if (!fullRelayConnections.empty()) {
+    m_p2p->externalRelayNotifyToList(NOTIFY_NEW_TRANSACTIONS::ID, LevinProtocol::encode(arg), fullRelayConnections);
+  }
+}
+
+void CryptoNoteProtocolHandler::announceTransactions() {
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& ctx, PeerIdType peerId) {
+    std::vector<Crypto::Hash>& announcements = ctx.m_tx_announcements;
+    for (size_t i = 0; i < announcements.size(); i += P2P_TX_INVENTORY_MAX_COUNT) {
+      NOTIFY_TX_INVENTORY::request notification;
+      notification.txs.assign(announcements.begin() + i, announcements.begin() + std::min(i + P2P_TX_INVENTORY_MAX_COUNT, announcements.size()));
+      logger(Logging::TRACE) << ctx << "-->>NOTIFY_TX_INVENTORY: txs.size() = " << notification.txs.size();
+      post_notify<NOTIFY_TX_INVENTORY>(*m_p2p, notification, ctx);
+    }
+
+    announcements.clear();
+  });
+}
+
+void CryptoNoteProtocolHandler::requestTransactions(const std::vector<Crypto::Hash>& txs, const CryptoNoteConnectionContext& context) {
+  for (size_t i = 0; i < txs.size(); i += P2P_TX_INVENTORY_MAX_COUNT) {
+    NOTIFY_REQUEST_TXS::request request;
+    request.txs.assign(txs.begin() + i, txs.begin() + std::min(i + P2P_TX_INVENTORY_MAX_COUNT, txs.size()));
+    logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_TXS: txs.size() = " << request.txs.size();
+    post_notify<NOTIFY_REQUEST_TXS>(*m_p2p, request, context);
+  }
+}
+
+void CryptoNoteProtocolHandler::retryTransactionRequests() {
+  if (m_requestedTransactions.empty()) {
+    return;
+  }
+
+  std::map<net_connection_id, CryptoNoteConnectionContext*> connections;
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& ctx, PeerIdType peerId) {
+    connections[ctx.m_connection_id] = &ctx;
+  });
+
+  time_t now = time(nullptr);
+  std::map<net_connection_id, std::vector<Crypto::Hash>> requests;
+  for (auto it = m_requestedTransactions.begin(); it != m_requestedTransactions.end();) {
+    TransactionRequest& request = it->second;
+    if (now - request.time < static_cast<time_t>(P2P_TX_REQUEST_TIMEOUT)) {
+      ++it;
+      continue;
+    }
+
+    // the peer asked last doesn't owe the transaction anymore
+    auto previous = connections.find(request.connection);
+    if (previous != connections.end()) {
+      --previous->second->m_requested_txs;
+    }
+
+    // it could come in a block or from a peer that relays full transactions meanwhile
+    if (m_core.haveTransaction(it->first)) {
+      it = m_requestedTransactions.erase(it);
+      continue;
+    }
+
+    // ask the next peer that announced the transaction, is still connected and has room for it
+    auto connection = connections.end();
+    while (connection == connections.end() && request.next < request.announcers.size()) {
+      connection = connections.find(request.announcers[request.next++]);
+      if (connection != connections.end() && (connection->second->m_state != CryptoNoteConnectionContext::state_normal ||
+          connection->second->m_requested_txs >= P2P_TX_REQUESTS_PER_CONNECTION_MAX)) {
+        connection = connections.end();
+      }
+    }
+
+    if (connection == connections.end()) {
+      logger(Logging::DEBUGGING) << "Transaction " << it->first << " wasn't received from any peer that announced it";
+      it = m_requestedTransactions.erase(it);
+      continue;
+    }
+
+    request.time = now;
+    request.connection = connection->first;
+    ++connection->second->m_requested_txs;
+    requests[connection->first].push_back(it->first);
+    ++it;
+  }
+
+  for (const auto& request : requests) {
+    requestTransactions(request.second, *connections[request.first]);
   }
 }
 
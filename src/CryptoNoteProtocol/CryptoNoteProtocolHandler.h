@@ -19,6 +19,8 @@
 #pragma once
 
 #include <atomic>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <Common/ObserverManager.h>
 
@@ -33,6 +35,7 @@
 #include "P2p/P2pProtocolDefinitions.h"
 #include "P2p/NetNodeCommon.h"
 #include "P2p/ConnectionContext.h"
+#include "P2p/RollingHashFilter.h"
 
 #include <Logging/LoggerRef.h>
 
@@ -148,6 +151,9 @@ namespace CryptoNote
     void requestMissingPoolTransactions(const CryptoNoteConnectionContext& context);
     bool select_dandelion_stem();
     bool fluffStemPool();
+    // When enabled, a new block that passes ICore::prevalidateBlock is relayed to the peers that take blocks before
+    // their validation right away and validated afterwards. Disabled by default, the daemon enables it.
+    void setRelayBeforeValidation(bool enabled) { m_relayBeforeValidation = enabled; }
 
   private:
     //----------------- commands handlers ----------------------------------------------
@@ -160,6 +166,9 @@ namespace CryptoNote
     int handle_request_tx_pool(int command, NOTIFY_REQUEST_TX_POOL::request& arg, CryptoNoteConnectionContext& context);
     int handle_notify_new_lite_block(int command, NOTIFY_NEW_LITE_BLOCK::request &arg, CryptoNoteConnectionContext &context);
     int handle_notify_missing_txs(int command, NOTIFY_MISSING_TXS::request &arg, CryptoNoteConnectionContext &context);
+    int handle_notify_tx_inventory(int command, NOTIFY_TX_INVENTORY::request& arg, CryptoNoteConnectionContext& context);
+    int handle_request_txs(int command, NOTIFY_REQUEST_TXS::request& arg, CryptoNoteConnectionContext& context);
+    int handle_response_txs(int command, NOTIFY_RESPONSE_TXS::request& arg, CryptoNoteConnectionContext& context);
 
     //----------------- i_cryptonote_protocol ----------------------------------
     virtual void relay_block(NOTIFY_NEW_BLOCK::request& arg) override;
@@ -172,6 +181,21 @@ namespace CryptoNote
     void updateObservedHeight(uint32_t peerHeight, const CryptoNoteConnectionContext& context);
     void recalculateMaxObservedHeight(const CryptoNoteConnectionContext& context);
     int processObjects(CryptoNoteConnectionContext& context, const std::vector<parsed_block_entry>& blocks);
+    void processNewTransactions(NOTIFY_NEW_TRANSACTIONS::request& arg, CryptoNoteConnectionContext& context);
+    // Must be called on the dispatcher thread. Queues the hashes for the next announcement to the peers that relay
+    // by inventory and don't know them yet, and sends the full transactions to the older peers.
+    void relayFluffTransactions(const NOTIFY_NEW_TRANSACTIONS::request& arg, const net_connection_id* excludeConnection);
+    void announceTransactions();
+    void requestTransactions(const std::vector<Crypto::Hash>& txs, const CryptoNoteConnectionContext& context);
+    void retryTransactionRequests();
+    // Adds a new block from the peer to the chain. False when it is being validated already or failed validation,
+    // relayedEarly tells whether it was relayed before validation.
+    bool pushNewBlock(const Block& b, size_t cumulativeSize, const NOTIFY_NEW_LITE_BLOCK::request& arg,
+                      CryptoNoteConnectionContext& context, block_verification_context& bvc, bool& relayedEarly);
+    // Sends the block to the peers that take blocks before their validation, or to the other ones when
+    // beforeValidation is false
+    void relayLiteBlock(NOTIFY_NEW_LITE_BLOCK::request& arg, const net_connection_id* excludeConnection, bool beforeValidation);
+    void relayBlock(NOTIFY_NEW_BLOCK::request& arg, bool skipEarlyRelayPeers);
     Logging::LoggerRef logger;
 
   private:
@@ -198,5 +222,26 @@ namespace CryptoNote
     std::vector<CryptoNoteConnectionContext> m_dandelion_stem;
 
     StemPool m_stemPool;
+
+    // Transactions requested after an announcement, the other peers that announced them are asked in turn when the
+    // request times out. Used on the dispatcher thread only, as the rejected transactions filter.
+    struct TransactionRequest {
+      time_t time;
+      net_connection_id connection;
+      // the peers that announced the transaction in order, the ones before next were already asked for it
+      std::vector<net_connection_id> announcers;
+      size_t next;
+    };
+
+    std::unordered_map<Crypto::Hash, TransactionRequest> m_requestedTransactions;
+    // transactions that failed verification on top of m_rejectedTransactionsTop, they aren't requested again
+    RollingHashFilter m_rejectedTransactions;
+    Crypto::Hash m_rejectedTransactionsTop;
+
+    bool m_relayBeforeValidation;
+    // Used on the dispatcher thread only. Blocks relayed before validation that failed it are remembered, so that
+    // they aren't relayed again when the other peers send them back.
+    std::unordered_set<Crypto::Hash> m_blocksInValidation;
+    RollingHashFilter m_rejectedBlocks;
   };
 }
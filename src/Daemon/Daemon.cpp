@@ -70,6 +70,7 @@ namespace
   const command_line::arg_descriptor<std::string> arg_load_checkpoints          = { "load-checkpoints", "<filename> Load checkpoints from csv file.", "" };
   const command_line::arg_descriptor<bool>        arg_disable_checkpoints       = { "without-checkpoints", "Synchronize without checkpoints" };
   const command_line::arg_descriptor<std::string> arg_rollback                  = { "rollback", "Rollback blockchain to <height>", "", true };
+  const command_line::arg_descriptor<bool>        arg_validate_before_relay     = { "validate-blocks-before-relay", "Relay new blocks only after their full validation" };
 
   bool command_line_preprocessor(const boost::program_options::variables_map &vm, LoggerRef &logger) {
     bool exit = false;
@@ -152,6 +153,7 @@ int main(int argc, char* argv[])
     command_line::add_arg(desc_cmd_sett, arg_load_checkpoints);
     command_line::add_arg(desc_cmd_sett, arg_disable_checkpoints);
     command_line::add_arg(desc_cmd_sett, arg_rollback);
+    command_line::add_arg(desc_cmd_sett, arg_validate_before_relay);
 
     RpcServerConfig::initOptions(desc_cmd_sett);
     CoreConfig::initOptions(desc_cmd_sett);
@@ -315,6 +317,7 @@ int main(int argc, char* argv[])
     CryptoNote::RpcServer rpcServer(dispatcher, logManager, m_core, p2psrv, cprotocol);
 
     cprotocol.set_p2p_endpoint(&p2psrv);
+    cprotocol.setRelayBeforeValidation(!command_line::get_arg(vm, arg_validate_before_relay));
     m_core.set_cryptonote_protocol(&cprotocol);
     DaemonCommandsHandler dch(m_core, p2psrv, logManager, cprotocol, &rpcServer);
 
@@ -379,10 +382,6 @@ int main(int argc, char* argv[])
         logger(ERROR, BRIGHT_RED) << "Start RPC SSL server was canceled because certificate file(s) could not be found" << std::endl;
       }
     }
-    std::string ssl_info = "";
-    if (server_ssl_enable) ssl_info += ", SSL on address " + rpcConfig.getBindAddressSSL();
-    logger(INFO) << "Starting core rpc server on address " << rpcConfig.getBindAddress() << ssl_info;
-    rpcServer.start(rpcConfig.getBindIP(), rpcConfig.getBindPort(), rpcConfig.getBindPortSSL(), server_ssl_enable);
     rpcServer.restrictRpc(rpcConfig.restrictedRPC);
     rpcServer.enableCors(rpcConfig.enableCors);
     if (!rpcConfig.nodeFeeAddress.empty() && !rpcConfig.nodeFeeAmountStr.empty()) {
@@ -413,6 +412,18 @@ int main(int argc, char* argv[])
     if (!rpcConfig.contactInfo.empty()) {
       rpcServer.setContactInfo(rpcConfig.contactInfo);
     }
+
+    // configure before starting, handlers may run on RPC threads right away
+    std::string ssl_info = "";
+    if (server_ssl_enable) ssl_info += ", SSL on address " + rpcConfig.getBindAddressSSL();
+    logger(INFO) << "Starting core rpc server on address " << rpcConfig.getBindAddress() << ssl_info;
+    rpcServer.setThreads(rpcConfig.getThreads());
+    rpcServer.setChunkedEncoding(rpcConfig.isChunkedEncoding());
+    rpcServer.setCompression(rpcConfig.getCompressionLevel(), rpcConfig.getCompressionThreshold(), rpcConfig.getCompressionThreads());
+    rpcServer.enableWorkers(rpcConfig.getWorkers(), rpcConfig.getWorkersQueue());
+    rpcServer.enableResponseCache(rpcConfig.getCacheEntries());
+    rpcServer.enableAdmissionControl(rpcConfig.getLimitRate(), rpcConfig.getLimitBurst(), rpcConfig.getLimitHeavyCost(), rpcConfig.getLimitInFlight());
+    rpcServer.start(rpcConfig.getBindIP(), rpcConfig.getBindPort(), rpcConfig.getBindPortSSL(), server_ssl_enable);
     logger(INFO) << "Core rpc server started ok";
 
     Tools::SignalHandler::install([&dch, &p2psrv] {
@@ -9,6 +9,8 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <thread>
+
 #include "linenoise.hpp"
 
 #include <GreenWallet/Sync.h>
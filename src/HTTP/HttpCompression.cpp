@@ -0,0 +1,261 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "HttpCompression.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "Common/StreamTools.h"
+#include "Common/StringOutputStream.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace CryptoNote {
+
+namespace {
+
+const size_t BUFFER_SIZE = 16 * 1024;
+
+std::string trim(const std::string& value) {
+  size_t begin = value.find_first_not_of(" \t");
+  if (begin == std::string::npos) {
+    return std::string();
+  }
+
+  return value.substr(begin, value.find_last_not_of(" \t") - begin + 1);
+}
+
+std::string toLower(std::string value) {
+  std::transform(value.begin(), value.end(), value.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+  return value;
+}
+
+#ifdef HAVE_ZLIB
+// gzip wraps the deflate stream in a gzip header, HTTP deflate means the zlib format
+int windowBits(HttpContentEncoding encoding) {
+  return encoding == HttpContentEncoding::GZIP ? 15 + 16 : 15;
+}
+#endif
+
+}
+
+#ifdef HAVE_ZLIB
+struct CompressingOutputStream::State {
+  z_stream zstream;
+  char buffer[BUFFER_SIZE];
+};
+#else
+struct CompressingOutputStream::State {
+};
+#endif
+
+bool isHttpCompressionSupported() {
+#ifdef HAVE_ZLIB
+  return true;
+#else
+  return false;
+#endif
+}
+
+HttpContentEncoding negotiateContentEncoding(const std::string& acceptEncoding) {
+  if (!isHttpCompressionSupported()) {
+    return HttpContentEncoding::IDENTITY;
+  }
+
+  double gzipWeight = 0;
+  double deflateWeight = 0;
+  double anyWeight = 0;
+  bool gzipListed = false;
+  size_t begin = 0;
+  while (begin <= acceptEncoding.size()) {
+    size_t end = std::min(acceptEncoding.find(',', begin), acceptEncoding.size());
+    std::string item = acceptEncoding.substr(begin, end - begin);
+    begin = end + 1;
+
+    double weight = 1;
+    size_t parameters = item.find(';');
+    if (parameters != std::string::npos) {
+      std::string parameter = trim(item.substr(parameters + 1));
+      if (parameter.size() > 2 && (parameter[0] == 'q' || parameter[0] == 'Q') && parameter[1] == '=') {
+        weight = std::atof(parameter.c_str() + 2);
+      }
+
+      item.resize(parameters);
+    }
+
+    std::string coding = toLower(trim(item));
+    if (coding == "gzip" || coding == "x-gzip") {
+      gzipWeight = weight;
+      gzipListed = true;
+    } else if (coding == "deflate") {
+      deflateWeight = weight;
+    } else if (coding == "*") {
+      anyWeight = weight;
+    }
+  }
+
+  if (!gzipListed) {
+    gzipWeight = anyWeight;
+  }
+
+  if (gzipWeight > 0 && gzipWeight >= deflateWeight) {
+    return HttpContentEncoding::GZIP;
+  }
+
+  return deflateWeight > 0 ? HttpContentEncoding::DEFLATE : HttpContentEncoding::IDENTITY;
+}
+
+const char* getContentEncodingName(HttpContentEncoding encoding) {
+  switch (encoding) {
+  case HttpContentEncoding::GZIP:
+    return "gzip";
+  case HttpContentEncoding::DEFLATE:
+    return "deflate";
+  default:
+    return "identity";
+  }
+}
+
+bool parseContentEncoding(const std::string& name, HttpContentEncoding& encoding) {
+  std::string coding = toLower(trim(name));
+  if (coding.empty() || coding == "identity") {
+    encoding = HttpContentEncoding::IDENTITY;
+    return true;
+  }
+
+  if (!isHttpCompressionSupported()) {
+    return false;
+  }
+
+  if (coding == "gzip" || coding == "x-gzip") {
+    encoding = HttpContentEncoding::GZIP;
+    return true;
+  }
+
+  if (coding == "deflate") {
+    encoding = HttpContentEncoding::DEFLATE;
+    return true;
+  }
+
+  return false;
+}
+
+std::string compressBody(const std::string& body, HttpContentEncoding encoding, int level) {
+  std::string result;
+  Common::StringOutputStream output(result);
+  CompressingOutputStream stream(output, encoding, level);
+  Common::write(stream, body.data(), body.size());
+  stream.finish();
+  return result;
+}
+
+std::string decompressBody(const std::string& body, HttpContentEncoding encoding, size_t maxSize) {
+  if (encoding == HttpContentEncoding::IDENTITY) {
+    return body;
+  }
+
+#ifdef HAVE_ZLIB
+  z_stream zstream = {};
+  // automatic header detection takes both gzip and zlib data, whichever encoding was declared
+  if (inflateInit2(&zstream, 15 + 32) != Z_OK) {
+    throw std::runtime_error("Failed to initialize decompression");
+  }
+
+  std::string result;
+  char buffer[BUFFER_SIZE];
+  zstream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(body.data()));
+  zstream.avail_in = static_cast<uInt>(body.size());
+  int status = Z_OK;
+  while (status != Z_STREAM_END) {
+    zstream.next_out = reinterpret_cast<Bytef*>(buffer);
+    zstream.avail_out = sizeof(buffer);
+    status = inflate(&zstream, Z_NO_FLUSH);
+    if (status != Z_OK && status != Z_STREAM_END) {
+      inflateEnd(&zstream);
+      throw std::runtime_error("Corrupt compressed body");
+    }
+
+    result.append(buffer, sizeof(buffer) - zstream.avail_out);
+    if (result.size() > maxSize) {
+      inflateEnd(&zstream);
+      throw std::runtime_error("Decompressed body is too big");
+    }
+
+    if (status == Z_OK && zstream.avail_in == 0 && zstream.avail_out != 0) {
+      inflateEnd(&zstream);
+      throw std::runtime_error("Compressed body is truncated");
+    }
+  }
+
+  inflateEnd(&zstream);
+  return result;
+#else
+  throw std::runtime_error("Compressed bodies are not supported");
+#endif
+}
+
+CompressingOutputStream::CompressingOutputStream(Common::IOutputStream& stream, HttpContentEncoding encoding, int level) :
+  stream(stream), state(new State()) {
+#ifdef HAVE_ZLIB
+  if (deflateInit2(&state->zstream, level, Z_DEFLATED, windowBits(encoding), 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    throw std::runtime_error("Failed to initialize compression");
+  }
+#else
+  throw std::runtime_error("Compression is not supported");
+#endif
+}
+
+CompressingOutputStream::~CompressingOutputStream() {
+#ifdef HAVE_ZLIB
+  deflateEnd(&state->zstream);
+#endif
+}
+
+size_t CompressingOutputStream::writeSome(const void* data, size_t size) {
+  deflate(data, size, false);
+  return size;
+}
+
+void CompressingOutputStream::finish() {
+  deflate(nullptr, 0, true);
+}
+
+void CompressingOutputStream::deflate(const void* data, size_t size, bool finish) {
+#ifdef HAVE_ZLIB
+  z_stream& zstream = state->zstream;
+  zstream.next_in = reinterpret_cast<Bytef*>(const_cast<void*>(data));
+  zstream.avail_in = static_cast<uInt>(size);
+  int status;
+  do {
+    zstream.next_out = reinterpret_cast<Bytef*>(state->buffer);
+    zstream.avail_out = sizeof(state->buffer);
+    status = ::deflate(&zstream, finish ? Z_FINISH : Z_NO_FLUSH);
+    if (status == Z_STREAM_ERROR) {
+      throw std::runtime_error("Compression failed");
+    }
+
+    Common::write(stream, state->buffer, sizeof(state->buffer) - zstream.avail_out);
+  } while (zstream.avail_out == 0 || (finish && status != Z_STREAM_END));
+#endif
+}
+
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "Common/IOutputStream.h"
+
+namespace CryptoNote {
+
+enum class HttpContentEncoding {
+  IDENTITY,
+  GZIP,
+  DEFLATE
+};
+
+// False when built without zlib, then nothing is ever negotiated and compressed bodies can't be read
+bool isHttpCompressionSupported();
+
+// Best supported encoding listed in an Accept-Encoding header, gzip is preferred at equal weight.
+// IDENTITY when the client accepts none of them.
+HttpContentEncoding negotiateContentEncoding(const std::string& acceptEncoding);
+const char* getContentEncodingName(HttpContentEncoding encoding);
+// Parses a Content-Encoding header, false for encodings that can't be decoded
+bool parseContentEncoding(const std::string& name, HttpContentEncoding& encoding);
+
+std::string compressBody(const std::string& body, HttpContentEncoding encoding, int level);
+// Throws std::runtime_error on corrupt data or when the decoded body would exceed maxSize
+std::string decompressBody(const std::string& body, HttpContentEncoding encoding, size_t maxSize);
+
+// Compresses everything written to it into stream, finish() flushes the end of the compressed data
+class CompressingOutputStream : public Common::IOutputStream {
+public:
+  CompressingOutputStream(Common::IOutputStream& stream, HttpContentEncoding encoding, int level);
+  CompressingOutputStream(const CompressingOutputStream&) = delete;
+  ~CompressingOutputStream();
+  CompressingOutputStream& operator=(const CompressingOutputStream&) = delete;
+
+  size_t writeSome(const void* data, size_t size) override;
+  void finish();
+
+private:
+  struct State;
+
+  void deflate(const void* data, size_t size, bool finish);
+
+  Common::IOutputStream& stream;
+  std::unique_ptr<State> state;
+};
+
+}
@@ -20,10 +20,14 @@
 
 #include <algorithm>
 
+#include "HttpCompression.h"
 #include "HttpParserErrorCodes.h"
 
 namespace {
 
+// Bound for decoded response bodies, so a small compressed body can't exhaust memory
+const size_t MAX_DECOMPRESSED_BODY_SIZE = 256 * 1024 * 1024;
+
 void throwIfNotGood(std::istream& stream) {
   if (!stream.good()) {
     if (stream.eof()) {
@@ -42,7 +46,9 @@ HttpResponse::HTTP_STATUS HttpParser::parseResponseStatusFromString(const std::s
   if (status == "200 OK" || status == "200 Ok") return CryptoNote::HttpResponse::STATUS_200;
   else if (status.substr(0, 4) == "401 ") return CryptoNote::HttpResponse::STATUS_401;
   else if (status == "404 Not Found") return CryptoNote::HttpResponse::STATUS_404;
+  else if (status.substr(0, 4) == "429 ") return CryptoNote::HttpResponse::STATUS_429;
   else if (status == "500 Internal Server Error") return CryptoNote::HttpResponse::STATUS_500;
+  else if (status.substr(0, 4) == "503 ") return CryptoNote::HttpResponse::STATUS_503;
   else throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL),
       "Unknown HTTP status code is given");
 
@@ -53,9 +59,7 @@ HttpResponse::HTTP_STATUS HttpParser::parseResponseStatusFromString(const std::s
 void HttpParser::receiveRequest(std::istream& stream, HttpRequest& request) {
   readWord(stream, request.method);
   readWord(stream, request.url);
-
-  std::string httpVersion;
-  readWord(stream, httpVersion);
+  readWord(stream, request.version);
 
   readHeaders(stream, request.headers);
 
@@ -102,15 +106,30 @@ void HttpParser::receiveResponse(std::istream& stream, HttpResponse& response) {
 
   response.addHeader(name, value);
   auto headers = response.getHeaders();
-  size_t length = 0;
-  auto it = headers.find("content-length");
-  if (it != headers.end()) {
-    length = std::stoul(it->second);
-  }
-  
   std::string body;
-  if (length) {
-    readBody(stream, body, length);
+  auto encoding = headers.find("transfer-encoding");
+  if (encoding != headers.end() && encoding->second.find("chunked") != std::string::npos) {
+    readChunkedBody(stream, body);
+  } else {
+    size_t length = 0;
+    auto it = headers.find("content-length");
+    if (it != headers.end()) {
+      length = std::stoul(it->second);
+    }
+
+    if (length) {
+      readBody(stream, body, length);
+    }
+  }
+
+  auto contentEncoding = headers.find("content-encoding");
+  if (contentEncoding != headers.end()) {
+    HttpContentEncoding encoding;
+    if (!parseContentEncoding(contentEncoding->second, encoding)) {
+      throw std::runtime_error("Unsupported content encoding " + contentEncoding->second);
+    }
+
+    body = decompressBody(body, encoding, MAX_DECOMPRESSED_BODY_SIZE);
   }
 
   response.setBody(body);
@@ -223,4 +242,43 @@ void HttpParser::readBody(std::istream& stream, std::string& body, const size_t
   throwIfNotGood(stream);
 }
 
+void HttpParser::readChunkedBody(std::istream& stream, std::string& body) {
+  for (;;) {
+    std::string sizeLine;
+    std::getline(stream, sizeLine);
+    throwIfNotGood(stream);
+
+    size_t chunkSize;
+    try {
+      // Chunk extensions after ';' and the trailing '\r' are ignored by stoul
+      chunkSize = std::stoul(sizeLine, nullptr, 16);
+    } catch (std::exception&) {
+      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL));
+    }
+
+    if (chunkSize == 0) {
+      break;
+    }
+
+    size_t offset = body.size();
+    body.resize(offset + chunkSize);
+    stream.read(&body[offset], chunkSize);
+    throwIfNotGood(stream);
+
+    char cr = static_cast<char>(stream.get());
+    char lf = static_cast<char>(stream.get());
+    throwIfNotGood(stream);
+    if (cr != '\r' || lf != '\n') {
+      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL));
+    }
+  }
+
+  // Skip trailers up to the terminating empty line
+  std::string line;
+  do {
+    std::getline(stream, line);
+    throwIfNotGood(stream);
+  } while (!line.empty() && line != "\r");
+}
+
 }
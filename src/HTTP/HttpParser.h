@@ -40,6 +40,7 @@ private:
   bool readHeader(std::istream& stream, std::string& name, std::string& value);
   size_t getBodyLen(const HttpRequest::Headers& headers);
   void readBody(std::istream& stream, std::string& body, const size_t bodyLen);
+  void readChunkedBody(std::istream& stream, std::string& body);
 };
 
 } //namespace CryptoNote
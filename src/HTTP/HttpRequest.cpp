@@ -27,6 +27,10 @@ namespace CryptoNote {
     return url;
   }
 
+  const std::string& HttpRequest::getVersion() const {
+    return version;
+  }
+
   const HttpRequest::Headers& HttpRequest::getHeaders() const {
     return headers;
   }
@@ -35,6 +39,10 @@ namespace CryptoNote {
     return body;
   }
 
+  const std::string& HttpRequest::getPeerAddress() const {
+    return peerAddress;
+  }
+
   void HttpRequest::addHeader(const std::string& name, const std::string& value) {
     headers[name] = value;
   }
@@ -56,6 +64,10 @@ namespace CryptoNote {
     m_host = host;
   }
 
+  void HttpRequest::setPeerAddress(const std::string& address) {
+    peerAddress = address;
+  }
+
   std::ostream& HttpRequest::printHttpRequest(std::ostream& os) const {
     os << "POST " << url << " HTTP/1.1\r\n";
     auto host = headers.find("Host");
@@ -29,22 +29,29 @@ namespace CryptoNote {
 
     const std::string& getMethod() const;
     const std::string& getUrl() const;
+    const std::string& getVersion() const;
     const Headers& getHeaders() const;
     const std::string& getBody() const;
+    // Address of the connected client, empty when the request was not received by a server
+    const std::string& getPeerAddress() const;
 
     void addHeader(const std::string& name, const std::string& value);
     void setBody(const std::string& b);
     void setUrl(const std::string& uri);
     void setHost(const std::string& host);
+    void setPeerAddress(const std::string& address);
 
   private:
     friend class HttpParser;
+    friend class HttpRequestParser;
 
     std::string method;
     std::string url;
+    std::string version;
     std::string m_host;
     Headers headers;
     std::string body;
+    std::string peerAddress;
 
     friend std::ostream& operator<<(std::ostream& os, const HttpRequest& resp);
     std::ostream& printHttpRequest(std::ostream& os) const;
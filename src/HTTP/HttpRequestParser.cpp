@@ -0,0 +1,165 @@
+// Copyright (c) 2012-2016, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "HttpRequestParser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+
+#include "HttpParserErrorCodes.h"
+
+namespace {
+
+void throwError(CryptoNote::error::HttpParserErrorCodes code) {
+  throw std::system_error(make_error_code(code));
+}
+
+// Cuts the next CRLF terminated line, returns false when it is not complete yet
+bool readLine(const char*& position, const char* end, Common::StringView& line) {
+  for (const char* current = position; current != end; ++current) {
+    if (*current == '\n') {
+      throwError(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL);
+    }
+
+    if (*current == '\r') {
+      if (current + 1 == end) {
+        return false;
+      }
+
+      if (current[1] != '\n') {
+        throwError(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL);
+      }
+
+      line = Common::StringView(position, current - position);
+      position = current + 2;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool equalsIgnoreCase(Common::StringView left, Common::StringView right) {
+  return left.getSize() == right.getSize() &&
+    std::equal(left.begin(), left.end(), right.begin(), [](char a, char b) { return std::tolower(a) == std::tolower(b); });
+}
+
+}
+
+namespace CryptoNote {
+
+HttpRequestParser::HttpRequestParser() : method(Common::StringView::EMPTY), url(Common::StringView::EMPTY),
+  version(Common::StringView::EMPTY), contentLength(0) {
+}
+
+size_t HttpRequestParser::parseHead(const char* data, size_t size) {
+  headers.clear();
+  contentLength = 0;
+
+  const char* position = data;
+  const char* end = data + size;
+  Common::StringView line;
+
+  // Tolerate empty lines left between pipelined requests
+  do {
+    if (!readLine(position, end, line)) {
+      return 0;
+    }
+  } while (line.isEmpty());
+
+  parseRequestLine(line);
+
+  for (;;) {
+    if (!readLine(position, end, line)) {
+      return 0;
+    }
+
+    if (line.isEmpty()) {
+      break;
+    }
+
+    parseHeader(line);
+  }
+
+  return position - data;
+}
+
+void HttpRequestParser::fillRequest(HttpRequest& request, Common::StringView body) const {
+  request.method.assign(method.getData(), method.getSize());
+  request.url.assign(url.getData(), url.getSize());
+  request.version.assign(version.getData(), version.getSize());
+  for (const Header& header : headers) {
+    std::string name(header.name.getData(), header.name.getSize());
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    request.headers[name].assign(header.value.getData(), header.value.getSize());
+  }
+
+  request.body.assign(body.getData(), body.getSize());
+}
+
+void HttpRequestParser::parseRequestLine(Common::StringView line) {
+  const char* methodEnd = std::find(line.begin(), line.end(), ' ');
+  if (methodEnd == line.begin() || methodEnd == line.end()) {
+    throwError(error::HttpParserErrorCodes::UNEXPECTED_SYMBOL);
+  }
+
+  const char* urlEnd = std::find(methodEnd + 1, line.end(), ' ');
+  if (urlEnd == methodEnd + 1 || urlEnd == line.end() || urlEnd + 1 == line.end()) {
+    throwError(error::HttpParserErrorCodes::UNEXPECTED_SYMBOL);
+  }
+
+  method = Common::StringView(line.begin(), methodEnd - line.begin());
+  url = Common::StringView(methodEnd + 1, urlEnd - methodEnd - 1);
+  version = Common::StringView(urlEnd + 1, line.end() - urlEnd - 1);
+}
+
+void HttpRequestParser::parseHeader(Common::StringView line) {
+  const char* colon = std::find(line.begin(), line.end(), ':');
+  if (colon == line.begin()) {
+    throwError(error::HttpParserErrorCodes::EMPTY_HEADER);
+  }
+
+  Header header;
+  header.name = Common::StringView(line.begin(), colon - line.begin());
+  const char* valueBegin = colon == line.end() ? colon : colon + 1;
+  while (valueBegin != line.end() && (*valueBegin == ' ' || *valueBegin == '\t')) {
+    ++valueBegin;
+  }
+
+  header.value = Common::StringView(valueBegin, line.end() - valueBegin);
+  headers.push_back(header);
+
+  if (equalsIgnoreCase(header.name, "content-length")) {
+    if (header.value.isEmpty()) {
+      throwError(error::HttpParserErrorCodes::UNEXPECTED_SYMBOL);
+    }
+
+    size_t length = 0;
+    for (char c : header.value) {
+      if (c < '0' || c > '9' || length > (std::numeric_limits<size_t>::max() - 9) / 10) {
+        throwError(error::HttpParserErrorCodes::UNEXPECTED_SYMBOL);
+      }
+
+      length = length * 10 + (c - '0');
+    }
+
+    contentLength = length;
+  }
+}
+
+} //namespace CryptoNote
@@ -0,0 +1,62 @@
+// Copyright (c) 2012-2016, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vector>
+#include "Common/StringView.h"
+#include "HttpRequest.h"
+
+namespace CryptoNote {
+
+// Incremental HTTP/1.1 request parser working in place on a receive buffer. Method, URL, version and
+// headers are views into that buffer and stay valid while the buffer is not modified.
+class HttpRequestParser {
+public:
+  struct Header {
+    Common::StringView name;
+    Common::StringView value;
+  };
+
+  HttpRequestParser();
+
+  // Parses the request line and headers at the start of data. Returns the size of the head once the
+  // terminating empty line is available and 0 if more data is needed, in which case parsing restarts
+  // on the next call. Throws std::system_error with HttpParserErrorCodes on malformed input.
+  size_t parseHead(const char* data, size_t size);
+
+  Common::StringView getMethod() const { return method; }
+  Common::StringView getUrl() const { return url; }
+  Common::StringView getVersion() const { return version; }
+  const std::vector<Header>& getHeaders() const { return headers; }
+  size_t getContentLength() const { return contentLength; }
+
+  // Copies the parsed head and the given body into request
+  void fillRequest(HttpRequest& request, Common::StringView body) const;
+
+private:
+  void parseRequestLine(Common::StringView line);
+  void parseHeader(Common::StringView line);
+
+  Common::StringView method;
+  Common::StringView url;
+  Common::StringView version;
+  std::vector<Header> headers;
+  size_t contentLength;
+};
+
+} //namespace CryptoNote
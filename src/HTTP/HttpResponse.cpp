@@ -18,10 +18,55 @@
 
 #include "HttpResponse.h"
 
+#include <algorithm>
 #include <stdexcept>
+#include <vector>
+
+#include "Common/StringOutputStream.h"
 
 namespace {
 
+const size_t CHUNK_SIZE = 64 * 1024;
+
+// Frames everything written to it as HTTP/1.1 chunks of up to CHUNK_SIZE bytes
+class ChunkedOutputStream : public Common::IOutputStream {
+public:
+  ChunkedOutputStream(std::ostream& os) : os(os) {
+    buffer.reserve(CHUNK_SIZE);
+  }
+
+  size_t writeSome(const void* data, size_t size) override {
+    size_t count = std::min(size, CHUNK_SIZE - buffer.size());
+    const char* begin = static_cast<const char*>(data);
+    buffer.insert(buffer.end(), begin, begin + count);
+    if (buffer.size() == CHUNK_SIZE) {
+      flushChunk();
+    }
+
+    return count;
+  }
+
+  void finish() {
+    flushChunk();
+    os << "0\r\n\r\n";
+  }
+
+private:
+  void flushChunk() {
+    if (buffer.empty()) {
+      return;
+    }
+
+    os << std::hex << buffer.size() << std::dec << "\r\n";
+    os.write(buffer.data(), buffer.size());
+    os << "\r\n";
+    buffer.clear();
+  }
+
+  std::ostream& os;
+  std::vector<char> buffer;
+};
+
 const char* getStatusString(CryptoNote::HttpResponse::HTTP_STATUS status) {
   switch (status) {
   case CryptoNote::HttpResponse::STATUS_200:
@@ -30,8 +75,12 @@ const char* getStatusString(CryptoNote::HttpResponse::HTTP_STATUS status) {
     return "401 Unauthorized";
   case CryptoNote::HttpResponse::STATUS_404:
     return "404 Not Found";
+  case CryptoNote::HttpResponse::STATUS_429:
+    return "429 Too Many Requests";
   case CryptoNote::HttpResponse::STATUS_500:
     return "500 Internal Server Error";
+  case CryptoNote::HttpResponse::STATUS_503:
+    return "503 Service Unavailable";
   default:
     throw std::runtime_error("Unknown HTTP status code is given");
   }
@@ -45,8 +94,12 @@ const char* getErrorBody(CryptoNote::HttpResponse::HTTP_STATUS status) {
     return "Authorization required\n";
   case CryptoNote::HttpResponse::STATUS_404:
     return "Requested url is not found\n";
+  case CryptoNote::HttpResponse::STATUS_429:
+    return "Too many requests\n";
   case CryptoNote::HttpResponse::STATUS_500:
     return "Internal server error is occurred\n";
+  case CryptoNote::HttpResponse::STATUS_503:
+    return "Server is busy\n";
   default:
     throw std::runtime_error("Error body for given status is not available");
   }
@@ -58,7 +111,7 @@ const char* getErrorBody(CryptoNote::HttpResponse::HTTP_STATUS status) {
 
 namespace CryptoNote {
 
-HttpResponse::HttpResponse() {
+HttpResponse::HttpResponse() : chunkedEncoding(false), streamedEncoding(HttpContentEncoding::IDENTITY), streamedLevel(0) {
   status = STATUS_200;
   headers["Server"] = "CryptoNote-based HTTP server";
   headers["Access-Control-Allow-Origin"] = "*";
@@ -77,6 +130,7 @@ void HttpResponse::addHeader(const std::string& name, const std::string& value)
 }
 
 void HttpResponse::setBody(const std::string& b) {
+  bodyWriter = nullptr;
   body = b;
   if (!body.empty()) {
     headers["Content-Length"] = std::to_string(body.size());
@@ -85,12 +139,78 @@ void HttpResponse::setBody(const std::string& b) {
   }
 }
 
+void HttpResponse::setBodyWriter(const BodyWriter& writer) {
+  body.clear();
+  headers.erase("Content-Length");
+  bodyWriter = writer;
+}
+
+void HttpResponse::setChunkedEncoding(bool chunked) {
+  chunkedEncoding = chunked;
+}
+
+void HttpResponse::setContentEncoding(HttpContentEncoding encoding, int level, size_t threshold) {
+  if (encoding == HttpContentEncoding::IDENTITY || status != STATUS_200 || headers.count("Content-Encoding") != 0) {
+    return;
+  }
+
+  if (bodyWriter && chunkedEncoding) {
+    streamedEncoding = encoding;
+    streamedLevel = level;
+  } else {
+    if (bodyWriter) {
+      std::string rendered;
+      Common::StringOutputStream stream(rendered);
+      bodyWriter(stream);
+      bodyWriter = nullptr;
+      setBody(rendered);
+    }
+
+    if (body.size() < threshold) {
+      return;
+    }
+
+    setBody(compressBody(body, encoding, level));
+  }
+
+  headers["Content-Encoding"] = getContentEncodingName(encoding);
+  headers["Vary"] = "Accept-Encoding";
+}
+
 std::ostream& HttpResponse::printHttpResponse(std::ostream& os) const {
+  std::string rendered;
+  if (bodyWriter && !chunkedEncoding) {
+    // The peer can't take chunks, render the body up front to learn its length
+    Common::StringOutputStream stream(rendered);
+    bodyWriter(stream);
+  }
+
   os << "HTTP/1.1 " << getStatusString(status) << "\r\n";
 
   for (auto pair: headers) {
     os << pair.first << ": " << pair.second << "\r\n";
   }
+
+  if (bodyWriter && chunkedEncoding) {
+    os << "Transfer-Encoding: chunked\r\n\r\n";
+    ChunkedOutputStream stream(os);
+    if (streamedEncoding != HttpContentEncoding::IDENTITY) {
+      CompressingOutputStream compressor(stream, streamedEncoding, streamedLevel);
+      bodyWriter(compressor);
+      compressor.finish();
+    } else {
+      bodyWriter(stream);
+    }
+
+    stream.finish();
+    return os;
+  }
+
+  if (bodyWriter) {
+    os << "Content-Length: " << rendered.size() << "\r\n\r\n" << rendered;
+    return os;
+  }
+
   os << "\r\n";
 
   if (!body.empty()) {
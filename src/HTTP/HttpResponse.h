@@ -19,9 +19,12 @@
 
 #pragma once
 
+#include <functional>
 #include <ostream>
 #include <string>
 #include <map>
+#include "Common/IOutputStream.h"
+#include "HttpCompression.h"
 #include "android.h"
 
 namespace CryptoNote {
@@ -32,18 +35,30 @@ namespace CryptoNote {
       STATUS_200,
       STATUS_401,
       STATUS_404,
-      STATUS_500
+      STATUS_429,
+      STATUS_500,
+      STATUS_503
     };
 
+    // Produces the body at send time, straight into the connection
+    typedef std::function<void(Common::IOutputStream&)> BodyWriter;
+
     HttpResponse();
 
     void setStatus(HTTP_STATUS s);
     void addHeader(const std::string& name, const std::string& value);
     void setBody(const std::string& b);
+    void setBodyWriter(const BodyWriter& writer);
+    void setChunkedEncoding(bool chunked);
+    // Compresses a successful response of at least threshold bytes. Bodies produced by a writer are compressed
+    // while they are streamed when sent chunked, otherwise they are rendered and compressed right here.
+    // Call after setChunkedEncoding.
+    void setContentEncoding(HttpContentEncoding encoding, int level, size_t threshold);
 
     const std::map<std::string, std::string>& getHeaders() const { return headers; }
     HTTP_STATUS getStatus() const { return status; }
     const std::string& getBody() const { return body; }
+    const BodyWriter& getBodyWriter() const { return bodyWriter; }
 
   private:
     friend std::ostream& operator<<(std::ostream& os, const HttpResponse& resp);
@@ -52,6 +67,10 @@ namespace CryptoNote {
     HTTP_STATUS status;
     std::map<std::string, std::string> headers;
     std::string body;
+    BodyWriter bodyWriter;
+    bool chunkedEncoding;
+    HttpContentEncoding streamedEncoding;
+    int streamedLevel;
   };
 
   inline std::ostream& operator<<(std::ostream& os, const HttpResponse& resp) {
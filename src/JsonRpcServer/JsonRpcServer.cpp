@@ -34,6 +34,7 @@
 #include "HTTP/HttpResponse.h"
 #include "Rpc/JsonRpc.h"
 #include "Common/JsonValue.h"
+#include "Common/StreamTools.h"
 #include "Serialization/JsonInputValueSerializer.h"
 #include "Serialization/JsonOutputStreamSerializer.h"
 
@@ -58,6 +59,10 @@ void JsonRpcServer::setCerts(const std::string& chain_file, const std::string& k
   HttpServer::setCerts(chain_file, key_file, dh_file);
 }
 
+void JsonRpcServer::setCompression(int level, size_t threshold, size_t threads) {
+  HttpServer::setCompression(level, threshold, threads);
+}
+
 void JsonRpcServer::processRequest(const CryptoNote::HttpRequest& req, CryptoNote::HttpResponse& resp) {
   try {
     logger(Logging::TRACE) << "HTTP request came: \n" << req;
@@ -83,6 +88,11 @@ void JsonRpcServer::processRequest(const CryptoNote::HttpRequest& req, CryptoNot
         return;
       }
 
+      if (jsonRpcRequest.isArray()) {
+        processJsonRpcBatch(jsonRpcRequest, resp);
+        return;
+      }
+
       processJsonRpcRequest(jsonRpcRequest, jsonRpcResponse);
 
       std::ostringstream jsonOutputStream;
@@ -102,6 +112,45 @@ void JsonRpcServer::processRequest(const CryptoNote::HttpRequest& req, CryptoNot
   }
 }
 
+void JsonRpcServer::processJsonRpcBatch(const Common::JsonValue& calls, CryptoNote::HttpResponse& resp) {
+  using Common::JsonValue;
+
+  resp.setStatus(CryptoNote::HttpResponse::STATUS_200);
+  if (calls.size() == 0) {
+    JsonValue jsonRpcResponse(JsonValue::OBJECT);
+    makeInvalidRequestResponse(jsonRpcResponse);
+    resp.setBody(jsonRpcResponse.toString());
+    return;
+  }
+
+  // calls run back to back and every response is written to the connection as soon as it is rendered
+  auto responses = std::make_shared<std::vector<JsonValue>>();
+  responses->reserve(calls.size());
+  for (size_t i = 0; i < calls.size(); ++i) {
+    JsonValue jsonRpcResponse(JsonValue::OBJECT);
+    if (calls[i].isObject()) {
+      processJsonRpcRequest(calls[i], jsonRpcResponse);
+    } else {
+      makeInvalidRequestResponse(jsonRpcResponse);
+    }
+
+    responses->push_back(std::move(jsonRpcResponse));
+  }
+
+  resp.setBodyWriter([responses](Common::IOutputStream& stream) {
+    Common::write(stream, std::string("["));
+    for (size_t i = 0; i < responses->size(); ++i) {
+      if (i != 0) {
+        Common::write(stream, std::string(","));
+      }
+
+      Common::write(stream, (*responses)[i].toString());
+    }
+
+    Common::write(stream, std::string("]"));
+  });
+}
+
 void JsonRpcServer::prepareJsonResponse(const Common::JsonValue& req, Common::JsonValue& resp) {
   using Common::JsonValue;
 
@@ -181,6 +230,25 @@ void JsonRpcServer::fillJsonResponse(const Common::JsonValue& v, Common::JsonVal
   resp.insert("result", v);
 }
 
+void JsonRpcServer::makeInvalidRequestResponse(Common::JsonValue& resp) {
+  using Common::JsonValue;
+
+  resp = JsonValue(JsonValue::OBJECT);
+  resp.insert("jsonrpc", "2.0");
+  resp.insert("id", nullptr);
+
+  JsonValue error(JsonValue::OBJECT);
+  JsonValue code;
+  code = static_cast<int64_t>(CryptoNote::JsonRpc::errInvalidRequest);
+
+  JsonValue message = "Invalid Request";
+
+  error.insert("code", code);
+  error.insert("message", message);
+
+  resp.insert("error", error);
+}
+
 void JsonRpcServer::makeJsonParsingErrorResponse(Common::JsonValue& resp) {
   using Common::JsonValue;
 
@@ -49,6 +49,7 @@ public:
   JsonRpcServer(const JsonRpcServer&) = delete;
 
   void setCerts(const std::string& chain_file, const std::string& key_file, const std::string& dh_file);
+  void setCompression(int level, size_t threshold, size_t threads);
 
   void start(const std::string& bindAddress, uint16_t bindPort, uint16_t bindPortSSL,
              bool server_ssl_enable, const std::string& m_rpcUser, const std::string& m_rpcPassword);
@@ -60,12 +61,15 @@ protected:
   static void fillJsonResponse(const Common::JsonValue& v, Common::JsonValue& resp);
   static void prepareJsonResponse(const Common::JsonValue& req, Common::JsonValue& resp);
   static void makeJsonParsingErrorResponse(Common::JsonValue& resp);
+  static void makeInvalidRequestResponse(Common::JsonValue& resp);
 
   virtual void processJsonRpcRequest(const Common::JsonValue& req, Common::JsonValue& resp) = 0;
 
 private:
   // HttpServer
   virtual void processRequest(const CryptoNote::HttpRequest& request, CryptoNote::HttpResponse& response) override;
+  // JSON-RPC 2.0 batch, the calls are answered with an array in the same order
+  void processJsonRpcBatch(const Common::JsonValue& calls, CryptoNote::HttpResponse& response);
 
   System::Dispatcher& system;
   System::Event& stopEvent;
@@ -55,6 +55,9 @@ namespace CryptoNote {
 
 namespace {
 
+// Seconds the node is asked to hold a /wait_for_changes request when nothing happens
+const uint32_t WAIT_FOR_CHANGES_TIMEOUT = 30;
+
 std::error_code interpretResponseStatus(const std::string& status) {
   if (CORE_RPC_STATUS_BUSY == status) {
     return make_error_code(error::NODE_BUSY);
@@ -69,6 +72,7 @@ std::error_code interpretResponseStatus(const std::string& status) {
 NodeRpcProxy::NodeRpcProxy(const std::string& nodeHost, unsigned short nodePort, const std::string &daemon_path, const bool &daemon_ssl) :
     m_rpcTimeout(10000),
     m_pullInterval(5000),
+    m_pushNotifications(true),
     m_nodeHost(nodeHost),
     m_nodePort(nodePort),
     m_daemon_path(daemon_path),
@@ -126,6 +130,7 @@ void NodeRpcProxy::resetInternalState() {
   lastLocalBlockHeaderInfo.difficulty = 0;
   lastLocalBlockHeaderInfo.reward = 0;
   m_knownTxs.clear();
+  m_poolSequence = 0;
 }
 
 void NodeRpcProxy::init(const INode::Callback& callback) {
@@ -160,6 +165,9 @@ bool NodeRpcProxy::shutdown() {
 
   m_dispatcher->remoteSpawn([this]() {
     m_stop = true;
+    if (m_notification_group != nullptr) {
+      m_notification_group->interrupt();
+    }
     // Run all spawned contexts
     m_dispatcher->yield();
   });
@@ -182,6 +190,10 @@ void NodeRpcProxy::workerThread(const INode::Callback& initialized_callback) {
     m_httpClient = &httpClient;
     if (!m_daemon_cert.empty()) m_httpClient->setRootCert(m_daemon_cert);
     if (m_daemon_no_verify) m_httpClient->disableVerify();
+    HttpClient notificationClient(dispatcher, m_nodeHost, m_nodePort, m_daemon_ssl);
+    m_notificationClient = &notificationClient;
+    if (!m_daemon_cert.empty()) m_notificationClient->setRootCert(m_daemon_cert);
+    if (m_daemon_no_verify) m_notificationClient->disableVerify();
     Event httpEvent(dispatcher);
     m_httpEvent = &httpEvent;
     m_httpEvent->set();
@@ -199,8 +211,15 @@ void NodeRpcProxy::workerThread(const INode::Callback& initialized_callback) {
       Timer pullTimer(*m_dispatcher);
       while (!m_stop) {
         updateNodeStatus();
-        if (!m_stop) {
-          pullTimer.sleep(std::chrono::milliseconds(m_pullInterval));
+        if (m_stop) {
+          break;
+        }
+
+        // in push mode the next update starts as soon as the node reports a change
+        if (!m_pushNotifications || !waitForChanges()) {
+          if (!m_stop) {
+            pullTimer.sleep(std::chrono::milliseconds(m_pullInterval));
+          }
         }
       }
     });
@@ -215,6 +234,7 @@ void NodeRpcProxy::workerThread(const INode::Callback& initialized_callback) {
   m_context_group = nullptr;
   m_httpClient = nullptr;
   m_httpEvent = nullptr;
+  m_notificationClient = nullptr;
   m_connected = false;
   m_rpcProxyObserverManager.notify(&INodeRpcProxyObserver::connectionStatusUpdated, m_connected);
 }
@@ -229,22 +249,45 @@ void NodeRpcProxy::updateNodeStatus() {
 }
 
 bool NodeRpcProxy::updatePoolStatus() {
-  std::vector<Crypto::Hash> knownTxs = getKnownTxsVector();
-  Crypto::Hash tailBlock = lastLocalBlockHeaderInfo.hash;
+  CryptoNote::COMMAND_RPC_GET_POOL_CHANGES_LITE::request req = AUTO_VAL_INIT(req);
+  CryptoNote::COMMAND_RPC_GET_POOL_CHANGES_LITE::response rsp = AUTO_VAL_INIT(rsp);
 
-  bool isBcActual = false;
-  std::vector<std::unique_ptr<ITransactionReader>> addedTxs;
-  std::vector<Crypto::Hash> deletedTxsIds;
+  req.tailBlockId = lastLocalBlockHeaderInfo.hash;
+  req.knownPoolSequence = m_poolSequence;
+  // the whole known set only goes to nodes without the pool journal and on the first request
+  if (m_poolSequence == 0) {
+    req.knownTxsIds = getKnownTxsVector();
+  }
 
-  std::error_code ec = doGetPoolSymmetricDifference(std::move(knownTxs), tailBlock, isBcActual, addedTxs, deletedTxsIds);
+  std::error_code ec = binaryCommand("get_pool_changes_lite.bin", req, rsp);
   if (ec) {
     return true;
   }
 
-  if (!isBcActual) {
+  if (!rsp.isTailBlockActual) {
     return false;
   }
 
+  std::vector<std::unique_ptr<ITransactionReader>> addedTxs;
+  std::vector<Crypto::Hash> deletedTxsIds;
+  if (rsp.isFullResync) {
+    std::unordered_set<Crypto::Hash> deleted = m_knownTxs;
+    for (const auto& tpi : rsp.addedTxs) {
+      if (deleted.erase(tpi.txHash) == 0) {
+        addedTxs.push_back(createTransactionPrefix(tpi.txPrefix, tpi.txHash));
+      }
+    }
+
+    deletedTxsIds.assign(deleted.begin(), deleted.end());
+  } else {
+    deletedTxsIds = std::move(rsp.deletedTxsIds);
+    for (const auto& tpi : rsp.addedTxs) {
+      addedTxs.push_back(createTransactionPrefix(tpi.txPrefix, tpi.txHash));
+    }
+  }
+
+  m_poolSequence = rsp.poolSequence;
+
   if (!addedTxs.empty() || !deletedTxsIds.empty()) {
     updatePoolState(addedTxs, deletedTxsIds);
     m_observerManager.notify(&INodeObserver::poolChanged);
@@ -327,6 +370,49 @@ void NodeRpcProxy::updateBlockchainStatus() {
   }
 }
 
+bool NodeRpcProxy::waitForChanges() {
+  CryptoNote::COMMAND_RPC_WAIT_FOR_CHANGES::request req = AUTO_VAL_INIT(req);
+  CryptoNote::COMMAND_RPC_WAIT_FOR_CHANGES::response rsp = AUTO_VAL_INIT(rsp);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    req.tail_block_id = lastLocalBlockHeaderInfo.hash;
+  }
+  req.known_pool_sequence = m_poolSequence;
+  if (m_poolSequence == 0) {
+    req.known_txs_ids = getKnownTxsVector();
+  }
+
+  req.timeout = WAIT_FOR_CHANGES_TIMEOUT;
+
+  // the request is held open by the node, so it goes over its own connection and is interrupted on shutdown
+  bool received = false;
+  ContextGroup notificationGroup(*m_dispatcher);
+  m_notification_group = &notificationGroup;
+  notificationGroup.spawn([&] {
+    try {
+      HttpRequest httpReq;
+      HttpResponse httpRes;
+      httpReq.addHeader("Connection", "keep-alive");
+      httpReq.addHeader("Content-Type", "application/json");
+      httpReq.setUrl(m_daemon_path + "wait_for_changes");
+      httpReq.setBody(storeToJson(req));
+      m_notificationClient->request(httpReq, httpRes);
+
+      if (httpRes.getStatus() == HttpResponse::STATUS_404) {
+        // node predates push notifications
+        m_pushNotifications = false;
+      } else if (httpRes.getStatus() == HttpResponse::STATUS_200 && loadFromJson(rsp, httpRes.getBody())) {
+        received = rsp.status == CORE_RPC_STATUS_OK;
+      }
+    } catch (std::exception&) {
+    }
+  });
+
+  notificationGroup.wait();
+  m_notification_group = nullptr;
+  return received;
+}
+
 void NodeRpcProxy::updatePeerCount(size_t peerCount) {
   if (peerCount != m_peerCount) {
     m_peerCount = peerCount;
@@ -1048,6 +1134,8 @@ std::error_code NodeRpcProxy::jsonRpcCommand(const std::string& method, const Re
       if (jsRes.getResult(res)) {
         ec = interpretResponseStatus(res.status);
       }
+    } else if (httpRes.getStatus() == HttpResponse::STATUS_429 || httpRes.getStatus() == HttpResponse::STATUS_503) {
+      ec = make_error_code(error::NODE_BUSY);
     }
   } catch (const ConnectException&) {
     ec = make_error_code(error::CONNECT_ERROR);
@@ -108,6 +108,11 @@ public:
   unsigned int rpcTimeout() const { return m_rpcTimeout; }
   void rpcTimeout(unsigned int val) { m_rpcTimeout = val; }
 
+  // Wait on the node's /wait_for_changes long-poll between status updates instead of pulling them on a timer.
+  // Falls back to pulling when the node doesn't support it.
+  bool pushNotifications() const { return m_pushNotifications; }
+  void pushNotifications(bool val) { m_pushNotifications = val; }
+
   const std::string m_daemon_path;
   const std::string m_nodeHost;
   const unsigned short m_nodePort;
@@ -126,6 +131,7 @@ private:
   void updateBlockchainStatus();
   bool updatePoolStatus();
   void updatePeerCount(size_t peerCount);
+  bool waitForChanges();
   void updatePoolState(const std::vector<std::unique_ptr<ITransactionReader>>& addedTxs, const std::vector<Crypto::Hash>& deletedTxsIds);
   void getFeeAddress();
 
@@ -176,8 +182,11 @@ private:
   unsigned int m_rpcTimeout;
   HttpClient* m_httpClient = nullptr;
   System::Event* m_httpEvent = nullptr;
+  HttpClient* m_notificationClient = nullptr;
+  System::ContextGroup* m_notification_group = nullptr;
 
   uint64_t m_pullInterval;
+  bool m_pushNotifications;
 
   // Internal state
   bool m_stop = false;
@@ -201,6 +210,8 @@ private:
   BlockHeaderInfo lastLocalBlockHeaderInfo;
   //protect it with mutex if decided to add worker threads
   std::unordered_set<Crypto::Hash> m_knownTxs;
+  // last pool journal number the node reported, 0 until then or when the node has no journal
+  uint64_t m_poolSequence;
 
   bool m_connected;
   std::string m_fee_address;
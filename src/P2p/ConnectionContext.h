@@ -22,13 +22,16 @@
 #include <list>
 #include <ostream>
 #include <unordered_set>
+#include <vector>
 
 #include <boost/uuid/uuid.hpp>
 #include <boost/optional.hpp>
 
 #include "Common/StringTools.h"
 #include "crypto/hash.h"
+#include "CryptoNoteConfig.h"
 #include "P2p/PendingLiteBlock.h"
+#include "P2p/RollingHashFilter.h"
 
 namespace CryptoNote {
 
@@ -56,6 +59,12 @@ struct CryptoNoteConnectionContext {
   std::unordered_set<Crypto::Hash> m_requested_objects;
   uint32_t m_remote_blockchain_height = 0;
   uint32_t m_last_response_height = 0;
+  // transactions the peer sent, announced or was announced, they are never announced to it again
+  RollingHashFilter m_known_txs = RollingHashFilter(P2P_KNOWN_TXS_FILTER_SIZE);
+  // transactions waiting for the next announcement to the peer
+  std::vector<Crypto::Hash> m_tx_announcements;
+  // announced transactions requested from the peer and not received yet
+  size_t m_requested_txs = 0;
 };
 
 inline std::string get_protocol_state_string(CryptoNoteConnectionContext::state s) {
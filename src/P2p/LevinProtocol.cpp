@@ -16,7 +16,10 @@
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "LevinProtocol.h"
+#include <Common/Metrics.h>
 #include <System/TcpConnection.h>
+#include "CryptoNoteProtocol/CryptoNoteProtocolDefinitions.h"
+#include "P2pProtocolDefinitions.h"
 
 using namespace CryptoNote;
 
@@ -42,6 +45,14 @@ struct bucket_head2
 };
 #pragma pack(pop)
 
+// Command ids are chosen by the peer, ids outside the pools used by the protocols are counted together
+Common::MetricsCounter& bytesMetric(const char* direction, uint32_t command) {
+  bool known = (command >= P2P_COMMANDS_POOL_BASE && command < P2P_COMMANDS_POOL_BASE + 100) ||
+    (command >= BC_COMMANDS_POOL_BASE && command < BC_COMMANDS_POOL_BASE + 100);
+  return Common::MetricsRegistry::instance().counter("p2p_bytes_total",
+    std::string("direction=\"") + direction + "\",command=\"" + (known ? std::to_string(command) : "other") + "\"");
+}
+
 }
 
 bool LevinProtocol::Command::needReply() const {
@@ -69,6 +80,7 @@ void LevinProtocol::sendMessage(uint32_t command, const BinaryArray& out, bool n
   stream.writeSome(out.data(), out.size());
 
   writeStrict(writeBuffer.data(), writeBuffer.size());
+  bytesMetric("out", command).add(writeBuffer.size());
 }
 
 bool LevinProtocol::readCommand(Command& cmd) {
@@ -95,6 +107,8 @@ bool LevinProtocol::readCommand(Command& cmd) {
     }
   }
 
+  bytesMetric("in", head.m_command).add(sizeof(head) + head.m_cb);
+
   cmd.command = head.m_command;
   cmd.buf = std::move(buf);
   cmd.isNotify = !head.m_have_to_return_data;
@@ -121,6 +135,7 @@ void LevinProtocol::sendReply(uint32_t command, const BinaryArray& out, int32_t
   stream.writeSome(out.data(), out.size());
 
   writeStrict(writeBuffer.data(), writeBuffer.size());
+  bytesMetric("out", command).add(writeBuffer.size());
 }
 
 void LevinProtocol::writeStrict(const uint8_t* ptr, size_t size) {
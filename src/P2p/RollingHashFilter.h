@@ -0,0 +1,115 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "CryptoTypes.h"
+#include "crypto/random.h"
+
+namespace CryptoNote {
+
+// Remembers the last capacity / 2 to capacity hashes inserted in it, in a fixed amount of memory. Two Bloom filters
+// take turns: inserts go to the current one, and when it holds capacity / 2 hashes the other one is cleared and
+// becomes current. contains() may answer true for a hash never inserted, with a probability of about 0.2%, but never
+// false for a remembered one. The memory is taken on the first insert, so filters that are never used cost nothing.
+class RollingHashFilter {
+public:
+  explicit RollingHashFilter(size_t capacity) :
+    m_generationCapacity(std::max<size_t>(capacity / 2, 1)), m_current(0), m_count(0), m_salt() {
+  }
+
+  void insert(const Crypto::Hash& hash) {
+    if (m_bits[0].empty()) {
+      size_t words = (m_generationCapacity * BITS_PER_HASH + 63) / 64;
+      m_bits[0].resize(words);
+      m_bits[1].resize(words);
+      for (auto& salt : m_salt) {
+        salt = Random::randomValue<uint32_t>();
+      }
+    }
+
+    if (m_count == m_generationCapacity) {
+      m_current ^= 1;
+      std::fill(m_bits[m_current].begin(), m_bits[m_current].end(), 0);
+      m_count = 0;
+    }
+
+    std::vector<uint64_t>& bits = m_bits[m_current];
+    uint64_t bitCount = bits.size() * 64;
+    for (size_t i = 0; i < HASH_FUNCTIONS; ++i) {
+      uint64_t bit = word(hash, i) % bitCount;
+      bits[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+
+    ++m_count;
+  }
+
+  bool contains(const Crypto::Hash& hash) const {
+    if (m_bits[0].empty()) {
+      return false;
+    }
+
+    return contains(m_bits[m_current], hash) || contains(m_bits[m_current ^ 1], hash);
+  }
+
+  void clear() {
+    for (auto& bits : m_bits) {
+      std::fill(bits.begin(), bits.end(), 0);
+    }
+
+    m_count = 0;
+  }
+
+private:
+  // 16 bits per hash and 6 bit indices give a false positive rate of 0.1% per generation
+  static const size_t BITS_PER_HASH = 16;
+  static const size_t HASH_FUNCTIONS = 6;
+
+  // The hashes are uniformly distributed already, every bit index is one of their 32-bit words
+  uint32_t word(const Crypto::Hash& hash, size_t i) const {
+    uint32_t result;
+    memcpy(&result, hash.data + i * sizeof(result), sizeof(result));
+    return result ^ m_salt[i];
+  }
+
+  bool contains(const std::vector<uint64_t>& bits, const Crypto::Hash& hash) const {
+    uint64_t bitCount = bits.size() * 64;
+    for (size_t i = 0; i < HASH_FUNCTIONS; ++i) {
+      uint64_t bit = word(hash, i) % bitCount;
+      if ((bits[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  size_t m_generationCapacity;
+  size_t m_current;
+  size_t m_count;
+  // salted per filter, so that nobody can make hashes that collide in the filters of every node
+  std::array<uint32_t, HASH_FUNCTIONS> m_salt;
+  std::array<std::vector<uint64_t>, 2> m_bits;
+};
+
+}
@@ -372,6 +372,7 @@ void PaymentGateService::runWalletService(const CryptoNote::Currency& currency,
         }
     }
 
+    rpcServer.setCompression(config.gateConfiguration.m_compression_level, 1024, 0);
     rpcServer.start(config.gateConfiguration.m_bind_address,
                     config.gateConfiguration.m_bind_port,
                     config.gateConfiguration.m_bind_port_ssl,
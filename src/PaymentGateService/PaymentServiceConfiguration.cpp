@@ -57,6 +57,7 @@ Configuration::Configuration() {
   m_chain_file = "";
   m_key_file = "";
   m_dh_file = "";
+  m_compression_level = 1;
   scanHeight = 0;
 }
 
@@ -71,6 +72,7 @@ void Configuration::initOptions(po::options_description& desc) {
       ("rpc-chain-file", po::value<std::string>()->default_value(std::string(CryptoNote::RPC_DEFAULT_CHAIN_FILE)), "SSL chain file")
       ("rpc-key-file", po::value<std::string>()->default_value(std::string(CryptoNote::RPC_DEFAULT_KEY_FILE)), "SSL key file")
       ("rpc-dh-file", po::value<std::string>()->default_value(std::string(CryptoNote::RPC_DEFAULT_DH_FILE)), "SSL DH file")
+      ("rpc-compression-level", po::value<int>()->default_value(1), "zlib level (1-9) of gzip/deflate compression offered to clients sending Accept-Encoding, 0 to disable")
       ("container-file,w", po::value<std::string>(), "container file")
       ("container-password,p", po::value<std::string>(), "container password")
       ("change-password", po::value<std::string>(), "change container password and exit")
@@ -168,6 +170,10 @@ void Configuration::init(const po::variables_map& options) {
     m_dh_file = options["rpc-dh-file"].as<std::string>();
   }
 
+  if (options.count("rpc-compression-level") != 0) {
+    m_compression_level = options["rpc-compression-level"].as<int>();
+  }
+
   if (options.count("container-file") != 0) {
     containerFile = options["container-file"].as<std::string>();
   }
@@ -54,6 +54,7 @@ struct Configuration {
   std::string m_chain_file;
   std::string m_key_file;
   std::string m_dh_file;
+  int m_compression_level;
 
   std::string containerFile;
   std::string containerPassword;
@@ -22,11 +22,14 @@
 #include <sys/eventfd.h>
 #include <sys/timerfd.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <stdexcept>
+#include <stdlib.h>
 #include <string.h>
 #include <ucontext.h>
 #include <unistd.h>
 #include "ErrorMessage.h"
+#include "IoUring.h"
 
 namespace System {
 
@@ -59,9 +62,15 @@ static_assert(Dispatcher::SIZEOF_PTHREAD_MUTEX_T == sizeof(pthread_mutex_t), "in
 //const size_t STACK_SIZE = 64 * 1024;
 const size_t STACK_SIZE = 512 * 1024;
 
+#ifdef USE_IO_URING
+const unsigned IO_URING_ENTRIES = 256;
+// Set this environment variable to force epoll backend on io_uring enabled build
+const char IO_URING_DISABLE_VARIABLE[] = "KARBO_DISABLE_IO_URING";
+#endif
+
 };
 
-Dispatcher::Dispatcher() {
+Dispatcher::Dispatcher() : ioUring(nullptr) {
   std::string message;
   epoll = ::epoll_create1(0);
   if (epoll == -1) {
@@ -100,6 +109,30 @@ Dispatcher::Dispatcher() {
           firstResumingContext = nullptr;
           firstReusableContext = nullptr;
           runningContextCount = 0;
+
+#ifdef USE_IO_URING
+          if (getenv(IO_URING_DISABLE_VARIABLE) == nullptr) {
+            try {
+              ioUring = new IoUring(IO_URING_ENTRIES);
+            } catch (std::runtime_error&) {
+              // kernel without io_uring support, stay on epoll
+            }
+
+            if (ioUring != nullptr) {
+              ioUringEventContext.readContext = nullptr;
+              ioUringEventContext.writeContext = nullptr;
+
+              epoll_event ioUringEpollEvent;
+              ioUringEpollEvent.events = EPOLLIN;
+              ioUringEpollEvent.data.ptr = &ioUringEventContext;
+              if (epoll_ctl(epoll, EPOLL_CTL_ADD, ioUring->getDescriptor(), &ioUringEpollEvent) == -1) {
+                delete ioUring;
+                ioUring = nullptr;
+              }
+            }
+          }
+#endif
+
           return;
         }
 
@@ -139,6 +172,10 @@ Dispatcher::~Dispatcher() {
     timers.pop();
   }
 
+#ifdef USE_IO_URING
+  delete ioUring;
+#endif
+
   auto result = close(epoll);
   assert(result == 0);
   result = close(remoteSpawnEvent);
@@ -177,10 +214,25 @@ void Dispatcher::dispatch() {
       break;
     }
 
+#ifdef USE_IO_URING
+    if (ioUring != nullptr) {
+      // Flush operations queued by all contexts resumed since the last wait in one system call
+      ioUring->submit();
+      if (processCompletions()) {
+        continue;
+      }
+    }
+#endif
+
     epoll_event event;
     int count = epoll_wait(epoll, &event, 1, -1);
     if (count == 1) {
       ContextPair *contextPair = static_cast<ContextPair*>(event.data.ptr);
+      if (ioUring != nullptr && contextPair == &ioUringEventContext) {
+        processCompletions();
+        continue;
+      }
+
       if(((event.events & (EPOLLIN | EPOLLOUT)) != 0) && contextPair->readContext == nullptr && contextPair->writeContext == nullptr) {
         uint64_t buf;
         auto transferred = read(remoteSpawnEvent, &buf, sizeof buf);
@@ -303,6 +355,13 @@ void Dispatcher::spawn(std::function<void()>&& procedure) {
 }
 
 void Dispatcher::yield() {
+#ifdef USE_IO_URING
+  if (ioUring != nullptr) {
+    ioUring->submit();
+    processCompletions();
+  }
+#endif
+
   for(;;){
     epoll_event events[16];
     int count = epoll_wait(epoll, events, 16, 0);
@@ -313,6 +372,11 @@ void Dispatcher::yield() {
     if(count > 0) {
       for(int i = 0; i < count; ++i) {
         ContextPair *contextPair = static_cast<ContextPair*>(events[i].data.ptr);
+        if (ioUring != nullptr && contextPair == &ioUringEventContext) {
+          processCompletions();
+          continue;
+        }
+
         if(((events[i].events & (EPOLLIN | EPOLLOUT)) != 0) && contextPair->readContext == nullptr && contextPair->writeContext == nullptr) {
           uint64_t buf;
           auto transferred = read(remoteSpawnEvent, &buf, sizeof buf);
@@ -368,6 +432,10 @@ int Dispatcher::getEpoll() const {
   return epoll;
 }
 
+IoUring* Dispatcher::getIoUring() const {
+  return ioUring;
+}
+
 NativeContext& Dispatcher::getReusableContext() {
   if(firstReusableContext == nullptr) {
     ucontext_t* newlyCreatedContext = new ucontext_t;
@@ -426,6 +494,28 @@ void Dispatcher::pushTimer(int timer) {
   timers.push(timer);
 }
 
+bool Dispatcher::processCompletions() {
+  bool resumed = false;
+#ifdef USE_IO_URING
+  uint64_t userData;
+  int32_t result;
+  while (ioUring->peekCompletion(userData, result)) {
+    if (userData == 0) {
+      // cancellation requests are not waited for
+      continue;
+    }
+
+    OperationContext* operation = reinterpret_cast<OperationContext*>(userData);
+    operation->result = result;
+    operation->context->interruptProcedure = nullptr;
+    pushContext(operation->context);
+    resumed = true;
+  }
+#endif
+
+  return resumed;
+}
+
 void Dispatcher::contextProcedure(void* ucontext) {
   assert(firstReusableContext == nullptr);
   NativeContext context;
@@ -28,6 +28,7 @@
 
 namespace System {
 
+class IoUring;
 struct NativeContextGroup;
 
 struct NativeContext {
@@ -54,6 +55,7 @@ struct OperationContext {
   NativeContext *context;
   bool interrupted;
   uint32_t events;
+  int32_t result;
 };
 
 struct ContextPair {
@@ -79,6 +81,7 @@ public:
 
   // system-dependent
   int getEpoll() const;
+  IoUring* getIoUring() const;
   NativeContext& getReusableContext();
   void pushReusableContext(NativeContext&);
   int getTimer();
@@ -98,7 +101,10 @@ public:
 
 private:
   void spawn(std::function<void()>&& procedure);
+  bool processCompletions();
   int epoll;
+  IoUring* ioUring;
+  ContextPair ioUringEventContext;
   alignas(void*) uint8_t mutex[SIZEOF_PTHREAD_MUTEX_T];
   int remoteSpawnEvent;
   ContextPair remoteSpawnEventContext;
@@ -0,0 +1,228 @@
+// Copyright (c) 2012-2016, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifdef USE_IO_URING
+
+#include "IoUring.h"
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "Dispatcher.h"
+#include "ErrorMessage.h"
+#include <System/InterruptedException.h>
+
+namespace System {
+
+namespace {
+
+int ioUringSetup(unsigned entries, io_uring_params* params) {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int ring, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+  return static_cast<int>(::syscall(__NR_io_uring_enter, ring, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+template<typename T> T* ringMember(void* ring, uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<uint8_t*>(ring) + offset);
+}
+
+}
+
+IoUring::IoUring(unsigned entries) : submissionRing(MAP_FAILED), completionRing(MAP_FAILED), submissions(nullptr) {
+  io_uring_params params;
+  memset(&params, 0, sizeof params);
+  ring = ioUringSetup(entries, &params);
+  if (ring == -1) {
+    throw std::runtime_error("IoUring::IoUring, io_uring_setup failed, " + lastErrorMessage());
+  }
+
+  std::string message;
+  submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  submissionsSize = params.sq_entries * sizeof(io_uring_sqe);
+  if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+    submissionRingSize = completionRingSize = std::max(submissionRingSize, completionRingSize);
+  }
+
+  submissionRing = mmap(nullptr, submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+  if (submissionRing == MAP_FAILED) {
+    message = "mmap failed, " + lastErrorMessage();
+  } else {
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+      completionRing = submissionRing;
+    } else {
+      completionRing = mmap(nullptr, completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+    }
+
+    if (completionRing == MAP_FAILED) {
+      message = "mmap failed, " + lastErrorMessage();
+    } else {
+      void* entriesPointer = mmap(nullptr, submissionsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+      if (entriesPointer == MAP_FAILED) {
+        message = "mmap failed, " + lastErrorMessage();
+      } else {
+        submissions = static_cast<io_uring_sqe*>(entriesPointer);
+        submissionHead = ringMember<unsigned>(submissionRing, params.sq_off.head);
+        submissionTail = ringMember<unsigned>(submissionRing, params.sq_off.tail);
+        submissionMask = ringMember<unsigned>(submissionRing, params.sq_off.ring_mask);
+        submissionArray = ringMember<unsigned>(submissionRing, params.sq_off.array);
+        completionHead = ringMember<unsigned>(completionRing, params.cq_off.head);
+        completionTail = ringMember<unsigned>(completionRing, params.cq_off.tail);
+        completionMask = ringMember<unsigned>(completionRing, params.cq_off.ring_mask);
+        completions = ringMember<io_uring_cqe>(completionRing, params.cq_off.cqes);
+        localTail = *submissionTail;
+        pendingSubmissions = 0;
+        return;
+      }
+
+      if (completionRing != submissionRing) {
+        munmap(completionRing, completionRingSize);
+      }
+    }
+
+    munmap(submissionRing, submissionRingSize);
+  }
+
+  auto result = close(ring);
+  assert(result == 0);
+  throw std::runtime_error("IoUring::IoUring, " + message);
+}
+
+IoUring::~IoUring() {
+  munmap(submissions, submissionsSize);
+  if (completionRing != submissionRing) {
+    munmap(completionRing, completionRingSize);
+  }
+
+  munmap(submissionRing, submissionRingSize);
+  auto result = close(ring);
+  assert(result == 0);
+}
+
+int IoUring::getDescriptor() const {
+  return ring;
+}
+
+bool IoUring::hasPendingSubmissions() const {
+  return pendingSubmissions != 0;
+}
+
+io_uring_sqe& IoUring::prepare(OperationContext& operation) {
+  io_uring_sqe& entry = getSubmission();
+  memset(&entry, 0, sizeof entry);
+  entry.user_data = reinterpret_cast<uint64_t>(&operation);
+  return entry;
+}
+
+std::size_t IoUring::submit() {
+  if (pendingSubmissions == 0) {
+    return 0;
+  }
+
+  __atomic_store_n(submissionTail, localTail, __ATOMIC_RELEASE);
+  for (;;) {
+    int submitted = ioUringEnter(ring, pendingSubmissions, 0, 0);
+    if (submitted >= 0) {
+      assert(static_cast<unsigned>(submitted) <= pendingSubmissions);
+      pendingSubmissions -= submitted;
+      return submitted;
+    }
+
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      throw std::runtime_error("IoUring::submit, io_uring_enter failed, " + lastErrorMessage());
+    }
+
+    if (errno != EINTR) {
+      return 0;
+    }
+  }
+}
+
+bool IoUring::peekCompletion(uint64_t& userData, int32_t& result) {
+  unsigned head = *completionHead;
+  if (head == __atomic_load_n(completionTail, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+
+  const io_uring_cqe& entry = completions[head & *completionMask];
+  userData = entry.user_data;
+  result = entry.res;
+  __atomic_store_n(completionHead, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+int32_t IoUring::wait(Dispatcher& dispatcher, OperationContext& operation, uint8_t cancelOpcode) {
+  operation.interrupted = false;
+  operation.context = dispatcher.getCurrentContext();
+  dispatcher.getCurrentContext()->interruptProcedure = [&]() {
+    io_uring_sqe& entry = prepare(operation);
+    entry.opcode = cancelOpcode;
+    entry.fd = -1;
+    entry.addr = reinterpret_cast<uint64_t>(&operation);
+    entry.user_data = 0;
+    operation.interrupted = true;
+
+    // Flush immediately, so cancellation is delivered before interrupting context waits for completion.
+    submit();
+  };
+
+  dispatcher.dispatch();
+  dispatcher.getCurrentContext()->interruptProcedure = nullptr;
+  assert(operation.context == dispatcher.getCurrentContext());
+  if (operation.interrupted) {
+    if (operation.result == -ECANCELED || operation.result == -EINTR) {
+      throw InterruptedException();
+    }
+
+    // Operation completed before cancellation took effect, keep interrupt for the next operation
+    dispatcher.interrupt();
+  }
+
+  return operation.result;
+}
+
+io_uring_sqe& IoUring::getSubmission() {
+  unsigned head = __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE);
+  while (localTail - head > *submissionMask) {
+    if (submit() == 0) {
+      throw std::runtime_error("IoUring::getSubmission, submission ring is full");
+    }
+
+    head = __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE);
+  }
+
+  unsigned index = localTail & *submissionMask;
+  submissionArray[index] = index;
+  ++localTail;
+  ++pendingSubmissions;
+  return submissions[index];
+}
+
+}
+
+#endif
@@ -0,0 +1,82 @@
+// Copyright (c) 2012-2016, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace System {
+
+class Dispatcher;
+struct OperationContext;
+
+// Completion-based backend for Dispatcher. Submissions are queued in the
+// shared submission ring and flushed in one io_uring_enter call when the
+// dispatcher is about to wait, so operations issued by different contexts
+// in the same loop iteration are batched together. The ring descriptor is
+// watched by the dispatcher epoll, completions are reaped from the mapped
+// completion ring without a system call.
+class IoUring {
+public:
+  explicit IoUring(unsigned entries);
+  IoUring(const IoUring&) = delete;
+  ~IoUring();
+  IoUring& operator=(const IoUring&) = delete;
+
+  int getDescriptor() const;
+  bool hasPendingSubmissions() const;
+
+  // Returns a zeroed submission entry bound to operation context.
+  io_uring_sqe& prepare(OperationContext& operation);
+  std::size_t submit();
+  bool peekCompletion(uint64_t& userData, int32_t& result);
+
+  // Suspends current context until prepared operation is completed. Interrupting
+  // the context cancels the operation with cancelOpcode and throws InterruptedException
+  // if the cancellation succeeded.
+  int32_t wait(Dispatcher& dispatcher, OperationContext& operation, uint8_t cancelOpcode);
+
+private:
+  io_uring_sqe& getSubmission();
+
+  int ring;
+  void* submissionRing;
+  std::size_t submissionRingSize;
+  void* completionRing;
+  std::size_t completionRingSize;
+  io_uring_sqe* submissions;
+  std::size_t submissionsSize;
+
+  unsigned* submissionHead;
+  unsigned* submissionTail;
+  unsigned* submissionMask;
+  unsigned* submissionArray;
+  unsigned* completionHead;
+  unsigned* completionTail;
+  unsigned* completionMask;
+  io_uring_cqe* completions;
+
+  unsigned localTail;
+  unsigned pendingSubmissions;
+};
+
+}
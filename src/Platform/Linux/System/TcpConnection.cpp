@@ -23,10 +23,15 @@
 #include <stdexcept>
 #include <sys/epoll.h>
 #include <unistd.h>
+#ifdef USE_IO_URING
+#include <linux/io_uring.h>
+#include <poll.h>
+#endif
 
 #include <System/ErrorMessage.h>
 #include <System/InterruptedException.h>
 #include <System/Ipv4Address.h>
+#include "IoUring.h"
 
 namespace System {
 
@@ -80,6 +85,10 @@ size_t TcpConnection::read(uint8_t* data, size_t size) {
     throw InterruptedException();
   }
 
+  if (dispatcher->getIoUring() != nullptr) {
+    return complete(true, data, size, contextPair.readContext);
+  }
+
   std::string message;
   ssize_t transferred = ::recv(connection, (void *)data, size, 0);
   if (transferred == -1) {
@@ -177,6 +186,10 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
     return 0;
   }
 
+  if (dispatcher->getIoUring() != nullptr) {
+    return complete(false, const_cast<uint8_t*>(data), size, contextPair.writeContext);
+  }
+
   ssize_t transferred = ::send(connection, (void *)data, size, MSG_NOSIGNAL);
   if (transferred == -1) {
     if (errno != EAGAIN) {
@@ -257,6 +270,59 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
   return transferred;
 }
 
+std::size_t TcpConnection::complete(bool receive, uint8_t* data, std::size_t size, OperationContext*& pending) {
+#ifdef USE_IO_URING
+  IoUring& ioUring = *dispatcher->getIoUring();
+  OperationContext operationContext;
+  pending = &operationContext;
+  for (;;) {
+    io_uring_sqe& entry = ioUring.prepare(operationContext);
+    entry.opcode = receive ? IORING_OP_RECV : IORING_OP_SEND;
+    entry.fd = connection;
+    entry.addr = reinterpret_cast<uint64_t>(data);
+    entry.len = static_cast<uint32_t>(size);
+    entry.msg_flags = receive ? 0 : MSG_NOSIGNAL;
+
+    int32_t result;
+    try {
+      result = ioUring.wait(*dispatcher, operationContext, IORING_OP_ASYNC_CANCEL);
+    } catch (InterruptedException&) {
+      pending = nullptr;
+      throw;
+    }
+
+    if (result == -EAGAIN) {
+      // Kernels without fast poll report readiness failures for non-blocking sockets, wait for readiness explicitly
+      io_uring_sqe& pollEntry = ioUring.prepare(operationContext);
+      pollEntry.opcode = IORING_OP_POLL_ADD;
+      pollEntry.fd = connection;
+      pollEntry.poll_events = receive ? POLLIN : POLLOUT;
+      try {
+        result = ioUring.wait(*dispatcher, operationContext, IORING_OP_POLL_REMOVE);
+      } catch (InterruptedException&) {
+        pending = nullptr;
+        throw;
+      }
+
+      if (result >= 0) {
+        continue;
+      }
+    }
+
+    pending = nullptr;
+    if (result < 0) {
+      throw std::runtime_error(std::string("TcpConnection::") + (receive ? "read" : "write") +
+        ", operation failed, " + errorMessage(-result));
+    }
+
+    assert(static_cast<std::size_t>(result) <= size);
+    return static_cast<std::size_t>(result);
+  }
+#else
+  throw std::runtime_error("TcpConnection::complete, io_uring support is not compiled in");
+#endif
+}
+
 std::pair<Ipv4Address, uint16_t> TcpConnection::getPeerAddressAndPort() const {
   sockaddr_in addr;
   socklen_t size = sizeof(addr);
@@ -47,6 +47,7 @@ private:
   ContextPair contextPair;
 
   TcpConnection(Dispatcher& dispatcher, int socket);
+  std::size_t complete(bool receive, uint8_t* data, std::size_t size, OperationContext*& pending);
 };
 
 }
@@ -22,8 +22,13 @@
 #include <sys/timerfd.h>
 #include <sys/epoll.h>
 #include <unistd.h>
+#ifdef USE_IO_URING
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#endif
 
 #include "Dispatcher.h"
+#include "IoUring.h"
 #include <System/ErrorMessage.h>
 #include <System/InterruptedException.h>
 
@@ -71,6 +76,37 @@ void Timer::sleep(std::chrono::nanoseconds duration) {
 
   if(duration.count() == 0 ) {
     dispatcher->yield();
+#ifdef USE_IO_URING
+  } else if (dispatcher->getIoUring() != nullptr) {
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration);
+    __kernel_timespec expires;
+    expires.tv_sec = seconds.count();
+    expires.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(duration - seconds).count();
+
+    OperationContext timerContext;
+    io_uring_sqe& entry = dispatcher->getIoUring()->prepare(timerContext);
+    entry.opcode = IORING_OP_TIMEOUT;
+    entry.fd = -1;
+    entry.addr = reinterpret_cast<uint64_t>(&expires);
+    entry.len = 1;
+
+    // Timeout is measured from submission, flush it now instead of batching with socket operations
+    dispatcher->getIoUring()->submit();
+
+    context = &timerContext;
+    int32_t result;
+    try {
+      result = dispatcher->getIoUring()->wait(*dispatcher, timerContext, IORING_OP_TIMEOUT_REMOVE);
+    } catch (InterruptedException&) {
+      context = nullptr;
+      throw;
+    }
+
+    context = nullptr;
+    if (result != -ETIME && result != 0) {
+      throw std::runtime_error("Timer::sleep, timeout failed, " + errorMessage(-result));
+    }
+#endif
   } else {
     timer = dispatcher->getTimer();
 
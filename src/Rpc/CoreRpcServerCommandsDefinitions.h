@@ -109,10 +109,12 @@ struct COMMAND_RPC_GET_POOL_CHANGES {
   struct request {
     Crypto::Hash tailBlockId;
     std::vector<Crypto::Hash> knownTxsIds;
+    uint64_t knownPoolSequence; // poolSequence of the previous response, knownTxsIds are used when 0
 
     void serialize(ISerializer &s) {
       KV_MEMBER(tailBlockId)
       serializeAsBinary(knownTxsIds, "knownTxsIds", s);
+      KV_MEMBER(knownPoolSequence)
     }
   };
 
@@ -120,12 +122,16 @@ struct COMMAND_RPC_GET_POOL_CHANGES {
     bool isTailBlockActual;
     std::vector<BinaryArray> addedTxs;       // Added transactions blobs
     std::vector<Crypto::Hash> deletedTxsIds; // IDs of not found transactions
+    uint64_t poolSequence;
+    bool isFullResync;                       // addedTxs is the whole pool, not a delta
     std::string status;
 
     void serialize(ISerializer &s) {
       KV_MEMBER(isTailBlockActual)
       KV_MEMBER(addedTxs)
       serializeAsBinary(deletedTxsIds, "deletedTxsIds", s);
+      KV_MEMBER(poolSequence)
+      KV_MEMBER(isFullResync)
       KV_MEMBER(status)
     }
   };
@@ -135,10 +141,12 @@ struct COMMAND_RPC_GET_POOL_CHANGES_LITE {
   struct request {
     Crypto::Hash tailBlockId;
     std::vector<Crypto::Hash> knownTxsIds;
+    uint64_t knownPoolSequence; // poolSequence of the previous response, knownTxsIds are used when 0
 
     void serialize(ISerializer &s) {
       KV_MEMBER(tailBlockId)
       serializeAsBinary(knownTxsIds, "knownTxsIds", s);
+      KV_MEMBER(knownPoolSequence)
     }
   };
 
@@ -146,12 +154,59 @@ struct COMMAND_RPC_GET_POOL_CHANGES_LITE {
     bool isTailBlockActual;
     std::vector<TransactionPrefixInfo> addedTxs; // Added transactions blobs
     std::vector<Crypto::Hash> deletedTxsIds;     // IDs of not found transactions
+    uint64_t poolSequence;
+    bool isFullResync;                           // addedTxs is the whole pool, not a delta
     std::string status;
 
     void serialize(ISerializer &s) {
       KV_MEMBER(isTailBlockActual)
       KV_MEMBER(addedTxs)
       serializeAsBinary(deletedTxsIds, "deletedTxsIds", s);
+      KV_MEMBER(poolSequence)
+      KV_MEMBER(isFullResync)
+      KV_MEMBER(status)
+    }
+  };
+};
+
+//-----------------------------------------------
+struct COMMAND_RPC_WAIT_FOR_CHANGES {
+  struct request {
+    Crypto::Hash tail_block_id;
+    std::vector<Crypto::Hash> known_txs_ids;
+    uint64_t known_pool_sequence; // as in COMMAND_RPC_GET_POOL_CHANGES, known_txs_ids are used when 0
+    uint32_t timeout; // seconds to wait for a change before returning the current state
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(tail_block_id)
+      KV_MEMBER(known_txs_ids)
+      KV_MEMBER(known_pool_sequence)
+      KV_MEMBER(timeout)
+    }
+  };
+
+  struct response {
+    bool changed;
+    Crypto::Hash tail_block_id;
+    uint32_t height;
+    bool is_tail_block_actual;
+    uint32_t reorg_depth; // blocks of the known tail chain no longer in the main chain
+    std::vector<Crypto::Hash> added_txs_ids;
+    std::vector<Crypto::Hash> deleted_txs_ids;
+    uint64_t pool_sequence;
+    bool is_full_resync;
+    std::string status;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(changed)
+      KV_MEMBER(tail_block_id)
+      KV_MEMBER(height)
+      KV_MEMBER(is_tail_block_actual)
+      KV_MEMBER(reorg_depth)
+      KV_MEMBER(added_txs_ids)
+      KV_MEMBER(deleted_txs_ids)
+      KV_MEMBER(pool_sequence)
+      KV_MEMBER(is_full_resync)
       KV_MEMBER(status)
     }
   };
@@ -299,6 +354,10 @@ struct COMMAND_RPC_GET_INFO {
     uint8_t block_major_version;
     std::string already_generated_coins;
     std::string contact;   
+    uint64_t rpc_cache_hits;
+    uint64_t rpc_cache_misses;
+    uint64_t rpc_requests_served;
+    uint64_t rpc_requests_rejected;
 
     void serialize(ISerializer &s) {
       KV_MEMBER(status)
@@ -323,6 +382,10 @@ struct COMMAND_RPC_GET_INFO {
       KV_MEMBER(block_major_version)
       KV_MEMBER(already_generated_coins)
       KV_MEMBER(contact)      
+      KV_MEMBER(rpc_cache_hits)
+      KV_MEMBER(rpc_cache_misses)
+      KV_MEMBER(rpc_requests_served)
+      KV_MEMBER(rpc_requests_rejected)
     }
   };
 };
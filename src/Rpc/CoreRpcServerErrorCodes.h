@@ -27,3 +27,5 @@
 #define CORE_RPC_ERROR_CODE_BLOCK_NOT_ACCEPTED    -7
 #define CORE_RPC_ERROR_CODE_CORE_BUSY             -9
 #define CORE_RPC_ERROR_CODE_RESTRICTED           -10
+#define CORE_RPC_ERROR_CODE_SERVER_BUSY          -11
+#define CORE_RPC_ERROR_CODE_TOO_MANY_REQUESTS    -12
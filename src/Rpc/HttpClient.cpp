@@ -126,6 +126,10 @@ void HttpClient::request(HttpRequest &req, HttpResponse &res) {
     connect();
   }
   req.setHost(m_address);
+  if (isHttpCompressionSupported()) {
+    req.addHeader("Accept-Encoding", "gzip, deflate");
+  }
+
   if (this->m_ssl_enable) {
     try {
       System::SocketStreambuf streambuf((char *) "", 1);
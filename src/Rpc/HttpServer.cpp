@@ -18,6 +18,7 @@
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "HttpServer.h"
+#include <algorithm>
 #include <thread>
 #include <string.h>
 #include <streambuf>
@@ -30,7 +31,10 @@
 #include <Common/base64.hpp>
 #include <Common/StringTools.h>
 #include <HTTP/HttpParser.h>
+#include <HTTP/HttpParserErrorCodes.h>
+#include <HTTP/HttpRequestParser.h>
 #include <System/InterruptedException.h>
+#include <System/TcpConnection.h>
 #include <System/TcpStream.h>
 #include <System/SocketStream.h>
 #include <System/Ipv4Address.h>
@@ -46,12 +50,41 @@ namespace {
 		response.addHeader("Content-Type", "text/plain");
 		response.setBody("Authorization required");
 	}
+
+	// Dispatcher of the reactor thread running the current context, null on the server dispatcher thread
+	thread_local System::Dispatcher* reactorDispatcher = nullptr;
+	thread_local bool sslServerThread = false;
+
+	const size_t RECEIVE_BUFFER_SIZE = 4096;
+	// The head is parsed again from its start after every receive, so it is kept short
+	const size_t MAX_REQUEST_HEAD_SIZE = 64 * 1024;
+	const size_t MAX_REQUEST_BODY_SIZE = 16 * 1024 * 1024;
+
+	// Moves pending bytes to the front of the buffer, grows it when full and appends what the connection
+	// has ready. Returns false if the peer closed the connection.
+	bool receive(System::TcpConnection& connection, std::vector<char>& buffer, size_t& begin, size_t& end) {
+		if (begin > 0) {
+			std::copy(buffer.begin() + begin, buffer.begin() + end, buffer.begin());
+			end -= begin;
+			begin = 0;
+		}
+
+		if (end == buffer.size()) {
+			buffer.resize(buffer.size() * 2);
+		}
+
+		size_t bytesRead = connection.read(reinterpret_cast<uint8_t*>(&buffer[end]), buffer.size() - end);
+		end += bytesRead;
+		return bytesRead != 0;
+	}
 }
 
 namespace CryptoNote {
 
 HttpServer::HttpServer(System::Dispatcher& dispatcher, Logging::ILogger& log)
-  : m_dispatcher(dispatcher), workingContextGroup(dispatcher), logger(log, "HttpServer") {
+  : m_dispatcher(dispatcher), m_threads(1), m_chunked_encoding(false), m_compression_level(0), m_compression_threshold(0),
+    m_connections_count(0), workingContextGroup(dispatcher),
+    m_running_reactors(0), m_reactors_stopped(dispatcher), logger(log, "HttpServer") {
   this->m_server_ssl_do = false;
   this->m_server_ssl_is_run = false;
   this->m_server_ssl_clients = 0;
@@ -68,10 +101,87 @@ void HttpServer::setCerts(const std::string& chain_file, const std::string& key_
   this->m_key_file = key_file;
 }
 
+void HttpServer::setThreads(size_t threads) {
+#ifdef _WIN32
+  if (threads > 1) {
+    logger(WARNING) << "Multiple RPC threads require SO_REUSEPORT, serving on a single thread";
+    threads = 1;
+  }
+#endif
+  m_threads = std::max<size_t>(threads, 1);
+}
+
+void HttpServer::setChunkedEncoding(bool enabled) {
+  m_chunked_encoding = enabled;
+}
+
+void HttpServer::setCompression(int level, size_t threshold, size_t threads) {
+  if (level != 0 && !isHttpCompressionSupported()) {
+    logger(WARNING) << "Built without zlib, RPC responses are sent uncompressed";
+    level = 0;
+  }
+
+  m_compression_level = std::min(level, 9);
+  m_compression_threshold = threshold;
+  // a busy pool makes the connection compress inline instead of waiting, so the queue is kept short
+  m_compression_workers.reset(level != 0 && threads > 0 ? new System::WorkerPool(threads, threads) : nullptr);
+}
+
+void HttpServer::compressResponse(const HttpRequest& request, HttpResponse& response) {
+  if (m_compression_level == 0 || (!response.getBodyWriter() && response.getBody().size() < m_compression_threshold)) {
+    return;
+  }
+
+  auto acceptEncoding = request.getHeaders().find("accept-encoding");
+  if (acceptEncoding == request.getHeaders().end()) {
+    return;
+  }
+
+  HttpContentEncoding encoding = negotiateContentEncoding(acceptEncoding->second);
+  if (encoding == HttpContentEncoding::IDENTITY) {
+    return;
+  }
+
+  auto compress = [&] { response.setContentEncoding(encoding, m_compression_level, m_compression_threshold); };
+  System::Dispatcher* dispatcher = getCurrentDispatcher();
+  if (m_compression_workers && dispatcher != nullptr && m_compression_workers->run(*dispatcher, compress)) {
+    return;
+  }
+
+  compress();
+}
+
 void HttpServer::start(const std::string& address, uint16_t port, uint16_t port_ssl,
                        bool server_ssl_enable, const std::string& user, const std::string& password) {
-  m_listener = System::TcpListener(m_dispatcher, System::Ipv4Address(address), port);
-  workingContextGroup.spawn(std::bind(&HttpServer::acceptLoop, this));
+  if (m_threads == 1) {
+    std::unique_ptr<Reactor> reactor(new Reactor);
+    reactor->dispatcher = &m_dispatcher;
+    reactor->contextGroup = &workingContextGroup;
+    reactor->stopEvent = nullptr;
+    reactor->listener = System::TcpListener(m_dispatcher, System::Ipv4Address(address), port);
+    m_reactors.push_back(std::move(reactor));
+    workingContextGroup.spawn(std::bind(&HttpServer::acceptLoop, this, std::ref(*m_reactors.back())));
+  } else {
+    for (size_t i = 0; i < m_threads; ++i) {
+      std::unique_ptr<Reactor> reactor(new Reactor);
+      std::promise<void> started;
+      auto startedFuture = started.get_future();
+      reactor->thread = std::thread(&HttpServer::reactorProcedure, this, std::ref(*reactor), System::Ipv4Address(address), port, std::ref(started));
+      m_reactors.push_back(std::move(reactor));
+      try {
+        startedFuture.get();
+      } catch (std::exception&) {
+        m_reactors.back()->thread.join();
+        m_reactors.pop_back();
+        stop();
+        throw;
+      }
+
+      ++m_running_reactors;
+    }
+
+    logger(INFO) << "Serving RPC on " << m_threads << " threads";
+  }
 
   this->m_server_ssl_do = server_ssl_enable;
   this->m_server_ssl_port = port_ssl;
@@ -91,6 +201,26 @@ void HttpServer::start(const std::string& address, uint16_t port, uint16_t port_
 void HttpServer::stop() {
   workingContextGroup.interrupt();
   workingContextGroup.wait();
+
+  for (auto& reactor : m_reactors) {
+    if (reactor->thread.joinable()) {
+      Reactor* stoppingReactor = reactor.get();
+      stoppingReactor->dispatcher->remoteSpawn([stoppingReactor] { stoppingReactor->stopEvent->set(); });
+    }
+  }
+
+  // Reactors may still wait for procedures queued to this dispatcher, keep dispatching until all of them exit
+  if (m_running_reactors > 0) {
+    m_reactors_stopped.wait();
+  }
+
+  for (auto& reactor : m_reactors) {
+    if (reactor->thread.joinable()) {
+      reactor->thread.join();
+    }
+  }
+
+  m_reactors.clear();
   this->m_server_ssl_do = false;
   while (this->m_server_ssl_is_run) {
     boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
@@ -129,6 +259,7 @@ void HttpServer::sslServerUnit(boost::asio::ip::tcp::socket &socket, boost::asio
   size_t stream_timeout_n = 0;
   boost::system::error_code ec;
   boost::asio::ssl::stream<tcp::socket&> stream(socket, ctx);
+  sslServerThread = true;
 
   boost::thread control_t(std::bind(&HttpServer::sslServerUnitControl, this, std::ref(stream),
                                                                              std::ref(ec),
@@ -198,12 +329,16 @@ void HttpServer::sslServerUnit(boost::asio::ip::tcp::socket &socket, boost::asio
 
           std::iostream io_stream(&streambuf);
           parser.receiveRequest(io_stream, req);
+          boost::system::error_code endpoint_ec;
+          req.setPeerAddress(socket.remote_endpoint(endpoint_ec).address().to_string());
 
           if (authenticate(req)) {
             processRequest(req, resp);
           } else {
             logger(WARNING) << "Authorization required" << std::endl;
           }
+          resp.setChunkedEncoding(m_chunked_encoding && req.getVersion() == "HTTP/1.1");
+          compressResponse(req, resp);
           io_stream << resp;
           io_stream.flush();
 
@@ -288,14 +423,90 @@ void HttpServer::sslServer() {
   this->m_server_ssl_is_run = false;
 }
 
-void HttpServer::acceptLoop() {
+void HttpServer::reactorProcedure(Reactor& reactor, const System::Ipv4Address& address, uint16_t port, std::promise<void>& started) {
+  System::Dispatcher dispatcher;
+  System::ContextGroup contextGroup(dispatcher);
+  System::Event stopEvent(dispatcher);
+  try {
+    reactor.listener = System::TcpListener(dispatcher, address, port, true);
+  } catch (std::exception&) {
+    started.set_exception(std::current_exception());
+    return;
+  }
+
+  reactorDispatcher = &dispatcher;
+  reactor.dispatcher = &dispatcher;
+  reactor.contextGroup = &contextGroup;
+  reactor.stopEvent = &stopEvent;
+  started.set_value();
+
+  contextGroup.spawn(std::bind(&HttpServer::acceptLoop, this, std::ref(reactor)));
+  stopEvent.wait();
+  contextGroup.interrupt();
+  contextGroup.wait();
+  reactor.listener = System::TcpListener();
+
+  m_dispatcher.remoteSpawn([this] {
+    if (--m_running_reactors == 0) {
+      m_reactors_stopped.set();
+    }
+  });
+}
+
+void HttpServer::invokeOnServerDispatcher(const std::function<void()>& procedure) {
+  System::Dispatcher* dispatcher = reactorDispatcher;
+  if (dispatcher == nullptr) {
+    procedure();
+    return;
+  }
+
+  System::Event done(*dispatcher);
+  std::exception_ptr error;
+  m_dispatcher.remoteSpawn([&] {
+    try {
+      procedure();
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    dispatcher->remoteSpawn([&done] { done.set(); });
+  });
+
+  // procedure refers to this frame, so it has to be waited for even if the context is interrupted
+  bool interrupted = false;
+  while (!done.get()) {
+    try {
+      done.wait();
+    } catch (System::InterruptedException&) {
+      interrupted = true;
+    }
+  }
+
+  if (interrupted) {
+    dispatcher->interrupt();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+System::Dispatcher* HttpServer::getCurrentDispatcher() {
+  if (sslServerThread) {
+    return nullptr;
+  }
+
+  return reactorDispatcher != nullptr ? reactorDispatcher : &m_dispatcher;
+}
+
+void HttpServer::acceptLoop(Reactor& reactor) {
   try {
     System::TcpConnection connection;
     bool accepted = false;
 
     while (!accepted) {
       try {
-        connection = m_listener.accept();
+        connection = reactor.listener.accept();
         accepted = true;
       }
       catch (System::InterruptedException&) {
@@ -306,12 +517,12 @@ void HttpServer::acceptLoop() {
       }
     }
 
-    m_connections.insert(&connection);
-    BOOST_SCOPE_EXIT_ALL(this, &connection) {
-      m_connections.erase(&connection);
+    ++m_connections_count;
+    BOOST_SCOPE_EXIT_ALL(this) {
+      --m_connections_count;
     };
 
-    workingContextGroup.spawn(std::bind(&HttpServer::acceptLoop, this));
+    reactor.contextGroup->spawn(std::bind(&HttpServer::acceptLoop, this, std::ref(reactor)));
 
     //auto addr = connection.getPeerAddressAndPort();
     auto addr = std::pair<System::Ipv4Address, uint16_t>(static_cast<System::Ipv4Address>(0), 0);
@@ -322,18 +533,61 @@ void HttpServer::acceptLoop() {
       logger(WARNING) << "Could not get IP of connection";
     }
 
-    logger(DEBUGGING) << "Incoming connection from " << addr.first.toDottedDecimal() << ":" << addr.second;
+    std::string peerAddress = addr.first.toDottedDecimal();
+    logger(DEBUGGING) << "Incoming connection from " << peerAddress << ":" << addr.second;
 
     System::TcpStreambuf streambuf(connection);
-    std::iostream stream(&streambuf);
-    HttpParser parser;
+    std::ostream stream(&streambuf);
+    std::vector<char> buffer(RECEIVE_BUFFER_SIZE);
+    size_t begin = 0;
+    size_t end = 0;
 
     for (;;) {
+      // Requests are parsed in place, bytes past the current one are kept for the next pipelined request
+      HttpRequestParser parser;
+      size_t headSize;
+      while ((headSize = parser.parseHead(buffer.data() + begin, end - begin)) == 0) {
+        if (end - begin >= MAX_REQUEST_HEAD_SIZE) {
+          throw std::system_error(make_error_code(error::HttpParserErrorCodes::REQUEST_TOO_LARGE));
+        }
+
+        if (!receive(connection, buffer, begin, end)) {
+          if (begin == end) {
+            break;
+          }
+
+          throw std::system_error(make_error_code(error::HttpParserErrorCodes::END_OF_STREAM));
+        }
+      }
+
+      if (headSize == 0) {
+        break;
+      }
+
+      // checked before the sum, a huge Content-Length would wrap it
+      if (parser.getContentLength() > MAX_REQUEST_BODY_SIZE) {
+        throw std::system_error(make_error_code(error::HttpParserErrorCodes::REQUEST_TOO_LARGE));
+      }
+
+      size_t requestSize = headSize + parser.getContentLength();
+      if (end - begin < requestSize) {
+        while (end - begin < requestSize) {
+          if (!receive(connection, buffer, begin, end)) {
+            throw std::system_error(make_error_code(error::HttpParserErrorCodes::END_OF_STREAM));
+          }
+        }
+
+        // The buffer has moved, refresh the views
+        parser.parseHead(buffer.data() + begin, end - begin);
+      }
+
       HttpRequest req;
       HttpResponse resp;
       resp.addHeader("Access-Control-Allow-Origin", "*");
 
-      parser.receiveRequest(stream, req);
+      parser.fillRequest(req, Common::StringView(buffer.data() + begin + headSize, parser.getContentLength()));
+      req.setPeerAddress(peerAddress);
+      begin += requestSize;
       if (authenticate(req)) {
         processRequest(req, resp);
       }
@@ -342,15 +596,13 @@ void HttpServer::acceptLoop() {
         fillUnauthorizedResponse(resp);
       }
 
+      resp.setChunkedEncoding(m_chunked_encoding && req.getVersion() == "HTTP/1.1");
+      compressResponse(req, resp);
       stream << resp;
       stream.flush();
-
-      if (stream.peek() == std::iostream::traits_type::eof()) {
-        break;
-      }
     }
 
-    logger(DEBUGGING) << "Closing connection from " << addr.first.toDottedDecimal() << ":" << addr.second << " total=" << m_connections.size();
+    logger(DEBUGGING) << "Closing connection from " << addr.first.toDottedDecimal() << ":" << addr.second << " total=" << m_connections_count;
 
   }
   catch (System::InterruptedException&) {
@@ -380,7 +632,7 @@ bool HttpServer::authenticate(const HttpRequest& request) const {
 }
 
 size_t HttpServer::get_connections_count() const {
-	return m_connections.size() + m_server_ssl_clients;
+	return m_connections_count + m_server_ssl_clients;
 }
 
 }
@@ -19,7 +19,12 @@
 
 #pragma once 
 
-#include <unordered_set>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
 #include <string.h>
 
 #include <HTTP/HttpRequest.h>
@@ -33,6 +38,8 @@
 #include <System/TcpListener.h>
 #include <System/TcpConnection.h>
 #include <System/Event.h>
+#include <System/Ipv4Address.h>
+#include <System/WorkerPool.h>
 
 #include <Logging/LoggerRef.h>
 
@@ -44,6 +51,16 @@ class HttpServer {
 public:
   HttpServer(System::Dispatcher& dispatcher, Logging::ILogger& log);
   void setCerts(const std::string& chain_file, const std::string& key_file, const std::string& dh_file);
+  // Number of threads serving plain HTTP connections. With more than one thread every
+  // thread runs its own dispatcher and listener bound with SO_REUSEPORT, so the kernel
+  // spreads incoming connections among them and processRequest is called concurrently.
+  void setThreads(size_t threads);
+  // Send responses produced by a body writer with chunked transfer encoding to HTTP/1.1 clients
+  // instead of rendering them into memory first. Off by default as older wallets can't decode chunks.
+  void setChunkedEncoding(bool enabled);
+  // Compress responses of at least threshold bytes for clients sending Accept-Encoding, level 0 disables it.
+  // With threads > 0 bodies known up front are compressed on a pool of that many threads, off the serving dispatcher.
+  void setCompression(int level, size_t threshold, size_t threads);
   void start(const std::string& address, uint16_t port, uint16_t port_ssl = 0,
              bool server_ssl_enable = false, const std::string& user = "", const std::string& password = "");
   void stop();
@@ -51,9 +68,24 @@ public:
   virtual size_t get_connections_count() const;
 
 protected:
+  // Runs procedure on the dispatcher the server was constructed with and suspends
+  // the calling context until it finishes. Used by handlers touching state owned by that dispatcher.
+  void invokeOnServerDispatcher(const std::function<void()>& procedure);
+  // Dispatcher running the calling context, either a reactor one or the server dispatcher.
+  // Null on SSL server threads, they serve connections without a dispatcher.
+  System::Dispatcher* getCurrentDispatcher();
+
   System::Dispatcher& m_dispatcher;
 
 private:
+  struct Reactor {
+    System::Dispatcher* dispatcher;
+    System::ContextGroup* contextGroup;
+    System::Event* stopEvent;
+    System::TcpListener listener;
+    std::thread thread;
+  };
+
   bool m_server_ssl_do;
   bool m_server_ssl_is_run;
   uint16_t m_server_ssl_port;
@@ -63,13 +95,22 @@ private:
   std::string m_dh_file;
   std::string m_key_file;
   std::string m_credentials;
-  std::unordered_set<System::TcpConnection*> m_connections;
+  size_t m_threads;
+  bool m_chunked_encoding;
+  int m_compression_level;
+  size_t m_compression_threshold;
+  std::unique_ptr<System::WorkerPool> m_compression_workers;
+  std::atomic<size_t> m_connections_count;
   boost::thread m_ssl_server_thread;
   System::ContextGroup workingContextGroup;
-  System::TcpListener m_listener;
+  std::vector<std::unique_ptr<Reactor>> m_reactors;
+  size_t m_running_reactors;
+  System::Event m_reactors_stopped;
   Logging::LoggerRef logger;
-  void acceptLoop();
+  void acceptLoop(Reactor& reactor);
+  void reactorProcedure(Reactor& reactor, const System::Ipv4Address& address, uint16_t port, std::promise<void>& started);
   bool authenticate(const HttpRequest& request) const;
+  void compressResponse(const HttpRequest& request, HttpResponse& response);
   void connectionHandler(System::TcpConnection&& conn);
   void sslServerUnitControl(boost::asio::ssl::stream<boost::asio::ip::tcp::socket&> &stream,
                             boost::system::error_code &ec,
@@ -21,9 +21,11 @@
 #include <boost/optional.hpp>
 #include <boost/foreach.hpp>
 #include <functional>
+#include <memory>
 
 #include "CoreRpcServerCommandsDefinitions.h"
 #include <Common/JsonValue.h>
+#include <Common/StreamTools.h>
 #include "Serialization/ISerializer.h"
 #include "Serialization/SerializationTools.h"
 
@@ -70,13 +72,20 @@ public:
   JsonRpcRequest() : psReq(Common::JsonValue::OBJECT) {}
 
   bool parseRequest(const std::string& requestBody) {
+    Common::JsonValue request;
     try {
-      psReq = Common::JsonValue::fromString(requestBody);
+      request = Common::JsonValue::fromString(requestBody);
     } catch (std::exception&) {
       throw JsonRpcError(errParseError);
     }
 
-    if (!psReq.contains("method")) {
+    return parseRequest(std::move(request));
+  }
+
+  // Takes an already parsed call, e.g. an element of a batch
+  bool parseRequest(Common::JsonValue&& request) {
+    psReq = std::move(request);
+    if (!psReq.isObject() || !psReq.contains("method")) {
       throw JsonRpcError(errInvalidRequest);
     }
 
@@ -148,6 +157,7 @@ public:
   }
 
   void setError(const JsonRpcError& err) {
+    resultWriter = nullptr;
     psResp.set("error", storeToJsonValue(err));
   }
 
@@ -161,13 +171,33 @@ public:
   }
 
   std::string getBody() {
+    std::string body;
+    Common::StringOutputStream stream(body);
+    writeBody(stream);
+    return body;
+  }
+
+  void writeBody(Common::IOutputStream& stream) {
     psResp.set("jsonrpc", std::string("2.0"));
-    return psResp.toString();
+    std::string envelope = psResp.toString();
+    if (!resultWriter) {
+      Common::write(stream, envelope);
+      return;
+    }
+
+    // Object members are sorted and "result" comes last, so it is spliced in before the closing brace
+    envelope.back() = ',';
+    envelope += "\"result\":";
+    Common::write(stream, envelope);
+    resultWriter(stream);
+    Common::write(stream, std::string("}"));
   }
 
+  // The result is kept aside and serialized only when the body is written
   template <typename T>
-  bool setResult(const T& v) {
-    psResp.set("result", storeToJsonValue(v));
+  bool setResult(T&& v) {
+    auto result = std::make_shared<typename std::decay<T>::type>(std::forward<T>(v));
+    resultWriter = [result](Common::IOutputStream& stream) { storeToJsonStream(*result, stream); };
     return true;
   }
 
@@ -183,6 +213,7 @@ public:
 
 private:
   Common::JsonValue psResp;
+  std::function<void(Common::IOutputStream&)> resultWriter;
 };
 
 
@@ -213,7 +244,7 @@ bool invokeMethod(const JsonRpcRequest& jsReq, JsonRpcResponse& jsRes, Handler h
   bool result = handler(req, res);
 
   if (result) {
-    if (!jsRes.setResult(res)) {
+    if (!jsRes.setResult(std::move(res))) {
       throw JsonRpcError(JsonRpc::errInternalError);
     }
   }
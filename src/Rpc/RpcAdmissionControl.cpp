@@ -0,0 +1,119 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "RpcAdmissionControl.h"
+
+#include <algorithm>
+
+namespace CryptoNote {
+
+namespace {
+
+// How often clients with full buckets and nothing in flight are forgotten
+const std::chrono::seconds IDLE_SWEEP_INTERVAL(60);
+
+}
+
+RpcAdmissionControl::RpcAdmissionControl(double rate, double burst, uint32_t heavyCost, size_t maxInFlight) :
+  rate(rate), burst(std::max(burst, static_cast<double>(std::max<uint32_t>(heavyCost, 1)))), heavyCost(std::max<uint32_t>(heavyCost, 1)),
+  maxInFlight(maxInFlight), lastSweep(Clock::now()), served(0), rejected(0) {
+}
+
+bool RpcAdmissionControl::enter(const std::string& client) {
+  std::lock_guard<std::mutex> lock(mutex);
+  Client& state = getClient(client, Clock::now());
+  if (maxInFlight != 0 && state.inFlight >= maxInFlight) {
+    ++rejected;
+    return false;
+  }
+
+  ++state.inFlight;
+  return true;
+}
+
+void RpcAdmissionControl::leave(const std::string& client) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = clients.find(client);
+  if (it != clients.end() && it->second.inFlight > 0) {
+    --it->second.inFlight;
+  }
+}
+
+bool RpcAdmissionControl::charge(const std::string& client, MethodClass methodClass) {
+  if (rate == 0) {
+    ++served;
+    return true;
+  }
+
+  double cost = methodClass == HEAVY ? heavyCost : 1;
+  Clock::time_point now = Clock::now();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  Bucket& bucket = getClient(client, now).buckets[methodClass];
+  refill(bucket, now);
+  if (bucket.tokens < cost) {
+    ++rejected;
+    return false;
+  }
+
+  bucket.tokens -= cost;
+  ++served;
+  return true;
+}
+
+size_t RpcAdmissionControl::getClientsCount() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return clients.size();
+}
+
+RpcAdmissionControl::Client& RpcAdmissionControl::getClient(const std::string& client, Clock::time_point now) {
+  if (now - lastSweep >= IDLE_SWEEP_INTERVAL) {
+    dropIdleClients(now);
+  }
+
+  auto it = clients.find(client);
+  if (it == clients.end()) {
+    Client state;
+    state.buckets[LIGHT] = Bucket{ burst, now };
+    state.buckets[HEAVY] = Bucket{ burst, now };
+    state.inFlight = 0;
+    it = clients.emplace(client, state).first;
+  }
+
+  return it->second;
+}
+
+void RpcAdmissionControl::refill(Bucket& bucket, Clock::time_point now) const {
+  double elapsed = std::chrono::duration<double>(now - bucket.updated).count();
+  bucket.tokens = std::min(burst, bucket.tokens + elapsed * rate);
+  bucket.updated = now;
+}
+
+void RpcAdmissionControl::dropIdleClients(Clock::time_point now) {
+  lastSweep = now;
+  for (auto it = clients.begin(); it != clients.end();) {
+    refill(it->second.buckets[LIGHT], now);
+    refill(it->second.buckets[HEAVY], now);
+    if (it->second.inFlight == 0 && it->second.buckets[LIGHT].tokens >= burst && it->second.buckets[HEAVY].tokens >= burst) {
+      it = clients.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+}
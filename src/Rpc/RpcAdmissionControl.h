@@ -0,0 +1,79 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace CryptoNote {
+
+// Per client admission control for the public RPC. Every client, keyed by its address, has a token
+// bucket for each method class and a limit on requests being served at once. Heavy calls draw from
+// their own bucket and cost more, so a scraper exhausting it still leaves light calls like wallet
+// sync going. A rate or an in-flight limit of 0 disables that check. Thread safe.
+class RpcAdmissionControl {
+public:
+  enum MethodClass {
+    LIGHT,
+    HEAVY
+  };
+
+  RpcAdmissionControl(double rate, double burst, uint32_t heavyCost, size_t maxInFlight);
+
+  // Reserves one of the client's in-flight slots, false when all of them are taken
+  bool enter(const std::string& client);
+  void leave(const std::string& client);
+  // Charges a call to the client's bucket for methodClass, false when there are not enough tokens left
+  bool charge(const std::string& client, MethodClass methodClass);
+
+  uint64_t getServed() const { return served; }
+  uint64_t getRejected() const { return rejected; }
+  size_t getClientsCount() const;
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Bucket {
+    double tokens;
+    Clock::time_point updated;
+  };
+
+  struct Client {
+    Bucket buckets[2];
+    size_t inFlight;
+  };
+
+  Client& getClient(const std::string& client, Clock::time_point now);
+  void refill(Bucket& bucket, Clock::time_point now) const;
+  void dropIdleClients(Clock::time_point now);
+
+  const double rate;
+  const double burst;
+  const uint32_t heavyCost;
+  const size_t maxInFlight;
+  mutable std::mutex mutex;
+  std::unordered_map<std::string, Client> clients;
+  Clock::time_point lastSweep;
+  std::atomic<uint64_t> served;
+  std::atomic<uint64_t> rejected;
+};
+
+}
@@ -0,0 +1,110 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "RpcChangeNotifier.h"
+
+#include <algorithm>
+
+#include <boost/scope_exit.hpp>
+
+#include <System/ContextGroup.h>
+#include <System/Dispatcher.h>
+#include <System/Event.h>
+#include <System/InterruptedException.h>
+#include <System/Timer.h>
+
+namespace CryptoNote {
+
+struct RpcChangeNotifier::Waiter {
+  explicit Waiter(System::Dispatcher& dispatcher) : dispatcher(dispatcher), event(dispatcher) {
+  }
+
+  System::Dispatcher& dispatcher;
+  System::Event event;
+};
+
+RpcChangeNotifier::RpcChangeNotifier() : m_version(0), m_blockingWaiters(0) {
+}
+
+void RpcChangeNotifier::notify() {
+  std::list<std::shared_ptr<Waiter>> waiters;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_version;
+    waiters.swap(m_waiters);
+  }
+
+  m_condition.notify_all();
+  // the event belongs to the waiter's dispatcher and can only be set from its thread
+  for (auto& waiter : waiters) {
+    waiter->dispatcher.remoteSpawn([waiter] { waiter->event.set(); });
+  }
+}
+
+uint64_t RpcChangeNotifier::getVersion() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_version;
+}
+
+uint64_t RpcChangeNotifier::wait(System::Dispatcher* dispatcher, uint64_t knownVersion, std::chrono::milliseconds timeout) {
+  if (dispatcher == nullptr) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    ++m_blockingWaiters;
+    m_condition.wait_for(lock, timeout, [&] { return m_version != knownVersion; });
+    --m_blockingWaiters;
+    return m_version;
+  }
+
+  auto waiter = std::make_shared<Waiter>(*dispatcher);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_version != knownVersion) {
+      return m_version;
+    }
+
+    m_waiters.push_back(waiter);
+  }
+
+  BOOST_SCOPE_EXIT_ALL(this, &waiter) {
+    // still queued when woken up by the timeout or interrupted
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = std::find(m_waiters.begin(), m_waiters.end(), waiter);
+    if (it != m_waiters.end()) {
+      m_waiters.erase(it);
+    }
+  };
+
+  System::ContextGroup timeoutGroup(*dispatcher);
+  timeoutGroup.spawn([&] {
+    try {
+      System::Timer timer(*dispatcher);
+      timer.sleep(timeout);
+      waiter->event.set();
+    } catch (System::InterruptedException&) {
+    }
+  });
+
+  waiter->event.wait();
+  return getVersion();
+}
+
+size_t RpcChangeNotifier::getWaitersCount() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_waiters.size() + m_blockingWaiters;
+}
+
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+
+namespace System {
+class Dispatcher;
+}
+
+namespace CryptoNote {
+
+// Counts blockchain and pool updates and wakes up long-poll requests waiting for the next one.
+// Updates may be reported from any thread. A waiter suspends its dispatcher context or,
+// when served without a dispatcher, blocks the calling thread.
+class RpcChangeNotifier {
+public:
+  RpcChangeNotifier();
+  RpcChangeNotifier(const RpcChangeNotifier&) = delete;
+  RpcChangeNotifier& operator=(const RpcChangeNotifier&) = delete;
+
+  void notify();
+  uint64_t getVersion() const;
+  // Returns the current version as soon as it differs from knownVersion or timeout expires.
+  // Throws InterruptedException if the waiting context is interrupted.
+  uint64_t wait(System::Dispatcher* dispatcher, uint64_t knownVersion, std::chrono::milliseconds timeout);
+  size_t getWaitersCount() const;
+
+private:
+  struct Waiter;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_condition;
+  uint64_t m_version;
+  size_t m_blockingWaiters;
+  std::list<std::shared_ptr<Waiter>> m_waiters;
+};
+
+}
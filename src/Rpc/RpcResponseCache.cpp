@@ -0,0 +1,104 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "RpcResponseCache.h"
+
+#include "crypto/crypto.h"
+
+namespace CryptoNote {
+
+RpcResponseCache::RpcResponseCache(size_t maxEntries, const MainChainHash& mainChainHash) :
+  maxEntries(maxEntries), mainChainHash(mainChainHash), hits(0), misses(0) {
+}
+
+std::shared_ptr<const void> RpcResponseCache::getValue(const std::string& key) {
+  std::unique_lock<std::mutex> lock(mutex);
+  auto it = index.find(key);
+  if (it == index.end()) {
+    ++misses;
+    return nullptr;
+  }
+
+  Entry& entry = *it->second;
+  uint32_t height = entry.height;
+  Crypto::Hash blockHash = entry.blockHash;
+  lock.unlock();
+
+  // Checked outside of the lock, the core has its own
+  if (mainChainHash(height) != blockHash) {
+    lock.lock();
+    it = index.find(key);
+    if (it != index.end() && it->second->blockHash == blockHash) {
+      entries.erase(it->second);
+      index.erase(it);
+    }
+
+    ++misses;
+    return nullptr;
+  }
+
+  lock.lock();
+  it = index.find(key);
+  if (it == index.end()) {
+    ++misses;
+    return nullptr;
+  }
+
+  entries.splice(entries.begin(), entries, it->second);
+  ++hits;
+  return it->second->value;
+}
+
+void RpcResponseCache::putValue(const std::string& key, uint32_t height, const Crypto::Hash& blockHash, std::shared_ptr<const void> value) {
+  if (maxEntries == 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = index.find(key);
+  if (it != index.end()) {
+    entries.erase(it->second);
+    index.erase(it);
+  }
+
+  entries.push_front(Entry{ key, height, blockHash, std::move(value) });
+  index.emplace(key, entries.begin());
+
+  while (entries.size() > maxEntries) {
+    index.erase(entries.back().key);
+    entries.pop_back();
+  }
+}
+
+void RpcResponseCache::invalidateFrom(uint32_t height) {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto it = entries.begin(); it != entries.end();) {
+    if (it->height >= height) {
+      index.erase(it->key);
+      it = entries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+size_t RpcResponseCache::getSize() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return entries.size();
+}
+
+}
@@ -0,0 +1,80 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+// Bounded LRU cache of handler results built from main chain data. Every entry remembers the block it
+// was built from, a lookup misses once that block is no longer on the main chain, so results survive
+// until evicted unless a reorganization replaces their block. Thread safe.
+class RpcResponseCache {
+public:
+  typedef std::function<Crypto::Hash(uint32_t height)> MainChainHash;
+
+  RpcResponseCache(size_t maxEntries, const MainChainHash& mainChainHash);
+
+  template <typename T>
+  std::shared_ptr<const T> get(const std::string& key) {
+    return std::static_pointer_cast<const T>(getValue(key));
+  }
+
+  template <typename T>
+  void put(const std::string& key, uint32_t height, const Crypto::Hash& blockHash, const T& value) {
+    putValue(key, height, blockHash, std::make_shared<const T>(value));
+  }
+
+  // Drops entries built from blocks at or above height
+  void invalidateFrom(uint32_t height);
+
+  size_t getMaxEntries() const { return maxEntries; }
+  size_t getSize() const;
+  uint64_t getHits() const { return hits; }
+  uint64_t getMisses() const { return misses; }
+
+private:
+  struct Entry {
+    std::string key;
+    uint32_t height;
+    Crypto::Hash blockHash;
+    std::shared_ptr<const void> value;
+  };
+
+  std::shared_ptr<const void> getValue(const std::string& key);
+  void putValue(const std::string& key, uint32_t height, const Crypto::Hash& blockHash, std::shared_ptr<const void> value);
+
+  const size_t maxEntries;
+  const MainChainHash mainChainHash;
+  mutable std::mutex mutex;
+  // most recently used first
+  std::list<Entry> entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index;
+  std::atomic<uint64_t> hits;
+  std::atomic<uint64_t> misses;
+};
+
+}
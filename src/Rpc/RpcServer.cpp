@@ -24,6 +24,7 @@
 #include <future>
 #include <unordered_map>
 #include <boost/lexical_cast.hpp>
+#include <boost/scope_exit.hpp>
 #include <boost/uuid/uuid.hpp>
 
 // CryptoNote
@@ -43,6 +44,7 @@
 #include "CryptoNoteProtocol/ICryptoNoteProtocolQuery.h"
 #include "P2p/ConnectionContext.h"
 #include "P2p/NetNode.h"
+#include "System/InterruptedException.h"
 
 #include "CoreRpcServerErrorCodes.h"
 #include "JsonRpc.h"
@@ -51,11 +53,56 @@
 
 const uint32_t MAX_NUMBER_OF_BLOCKS_PER_STATS_REQUEST = 10000;
 const uint64_t BLOCK_LIST_MAX_COUNT = 1000;
+// Cached responses for blocks this close to the tip are dropped on every chain update
+const uint32_t RESPONSE_CACHE_TIP_DEPTH = 10;
+// Upper bound for the time a /wait_for_changes request is held open, in seconds
+const uint32_t WAIT_FOR_CHANGES_MAX_TIMEOUT = 60;
+// How far back alternative blocks are followed to find where a client's tail left the main chain
+const uint32_t REORG_DEPTH_MAX_LOOKUP = 1000;
+// Calls accepted in one JSON-RPC batch
+const size_t JSON_RPC_MAX_BATCH_SIZE = 1000;
+// Consecutive batch calls run while the core locks are held
+const size_t JSON_RPC_BATCH_LOCKED_CALLS = 32;
+// Routes served by prefix in processRequest, tracked in metrics under the prefix
+const char* const API_ROUTE_PREFIXES[] = { "/api/block/height/", "/api/block/hash/", "/api/transaction/", "/api/payment_id/", "/api/mempool/" };
 
 namespace CryptoNote {
 
 namespace {
 
+class CountingOutputStream : public Common::IOutputStream {
+public:
+  explicit CountingOutputStream(Common::IOutputStream& stream) : stream(stream), count(0) {}
+
+  size_t writeSome(const void* data, size_t size) override {
+    size_t written = stream.writeSome(data, size);
+    count += written;
+    return written;
+  }
+
+  size_t getCount() const { return count; }
+
+private:
+  Common::IOutputStream& stream;
+  size_t count;
+};
+
+// Records the size of the body produced by writer once it has been sent
+HttpResponse::BodyWriter countingBodyWriter(const HttpResponse::BodyWriter& writer, Common::MetricsHistogram& size) {
+  return [writer, &size](Common::IOutputStream& stream) {
+    CountingOutputStream counter(stream);
+    writer(counter);
+    size.record(counter.getCount());
+  };
+}
+
+// Serializes value at send time straight into the connection, no intermediate JsonValue tree is built
+template <typename T>
+void setJsonBody(HttpResponse& response, T&& value) {
+  auto data = std::make_shared<typename std::decay<T>::type>(std::forward<T>(value));
+  response.setBodyWriter([data](Common::IOutputStream& stream) { storeToJsonStream(*data, stream); });
+}
+
 template <typename Command>
 RpcServer::HandlerFunction binMethod(bool (RpcServer::*handler)(typename Command::request const&, typename Command::response&)) {
   return [handler](RpcServer* obj, const HttpRequest& request, HttpResponse& response) {
@@ -92,7 +139,7 @@ RpcServer::HandlerFunction jsonMethod(bool (RpcServer::*handler)(typename Comman
       response.addHeader("Access-Control-Allow-Methods", "POST, GET");
     }
     response.addHeader("Content-Type", "application/json");
-    response.setBody(storeToJson(res.data()));
+    setJsonBody(response, std::move(res.data()));
     return result;
   };
 }
@@ -132,62 +179,134 @@ RpcServer::HandlerFunction httpMethod(bool (RpcServer::*handler)(typename Comman
 std::unordered_map<std::string, RpcServer::RpcHandler<RpcServer::HandlerFunction>> RpcServer::s_handlers = {
   
   // binary handlers
-  { "/getblocks.bin", { binMethod<COMMAND_RPC_GET_BLOCKS_FAST>(&RpcServer::on_get_blocks), true } },
-  { "/queryblocks.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS>(&RpcServer::on_query_blocks), true } },
-  { "/queryblockslite.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS_LITE>(&RpcServer::on_query_blocks_lite), true } },
-  { "/get_o_indexes.bin", { binMethod<COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES>(&RpcServer::on_get_indexes), true } },
-  { "/getrandom_outs.bin", { binMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::on_get_random_outs), true } },
-  { "/get_pool_changes.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::on_get_pool_changes), true } },
-  { "/get_pool_changes_lite.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::on_get_pool_changes_lite), true } },
+  { "/getblocks.bin", { binMethod<COMMAND_RPC_GET_BLOCKS_FAST>(&RpcServer::on_get_blocks), ALLOW_BUSY_CORE } },
+  { "/queryblocks.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS>(&RpcServer::on_query_blocks), ALLOW_BUSY_CORE } },
+  { "/queryblockslite.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS_LITE>(&RpcServer::on_query_blocks_lite), ALLOW_BUSY_CORE } },
+  { "/get_o_indexes.bin", { binMethod<COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES>(&RpcServer::on_get_indexes), ALLOW_BUSY_CORE } },
+  { "/getrandom_outs.bin", { binMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::on_get_random_outs), ALLOW_BUSY_CORE } },
+  { "/get_pool_changes.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::on_get_pool_changes), ALLOW_BUSY_CORE } },
+  { "/get_pool_changes_lite.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::on_get_pool_changes_lite), ALLOW_BUSY_CORE } },
 
   // plain text/html handlers
-  { "/", { httpMethod<COMMAND_HTTP>(&RpcServer::on_get_index), true } },
-  { "/supply", { httpMethod<COMMAND_HTTP>(&RpcServer::on_get_supply), false } },
-  { "/paymentid", { httpMethod<COMMAND_HTTP>(&RpcServer::on_get_payment_id), true } },
+  { "/", { httpMethod<COMMAND_HTTP>(&RpcServer::on_get_index), ALLOW_BUSY_CORE | ON_NODE_THREAD } },
+  { "/supply", { httpMethod<COMMAND_HTTP>(&RpcServer::on_get_supply), NONE } },
+  { "/paymentid", { httpMethod<COMMAND_HTTP>(&RpcServer::on_get_payment_id), ALLOW_BUSY_CORE } },
 
   // get json handlers
-  { "/getinfo", { jsonMethod<COMMAND_RPC_GET_INFO>(&RpcServer::on_get_info), true } },
-  { "/getheight", { jsonMethod<COMMAND_RPC_GET_HEIGHT>(&RpcServer::on_get_height), true } },
-  { "/feeaddress", { jsonMethod<COMMAND_RPC_GET_FEE_ADDRESS>(&RpcServer::on_get_fee_address), true } },
-  { "/gettransactionspool", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_POOL_SHORT>(&RpcServer::on_get_transactions_pool_short), true } },
-  { "/gettransactionsinpool", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_POOL>(&RpcServer::on_get_transactions_pool), true } },
-  { "/getrawtransactionspool", { jsonMethod<COMMAND_RPC_GET_RAW_TRANSACTIONS_POOL>(&RpcServer::on_get_transactions_pool_raw), true } },
+  { "/getinfo", { jsonMethod<COMMAND_RPC_GET_INFO>(&RpcServer::on_get_info), ALLOW_BUSY_CORE | ON_NODE_THREAD } },
+  { "/getheight", { jsonMethod<COMMAND_RPC_GET_HEIGHT>(&RpcServer::on_get_height), ALLOW_BUSY_CORE } },
+  { "/feeaddress", { jsonMethod<COMMAND_RPC_GET_FEE_ADDRESS>(&RpcServer::on_get_fee_address), ALLOW_BUSY_CORE } },
+  { "/gettransactionspool", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_POOL_SHORT>(&RpcServer::on_get_transactions_pool_short), ALLOW_BUSY_CORE } },
+  { "/gettransactionsinpool", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_POOL>(&RpcServer::on_get_transactions_pool), ALLOW_BUSY_CORE } },
+  { "/getrawtransactionspool", { jsonMethod<COMMAND_RPC_GET_RAW_TRANSACTIONS_POOL>(&RpcServer::on_get_transactions_pool_raw), ALLOW_BUSY_CORE } },
 
   // post json handlers
-  { "/gettransactions", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS>(&RpcServer::on_get_transactions), false } },
-  { "/sendrawtransaction", { jsonMethod<COMMAND_RPC_SEND_RAW_TRANSACTION>(&RpcServer::on_send_raw_transaction), false } },
-  { "/getblocks", { jsonMethod<COMMAND_RPC_GET_BLOCKS_FAST>(&RpcServer::on_get_blocks), false } },
-  { "/queryblocks", { jsonMethod<COMMAND_RPC_QUERY_BLOCKS>(&RpcServer::on_query_blocks), false } },
-  { "/queryblockslite", { jsonMethod<COMMAND_RPC_QUERY_BLOCKS_LITE>(&RpcServer::on_query_blocks_lite), false } },
-  { "/get_o_indexes", { jsonMethod<COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES>(&RpcServer::on_get_indexes), false } },
-  { "/getrandom_outs", { jsonMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::on_get_random_outs), false } },
-  { "/get_pool_changes", { jsonMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::on_get_pool_changes), true } },
-  { "/get_pool_changes_lite", { jsonMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::on_get_pool_changes_lite), true } },
-  { "/get_block_details_by_height", { jsonMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HEIGHT>(&RpcServer::on_get_block_details_by_height), true } },
-  { "/get_block_details_by_hash", { jsonMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HASH>(&RpcServer::on_get_block_details_by_hash), true } },
-  { "/get_blocks_details_by_heights", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS>(&RpcServer::on_get_blocks_details_by_heights), true } },
-  { "/get_blocks_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES>(&RpcServer::on_get_blocks_details_by_hashes), true } },
-  { "/get_blocks_hashes_by_timestamps", { jsonMethod<COMMAND_RPC_GET_BLOCKS_HASHES_BY_TIMESTAMPS>(&RpcServer::on_get_blocks_hashes_by_timestamps), true } },
-  { "/get_transaction_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_DETAILS_BY_HASHES>(&RpcServer::on_get_transactions_details_by_hashes), true } },
-  { "/get_transaction_details_by_hash", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASH>(&RpcServer::on_get_transaction_details_by_hash), true } },
-  { "/get_transaction_details_by_heights", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_DETAILS_BY_HEIGHTS>(&RpcServer::on_get_transactions_details_by_heights), true } },
-  { "/get_raw_transactions_by_heights", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_WITH_OUTPUT_GLOBAL_INDEXES_BY_HEIGHTS>(&RpcServer::on_get_transactions_with_output_global_indexes_by_heights), true } },
-  { "/get_transaction_hashes_by_payment_id", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID>(&RpcServer::on_get_transaction_hashes_by_paymentid), true } },
+  { "/gettransactions", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS>(&RpcServer::on_get_transactions), NONE } },
+  { "/sendrawtransaction", { jsonMethod<COMMAND_RPC_SEND_RAW_TRANSACTION>(&RpcServer::on_send_raw_transaction), ON_NODE_THREAD } },
+  { "/getblocks", { jsonMethod<COMMAND_RPC_GET_BLOCKS_FAST>(&RpcServer::on_get_blocks), NONE } },
+  { "/queryblocks", { jsonMethod<COMMAND_RPC_QUERY_BLOCKS>(&RpcServer::on_query_blocks), NONE } },
+  { "/queryblockslite", { jsonMethod<COMMAND_RPC_QUERY_BLOCKS_LITE>(&RpcServer::on_query_blocks_lite), NONE } },
+  { "/get_o_indexes", { jsonMethod<COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES>(&RpcServer::on_get_indexes), NONE } },
+  { "/getrandom_outs", { jsonMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::on_get_random_outs), NONE } },
+  { "/get_pool_changes", { jsonMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::on_get_pool_changes), ALLOW_BUSY_CORE } },
+  { "/get_pool_changes_lite", { jsonMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::on_get_pool_changes_lite), ALLOW_BUSY_CORE } },
+  { "/wait_for_changes", { jsonMethod<COMMAND_RPC_WAIT_FOR_CHANGES>(&RpcServer::on_wait_for_changes), ALLOW_BUSY_CORE } },
+  { "/get_block_details_by_height", { jsonMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HEIGHT>(&RpcServer::on_get_block_details_by_height), ALLOW_BUSY_CORE } },
+  { "/get_block_details_by_hash", { jsonMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HASH>(&RpcServer::on_get_block_details_by_hash), ALLOW_BUSY_CORE } },
+  { "/get_blocks_details_by_heights", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS>(&RpcServer::on_get_blocks_details_by_heights), ALLOW_BUSY_CORE | HEAVY } },
+  { "/get_blocks_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES>(&RpcServer::on_get_blocks_details_by_hashes), ALLOW_BUSY_CORE | HEAVY } },
+  { "/get_blocks_hashes_by_timestamps", { jsonMethod<COMMAND_RPC_GET_BLOCKS_HASHES_BY_TIMESTAMPS>(&RpcServer::on_get_blocks_hashes_by_timestamps), ALLOW_BUSY_CORE } },
+  { "/get_transaction_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_DETAILS_BY_HASHES>(&RpcServer::on_get_transactions_details_by_hashes), ALLOW_BUSY_CORE | HEAVY } },
+  { "/get_transaction_details_by_hash", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASH>(&RpcServer::on_get_transaction_details_by_hash), ALLOW_BUSY_CORE } },
+  { "/get_transaction_details_by_heights", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_DETAILS_BY_HEIGHTS>(&RpcServer::on_get_transactions_details_by_heights), ALLOW_BUSY_CORE | HEAVY } },
+  { "/get_raw_transactions_by_heights", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_WITH_OUTPUT_GLOBAL_INDEXES_BY_HEIGHTS>(&RpcServer::on_get_transactions_with_output_global_indexes_by_heights), ALLOW_BUSY_CORE | HEAVY } },
+  { "/get_transaction_hashes_by_payment_id", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID>(&RpcServer::on_get_transaction_hashes_by_paymentid), ALLOW_BUSY_CORE } },
   
   // disabled in restricted rpc mode
-  { "/start_mining", { jsonMethod<COMMAND_RPC_START_MINING>(&RpcServer::on_start_mining), false } },
-  { "/stop_mining", { jsonMethod<COMMAND_RPC_STOP_MINING>(&RpcServer::on_stop_mining), false } },
-  { "/stop_daemon", { jsonMethod<COMMAND_RPC_STOP_DAEMON>(&RpcServer::on_stop_daemon), true } },
-  { "/getconnections", { jsonMethod<COMMAND_RPC_GET_CONNECTIONS>(&RpcServer::on_get_connections), true } },
-  { "/getpeers", { jsonMethod<COMMAND_RPC_GET_PEER_LIST>(&RpcServer::on_get_peer_list), true } },
+  { "/start_mining", { jsonMethod<COMMAND_RPC_START_MINING>(&RpcServer::on_start_mining), ON_NODE_THREAD } },
+  { "/stop_mining", { jsonMethod<COMMAND_RPC_STOP_MINING>(&RpcServer::on_stop_mining), ON_NODE_THREAD } },
+  { "/stop_daemon", { jsonMethod<COMMAND_RPC_STOP_DAEMON>(&RpcServer::on_stop_daemon), ALLOW_BUSY_CORE | ON_NODE_THREAD } },
+  { "/getconnections", { jsonMethod<COMMAND_RPC_GET_CONNECTIONS>(&RpcServer::on_get_connections), ALLOW_BUSY_CORE | ON_NODE_THREAD } },
+  { "/getpeers", { jsonMethod<COMMAND_RPC_GET_PEER_LIST>(&RpcServer::on_get_peer_list), ALLOW_BUSY_CORE | ON_NODE_THREAD } },
+  { "/metrics", { std::bind(&RpcServer::on_get_metrics, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), ALLOW_BUSY_CORE } },
 
 
   // json rpc
-  { "/json_rpc", { std::bind(&RpcServer::processJsonRpcRequest, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true } }
+  { "/json_rpc", { std::bind(&RpcServer::processJsonRpcRequest, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), ALLOW_BUSY_CORE } }
+};
+
+std::unordered_map<std::string, RpcServer::RpcHandler<JsonRpc::JsonMemberMethod>> RpcServer::s_jsonRpcHandlers = {
+  
+  { "getblockcount", { JsonRpc::makeMemberMethod(&RpcServer::on_getblockcount), ALLOW_BUSY_CORE } },
+  { "getblockhash", { JsonRpc::makeMemberMethod(&RpcServer::on_getblockhash), ALLOW_BUSY_CORE } },
+  { "getblocktemplate", { JsonRpc::makeMemberMethod(&RpcServer::on_getblocktemplate), ALLOW_BUSY_CORE | OWN_LOCKS } },
+  { "getblockheaderbyhash", { JsonRpc::makeMemberMethod(&RpcServer::on_get_block_header_by_hash), ALLOW_BUSY_CORE } },
+  { "getblockheaderbyheight", { JsonRpc::makeMemberMethod(&RpcServer::on_get_block_header_by_height), ALLOW_BUSY_CORE } },
+  { "getblocktimestamp", { JsonRpc::makeMemberMethod(&RpcServer::on_get_block_timestamp_by_height), ALLOW_BUSY_CORE } },
+  { "getblockbyheight", { JsonRpc::makeMemberMethod(&RpcServer::on_get_block_details_by_height), ALLOW_BUSY_CORE } },
+  { "getblockbyhash", { JsonRpc::makeMemberMethod(&RpcServer::on_get_block_details_by_hash), ALLOW_BUSY_CORE } },
+  { "getblocksbyheights", { JsonRpc::makeMemberMethod(&RpcServer::on_get_blocks_details_by_heights), ALLOW_BUSY_CORE | HEAVY } },
+  { "getblocksbyhashes", { JsonRpc::makeMemberMethod(&RpcServer::on_get_blocks_details_by_hashes), ALLOW_BUSY_CORE | HEAVY } },
+  { "getblockshashesbytimestamps", { JsonRpc::makeMemberMethod(&RpcServer::on_get_blocks_hashes_by_timestamps), ALLOW_BUSY_CORE } },
+  { "getblockslist", { JsonRpc::makeMemberMethod(&RpcServer::on_blocks_list_json), ALLOW_BUSY_CORE | HEAVY } },
+  { "getaltblockslist", { JsonRpc::makeMemberMethod(&RpcServer::on_alt_blocks_list_json), ALLOW_BUSY_CORE } },
+  { "getlastblockheader", { JsonRpc::makeMemberMethod(&RpcServer::on_get_last_block_header), ALLOW_BUSY_CORE } },
+  { "gettransaction", { JsonRpc::makeMemberMethod(&RpcServer::on_get_transaction_details_by_hash), ALLOW_BUSY_CORE } },
+  { "gettransactionspool", { JsonRpc::makeMemberMethod(&RpcServer::on_get_transactions_pool_short), ALLOW_BUSY_CORE } },
+  { "getrawtransactionspool", { JsonRpc::makeMemberMethod(&RpcServer::on_get_transactions_pool_raw), ALLOW_BUSY_CORE } },
+  { "gettransactionsinpool", { JsonRpc::makeMemberMethod(&RpcServer::on_get_transactions_pool), ALLOW_BUSY_CORE } },
+  { "gettransactionsbypaymentid", { JsonRpc::makeMemberMethod(&RpcServer::on_get_transactions_by_payment_id), ALLOW_BUSY_CORE } },
+  { "gettransactionhashesbypaymentid", { JsonRpc::makeMemberMethod(&RpcServer::on_get_transaction_hashes_by_paymentid), ALLOW_BUSY_CORE } },
+  { "gettransactionsbyhashes", { JsonRpc::makeMemberMethod(&RpcServer::on_get_transactions_details_by_hashes), ALLOW_BUSY_CORE | HEAVY } },
+  { "gettransactionsbyheights", { JsonRpc::makeMemberMethod(&RpcServer::on_get_transactions_details_by_heights), ALLOW_BUSY_CORE | HEAVY } },
+  { "getrawtransactionsbyheights", { JsonRpc::makeMemberMethod(&RpcServer::on_get_transactions_with_output_global_indexes_by_heights), ALLOW_BUSY_CORE | HEAVY } },
+  { "getcurrencyid", { JsonRpc::makeMemberMethod(&RpcServer::on_get_currency_id), ALLOW_BUSY_CORE } },
+  { "getstatsbyheights", { JsonRpc::makeMemberMethod(&RpcServer::on_get_stats_by_heights), HEAVY } },
+  { "getstatsinrange", { JsonRpc::makeMemberMethod(&RpcServer::on_get_stats_by_heights_range), HEAVY } },
+  { "checktransactionkey", { JsonRpc::makeMemberMethod(&RpcServer::on_check_transaction_key), ALLOW_BUSY_CORE } },
+  { "checktransactionbyviewkey", { JsonRpc::makeMemberMethod(&RpcServer::on_check_transaction_with_view_key), ALLOW_BUSY_CORE | HEAVY | OWN_LOCKS } },
+  { "checktransactionproof", { JsonRpc::makeMemberMethod(&RpcServer::on_check_transaction_proof), ALLOW_BUSY_CORE | OWN_LOCKS } },
+  { "checkreserveproof", { JsonRpc::makeMemberMethod(&RpcServer::on_check_reserve_proof), ALLOW_BUSY_CORE | HEAVY } },
+  { "checkpayment", { JsonRpc::makeMemberMethod(&RpcServer::on_check_payment), ALLOW_BUSY_CORE | OWN_LOCKS } },
+  { "validateaddress", { JsonRpc::makeMemberMethod(&RpcServer::on_validate_address), ALLOW_BUSY_CORE } },
+  { "verifymessage", { JsonRpc::makeMemberMethod(&RpcServer::on_verify_message), ALLOW_BUSY_CORE } },
+  { "submitblock", { JsonRpc::makeMemberMethod(&RpcServer::on_submitblock), ON_NODE_THREAD } },
+  { "resolveopenalias", { JsonRpc::makeMemberMethod(&RpcServer::on_resolve_open_alias), ALLOW_BUSY_CORE | OWN_LOCKS } },
+
 };
 
 RpcServer::RpcServer(System::Dispatcher& dispatcher, Logging::ILogger& log, CryptoNote::Core& core, NodeServer& p2p, ICryptoNoteProtocolQuery& protocolQuery) :
-  HttpServer(dispatcher, log), logger(log, "RpcServer"), m_core(core), m_p2p(p2p), m_protocolQuery(protocolQuery), blockchainExplorerDataBuilder(core, protocolQuery) {
+  HttpServer(dispatcher, log), logger(log, "RpcServer"), m_core(core), m_p2p(p2p), m_protocolQuery(protocolQuery), blockchainExplorerDataBuilder(core, protocolQuery),
+  m_nodeQueueSize(0),
+  m_nodeQueueDepthMetric(Common::MetricsRegistry::instance().histogram("rpc_queue_depth", "queue=\"node\"")),
+  m_nodeQueueWaitMetric(Common::MetricsRegistry::instance().histogram("rpc_queue_wait_us", "queue=\"node\"")),
+  m_workerQueueDepthMetric(Common::MetricsRegistry::instance().histogram("rpc_queue_depth", "queue=\"workers\"")),
+  m_workerQueueWaitMetric(Common::MetricsRegistry::instance().histogram("rpc_queue_wait_us", "queue=\"workers\"")) {
+  auto addMethod = [this](const std::string& method) {
+    Common::MetricsRegistry& registry = Common::MetricsRegistry::instance();
+    std::string label = "method=\"" + method + "\"";
+    MethodMetrics metrics = { &registry.histogram("rpc_duration_us", label), &registry.histogram("rpc_request_bytes", label),
+                              &registry.histogram("rpc_response_bytes", label) };
+    m_methodMetrics.emplace(method, metrics);
+  };
+
+  for (const auto& handler : s_handlers) {
+    addMethod(handler.first);
+  }
+
+  for (const auto& handler : s_jsonRpcHandlers) {
+    addMethod(handler.first);
+  }
+
+  for (const char* prefix : API_ROUTE_PREFIXES) {
+    addMethod(prefix);
+  }
+
+  m_core.addObserver(this);
+}
+
+RpcServer::~RpcServer() {
+  m_core.removeObserver(this);
 }
 
 void RpcServer::processRequest(const HttpRequest& request, HttpResponse& response) {
@@ -195,8 +314,28 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
 
   try {
 
+  const std::string& client = request.getPeerAddress();
+  if (m_admission && !m_admission->enter(client)) {
+    response.setStatus(HttpResponse::STATUS_429);
+    return;
+  }
+
+  BOOST_SCOPE_EXIT_ALL(this, &client) {
+    if (m_admission) {
+      m_admission->leave(client);
+    }
+  };
+
   auto url = request.getUrl();
 
+  const MethodMetrics* metrics = getMethodMetrics(url);
+  auto callStart = std::chrono::steady_clock::now();
+  BOOST_SCOPE_EXIT_ALL(this, metrics, callStart, &request, &response) {
+    if (metrics != nullptr) {
+      recordCall(*metrics, callStart, request, response);
+    }
+  };
+
   auto it = s_handlers.find(url);
   if (it == s_handlers.end()) {
     if (Common::starts_with(url, "/api/")) {
@@ -212,11 +351,15 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
         std::string height_str = url.substr(block_height_method.size());
         uint32_t height = Common::integer_cast<uint32_t>(height_str);
         auto it = s_handlers.find("/get_block_details_by_height");
-        if (!it->second.allowBusyCore && !isCoreReady()) {
+        if (!it->second.allowBusyCore() && !isCoreReady()) {
           response.setStatus(HttpResponse::STATUS_500);
           response.setBody("Core is busy");
           return;
         }
+        if (!admitCall(client, it->second.heavy())) {
+          response.setStatus(HttpResponse::STATUS_429);
+          return;
+        }
         COMMAND_RPC_GET_BLOCK_DETAILS_BY_HEIGHT::request req;
         req.blockHeight = height;
         COMMAND_RPC_GET_BLOCK_DETAILS_BY_HEIGHT::response rsp;
@@ -224,7 +367,7 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
         if (r) {
           response.addHeader("Content-Type", "application/json");
           response.setStatus(HttpResponse::HTTP_STATUS::STATUS_200);
-          response.setBody(storeToJson(rsp));
+          setJsonBody(response, std::move(rsp));
         } else {
           response.setStatus(HttpResponse::STATUS_500);
           response.setBody("Internal error");
@@ -235,11 +378,15 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
 
         std::string hash_str = url.substr(block_hash_method.size());
         auto it = s_handlers.find("/get_block_details_by_hash");
-        if (!it->second.allowBusyCore && !isCoreReady()) {
+        if (!it->second.allowBusyCore() && !isCoreReady()) {
           response.setStatus(HttpResponse::STATUS_500);
           response.setBody("Core is busy");
           return;
         }
+        if (!admitCall(client, it->second.heavy())) {
+          response.setStatus(HttpResponse::STATUS_429);
+          return;
+        }
         COMMAND_RPC_GET_BLOCK_DETAILS_BY_HASH::request req;
         req.hash = hash_str;
         COMMAND_RPC_GET_BLOCK_DETAILS_BY_HASH::response rsp;
@@ -247,7 +394,7 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
         if (r) {
           response.addHeader("Content-Type", "application/json");
           response.setStatus(HttpResponse::HTTP_STATUS::STATUS_200);
-          response.setBody(storeToJson(rsp));
+          setJsonBody(response, std::move(rsp));
         } else {
           response.setStatus(HttpResponse::STATUS_500);
           response.setBody("Internal error");
@@ -258,11 +405,15 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
 
         std::string hash_str = url.substr(tx_hash_method.size());
         auto it = s_handlers.find("/get_transaction_details_by_hash");
-        if (!it->second.allowBusyCore && !isCoreReady()) {
+        if (!it->second.allowBusyCore() && !isCoreReady()) {
           response.setStatus(HttpResponse::STATUS_500);
           response.setBody("Core is busy");
           return;
         }
+        if (!admitCall(client, it->second.heavy())) {
+          response.setStatus(HttpResponse::STATUS_429);
+          return;
+        }
         COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASH::request req;
         req.hash = hash_str;
         COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASH::response rsp;
@@ -270,7 +421,7 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
         if (r) {
           response.addHeader("Content-Type", "application/json");
           response.setStatus(HttpResponse::HTTP_STATUS::STATUS_200);
-          response.setBody(storeToJson(rsp));
+          setJsonBody(response, std::move(rsp));
         }
         else {
           response.setStatus(HttpResponse::STATUS_500);
@@ -282,11 +433,15 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
 
         std::string pid_str = url.substr(payment_id_method.size());
         auto it = s_handlers.find("/get_transaction_hashes_by_payment_id");
-        if (!it->second.allowBusyCore && !isCoreReady()) {
+        if (!it->second.allowBusyCore() && !isCoreReady()) {
           response.setStatus(HttpResponse::STATUS_500);
           response.setBody("Core is busy");
           return;
         }
+        if (!admitCall(client, it->second.heavy())) {
+          response.setStatus(HttpResponse::STATUS_429);
+          return;
+        }
         COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID::request req;
         req.paymentId = pid_str;
         COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID::response rsp;
@@ -294,7 +449,7 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
         if (r) {
           response.addHeader("Content-Type", "application/json");
           response.setStatus(HttpResponse::HTTP_STATUS::STATUS_200);
-          response.setBody(storeToJson(rsp));
+          setJsonBody(response, std::move(rsp));
         }
         else {
           response.setStatus(HttpResponse::STATUS_500);
@@ -305,12 +460,16 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
       } else if (Common::starts_with(url, tx_mempool_method)) {
 
         auto it = s_handlers.find("/gettransactionsinpool");
-        if (!it->second.allowBusyCore && !isCoreReady())
+        if (!it->second.allowBusyCore() && !isCoreReady())
         {
           response.setStatus(HttpResponse::STATUS_500);
           response.setBody("Core is busy");
           return;
         }
+        if (!admitCall(client, it->second.heavy())) {
+          response.setStatus(HttpResponse::STATUS_429);
+          return;
+        }
 
         COMMAND_RPC_GET_TRANSACTIONS_POOL::request req;
         COMMAND_RPC_GET_TRANSACTIONS_POOL::response rsp;
@@ -318,7 +477,7 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
         if (r) {
           response.addHeader("Content-Type", "application/json");
           response.setStatus(HttpResponse::HTTP_STATUS::STATUS_200);
-          response.setBody(storeToJson(rsp));
+          setJsonBody(response, std::move(rsp));
         }
         else {
           response.setStatus(HttpResponse::STATUS_500);
@@ -338,14 +497,26 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
     }
   }
 
-  if (!it->second.allowBusyCore && !isCoreReady()) {
+  if (!it->second.allowBusyCore() && !isCoreReady()) {
     response.setStatus(HttpResponse::STATUS_500);
     response.setBody("Core is busy");
     return;
   }
 
-  it->second.handler(this, request, response);
+  // JSON-RPC calls are charged one by one, a batch costs as much as its calls
+  if (url != "/json_rpc" && !admitCall(client, it->second.heavy())) {
+    response.setStatus(HttpResponse::STATUS_429);
+    return;
+  }
+
+  if (!invokeHandler(client, it->second.onNodeThread(), it->second.heavy(), [&] { it->second.handler(this, request, response); })) {
+    response.setStatus(HttpResponse::STATUS_503);
+  }
 
+  }
+  catch (const System::InterruptedException&) {
+    // the server is stopping while a long-poll request waits, let the connection close
+    throw;
   }
   catch (const JsonRpc::JsonRpcError& err) {
     response.addHeader("Content-Type", "application/json");
@@ -369,74 +540,144 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
     response.addHeader("Access-Control-Allow-Methods", "POST, GET");
   }  
 
-  JsonRpcRequest jsonRequest;
-  JsonRpcResponse jsonResponse;
-
+  //logger(Logging::TRACE) << "JSON-RPC request: " << request.getBody();
+  Common::JsonValue jsonBody;
   try {
-    //logger(Logging::TRACE) << "JSON-RPC request: " << request.getBody();
-    jsonRequest.parseRequest(request.getBody());
-    jsonResponse.setId(jsonRequest.getId()); // copy id
+    jsonBody = Common::JsonValue::fromString(request.getBody());
+  } catch (std::exception&) {
+    JsonRpcResponse jsonResponse;
+    jsonResponse.setError(JsonRpcError(errParseError));
+    response.setBody(jsonResponse.getBody());
+    return true;
+  }
 
-    static std::unordered_map<std::string, RpcServer::RpcHandler<JsonMemberMethod>> jsonRpcHandlers = {
-  
-      { "getblockcount", { makeMemberMethod(&RpcServer::on_getblockcount), true } },
-      { "getblockhash", { makeMemberMethod(&RpcServer::on_getblockhash), true } },
-      { "getblocktemplate", { makeMemberMethod(&RpcServer::on_getblocktemplate), true } },
-      { "getblockheaderbyhash", { makeMemberMethod(&RpcServer::on_get_block_header_by_hash), true } },
-      { "getblockheaderbyheight", { makeMemberMethod(&RpcServer::on_get_block_header_by_height), true } },
-      { "getblocktimestamp", { makeMemberMethod(&RpcServer::on_get_block_timestamp_by_height), true } },
-      { "getblockbyheight", { makeMemberMethod(&RpcServer::on_get_block_details_by_height), true } },
-      { "getblockbyhash", { makeMemberMethod(&RpcServer::on_get_block_details_by_hash), true } },
-      { "getblocksbyheights", { makeMemberMethod(&RpcServer::on_get_blocks_details_by_heights), true } },
-      { "getblocksbyhashes", { makeMemberMethod(&RpcServer::on_get_blocks_details_by_hashes), true } },
-      { "getblockshashesbytimestamps", { makeMemberMethod(&RpcServer::on_get_blocks_hashes_by_timestamps), true } },
-      { "getblockslist", { makeMemberMethod(&RpcServer::on_blocks_list_json), true } },
-      { "getaltblockslist", { makeMemberMethod(&RpcServer::on_alt_blocks_list_json), true } },
-      { "getlastblockheader", { makeMemberMethod(&RpcServer::on_get_last_block_header), true } },
-      { "gettransaction", { makeMemberMethod(&RpcServer::on_get_transaction_details_by_hash), true } },
-      { "gettransactionspool", { makeMemberMethod(&RpcServer::on_get_transactions_pool_short), true } },
-      { "getrawtransactionspool", { makeMemberMethod(&RpcServer::on_get_transactions_pool_raw), true } },
-      { "gettransactionsinpool", { makeMemberMethod(&RpcServer::on_get_transactions_pool), true } },
-      { "gettransactionsbypaymentid", { makeMemberMethod(&RpcServer::on_get_transactions_by_payment_id), true } },
-      { "gettransactionhashesbypaymentid", { makeMemberMethod(&RpcServer::on_get_transaction_hashes_by_paymentid), true } },
-      { "gettransactionsbyhashes", { makeMemberMethod(&RpcServer::on_get_transactions_details_by_hashes), true } },
-      { "gettransactionsbyheights", { makeMemberMethod(&RpcServer::on_get_transactions_details_by_heights), true } },
-      { "getrawtransactionsbyheights", { makeMemberMethod(&RpcServer::on_get_transactions_with_output_global_indexes_by_heights), true } },
-      { "getcurrencyid", { makeMemberMethod(&RpcServer::on_get_currency_id), true } },
-      { "getstatsbyheights", { makeMemberMethod(&RpcServer::on_get_stats_by_heights), false } },
-      { "getstatsinrange", { makeMemberMethod(&RpcServer::on_get_stats_by_heights_range), false } },
-      { "checktransactionkey", { makeMemberMethod(&RpcServer::on_check_transaction_key), true } },
-      { "checktransactionbyviewkey", { makeMemberMethod(&RpcServer::on_check_transaction_with_view_key), true } },
-      { "checktransactionproof", { makeMemberMethod(&RpcServer::on_check_transaction_proof), true } },
-      { "checkreserveproof", { makeMemberMethod(&RpcServer::on_check_reserve_proof), true } },
-      { "checkpayment", { makeMemberMethod(&RpcServer::on_check_payment), true } },
-      { "validateaddress", { makeMemberMethod(&RpcServer::on_validate_address), true } },
-      { "verifymessage", { makeMemberMethod(&RpcServer::on_verify_message), true } },
-      { "submitblock", { makeMemberMethod(&RpcServer::on_submitblock), false } },
-      { "resolveopenalias", { makeMemberMethod(&RpcServer::on_resolve_open_alias), true } },
+  if (!jsonBody.isArray()) {
+    auto body = std::make_shared<JsonRpcResponse>();
+    JsonRpcRequest jsonRequest;
+    const RpcHandler<JsonMemberMethod>* handler = prepareJsonRpcCall(request.getPeerAddress(), std::move(jsonBody), jsonRequest, *body);
+    HttpResponse::BodyWriter writer = [body](Common::IOutputStream& stream) { body->writeBody(stream); };
+    if (handler != nullptr) {
+      invokeJsonRpcHandler(request.getPeerAddress(), *handler, jsonRequest, *body);
+      writer = countingBodyWriter(writer, *getMethodMetrics(jsonRequest.getMethod())->responseSize);
+    }
 
-    };
+    response.setBodyWriter(writer);
+    //logger(Logging::TRACE) << "JSON-RPC response: " << jsonResponse.getBody();
+    return true;
+  }
+
+  if (jsonBody.size() == 0 || jsonBody.size() > JSON_RPC_MAX_BATCH_SIZE) {
+    JsonRpcResponse jsonResponse;
+    jsonResponse.setError(JsonRpcError(errInvalidRequest, "Batch must contain from 1 to " + std::to_string(JSON_RPC_MAX_BATCH_SIZE) + " calls"));
+    response.setBody(jsonResponse.getBody());
+    return true;
+  }
+
+  auto body = std::make_shared<std::vector<JsonRpcResponse>>(jsonBody.size());
+  processJsonRpcBatch(request.getPeerAddress(), jsonBody, *body);
+
+  // Every result is serialized straight into the connection, the batch is never rendered as a whole
+  response.setBodyWriter([body](Common::IOutputStream& stream) {
+    Common::write(stream, std::string("["));
+    for (size_t i = 0; i < body->size(); ++i) {
+      if (i != 0) {
+        Common::write(stream, std::string(","));
+      }
 
-    auto it = jsonRpcHandlers.find(jsonRequest.getMethod());
-    if (it == jsonRpcHandlers.end()) {
-      throw JsonRpcError(JsonRpc::errMethodNotFound);
+      (*body)[i].writeBody(stream);
     }
 
-    if (!it->second.allowBusyCore && !isCoreReady()) {
-      throw JsonRpcError(CORE_RPC_ERROR_CODE_CORE_BUSY, "Core is busy");
+    Common::write(stream, std::string("]"));
+  });
+
+  return true;
+}
+
+void RpcServer::processJsonRpcBatch(const std::string& client, Common::JsonValue& calls, std::vector<JsonRpc::JsonRpcResponse>& responses) {
+  size_t count = calls.size();
+  std::vector<JsonRpc::JsonRpcRequest> requests(count);
+  std::vector<const RpcHandler<JsonRpc::JsonMemberMethod>*> handlers(count);
+  for (size_t i = 0; i < count; ++i) {
+    handlers[i] = prepareJsonRpcCall(client, std::move(calls[i]), requests[i], responses[i]);
+  }
+
+  auto servedInline = [&handlers](size_t i) {
+    return handlers[i] == nullptr || (!handlers[i]->onNodeThread() && !handlers[i]->heavy() && !handlers[i]->ownLocks());
+  };
+
+  size_t i = 0;
+  while (i < count) {
+    if (!servedInline(i)) {
+      invokeJsonRpcHandler(client, *handlers[i], requests[i], responses[i]);
+      ++i;
+      continue;
+    }
+
+    // Consecutive calls served on this thread run back to back under one acquisition of the core locks. Calls that
+    // take other locks run on their own, holding the core locks over them would impose a lock order on their callees.
+    // The run is bounded so a large batch doesn't hold back block processing for long.
+    size_t end = i;
+    while (end < count && end - i < JSON_RPC_BATCH_LOCKED_CALLS && servedInline(end)) {
+      ++end;
     }
 
-    it->second.handler(this, jsonRequest, jsonResponse);
+    m_core.executeLocked([&] {
+      for (size_t j = i; j < end; ++j) {
+        if (handlers[j] != nullptr) {
+          invokeJsonRpcHandler(client, *handlers[j], requests[j], responses[j]);
+        }
+      }
+
+      return std::error_code();
+    });
+
+    i = end;
+  }
+}
 
-  } catch (const JsonRpcError& err) {
+const RpcServer::RpcHandler<JsonRpc::JsonMemberMethod>* RpcServer::prepareJsonRpcCall(const std::string& client, Common::JsonValue&& call,
+                                                                                       JsonRpc::JsonRpcRequest& jsonRequest, JsonRpc::JsonRpcResponse& jsonResponse) {
+  try {
+    jsonRequest.parseRequest(std::move(call));
+    jsonResponse.setId(jsonRequest.getId()); // copy id
+
+    auto it = s_jsonRpcHandlers.find(jsonRequest.getMethod());
+    if (it == s_jsonRpcHandlers.end()) {
+      throw JsonRpc::JsonRpcError(JsonRpc::errMethodNotFound);
+    }
+
+    if (!admitCall(client, it->second.heavy())) {
+      throw JsonRpc::JsonRpcError(CORE_RPC_ERROR_CODE_TOO_MANY_REQUESTS, "Too many requests");
+    }
+
+    return &it->second;
+  } catch (const JsonRpc::JsonRpcError& err) {
     jsonResponse.setError(err);
   } catch (const std::exception& e) {
-    jsonResponse.setError(JsonRpcError(JsonRpc::errInternalError, e.what()));
+    jsonResponse.setError(JsonRpc::JsonRpcError(JsonRpc::errInvalidRequest, e.what()));
   }
 
-  response.setBody(jsonResponse.getBody());
-  //logger(Logging::TRACE) << "JSON-RPC response: " << jsonResponse.getBody();
-  return true;
+  return nullptr;
+}
+
+void RpcServer::invokeJsonRpcHandler(const std::string& client, const RpcHandler<JsonRpc::JsonMemberMethod>& handler,
+                                     const JsonRpc::JsonRpcRequest& jsonRequest, JsonRpc::JsonRpcResponse& jsonResponse) {
+  Common::MetricsTimer timer(*getMethodMetrics(jsonRequest.getMethod())->duration);
+  try {
+    if (!handler.allowBusyCore() && !isCoreReady()) {
+      throw JsonRpc::JsonRpcError(CORE_RPC_ERROR_CODE_CORE_BUSY, "Core is busy");
+    }
+
+    if (!invokeHandler(client, handler.onNodeThread(), handler.heavy(), [&] { handler.handler(this, jsonRequest, jsonResponse); })) {
+      throw JsonRpc::JsonRpcError(CORE_RPC_ERROR_CODE_SERVER_BUSY, "Server is busy");
+    }
+  } catch (const JsonRpc::JsonRpcError& err) {
+    jsonResponse.setError(err);
+  } catch (const System::InterruptedException&) {
+    throw;
+  } catch (const std::exception& e) {
+    jsonResponse.setError(JsonRpc::JsonRpcError(JsonRpc::errInternalError, e.what()));
+  }
 }
 
 bool RpcServer::restrictRpc(const bool is_restricted) {
@@ -480,10 +721,112 @@ bool RpcServer::setContactInfo(const std::string& contact) {
   return true;
 }
 
+bool RpcServer::enableWorkers(size_t threads, size_t maxQueueSize) {
+  m_workerPool.reset(threads > 0 ? new System::WorkerPool(threads, maxQueueSize) : nullptr);
+  return true;
+}
+
+bool RpcServer::enableResponseCache(size_t maxEntries) {
+  m_response_cache.reset(maxEntries > 0 ? new RpcResponseCache(maxEntries, [this](uint32_t height) { return m_core.getBlockIdByHeight(height); }) : nullptr);
+  return true;
+}
+
+bool RpcServer::enableAdmissionControl(uint32_t rate, uint32_t burst, uint32_t heavyCost, size_t maxInFlight) {
+  m_admission.reset(rate > 0 || maxInFlight > 0 ? new RpcAdmissionControl(rate, burst, heavyCost, maxInFlight) : nullptr);
+  return true;
+}
+
+void RpcServer::blockchainUpdated() {
+  if (m_response_cache) {
+    uint32_t height = m_core.getCurrentBlockchainHeight();
+    m_response_cache->invalidateFrom(height > RESPONSE_CACHE_TIP_DEPTH ? height - RESPONSE_CACHE_TIP_DEPTH : 0);
+  }
+
+  m_changeNotifier.notify();
+}
+
+void RpcServer::poolUpdated() {
+  m_changeNotifier.notify();
+}
+
+uint32_t RpcServer::getReorgDepth(const Crypto::Hash& blockId) {
+  // blocks disconnected by a reorganization are kept among the alternative ones, follow them back to the main chain
+  uint32_t depth = 0;
+  uint32_t height;
+  Crypto::Hash hash = blockId;
+  Block block;
+  while (!m_core.getBlockHeight(hash, height)) {
+    if (depth == REORG_DEPTH_MAX_LOOKUP || !m_core.getBlockByHash(hash, block)) {
+      return 0;
+    }
+
+    hash = block.previousBlockHash;
+    ++depth;
+  }
+
+  return depth;
+}
+
 bool RpcServer::isCoreReady() {
   return m_core.currency().isTestnet() || m_p2p.get_payload_object().isSynchronized();
 }
 
+bool RpcServer::admitCall(const std::string& client, bool heavy) {
+  return !m_admission || m_admission->charge(client, heavy ? RpcAdmissionControl::HEAVY : RpcAdmissionControl::LIGHT);
+}
+
+bool RpcServer::invokeHandler(const std::string& client, bool onNodeThread, bool heavy, const std::function<void()>& procedure) {
+  auto queued = std::chrono::steady_clock::now();
+  auto waited = [queued](Common::MetricsHistogram& wait) {
+    wait.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - queued).count());
+  };
+
+  if (onNodeThread) {
+    m_nodeQueueDepthMetric.record(++m_nodeQueueSize);
+    BOOST_SCOPE_EXIT_ALL(this) {
+      --m_nodeQueueSize;
+    };
+
+    invokeOnServerDispatcher([&] {
+      waited(m_nodeQueueWaitMetric);
+      procedure();
+    });
+
+    return true;
+  }
+
+  System::Dispatcher* dispatcher = getCurrentDispatcher();
+  if (heavy && m_workerPool && dispatcher != nullptr) {
+    m_workerQueueDepthMetric.record(m_workerPool->getQueueSize());
+    return m_workerPool->run(*dispatcher, client, [&] {
+      waited(m_workerQueueWaitMetric);
+      procedure();
+    });
+  }
+
+  procedure();
+  return true;
+}
+
+const RpcServer::MethodMetrics* RpcServer::getMethodMetrics(const std::string& method) const {
+  auto it = m_methodMetrics.find(method);
+  if (it == m_methodMetrics.end() && Common::starts_with(method, "/api/")) {
+    it = m_methodMetrics.find(method.substr(0, method.rfind('/') + 1));
+  }
+
+  return it != m_methodMetrics.end() ? &it->second : nullptr;
+}
+
+void RpcServer::recordCall(const MethodMetrics& metrics, std::chrono::steady_clock::time_point start, const HttpRequest& request, HttpResponse& response) {
+  metrics.duration->record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+  metrics.requestSize->record(request.getBody().size());
+  if (response.getBodyWriter()) {
+    response.setBodyWriter(countingBodyWriter(response.getBodyWriter(), *metrics.responseSize));
+  } else {
+    metrics.responseSize->record(response.getBody().size());
+  }
+}
+
 bool RpcServer::checkIncomingTransactionForFee(const BinaryArray& tx_blob) {
   Crypto::Hash tx_hash = NULL_HASH;
   Crypto::Hash tx_prefixt_hash = NULL_HASH;
@@ -542,18 +885,11 @@ bool RpcServer::on_get_blocks(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, C
   res.current_height = totalBlockCount;
   res.start_height = startBlockIndex;
 
-  for (const auto& blockId : supplement) {
-    assert(m_core.have_block(blockId));
-    auto completeBlock = m_core.getBlock(blockId);
-    assert(completeBlock != nullptr);
-
-    res.blocks.resize(res.blocks.size() + 1);
-    res.blocks.back().block = Common::asString(toBinaryArray(completeBlock->getBlock()));
-
-    res.blocks.back().txs.reserve(completeBlock->getTransactionCount());
-    for (size_t i = 0; i < completeBlock->getTransactionCount(); ++i) {
-      res.blocks.back().txs.push_back(Common::asString(toBinaryArray(completeBlock->getTransaction(i))));
-    }
+  // blobs are copied as stored, the supplement is a run of main chain blocks from startBlockIndex
+  res.blocks.reserve(supplement.size());
+  if (!supplement.empty() && !m_core.getRawBlocks(startBlockIndex, static_cast<uint32_t>(supplement.size()), res.blocks)) {
+    res.status = "Failed";
+    return false;
   }
 
   res.status = CORE_RPC_STATUS_OK;
@@ -638,7 +974,7 @@ bool RpcServer::on_get_random_outs(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOU
 bool RpcServer::on_get_pool_changes(const COMMAND_RPC_GET_POOL_CHANGES::request& req, COMMAND_RPC_GET_POOL_CHANGES::response& rsp) {
   rsp.status = CORE_RPC_STATUS_OK;
   std::vector<CryptoNote::Transaction> addedTransactions;
-  rsp.isTailBlockActual = m_core.getPoolChanges(req.tailBlockId, req.knownTxsIds, addedTransactions, rsp.deletedTxsIds);
+  rsp.isTailBlockActual = m_core.getPoolChanges(req.tailBlockId, req.knownPoolSequence, req.knownTxsIds, addedTransactions, rsp.deletedTxsIds, rsp.poolSequence, rsp.isFullResync);
   for (auto& tx : addedTransactions) {
     BinaryArray txBlob;
     if (!toBinaryArray(tx, txBlob)) {
@@ -654,8 +990,34 @@ bool RpcServer::on_get_pool_changes(const COMMAND_RPC_GET_POOL_CHANGES::request&
 
 bool RpcServer::on_get_pool_changes_lite(const COMMAND_RPC_GET_POOL_CHANGES_LITE::request& req, COMMAND_RPC_GET_POOL_CHANGES_LITE::response& rsp) {
   rsp.status = CORE_RPC_STATUS_OK;
-  rsp.isTailBlockActual = m_core.getPoolChangesLite(req.tailBlockId, req.knownTxsIds, rsp.addedTxs, rsp.deletedTxsIds);
+  rsp.isTailBlockActual = m_core.getPoolChangesLite(req.tailBlockId, req.knownPoolSequence, req.knownTxsIds, rsp.addedTxs, rsp.deletedTxsIds, rsp.poolSequence, rsp.isFullResync);
+
+  return true;
+}
+
+bool RpcServer::on_wait_for_changes(const COMMAND_RPC_WAIT_FOR_CHANGES::request& req, COMMAND_RPC_WAIT_FOR_CHANGES::response& rsp) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(std::min(req.timeout, WAIT_FOR_CHANGES_MAX_TIMEOUT));
+  for (;;) {
+    // taken before the state is read so that an update in between ends the wait at once
+    uint64_t version = m_changeNotifier.getVersion();
 
+    m_core.get_blockchain_top(rsp.height, rsp.tail_block_id);
+    rsp.is_tail_block_actual = rsp.tail_block_id == req.tail_block_id;
+    rsp.added_txs_ids.clear();
+    rsp.deleted_txs_ids.clear();
+    m_core.getPoolChangesIds(req.known_pool_sequence, req.known_txs_ids, rsp.added_txs_ids, rsp.deleted_txs_ids, rsp.pool_sequence, rsp.is_full_resync);
+    rsp.changed = !rsp.is_tail_block_actual || rsp.is_full_resync || !rsp.added_txs_ids.empty() || !rsp.deleted_txs_ids.empty();
+
+    auto now = std::chrono::steady_clock::now();
+    if (rsp.changed || now >= deadline) {
+      break;
+    }
+
+    m_changeNotifier.wait(getCurrentDispatcher(), version, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now));
+  }
+
+  rsp.reorg_depth = rsp.is_tail_block_actual ? 0 : getReorgDepth(req.tail_block_id);
+  rsp.status = CORE_RPC_STATUS_OK;
   return true;
 }
 
@@ -736,6 +1098,13 @@ bool RpcServer::on_get_block_details_by_height(const COMMAND_RPC_GET_BLOCK_DETAI
         std::string("To big height: ") + std::to_string(req.blockHeight) + ", current blockchain height = " + std::to_string(m_core.getCurrentBlockchainHeight() - 1) };
     }
     Crypto::Hash block_hash = m_core.getBlockIdByHeight(req.blockHeight);
+    std::string cacheKey = "block:" + Common::podToHex(block_hash);
+    if (auto cached = getCachedResponse<BlockDetails>(cacheKey)) {
+      rsp.block = *cached;
+      rsp.block.depth = m_core.getCurrentBlockchainHeight() - rsp.block.height - 1;
+      rsp.status = CORE_RPC_STATUS_OK;
+      return true;
+    }
     Block blk;
     if (!m_core.getBlockByHash(block_hash, blk)) {
       throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
@@ -744,6 +1113,9 @@ bool RpcServer::on_get_block_details_by_height(const COMMAND_RPC_GET_BLOCK_DETAI
     if (!blockchainExplorerDataBuilder.fillBlockDetails(blk, blockDetails, true)) {
       throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "Internal error: can't fill block details." };
     }
+    if (!blockDetails.isOrphaned) {
+      cacheResponse(cacheKey, blockDetails.height, block_hash, blockDetails);
+    }
     rsp.block = blockDetails;
   }
   catch (std::system_error& e) {
@@ -767,6 +1139,13 @@ bool RpcServer::on_get_block_details_by_hash(const COMMAND_RPC_GET_BLOCK_DETAILS
         CORE_RPC_ERROR_CODE_WRONG_PARAM,
         "Failed to parse hex representation of block hash. Hex = " + req.hash + '.' };
     }
+    std::string cacheKey = "block:" + Common::podToHex(block_hash);
+    if (auto cached = getCachedResponse<BlockDetails>(cacheKey)) {
+      rsp.block = *cached;
+      rsp.block.depth = m_core.getCurrentBlockchainHeight() - rsp.block.height - 1;
+      rsp.status = CORE_RPC_STATUS_OK;
+      return true;
+    }
     Block blk;
     if (!m_core.getBlockByHash(block_hash, blk)) {
       throw JsonRpc::JsonRpcError{
@@ -776,6 +1155,9 @@ bool RpcServer::on_get_block_details_by_hash(const COMMAND_RPC_GET_BLOCK_DETAILS
     if (!blockchainExplorerDataBuilder.fillBlockDetails(blk, blockDetails, true)) {
       throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "Internal error: can't fill block details." };
     }
+    if (!blockDetails.isOrphaned) {
+      cacheResponse(cacheKey, blockDetails.height, block_hash, blockDetails);
+    }
     rsp.block = blockDetails;
   }
   catch (std::system_error& e) {
@@ -867,6 +1249,12 @@ bool RpcServer::on_get_transaction_details_by_hash(const COMMAND_RPC_GET_TRANSAC
         CORE_RPC_ERROR_CODE_WRONG_PARAM,
         "Failed to parse hex representation of transaction hash. Hex = " + req.hash + '.' };
     }
+    std::string cacheKey = "tx:" + Common::podToHex(tx_hash);
+    if (auto cached = getCachedResponse<TransactionDetails>(cacheKey)) {
+      rsp.transaction = *cached;
+      rsp.status = CORE_RPC_STATUS_OK;
+      return true;
+    }
     hashes.push_back(tx_hash);
     m_core.getTransactions(hashes, txs, missed_txs, true);
 
@@ -881,6 +1269,9 @@ bool RpcServer::on_get_transaction_details_by_hash(const COMMAND_RPC_GET_TRANSAC
       throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
         "Internal error: can't fill transaction details." };
     }
+    if (transactionsDetails.inBlockchain) {
+      cacheResponse(cacheKey, transactionsDetails.blockHeight, transactionsDetails.blockHash, transactionsDetails);
+    }
 
     rsp.transaction = std::move(transactionsDetails);
   }
@@ -1290,6 +1681,34 @@ bool RpcServer::on_get_payment_id(const COMMAND_HTTP::request& req, COMMAND_HTTP
   return true;
 }
 
+bool RpcServer::on_get_metrics(const HttpRequest& request, HttpResponse& response) {
+  // internal counters of the node, for its operator only
+  if (m_restricted_rpc) {
+    response.setStatus(HttpResponse::STATUS_404);
+    response.setBody("Method disabled");
+    return true;
+  }
+
+  std::ostringstream gauges;
+  gauges << "# TYPE rpc_queue_size gauge\n";
+  gauges << "rpc_queue_size{queue=\"node\"} " << m_nodeQueueSize << "\n";
+  gauges << "rpc_queue_size{queue=\"workers\"} " << (m_workerPool ? m_workerPool->getQueueSize() : 0) << "\n";
+  gauges << "# TYPE rpc_connections gauge\n";
+  gauges << "rpc_connections " << get_connections_count() << "\n";
+  gauges << "# TYPE txpool_transactions gauge\n";
+  gauges << "txpool_transactions " << m_core.getPoolTransactionsCount() << "\n";
+  gauges << "# TYPE txpool_size_bytes gauge\n";
+  gauges << "txpool_size_bytes " << m_core.getPoolSize() << "\n";
+  gauges << "# TYPE txpool_min_fee_per_byte gauge\n";
+  gauges << "txpool_min_fee_per_byte " << m_core.getPoolMinimalFeePerByte() << "\n";
+
+  response.addHeader("Content-Type", "text/plain; version=0.0.4");
+  response.addHeader("Cache-Control", "no-cache, no-store, must-revalidate");
+  response.setStatus(HttpResponse::STATUS_200);
+  response.setBody(Common::MetricsRegistry::instance().render() + gauges.str());
+  return true;
+}
+
 //
 // JSON handlers
 //
@@ -1324,6 +1743,10 @@ bool RpcServer::on_get_info(const COMMAND_RPC_GET_INFO::request& req, COMMAND_RP
       CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "Internal error: can't get last cumulative difficulty." };
   }
   res.max_cumulative_block_size = (uint64_t)m_core.currency().maxBlockCumulativeSize(res.height);
+  res.rpc_cache_hits = m_response_cache ? m_response_cache->getHits() : 0;
+  res.rpc_cache_misses = m_response_cache ? m_response_cache->getMisses() : 0;
+  res.rpc_requests_served = m_admission ? m_admission->getServed() : 0;
+  res.rpc_requests_rejected = m_admission ? m_admission->getRejected() : 0;
 
   res.status = CORE_RPC_STATUS_OK;
   return true;
@@ -1635,6 +2058,15 @@ bool RpcServer::on_blocks_list_json(const COMMAND_RPC_GET_BLOCKS_LIST::request&
     last_height = 0;
   }
 
+  // The list is built from blocks below req.height, it stays valid while that block is on the main chain
+  Crypto::Hash top_hash = m_core.getBlockIdByHeight(req.height);
+  std::string cacheKey = "blocks_list:" + std::to_string(req.height) + ":" + std::to_string(print_blocks_count);
+  if (auto cached = getCachedResponse<std::vector<block_short_response>>(cacheKey)) {
+    res.blocks = *cached;
+    res.status = CORE_RPC_STATUS_OK;
+    return true;
+  }
+
   for (uint32_t i = req.height; i >= last_height; i--) {
     Crypto::Hash block_hash = m_core.getBlockIdByHeight(i);
     Block blk;
@@ -1664,6 +2096,7 @@ bool RpcServer::on_blocks_list_json(const COMMAND_RPC_GET_BLOCKS_LIST::request&
       break;
   }
 
+  cacheResponse(cacheKey, req.height, top_hash, res.blocks);
   res.status = CORE_RPC_STATUS_OK;
   return true;
 }
@@ -1984,6 +2417,14 @@ bool RpcServer::on_get_block_header_by_height(const COMMAND_RPC_GET_BLOCK_HEADER
   }
 
   Crypto::Hash block_hash = m_core.getBlockIdByHeight(static_cast<uint32_t>(req.height));
+  std::string cacheKey = "header:" + Common::podToHex(block_hash);
+  if (auto cached = getCachedResponse<block_header_response>(cacheKey)) {
+    res.block_header = *cached;
+    res.block_header.depth = m_core.getCurrentBlockchainHeight() - res.block_header.height - 1;
+    res.status = CORE_RPC_STATUS_OK;
+    return true;
+  }
+
   Block blk;
   if (!m_core.getBlockByHash(block_hash, blk)) {
     throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
@@ -1993,6 +2434,9 @@ bool RpcServer::on_get_block_header_by_height(const COMMAND_RPC_GET_BLOCK_HEADER
   Crypto::Hash tmp_hash = m_core.getBlockIdByHeight(req.height);
   bool is_orphaned = block_hash != tmp_hash;
   fill_block_header_response(blk, is_orphaned, req.height, block_hash, res.block_header);
+  if (!is_orphaned) {
+    cacheResponse(cacheKey, req.height, block_hash, res.block_header);
+  }
   res.status = CORE_RPC_STATUS_OK;
   return true;
 }
@@ -20,16 +20,27 @@
 #pragma once
 
 #include "HttpServer.h"
+#include "JsonRpc.h"
+#include "RpcAdmissionControl.h"
+#include "RpcChangeNotifier.h"
+#include "RpcResponseCache.h"
 
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <memory>
 #include <unordered_map>
 
+#include <System/WorkerPool.h>
+
 #include <Logging/LoggerRef.h>
 #include "ITransaction.h"
 #include "CoreRpcServerCommandsDefinitions.h"
 #include "BlockchainExplorer/BlockchainExplorerDataBuilder.h"
 #include "CryptoNoteCore/Core.h"
+#include "CryptoNoteCore/ICoreObserver.h"
 #include "Common/Math.h"
+#include "Common/Metrics.h"
 
 namespace CryptoNote {
 
@@ -38,9 +49,10 @@ class NodeServer;
 class BlockchainExplorer;
 class ICryptoNoteProtocolQuery;
 
-class RpcServer : public HttpServer {
+class RpcServer : public HttpServer, private ICoreObserver {
 public:
   RpcServer(System::Dispatcher& dispatcher, Logging::ILogger& log, Core& core, NodeServer& p2p, ICryptoNoteProtocolQuery& protocolQuery);
+  ~RpcServer();
 
   typedef std::function<bool(RpcServer*, const HttpRequest& request, HttpResponse& response)> HandlerFunction;
   bool restrictRpc(const bool is_resctricted);
@@ -49,23 +61,85 @@ public:
   bool setFeeAmount(const uint64_t fee_amount);
   bool setViewKey(const std::string& view_key);
   bool setContactInfo(const std::string& contact);
+  bool enableWorkers(size_t threads, size_t maxQueueSize);
+  bool enableResponseCache(size_t maxEntries);
+  bool enableAdmissionControl(uint32_t rate, uint32_t burst, uint32_t heavyCost, size_t maxInFlight);
   bool checkIncomingTransactionForFee(const BinaryArray& tx_blob);
   std::string getCorsDomain();
 
 private:
 
+  // How a handler is run, combined in the handler tables
+  enum HandlerFlags : uint32_t {
+    NONE = 0,
+    // handler is served while the core is still synchronizing
+    ALLOW_BUSY_CORE = 1 << 0,
+    // handler uses P2P or protocol state, run it on the node dispatcher when RPC is served by several threads
+    ON_NODE_THREAD = 1 << 1,
+    // CPU bound handler, run it on the worker pool instead of the serving dispatcher
+    HEAVY = 1 << 2,
+    // handler takes locks besides the core ones or waits on I/O, a JSON-RPC batch doesn't run it under the core locks
+    OWN_LOCKS = 1 << 3
+  };
+
   template <class Handler>
   struct RpcHandler {
     const Handler handler;
-    const bool allowBusyCore;
+    const uint32_t flags;
+
+    bool allowBusyCore() const { return (flags & ALLOW_BUSY_CORE) != 0; }
+    bool onNodeThread() const { return (flags & ON_NODE_THREAD) != 0; }
+    bool heavy() const { return (flags & HEAVY) != 0; }
+    bool ownLocks() const { return (flags & OWN_LOCKS) != 0; }
+  };
+
+  struct MethodMetrics {
+    Common::MetricsHistogram* duration;
+    Common::MetricsHistogram* requestSize;
+    Common::MetricsHistogram* responseSize;
   };
 
   typedef void (RpcServer::*HandlerPtr)(const HttpRequest& request, HttpResponse& response);
   static std::unordered_map<std::string, RpcHandler<HandlerFunction>> s_handlers;
+  static std::unordered_map<std::string, RpcHandler<JsonRpc::JsonMemberMethod>> s_jsonRpcHandlers;
 
   virtual void processRequest(const HttpRequest& request, HttpResponse& response) override;
   bool processJsonRpcRequest(const HttpRequest& request, HttpResponse& response);
+  void processJsonRpcBatch(const std::string& client, Common::JsonValue& calls, std::vector<JsonRpc::JsonRpcResponse>& responses);
+  // Parses a single call, looks up its handler and charges it to the client,
+  // returns null with the error stored in jsonResponse on failure
+  const RpcHandler<JsonRpc::JsonMemberMethod>* prepareJsonRpcCall(const std::string& client, Common::JsonValue&& call,
+                                                                  JsonRpc::JsonRpcRequest& jsonRequest, JsonRpc::JsonRpcResponse& jsonResponse);
+  void invokeJsonRpcHandler(const std::string& client, const RpcHandler<JsonRpc::JsonMemberMethod>& handler,
+                            const JsonRpc::JsonRpcRequest& jsonRequest, JsonRpc::JsonRpcResponse& jsonResponse);
   bool isCoreReady();
+  // Charges a call to the client's token bucket, true when admission control is off
+  bool admitCall(const std::string& client, bool heavy);
+  // Heavy procedures queue on the worker pool per client, so clients take turns for the workers
+  bool invokeHandler(const std::string& client, bool onNodeThread, bool heavy, const std::function<void()>& procedure);
+  // Metrics of a route, /api/ routes are looked up by prefix. Null for unknown routes, they aren't tracked
+  // so scanning random urls can't grow the registry.
+  const MethodMetrics* getMethodMetrics(const std::string& method) const;
+  void recordCall(const MethodMetrics& metrics, std::chrono::steady_clock::time_point start, const HttpRequest& request, HttpResponse& response);
+  bool on_get_metrics(const HttpRequest& request, HttpResponse& response);
+
+  // ICoreObserver
+  virtual void blockchainUpdated() override;
+  virtual void poolUpdated() override;
+
+  uint32_t getReorgDepth(const Crypto::Hash& blockId);
+
+  template <typename T>
+  std::shared_ptr<const T> getCachedResponse(const std::string& key) {
+    return m_response_cache ? m_response_cache->get<T>(key) : nullptr;
+  }
+
+  template <typename T>
+  void cacheResponse(const std::string& key, uint32_t height, const Crypto::Hash& blockHash, const T& value) {
+    if (m_response_cache) {
+      m_response_cache->put(key, height, blockHash, value);
+    }
+  }
 
   // binary handlers
   bool on_get_blocks(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, COMMAND_RPC_GET_BLOCKS_FAST::response& res);
@@ -75,6 +149,7 @@ private:
   bool on_get_random_outs(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response& res);
   bool on_get_pool_changes(const COMMAND_RPC_GET_POOL_CHANGES::request& req, COMMAND_RPC_GET_POOL_CHANGES::response& rsp);
   bool on_get_pool_changes_lite(const COMMAND_RPC_GET_POOL_CHANGES_LITE::request& req, COMMAND_RPC_GET_POOL_CHANGES_LITE::response& rsp);
+  bool on_wait_for_changes(const COMMAND_RPC_WAIT_FOR_CHANGES::request& req, COMMAND_RPC_WAIT_FOR_CHANGES::response& rsp);
 
   // http handlers
   bool on_get_index(const COMMAND_HTTP::request& req, COMMAND_HTTP::response& res);
@@ -146,6 +221,17 @@ private:
   std::string m_contact_info;
   Crypto::SecretKey m_view_key = NULL_SECRET_KEY;
   CryptoNote::AccountPublicAddress m_fee_acc;
+  std::unique_ptr<System::WorkerPool> m_workerPool;
+  std::unique_ptr<RpcResponseCache> m_response_cache;
+  std::unique_ptr<RpcAdmissionControl> m_admission;
+  RpcChangeNotifier m_changeNotifier;
+  std::unordered_map<std::string, MethodMetrics> m_methodMetrics;
+  // calls waiting for or running on the node dispatcher
+  std::atomic<size_t> m_nodeQueueSize;
+  Common::MetricsHistogram& m_nodeQueueDepthMetric;
+  Common::MetricsHistogram& m_nodeQueueWaitMetric;
+  Common::MetricsHistogram& m_workerQueueDepthMetric;
+  Common::MetricsHistogram& m_workerQueueWaitMetric;
 };
 
 }
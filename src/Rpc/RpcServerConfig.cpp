@@ -36,6 +36,18 @@ namespace CryptoNote {
     const command_line::arg_descriptor<uint16_t>    arg_rpc_bind_port   = { "rpc-bind-port", "", DEFAULT_RPC_PORT };
     const command_line::arg_descriptor<bool> arg_rpc_bind_ssl_enable    = { "rpc-bind-ssl-enable", "Enable SSL for RPC service", false };
     const command_line::arg_descriptor<uint16_t> arg_rpc_bind_ssl_port  = { "rpc-bind-ssl-port", "SSL port for RPC service", DEFAULT_RPC_SSL_PORT };
+    const command_line::arg_descriptor<size_t>   arg_rpc_threads        = { "rpc-threads", "Number of threads serving RPC connections, separate from the P2P thread when greater than 1", 1 };
+    const command_line::arg_descriptor<size_t>   arg_rpc_workers        = { "rpc-workers", "Number of threads executing heavy RPC requests, 0 to execute them inline", 2 };
+    const command_line::arg_descriptor<size_t>   arg_rpc_workers_queue  = { "rpc-workers-queue", "Number of heavy RPC requests allowed to wait for a worker before the server reports busy", 16 };
+    const command_line::arg_descriptor<size_t>   arg_rpc_cache_entries  = { "rpc-cache-entries", "Number of explorer responses for historical blocks kept in memory, 0 to disable", 1024 };
+    const command_line::arg_descriptor<uint32_t> arg_rpc_limit_rate     = { "rpc-limit-rate", "Tokens per second each client address gets for RPC calls of every class, 0 to disable the limit", 0 };
+    const command_line::arg_descriptor<uint32_t> arg_rpc_limit_burst    = { "rpc-limit-burst", "Tokens a client address can save up per class of RPC calls", 100 };
+    const command_line::arg_descriptor<uint32_t> arg_rpc_limit_heavy    = { "rpc-limit-heavy-cost", "Tokens taken by a heavy RPC call, light calls take one", 10 };
+    const command_line::arg_descriptor<size_t>   arg_rpc_limit_in_flight = { "rpc-limit-in-flight", "Number of RPC requests a client address can have served at once, 0 for no limit", 0 };
+    const command_line::arg_descriptor<bool>     arg_rpc_chunked        = { "rpc-chunked-encoding", "Stream large JSON responses with chunked transfer encoding, needs clients able to decode it", false };
+    const command_line::arg_descriptor<int>      arg_rpc_compression_level = { "rpc-compression-level", "zlib level (1-9) of gzip/deflate compression offered to RPC clients sending Accept-Encoding, 0 to disable", 1 };
+    const command_line::arg_descriptor<size_t>   arg_rpc_compression_threshold = { "rpc-compression-threshold", "Smallest RPC response body in bytes that gets compressed", 1024 };
+    const command_line::arg_descriptor<size_t>   arg_rpc_compression_threads = { "rpc-compression-threads", "Number of threads compressing RPC responses, 0 to compress on the threads serving connections", 0 };
     const command_line::arg_descriptor<std::string> arg_chain_file      = { "rpc-chain-file", "SSL chain file", DEFAULT_RPC_CHAIN_FILE };
     const command_line::arg_descriptor<std::string> arg_key_file        = { "rpc-key-file", "SSL key file", DEFAULT_RPC_KEY_FILE };
     const command_line::arg_descriptor<std::string> arg_dh_file         = { "rpc-dh-file", "SSL DH file", DEFAULT_RPC_DH_FILE };
@@ -58,12 +70,36 @@ namespace CryptoNote {
     nodeFeeAddress(""),
     nodeFeeAmountStr(""),
     nodeFeeViewKey(""),
-    bindPortSSL(RPC_DEFAULT_SSL_PORT) {
+    bindPortSSL(RPC_DEFAULT_SSL_PORT),
+    threads(1),
+    workers(2),
+    workersQueue(16),
+    chunkedEncoding(false),
+    compressionLevel(1),
+    compressionThreshold(1024),
+    compressionThreads(0),
+    cacheEntries(1024),
+    limitRate(0),
+    limitBurst(100),
+    limitHeavyCost(10),
+    limitInFlight(0) {
   }
 
   bool RpcServerConfig::isEnabledSSL() const { return enableSSL; }
   uint16_t RpcServerConfig::getBindPort() const { return bindPort; }
   uint16_t RpcServerConfig::getBindPortSSL() const { return bindPortSSL; }
+  size_t RpcServerConfig::getThreads() const { return threads; }
+  size_t RpcServerConfig::getWorkers() const { return workers; }
+  size_t RpcServerConfig::getWorkersQueue() const { return workersQueue; }
+  bool RpcServerConfig::isChunkedEncoding() const { return chunkedEncoding; }
+  int RpcServerConfig::getCompressionLevel() const { return compressionLevel; }
+  size_t RpcServerConfig::getCompressionThreshold() const { return compressionThreshold; }
+  size_t RpcServerConfig::getCompressionThreads() const { return compressionThreads; }
+  size_t RpcServerConfig::getCacheEntries() const { return cacheEntries; }
+  uint32_t RpcServerConfig::getLimitRate() const { return limitRate; }
+  uint32_t RpcServerConfig::getLimitBurst() const { return limitBurst; }
+  uint32_t RpcServerConfig::getLimitHeavyCost() const { return limitHeavyCost; }
+  size_t RpcServerConfig::getLimitInFlight() const { return limitInFlight; }
   std::string RpcServerConfig::getBindIP() const { return bindIp; }
   std::string RpcServerConfig::getDhFile() const { return dhFile; }
   std::string RpcServerConfig::getChainFile() const { return chainFile; }
@@ -76,6 +112,18 @@ namespace CryptoNote {
     command_line::add_arg(desc, arg_rpc_bind_port);
     command_line::add_arg(desc, arg_rpc_bind_ssl_enable);
     command_line::add_arg(desc, arg_rpc_bind_ssl_port);
+    command_line::add_arg(desc, arg_rpc_threads);
+    command_line::add_arg(desc, arg_rpc_workers);
+    command_line::add_arg(desc, arg_rpc_workers_queue);
+    command_line::add_arg(desc, arg_rpc_chunked);
+    command_line::add_arg(desc, arg_rpc_compression_level);
+    command_line::add_arg(desc, arg_rpc_compression_threshold);
+    command_line::add_arg(desc, arg_rpc_compression_threads);
+    command_line::add_arg(desc, arg_rpc_cache_entries);
+    command_line::add_arg(desc, arg_rpc_limit_rate);
+    command_line::add_arg(desc, arg_rpc_limit_burst);
+    command_line::add_arg(desc, arg_rpc_limit_heavy);
+    command_line::add_arg(desc, arg_rpc_limit_in_flight);
     command_line::add_arg(desc, arg_chain_file);
     command_line::add_arg(desc, arg_key_file);
     command_line::add_arg(desc, arg_dh_file);
@@ -92,6 +140,18 @@ namespace CryptoNote {
     bindPort = command_line::get_arg(vm, arg_rpc_bind_port);
     enableSSL = command_line::get_arg(vm, arg_rpc_bind_ssl_enable);
     bindPortSSL = command_line::get_arg(vm, arg_rpc_bind_ssl_port);
+    threads = command_line::get_arg(vm, arg_rpc_threads);
+    workers = command_line::get_arg(vm, arg_rpc_workers);
+    workersQueue = command_line::get_arg(vm, arg_rpc_workers_queue);
+    chunkedEncoding = command_line::get_arg(vm, arg_rpc_chunked);
+    compressionLevel = command_line::get_arg(vm, arg_rpc_compression_level);
+    compressionThreshold = command_line::get_arg(vm, arg_rpc_compression_threshold);
+    compressionThreads = command_line::get_arg(vm, arg_rpc_compression_threads);
+    cacheEntries = command_line::get_arg(vm, arg_rpc_cache_entries);
+    limitRate = command_line::get_arg(vm, arg_rpc_limit_rate);
+    limitBurst = command_line::get_arg(vm, arg_rpc_limit_burst);
+    limitHeavyCost = command_line::get_arg(vm, arg_rpc_limit_heavy);
+    limitInFlight = command_line::get_arg(vm, arg_rpc_limit_in_flight);
     chainFile = command_line::get_arg(vm, arg_chain_file);
     keyFile = command_line::get_arg(vm, arg_key_file);
     dhFile = command_line::get_arg(vm, arg_dh_file);
@@ -33,6 +33,18 @@ public:
   bool isEnabledSSL() const;
   uint16_t getBindPort() const;
   uint16_t getBindPortSSL() const;
+  size_t getThreads() const;
+  size_t getWorkers() const;
+  size_t getWorkersQueue() const;
+  bool isChunkedEncoding() const;
+  int getCompressionLevel() const;
+  size_t getCompressionThreshold() const;
+  size_t getCompressionThreads() const;
+  size_t getCacheEntries() const;
+  uint32_t getLimitRate() const;
+  uint32_t getLimitBurst() const;
+  uint32_t getLimitHeavyCost() const;
+  size_t getLimitInFlight() const;
   std::string getBindIP() const;
   std::string getBindAddress() const;
   std::string getBindAddressSSL() const;
@@ -45,6 +57,18 @@ public:
   bool        enableSSL;
   uint16_t    bindPort;
   uint16_t    bindPortSSL;
+  size_t      threads;
+  size_t      workers;
+  size_t      workersQueue;
+  bool        chunkedEncoding;
+  int         compressionLevel;
+  size_t      compressionThreshold;
+  size_t      compressionThreads;
+  size_t      cacheEntries;
+  uint32_t    limitRate;
+  uint32_t    limitBurst;
+  uint32_t    limitHeavyCost;
+  size_t      limitInFlight;
   std::string bindIp;
   std::string dhFile;
   std::string chainFile;
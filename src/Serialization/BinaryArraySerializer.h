@@ -0,0 +1,273 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "ISerializer.h"
+
+namespace CryptoNote {
+
+// Non-virtual counterparts of BinaryOutputStreamSerializer and BinaryInputStreamSerializer working on memory.
+// They have the member interface of ISerializer, so serialize definitions written as templates on the serializer
+// type compile for them and every field becomes an inlined varint or memcpy. Only types with such definitions
+// can be serialized, there is no fallback to ISerializer.
+class BinaryArrayOutputSerializer {
+public:
+  // Appends to output
+  explicit BinaryArrayOutputSerializer(std::vector<uint8_t>& output) : output(output) {}
+
+  ISerializer::SerializerType type() const { return ISerializer::OUTPUT; }
+
+  bool beginObject(Common::StringView name) { return true; }
+  void endObject() {}
+
+  bool beginArray(size_t& size, Common::StringView name) {
+    writeVarint(size);
+    return true;
+  }
+
+  void endArray() {}
+
+  bool operator()(uint8_t& value, Common::StringView name) { writeVarint(value); return true; }
+  bool operator()(int16_t& value, Common::StringView name) { writeVarint(static_cast<uint16_t>(value)); return true; }
+  bool operator()(uint16_t& value, Common::StringView name) { writeVarint(value); return true; }
+  bool operator()(int32_t& value, Common::StringView name) { writeVarint(static_cast<uint32_t>(value)); return true; }
+  bool operator()(uint32_t& value, Common::StringView name) { writeVarint(value); return true; }
+  bool operator()(int64_t& value, Common::StringView name) { writeVarint(static_cast<uint64_t>(value)); return true; }
+  bool operator()(uint64_t& value, Common::StringView name) { writeVarint(value); return true; }
+  bool operator()(bool& value, Common::StringView name) { output.push_back(value ? 1 : 0); return true; }
+
+  bool operator()(std::string& value, Common::StringView name) {
+    writeVarint(value.size());
+    return binary(&value[0], value.size(), name);
+  }
+
+  bool binary(void* value, size_t size, Common::StringView name) {
+    const uint8_t* data = static_cast<const uint8_t*>(value);
+    output.insert(output.end(), data, data + size);
+    return true;
+  }
+
+  bool binary(std::string& value, Common::StringView name) { return (*this)(value, name); }
+
+  template<typename T>
+  bool operator()(T& value, Common::StringView name) {
+    return serialize(value, name, *this);
+  }
+
+private:
+  void writeVarint(uint64_t value) {
+    while (value >= 0x80) {
+      output.push_back(static_cast<uint8_t>(value | 0x80));
+      value >>= 7;
+    }
+
+    output.push_back(static_cast<uint8_t>(value));
+  }
+
+  std::vector<uint8_t>& output;
+};
+
+// Throws std::runtime_error on truncated data and on the varints BinaryInputStreamSerializer rejects
+class BinaryArrayInputSerializer {
+public:
+  BinaryArrayInputSerializer(const void* data, size_t size) :
+    current(static_cast<const uint8_t*>(data)), end(current + size) {}
+
+  ISerializer::SerializerType type() const { return ISerializer::INPUT; }
+
+  bool beginObject(Common::StringView name) { return true; }
+  void endObject() {}
+
+  bool beginArray(size_t& size, Common::StringView name) {
+    uint64_t value;
+    readVarint(value);
+    size = static_cast<size_t>(value);
+    return true;
+  }
+
+  void endArray() {}
+
+  bool operator()(uint8_t& value, Common::StringView name) { readVarint(value); return true; }
+  bool operator()(int16_t& value, Common::StringView name) { readVarintAs<uint16_t>(value); return true; }
+  bool operator()(uint16_t& value, Common::StringView name) { readVarint(value); return true; }
+  bool operator()(int32_t& value, Common::StringView name) { readVarintAs<uint32_t>(value); return true; }
+  bool operator()(uint32_t& value, Common::StringView name) { readVarint(value); return true; }
+  bool operator()(int64_t& value, Common::StringView name) { readVarintAs<uint64_t>(value); return true; }
+  bool operator()(uint64_t& value, Common::StringView name) { readVarint(value); return true; }
+
+  bool operator()(bool& value, Common::StringView name) {
+    uint8_t byte;
+    binary(&byte, 1, name);
+    value = byte != 0;
+    return true;
+  }
+
+  bool operator()(std::string& value, Common::StringView name) {
+    uint64_t size;
+    readVarint(size);
+    checkAvailable(size);
+    value.assign(reinterpret_cast<const char*>(current), static_cast<size_t>(size));
+    current += size;
+    return true;
+  }
+
+  bool binary(void* value, size_t size, Common::StringView name) {
+    checkAvailable(size);
+    if (size != 0) {
+      memcpy(value, current, size);
+      current += size;
+    }
+
+    return true;
+  }
+
+  bool binary(std::string& value, Common::StringView name) { return (*this)(value, name); }
+
+  template<typename T>
+  bool operator()(T& value, Common::StringView name) {
+    return serialize(value, name, *this);
+  }
+
+  bool endOfStream() const { return current == end; }
+
+  // Next byte to be read, for callers that need the boundaries of the serialized fields
+  const uint8_t* position() const { return current; }
+
+  // Every element takes at least a byte, so a larger count can't be satisfied and is rejected before allocating
+  void checkArraySize(size_t size) const {
+    checkAvailable(size);
+  }
+
+private:
+  void checkAvailable(uint64_t size) const {
+    if (size > static_cast<uint64_t>(end - current)) {
+      throw std::runtime_error("Unexpected end of binary data");
+    }
+  }
+
+  // Same checks as Common::readVarint: values that don't fit T and zero trailing groups are rejected
+  template<typename T>
+  void readVarint(T& value) {
+    T temp = 0;
+    for (uint8_t shift = 0;; shift += 7) {
+      checkAvailable(1);
+      uint8_t piece = *current++;
+      if (shift >= sizeof(temp) * 8 - 7 && piece >= 1 << (sizeof(temp) * 8 - shift)) {
+        throw std::runtime_error("readVarint, value overflow");
+      }
+
+      temp |= static_cast<T>(static_cast<uint64_t>(piece & 0x7f) << shift);
+      if ((piece & 0x80) == 0) {
+        if (piece == 0 && shift != 0) {
+          throw std::runtime_error("readVarint, invalid value representation");
+        }
+
+        break;
+      }
+    }
+
+    value = temp;
+  }
+
+  template<typename StorageType, typename T>
+  void readVarintAs(T& value) {
+    StorageType temp;
+    readVarint(temp);
+    value = static_cast<T>(temp);
+  }
+
+  const uint8_t* current;
+  const uint8_t* end;
+};
+
+template<typename T>
+bool serialize(T& value, Common::StringView name, BinaryArrayOutputSerializer& serializer) {
+  serialize(value, serializer);
+  return true;
+}
+
+template<typename T>
+bool serialize(T& value, Common::StringView name, BinaryArrayInputSerializer& serializer) {
+  serialize(value, serializer);
+  return true;
+}
+
+// Classes with a serialize member template on the serializer type
+template<typename T>
+void serialize(T& value, BinaryArrayOutputSerializer& serializer) {
+  value.serialize(serializer);
+}
+
+template<typename T>
+void serialize(T& value, BinaryArrayInputSerializer& serializer) {
+  value.serialize(serializer);
+}
+
+template<typename T>
+bool serialize(std::vector<T>& value, Common::StringView name, BinaryArrayOutputSerializer& serializer) {
+  size_t size = value.size();
+  serializer.beginArray(size, name);
+  for (auto& item : value) {
+    serializer(item, "");
+  }
+
+  return true;
+}
+
+template<typename T>
+bool serialize(std::vector<T>& value, Common::StringView name, BinaryArrayInputSerializer& serializer) {
+  size_t size;
+  serializer.beginArray(size, name);
+  serializer.checkArraySize(size);
+  value.resize(size);
+  for (auto& item : value) {
+    serializer(item, "");
+  }
+
+  return true;
+}
+
+template<typename T>
+typename std::enable_if<std::is_pod<T>::value>::type
+serializeAsBinary(std::vector<T>& value, Common::StringView name, BinaryArrayOutputSerializer& serializer) {
+  size_t size = value.size() * sizeof(T);
+  serializer.beginArray(size, name);
+  serializer.binary(value.data(), size, name);
+}
+
+template<typename T>
+typename std::enable_if<std::is_pod<T>::value>::type
+serializeAsBinary(std::vector<T>& value, Common::StringView name, BinaryArrayInputSerializer& serializer) {
+  size_t size;
+  serializer.beginArray(size, name);
+  serializer.checkArraySize(size);
+  if (size % sizeof(T) != 0) {
+    throw std::runtime_error("Invalid blob size given!");
+  }
+
+  value.resize(size / sizeof(T));
+  serializer.binary(value.data(), size, name);
+}
+
+}
@@ -0,0 +1,174 @@
+// Copyright (c) 2012-2016, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "JsonOutputStreamingSerializer.h"
+#include <cassert>
+#include <cinttypes>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include "Common/StreamTools.h"
+#include "Common/StringTools.h"
+
+using namespace CryptoNote;
+
+JsonOutputStreamingSerializer::JsonOutputStreamingSerializer(Common::IOutputStream& stream) : stream(stream) {
+  chain.push_back({ false, true });
+  write('{');
+}
+
+JsonOutputStreamingSerializer::~JsonOutputStreamingSerializer() {
+}
+
+ISerializer::SerializerType JsonOutputStreamingSerializer::type() const {
+  return ISerializer::OUTPUT;
+}
+
+void JsonOutputStreamingSerializer::finish() {
+  assert(chain.size() == 1);
+  chain.pop_back();
+  write('}');
+}
+
+bool JsonOutputStreamingSerializer::beginObject(Common::StringView name) {
+  beginValue(name);
+  chain.push_back({ false, true });
+  write('{');
+  return true;
+}
+
+void JsonOutputStreamingSerializer::endObject() {
+  assert(chain.size() > 1);
+  chain.pop_back();
+  write('}');
+}
+
+bool JsonOutputStreamingSerializer::beginArray(size_t& size, Common::StringView name) {
+  beginValue(name);
+  chain.push_back({ true, true });
+  write('[');
+  return true;
+}
+
+void JsonOutputStreamingSerializer::endArray() {
+  assert(chain.size() > 1);
+  chain.pop_back();
+  write(']');
+}
+
+bool JsonOutputStreamingSerializer::operator()(uint64_t& value, Common::StringView name) {
+  int64_t v = static_cast<int64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputStreamingSerializer::operator()(uint16_t& value, Common::StringView name) {
+  uint64_t v = static_cast<uint64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputStreamingSerializer::operator()(int16_t& value, Common::StringView name) {
+  int64_t v = static_cast<int64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputStreamingSerializer::operator()(uint32_t& value, Common::StringView name) {
+  uint64_t v = static_cast<uint64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputStreamingSerializer::operator()(int32_t& value, Common::StringView name) {
+  int64_t v = static_cast<int64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputStreamingSerializer::operator()(int64_t& value, Common::StringView name) {
+  beginValue(name);
+  char buffer[24];
+  int length = snprintf(buffer, sizeof(buffer), "%" PRId64, value);
+  write(buffer, static_cast<size_t>(length));
+  return true;
+}
+
+bool JsonOutputStreamingSerializer::operator()(double& value, Common::StringView name) {
+  beginValue(name);
+  // Same formatting as Common::JsonValue
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(11) << value;
+  std::string text = out.str();
+  while (text.size() > 1 && text[text.size() - 2] != '.' && text[text.size() - 1] == '0') {
+    text.resize(text.size() - 1);
+  }
+
+  write(text.data(), text.size());
+  return true;
+}
+
+bool JsonOutputStreamingSerializer::operator()(std::string& value, Common::StringView name) {
+  beginValue(name);
+  write('"');
+  write(value.data(), value.size());
+  write('"');
+  return true;
+}
+
+bool JsonOutputStreamingSerializer::operator()(uint8_t& value, Common::StringView name) {
+  int64_t v = static_cast<int64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputStreamingSerializer::operator()(bool& value, Common::StringView name) {
+  beginValue(name);
+  if (value) {
+    write("true", 4);
+  } else {
+    write("false", 5);
+  }
+
+  return true;
+}
+
+bool JsonOutputStreamingSerializer::binary(void* value, size_t size, Common::StringView name) {
+  std::string hex = Common::toHex(value, size);
+  return (*this)(hex, name);
+}
+
+bool JsonOutputStreamingSerializer::binary(std::string& value, Common::StringView name) {
+  return binary(const_cast<char*>(value.data()), value.size(), name);
+}
+
+void JsonOutputStreamingSerializer::beginValue(Common::StringView name) {
+  assert(!chain.empty());
+  Scope& scope = chain.back();
+  if (!scope.empty) {
+    write(',');
+  }
+
+  scope.empty = false;
+  if (!scope.isArray) {
+    write('"');
+    write(name.getData(), name.getSize());
+    write("\":", 2);
+  }
+}
+
+void JsonOutputStreamingSerializer::write(const char* data, size_t size) {
+  Common::write(stream, data, size);
+}
+
+void JsonOutputStreamingSerializer::write(char c) {
+  Common::write(stream, &c, 1);
+}
@@ -7,11 +7,9 @@
 
 #include "KVBinaryInputStreamSerializer.h"
 
-#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <stdexcept>
-#include <Common/StreamTools.h>
 #include "KVBinaryCommon.h"
 
 using namespace Common;
@@ -19,27 +17,26 @@ using namespace CryptoNote;
 
 namespace {
 
-template <typename T>
-T readPod(Common::IInputStream& s) {
-  T v;
-  read(s, &v, sizeof(T));
-  return v;
-}
+// Bounds the recursion while skipping over nested values
+const size_t MAX_NESTING_DEPTH = 100;
 
-template <typename T, typename JsonT = T>
-JsonValue readPodJson(Common::IInputStream& s) {
-  JsonValue jv;
-  jv = static_cast<JsonT>(readPod<T>(s));
-  return jv;
+void checkAvailable(const uint8_t* cursor, const uint8_t* end, size_t size) {
+  if (static_cast<size_t>(end - cursor) < size) {
+    throw std::runtime_error("Unexpected end of binary storage");
+  }
 }
 
 template <typename T>
-JsonValue readIntegerJson(Common::IInputStream& s) {
-  return readPodJson<T, int64_t>(s);
+T readPod(const uint8_t*& cursor, const uint8_t* end) {
+  checkAvailable(cursor, end, sizeof(T));
+  T v;
+  memcpy(&v, cursor, sizeof(T));
+  cursor += sizeof(T);
+  return v;
 }
 
-size_t readVarint(Common::IInputStream& s) {
-  uint8_t b = read<uint8_t>(s);
+size_t readVarint(const uint8_t*& cursor, const uint8_t* end) {
+  uint8_t b = readPod<uint8_t>(cursor, end);
   uint8_t size_mask = b & PORTABLE_RAW_SIZE_MARK_MASK;
   size_t bytesLeft = 0;
 
@@ -61,7 +58,7 @@ size_t readVarint(Common::IInputStream& s) {
   size_t value = b;
 
   for (size_t i = 1; i <= bytesLeft; ++i) {
-    size_t n = read<uint8_t>(s);
+    size_t n = readPod<uint8_t>(cursor, end);
     value |= n << (i * 8);
   }
 
@@ -69,129 +66,354 @@ size_t readVarint(Common::IInputStream& s) {
   return value;
 }
 
-std::string readString(Common::IInputStream& s) {
-  auto size = readVarint(s);
+// Size of a fixed size value, 0 for strings, objects and arrays
+size_t podSize(uint8_t type) {
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_INT64:
+  case BIN_KV_SERIALIZE_TYPE_UINT64:
+  case BIN_KV_SERIALIZE_TYPE_DOUBLE:
+    return 8;
+  case BIN_KV_SERIALIZE_TYPE_INT32:
+  case BIN_KV_SERIALIZE_TYPE_UINT32:
+    return 4;
+  case BIN_KV_SERIALIZE_TYPE_INT16:
+  case BIN_KV_SERIALIZE_TYPE_UINT16:
+    return 2;
+  case BIN_KV_SERIALIZE_TYPE_INT8:
+  case BIN_KV_SERIALIZE_TYPE_UINT8:
+  case BIN_KV_SERIALIZE_TYPE_BOOL:
+    return 1;
+  default:
+    return 0;
+  }
+}
 
-  std::string str;
-  str.resize(size);
-  if (size) {
-    read(s, &str[0], size);
+const uint8_t* skipValue(const uint8_t* cursor, const uint8_t* end, uint8_t type, size_t depth);
+
+const uint8_t* skipArray(const uint8_t* cursor, const uint8_t* end, uint8_t itemType, size_t depth) {
+  size_t count = readVarint(cursor, end);
+  size_t itemSize = podSize(itemType);
+  if (itemSize != 0) {
+    if (count > static_cast<size_t>(end - cursor) / itemSize) {
+      throw std::runtime_error("Unexpected end of binary storage");
+    }
+
+    return cursor + count * itemSize;
+  }
+
+  while (count--) {
+    cursor = skipValue(cursor, end, itemType, depth);
+  }
+
+  return cursor;
+}
+
+// Validates a value and returns where it ends
+const uint8_t* skipValue(const uint8_t* cursor, const uint8_t* end, uint8_t type, size_t depth) {
+  if (depth > MAX_NESTING_DEPTH) {
+    throw std::runtime_error("Binary storage nesting is too deep");
+  }
+
+  size_t size = podSize(type);
+  if (size != 0) {
+    checkAvailable(cursor, end, size);
+    return cursor + size;
+  }
+
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_STRING:
+    size = readVarint(cursor, end);
+    checkAvailable(cursor, end, size);
+    return cursor + size;
+  case BIN_KV_SERIALIZE_TYPE_OBJECT: {
+    size_t count = readVarint(cursor, end);
+    while (count--) {
+      uint8_t nameSize = readPod<uint8_t>(cursor, end);
+      checkAvailable(cursor, end, nameSize);
+      cursor += nameSize;
+      uint8_t elementType = readPod<uint8_t>(cursor, end);
+      if (elementType & BIN_KV_SERIALIZE_FLAG_ARRAY) {
+        cursor = skipArray(cursor, end, elementType & ~BIN_KV_SERIALIZE_FLAG_ARRAY, depth + 1);
+      } else {
+        cursor = skipValue(cursor, end, elementType, depth + 1);
+      }
+    }
+
+    return cursor;
+  }
+  case BIN_KV_SERIALIZE_TYPE_ARRAY:
+    return skipArray(cursor, end, type, depth + 1);
+  default:
+    throw std::runtime_error("Unknown data type");
   }
-  return str;
 }
 
-JsonValue readStringJson(Common::IInputStream& s) {
-  return JsonValue(readString(s));
 }
 
-void readName(Common::IInputStream& s, std::string& name) {
-  uint8_t len = readPod<uint8_t>(s);
-  if (len) {
-    name.resize(len);
-    read(s, &name[0], len);
+KVBinaryInputStreamSerializer::KVBinaryInputStreamSerializer(Common::IInputStream& strm) {
+  const size_t CHUNK_SIZE = 4096;
+  for (;;) {
+    size_t offset = m_buffer.size();
+    m_buffer.resize(offset + CHUNK_SIZE);
+    size_t size = strm.readSome(&m_buffer[offset], CHUNK_SIZE);
+    m_buffer.resize(offset + size);
+    if (size == 0) {
+      break;
+    }
   }
+
+  init(reinterpret_cast<const uint8_t*>(m_buffer.data()), m_buffer.size());
+}
+
+KVBinaryInputStreamSerializer::KVBinaryInputStreamSerializer(const void* data, size_t size) {
+  init(static_cast<const uint8_t*>(data), size);
 }
 
-JsonValue loadValue(Common::IInputStream& stream, uint8_t type);
-JsonValue loadSection(Common::IInputStream& stream);
-JsonValue loadEntry(Common::IInputStream& stream);
-JsonValue loadArray(Common::IInputStream& stream, uint8_t itemType);
+void KVBinaryInputStreamSerializer::init(const uint8_t* data, size_t size) {
+  m_end = data + size;
+  auto hdr = readPod<KVBinaryStorageBlockHeader>(data, m_end);
+
+  if (
+    hdr.m_signature_a != PORTABLE_STORAGE_SIGNATUREA ||
+    hdr.m_signature_b != PORTABLE_STORAGE_SIGNATUREB) {
+    throw std::runtime_error("Invalid binary storage signature");
+  }
 
+  if (hdr.m_ver != PORTABLE_STORAGE_FORMAT_VER) {
+    throw std::runtime_error("Unknown binary storage format version");
+  }
 
-JsonValue loadSection(Common::IInputStream& stream) {
-  JsonValue sec(JsonValue::OBJECT);
-  size_t count = readVarint(stream);
-  std::string name;
+  // the whole document is validated here, values are read later without checking nested structure again
+  skipValue(data, m_end, BIN_KV_SERIALIZE_TYPE_OBJECT, 0);
+  openObject(data);
+}
 
+void KVBinaryInputStreamSerializer::openObject(const uint8_t* data) {
+  Level level = {};
+  level.firstElement = m_elements.size();
+  size_t count = readVarint(data, m_end);
   while (count--) {
-    readName(stream, name);
-    sec.insert(name, loadEntry(stream));
+    Element element;
+    uint8_t nameSize = readPod<uint8_t>(data, m_end);
+    checkAvailable(data, m_end, nameSize);
+    element.name = Common::StringView(reinterpret_cast<const char*>(data), nameSize);
+    data += nameSize;
+    element.type = readPod<uint8_t>(data, m_end);
+    element.isArray = (element.type & BIN_KV_SERIALIZE_FLAG_ARRAY) != 0 || element.type == BIN_KV_SERIALIZE_TYPE_ARRAY;
+    element.type &= ~BIN_KV_SERIALIZE_FLAG_ARRAY;
+    element.data = data;
+    data = element.isArray ? skipArray(data, m_end, element.type, 0) : skipValue(data, m_end, element.type, 0);
+    m_elements.push_back(element);
   }
 
-  return sec;
+  level.elementCount = m_elements.size() - level.firstElement;
+  m_stack.push_back(level);
 }
 
-JsonValue loadValue(Common::IInputStream& stream, uint8_t type) {
-  switch (type) {
-  case BIN_KV_SERIALIZE_TYPE_INT64:  return readIntegerJson<int64_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_INT32:  return readIntegerJson<int32_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_INT16:  return readIntegerJson<int16_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_INT8:   return readIntegerJson<int8_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_UINT64: return readIntegerJson<uint64_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_UINT32: return readIntegerJson<uint32_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_UINT16: return readIntegerJson<uint16_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_UINT8:  return readIntegerJson<uint8_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_DOUBLE: return readPodJson<double>(stream);
-  case BIN_KV_SERIALIZE_TYPE_BOOL:   return JsonValue(read<uint8_t>(stream) != 0);
-  case BIN_KV_SERIALIZE_TYPE_STRING: return readStringJson(stream);
-  case BIN_KV_SERIALIZE_TYPE_OBJECT: return loadSection(stream);
-  case BIN_KV_SERIALIZE_TYPE_ARRAY:  return loadArray(stream, type);
+// The next item of the current array, or the first element with the given name of the current object
+bool KVBinaryInputStreamSerializer::getElement(Common::StringView name, Element& element) {
+  assert(!m_stack.empty());
+  Level& level = m_stack.back();
+  if (level.isArray) {
+    if (level.itemsLeft == 0) {
+      throw std::out_of_range("Binary storage array has no more items");
+    }
+
+    element.name = name;
+    element.type = level.itemType;
+    element.isArray = level.itemType == BIN_KV_SERIALIZE_TYPE_ARRAY;
+    element.data = level.next;
+    level.next = element.isArray ? skipArray(level.next, m_end, level.itemType, 0) : skipValue(level.next, m_end, level.itemType, 0);
+    --level.itemsLeft;
+    return true;
+  }
+
+  for (size_t i = level.firstElement; i < level.firstElement + level.elementCount; ++i) {
+    if (m_elements[i].name == name) {
+      element = m_elements[i];
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool KVBinaryInputStreamSerializer::getInteger(Common::StringView name, int64_t& value) {
+  Element element;
+  if (!getElement(name, element)) {
+    return false;
+  }
+
+  if (element.isArray) {
+    throw std::runtime_error("Binary storage value is not an integer");
+  }
+
+  const uint8_t* data = element.data;
+  switch (element.type) {
+  case BIN_KV_SERIALIZE_TYPE_INT64:  value = readPod<int64_t>(data, m_end); break;
+  case BIN_KV_SERIALIZE_TYPE_INT32:  value = readPod<int32_t>(data, m_end); break;
+  case BIN_KV_SERIALIZE_TYPE_INT16:  value = readPod<int16_t>(data, m_end); break;
+  case BIN_KV_SERIALIZE_TYPE_INT8:   value = readPod<int8_t>(data, m_end); break;
+  case BIN_KV_SERIALIZE_TYPE_UINT64: value = static_cast<int64_t>(readPod<uint64_t>(data, m_end)); break;
+  case BIN_KV_SERIALIZE_TYPE_UINT32: value = readPod<uint32_t>(data, m_end); break;
+  case BIN_KV_SERIALIZE_TYPE_UINT16: value = readPod<uint16_t>(data, m_end); break;
+  case BIN_KV_SERIALIZE_TYPE_UINT8:  value = readPod<uint8_t>(data, m_end); break;
   default:
-    throw std::runtime_error("Unknown data type");
-    break;
+    throw std::runtime_error("Binary storage value is not an integer");
   }
+
+  return true;
 }
 
-JsonValue loadEntry(Common::IInputStream& stream) {
-  uint8_t type = readPod<uint8_t>(stream);
+ISerializer::SerializerType KVBinaryInputStreamSerializer::type() const {
+  return ISerializer::INPUT;
+}
+
+bool KVBinaryInputStreamSerializer::beginObject(Common::StringView name) {
+  Element element;
+  if (!getElement(name, element)) {
+    return false;
+  }
 
-  if (type & BIN_KV_SERIALIZE_FLAG_ARRAY) {
-    type &= ~BIN_KV_SERIALIZE_FLAG_ARRAY;
-    return loadArray(stream, type);
+  if (element.isArray || element.type != BIN_KV_SERIALIZE_TYPE_OBJECT) {
+    throw std::runtime_error("Binary storage value is not an object");
   }
 
-  return loadValue(stream, type);
+  openObject(element.data);
+  return true;
 }
 
-JsonValue loadArray(Common::IInputStream& stream, uint8_t itemType) {
-  JsonValue arr(JsonValue::ARRAY);
-  size_t count = readVarint(stream);
+void KVBinaryInputStreamSerializer::endObject() {
+  assert(!m_stack.empty() && !m_stack.back().isArray);
+  m_elements.resize(m_stack.back().firstElement);
+  m_stack.pop_back();
+}
 
-  while (count--) {
-    arr.pushBack(loadValue(stream, itemType));
+bool KVBinaryInputStreamSerializer::beginArray(size_t& size, Common::StringView name) {
+  if (m_stack.back().isArray) {
+    throw std::runtime_error("Binary storage arrays of arrays are not supported");
   }
 
-  return arr;
+  Element element;
+  if (!getElement(name, element)) {
+    size = 0;
+    return false;
+  }
+
+  if (!element.isArray) {
+    throw std::runtime_error("Binary storage value is not an array");
+  }
+
+  Level level = {};
+  level.isArray = true;
+  level.next = element.data;
+  level.itemsLeft = readVarint(level.next, m_end);
+  level.itemType = element.type;
+  m_stack.push_back(level);
+  size = level.itemsLeft;
+  return true;
 }
 
+void KVBinaryInputStreamSerializer::endArray() {
+  assert(!m_stack.empty() && m_stack.back().isArray);
+  m_stack.pop_back();
+}
 
-JsonValue parseBinary(Common::IInputStream& stream) {
-  auto hdr = readPod<KVBinaryStorageBlockHeader>(stream);
+bool KVBinaryInputStreamSerializer::operator()(uint8_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
 
-  if (
-    hdr.m_signature_a != PORTABLE_STORAGE_SIGNATUREA ||
-    hdr.m_signature_b != PORTABLE_STORAGE_SIGNATUREB) {
-    throw std::runtime_error("Invalid binary storage signature");
+bool KVBinaryInputStreamSerializer::operator()(int16_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool KVBinaryInputStreamSerializer::operator()(uint16_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool KVBinaryInputStreamSerializer::operator()(int32_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool KVBinaryInputStreamSerializer::operator()(uint32_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool KVBinaryInputStreamSerializer::operator()(int64_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool KVBinaryInputStreamSerializer::operator()(uint64_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool KVBinaryInputStreamSerializer::operator()(double& value, Common::StringView name) {
+  Element element;
+  if (!getElement(name, element)) {
+    return false;
   }
 
-  if (hdr.m_ver != PORTABLE_STORAGE_FORMAT_VER) {
-    throw std::runtime_error("Unknown binary storage format version");
+  if (element.isArray || element.type != BIN_KV_SERIALIZE_TYPE_DOUBLE) {
+    throw std::runtime_error("Binary storage value is not a double");
   }
 
-  return loadSection(stream);
+  const uint8_t* data = element.data;
+  value = readPod<double>(data, m_end);
+  return true;
 }
 
+bool KVBinaryInputStreamSerializer::operator()(bool& value, Common::StringView name) {
+  Element element;
+  if (!getElement(name, element)) {
+    return false;
+  }
+
+  if (element.isArray || element.type != BIN_KV_SERIALIZE_TYPE_BOOL) {
+    throw std::runtime_error("Binary storage value is not a bool");
+  }
+
+  const uint8_t* data = element.data;
+  value = readPod<uint8_t>(data, m_end) != 0;
+  return true;
 }
 
-KVBinaryInputStreamSerializer::KVBinaryInputStreamSerializer(Common::IInputStream& strm) : JsonInputValueSerializer(parseBinary(strm)) {
+bool KVBinaryInputStreamSerializer::operator()(std::string& value, Common::StringView name) {
+  Element element;
+  if (!getElement(name, element)) {
+    return false;
+  }
+
+  if (element.isArray || element.type != BIN_KV_SERIALIZE_TYPE_STRING) {
+    throw std::runtime_error("Binary storage value is not a string");
+  }
+
+  const uint8_t* data = element.data;
+  size_t size = readVarint(data, m_end);
+  checkAvailable(data, m_end, size);
+  value.assign(reinterpret_cast<const char*>(data), size);
+  return true;
 }
 
 bool KVBinaryInputStreamSerializer::binary(void* value, size_t size, Common::StringView name) {
-  std::string str;
-
-  if (!(*this)(str, name)) {
+  Element element;
+  if (!getElement(name, element)) {
     return false;
   }
 
-  if (str.size() != size) {
+  if (element.isArray || element.type != BIN_KV_SERIALIZE_TYPE_STRING) {
+    throw std::runtime_error("Binary storage value is not a string");
+  }
+
+  const uint8_t* data = element.data;
+  if (readVarint(data, m_end) != size) {
     throw std::runtime_error("Binary block size mismatch");
   }
 
-  memcpy(value, str.data(), size);
+  checkAvailable(data, m_end, size);
+  memcpy(value, data, size);
   return true;
 }
 
 bool KVBinaryInputStreamSerializer::binary(std::string& value, Common::StringView name) {
   return (*this)(value, name); // load as string
 }
-
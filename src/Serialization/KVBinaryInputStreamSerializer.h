@@ -17,18 +17,89 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
 #include <Common/IInputStream.h>
 #include "ISerializer.h"
-#include "JsonInputValueSerializer.h"
 
 namespace CryptoNote {
 
-class KVBinaryInputStreamSerializer : public JsonInputValueSerializer {
+// Reads values straight out of the serialized data, without building a JsonValue first. Opening an object indexes
+// its elements by name, a value is decoded only when it is asked for and strings are copied once, into their destination.
+class KVBinaryInputStreamSerializer : public ISerializer {
 public:
+  // Reads the rest of the stream into a buffer of its own
   KVBinaryInputStreamSerializer(Common::IInputStream& strm);
+  // Reads from data in place, it has to outlive the serializer
+  KVBinaryInputStreamSerializer(const void* data, size_t size);
+  virtual ~KVBinaryInputStreamSerializer() {}
 
+  virtual SerializerType type() const override;
+
+  virtual bool beginObject(Common::StringView name) override;
+  virtual void endObject() override;
+
+  virtual bool beginArray(size_t& size, Common::StringView name) override;
+  virtual void endArray() override;
+
+  virtual bool operator()(uint8_t& value, Common::StringView name) override;
+  virtual bool operator()(int16_t& value, Common::StringView name) override;
+  virtual bool operator()(uint16_t& value, Common::StringView name) override;
+  virtual bool operator()(int32_t& value, Common::StringView name) override;
+  virtual bool operator()(uint32_t& value, Common::StringView name) override;
+  virtual bool operator()(int64_t& value, Common::StringView name) override;
+  virtual bool operator()(uint64_t& value, Common::StringView name) override;
+  virtual bool operator()(double& value, Common::StringView name) override;
+  virtual bool operator()(bool& value, Common::StringView name) override;
+  virtual bool operator()(std::string& value, Common::StringView name) override;
   virtual bool binary(void* value, size_t size, Common::StringView name) override;
   virtual bool binary(std::string& value, Common::StringView name) override;
+
+  template<typename T>
+  bool operator()(T& value, Common::StringView name) {
+    return ISerializer::operator()(value, name);
+  }
+
+private:
+  struct Element {
+    Common::StringView name;
+    uint8_t type;
+    bool isArray;
+    const uint8_t* data;
+  };
+
+  struct Level {
+    bool isArray;
+    // objects: their elements in m_elements
+    size_t firstElement;
+    size_t elementCount;
+    // arrays: the next item and how many are left
+    const uint8_t* next;
+    size_t itemsLeft;
+    uint8_t itemType;
+  };
+
+  void init(const uint8_t* data, size_t size);
+  void openObject(const uint8_t* data);
+  bool getElement(Common::StringView name, Element& element);
+  bool getInteger(Common::StringView name, int64_t& value);
+
+  template <typename T>
+  bool getNumber(Common::StringView name, T& value) {
+    int64_t integer;
+    if (!getInteger(name, integer)) {
+      return false;
+    }
+
+    value = static_cast<T>(integer);
+    return true;
+  }
+
+  std::string m_buffer;
+  const uint8_t* m_end;
+  // elements of all open objects, each object's follow its parent's
+  std::vector<Element> m_elements;
+  std::vector<Level> m_stack;
 };
 
 }
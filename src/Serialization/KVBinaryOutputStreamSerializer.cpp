@@ -19,6 +19,8 @@
 #include "KVBinaryCommon.h"
 
 #include <cassert>
+#include <cstring>
+#include <limits>
 #include <stdexcept>
 #include <Common/StreamTools.h>
 
@@ -33,10 +35,10 @@ void writePod(IOutputStream& s, const T& value) {
 }
 
 template<class T>
-size_t packVarint(IOutputStream& s, uint8_t type_or, size_t pv) {
+size_t packVarint(uint8_t* buffer, uint8_t type_or, size_t pv) {
   T v = static_cast<T>(pv << 2);
   v |= type_or;
-  write(s, &v, sizeof(T));
+  memcpy(buffer, &v, sizeof(T));
   return sizeof(T);
 }
 
@@ -50,21 +52,29 @@ void writeElementName(IOutputStream& s, Common::StringView name) {
   write(s, name.getData(), len);
 }
 
-size_t writeArraySize(IOutputStream& s, size_t val) {
+// buffer has to hold 8 bytes
+size_t packArraySize(uint8_t* buffer, size_t val) {
   if (val <= 63) {
-    return packVarint<uint8_t>(s, PORTABLE_RAW_SIZE_MARK_BYTE, val);
+    return packVarint<uint8_t>(buffer, PORTABLE_RAW_SIZE_MARK_BYTE, val);
   } else if (val <= 16383) {
-    return packVarint<uint16_t>(s, PORTABLE_RAW_SIZE_MARK_WORD, val);
+    return packVarint<uint16_t>(buffer, PORTABLE_RAW_SIZE_MARK_WORD, val);
   } else if (val <= 1073741823) {
-    return packVarint<uint32_t>(s, PORTABLE_RAW_SIZE_MARK_DWORD, val);
+    return packVarint<uint32_t>(buffer, PORTABLE_RAW_SIZE_MARK_DWORD, val);
   } else {
     if (val > 4611686018427387903) {
       throw std::runtime_error("failed to pack varint - too big amount");
     }
-    return packVarint<uint64_t>(s, PORTABLE_RAW_SIZE_MARK_INT64, val);
+    return packVarint<uint64_t>(buffer, PORTABLE_RAW_SIZE_MARK_INT64, val);
   }
 }
 
+size_t writeArraySize(IOutputStream& s, size_t val) {
+  uint8_t buffer[sizeof(uint64_t)];
+  size_t size = packArraySize(buffer, val);
+  write(s, buffer, size);
+  return size;
+}
+
 }
 
 namespace CryptoNote {
@@ -74,7 +84,6 @@ KVBinaryOutputStreamSerializer::KVBinaryOutputStreamSerializer() {
 }
 
 void KVBinaryOutputStreamSerializer::dump(IOutputStream& target) {
-  assert(m_objectsStack.size() == 1);
   assert(m_stack.size() == 1);
 
   KVBinaryStorageBlockHeader hdr;
@@ -84,7 +93,7 @@ void KVBinaryOutputStreamSerializer::dump(IOutputStream& target) {
 
   Common::write(target, &hdr, sizeof(hdr));
   writeArraySize(target, m_stack.front().count);
-  write(target, stream().data(), stream().size());
+  write(target, m_stream.data(), m_stream.size());
 }
 
 ISerializer::SerializerType KVBinaryOutputStreamSerializer::type() const {
@@ -92,29 +101,26 @@ ISerializer::SerializerType KVBinaryOutputStreamSerializer::type() const {
 }
 
 bool KVBinaryOutputStreamSerializer::beginObject(Common::StringView name) {
-  checkArrayPreamble(BIN_KV_SERIALIZE_TYPE_OBJECT);
- 
-  m_stack.push_back(Level(name));
-  m_objectsStack.push_back(MemoryStream());
+  if (m_stack.empty()) {
+    // the root object's count is written by dump
+    m_stack.push_back(Level(0));
+    return true;
+  }
 
+  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_OBJECT, name);
+  m_stack.push_back(Level(m_stream.size()));
+  uint8_t count = 0;
+  write(m_stream, &count, sizeof(count));
   return true;
 }
 
 void KVBinaryOutputStreamSerializer::endObject() {
-  assert(m_objectsStack.size());
+  assert(m_stack.size() > 1);
 
-  auto level = std::move(m_stack.back());
+  uint8_t count[sizeof(uint64_t)];
+  size_t countSize = packArraySize(count, m_stack.back().count);
+  m_stream.replace(m_stack.back().countOffset, 1, count, countSize);
   m_stack.pop_back();
-
-  auto objStream = std::move(m_objectsStack.back());
-  m_objectsStack.pop_back();
-
-  auto& out = stream();
-
-  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_OBJECT, level.name);
-
-  writeArraySize(out, level.count);
-  write(out, objStream.data(), objStream.size());
 }
 
 bool KVBinaryOutputStreamSerializer::beginArray(size_t& size, Common::StringView name) {
@@ -133,73 +139,71 @@ void KVBinaryOutputStreamSerializer::endArray() {
 
 bool KVBinaryOutputStreamSerializer::operator()(uint8_t& value, Common::StringView name) {
   writeElementPrefix(BIN_KV_SERIALIZE_TYPE_UINT8, name);
-  writePod(stream(), value);
+  writePod(m_stream, value);
   return true;
 }
 
 bool KVBinaryOutputStreamSerializer::operator()(uint16_t& value, Common::StringView name) {
   writeElementPrefix(BIN_KV_SERIALIZE_TYPE_UINT16, name);
-  writePod(stream(), value);
+  writePod(m_stream, value);
   return true;
 }
 
 bool KVBinaryOutputStreamSerializer::operator()(int16_t& value, Common::StringView name) {
   writeElementPrefix(BIN_KV_SERIALIZE_TYPE_INT16, name);
-  writePod(stream(), value);
+  writePod(m_stream, value);
   return true;
 }
 
 bool KVBinaryOutputStreamSerializer::operator()(uint32_t& value, Common::StringView name) {
   writeElementPrefix(BIN_KV_SERIALIZE_TYPE_UINT32, name);
-  writePod(stream(), value);
+  writePod(m_stream, value);
   return true;
 }
 
 bool KVBinaryOutputStreamSerializer::operator()(int32_t& value, Common::StringView name) {
   writeElementPrefix(BIN_KV_SERIALIZE_TYPE_INT32, name);
-  writePod(stream(), value);
+  writePod(m_stream, value);
   return true;
 }
 
 bool KVBinaryOutputStreamSerializer::operator()(int64_t& value, Common::StringView name) {
   writeElementPrefix(BIN_KV_SERIALIZE_TYPE_INT64, name);
-  writePod(stream(), value);
+  writePod(m_stream, value);
   return true;
 }
 
 bool KVBinaryOutputStreamSerializer::operator()(uint64_t& value, Common::StringView name) {
   writeElementPrefix(BIN_KV_SERIALIZE_TYPE_UINT64, name);
-  writePod(stream(), value);
+  writePod(m_stream, value);
   return true;
 }
 
 bool KVBinaryOutputStreamSerializer::operator()(bool& value, Common::StringView name) {
   writeElementPrefix(BIN_KV_SERIALIZE_TYPE_BOOL, name);
-  writePod(stream(), value);
+  writePod(m_stream, value);
   return true;
 }
 
 bool KVBinaryOutputStreamSerializer::operator()(double& value, Common::StringView name) {
   writeElementPrefix(BIN_KV_SERIALIZE_TYPE_DOUBLE, name);
-  writePod(stream(), value);
+  writePod(m_stream, value);
   return true;
 }
 
 bool KVBinaryOutputStreamSerializer::operator()(std::string& value, Common::StringView name) {
   writeElementPrefix(BIN_KV_SERIALIZE_TYPE_STRING, name);
 
-  auto& out = stream();
-  writeArraySize(out, value.size());
-  write(out, value.data(), value.size());
+  writeArraySize(m_stream, value.size());
+  write(m_stream, value.data(), value.size());
   return true;
 }
 
 bool KVBinaryOutputStreamSerializer::binary(void* value, size_t size, Common::StringView name) {
   if (size > 0) {
     writeElementPrefix(BIN_KV_SERIALIZE_TYPE_STRING, name);
-    auto& out = stream();
-    writeArraySize(out, size);
-    write(out, value, size);
+    writeArraySize(m_stream, size);
+    write(m_stream, value, size);
   }
   return true;
 }
@@ -216,9 +220,8 @@ void KVBinaryOutputStreamSerializer::writeElementPrefix(uint8_t type, Common::St
   
   if (level.state != State::Array) {
     if (!name.isEmpty()) {
-      auto& s = stream();
-      writeElementName(s, name);
-      write(s, &type, 1);
+      writeElementName(m_stream, name);
+      write(m_stream, &type, 1);
     }
     ++level.count;
   }
@@ -232,19 +235,12 @@ void KVBinaryOutputStreamSerializer::checkArrayPreamble(uint8_t type) {
   Level& level = m_stack.back();
 
   if (level.state == State::ArrayPrefix) {
-    auto& s = stream();
-    writeElementName(s, level.name);
+    writeElementName(m_stream, level.name);
     char c = BIN_KV_SERIALIZE_FLAG_ARRAY | type;
-    write(s, &c, 1);
-    writeArraySize(s, level.count);
+    write(m_stream, &c, 1);
+    writeArraySize(m_stream, level.count);
     level.state = State::Array;
   }
 }
 
-
-MemoryStream& KVBinaryOutputStreamSerializer::stream() {
-  assert(m_objectsStack.size());
-  return m_objectsStack.back();
-}
-
 }
@@ -24,6 +24,9 @@
 
 namespace CryptoNote {
 
+// Everything is written to a single buffer as it is serialized. An object's element count precedes its elements,
+// so one byte is left for it when the object begins and filled in when it ends; the rest of the buffer is only moved
+// in the rare case of an object with more than 63 elements.
 class KVBinaryOutputStreamSerializer : public ISerializer {
 public:
 
@@ -63,7 +66,6 @@ private:
   void writeElementPrefix(uint8_t type, Common::StringView name);
   void checkArrayPreamble(uint8_t type);
   void updateState(uint8_t type);
-  MemoryStream& stream();
 
   enum class State {
     Root,
@@ -76,22 +78,24 @@ private:
     State state;
     std::string name;
     size_t count;
+    size_t countOffset;
 
-    Level(Common::StringView nm) :
-      name(nm), state(State::Object), count(0) {}
+    Level(size_t offset) :
+      state(State::Object), count(0), countOffset(offset) {}
 
     Level(Common::StringView nm, size_t arraySize) :
-      name(nm), state(State::ArrayPrefix), count(arraySize) {}
+      state(State::ArrayPrefix), name(nm), count(arraySize), countOffset(0) {}
 
     Level(Level&& rv) {
       state = rv.state;
       name = std::move(rv.name);
       count = rv.count;
+      countOffset = rv.countOffset;
     }
 
   };
 
-  std::vector<MemoryStream> m_objectsStack;
+  MemoryStream m_stream;
   std::vector<Level> m_stack;
 };
 
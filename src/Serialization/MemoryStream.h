@@ -58,6 +58,21 @@ public:
     m_buffer.resize(0);
   }
 
+  // Replaces oldSize bytes at offset with size bytes of data, moving everything after them
+  void replace(size_t offset, size_t oldSize, const void* data, size_t size) {
+    if (size > oldSize) {
+      m_buffer.insert(m_buffer.begin() + offset + oldSize, size - oldSize, 0);
+    } else if (size < oldSize) {
+      m_buffer.erase(m_buffer.begin() + offset + size, m_buffer.begin() + offset + oldSize);
+    }
+
+    if (size != 0) {
+      memcpy(&m_buffer[offset], data, size);
+    }
+
+    m_writePos = m_writePos + size - oldSize;
+  }
+
 private:
   size_t m_writePos;
   std::vector<uint8_t> m_buffer;
@@ -21,9 +21,11 @@
 #include <list>
 #include <vector>
 #include <Common/MemoryInputStream.h>
+#include <Common/StreamTools.h>
 #include <Common/StringOutputStream.h>
 #include "JsonInputStreamSerializer.h"
 #include "JsonOutputStreamSerializer.h"
+#include "JsonOutputStreamingSerializer.h"
 #include "KVBinaryInputStreamSerializer.h"
 #include "KVBinaryOutputStreamSerializer.h"
 #include "GreenWallet/Types.h"
@@ -117,6 +119,21 @@ std::string storeToJson(const T& v) {
   return storeToJsonValue(v).toString();
 }
 
+template <typename T>
+void storeToJsonStream(const T& v, Common::IOutputStream& stream) {
+  JsonOutputStreamingSerializer s(stream);
+  serialize(const_cast<T&>(v), s);
+  s.finish();
+}
+
+template <typename T>
+void storeToJsonStream(const std::vector<T>& v, Common::IOutputStream& stream) { Common::write(stream, storeToJsonValue(v).toString()); }
+
+template <typename T>
+void storeToJsonStream(const std::list<T>& v, Common::IOutputStream& stream) { Common::write(stream, storeToJsonValue(v).toString()); }
+
+inline void storeToJsonStream(const std::string& v, Common::IOutputStream& stream) { Common::write(stream, storeToJsonValue(v).toString()); }
+
 template <typename T>
 bool loadFromJson(T& v, const std::string& buf) {
   try {
@@ -145,8 +162,7 @@ std::string storeToBinaryKeyValue(const T& v) {
 template <typename T>
 bool loadFromBinaryKeyValue(T& v, const std::string& buf) {
   try {
-    Common::MemoryInputStream stream(buf.data(), buf.size());
-    KVBinaryInputStreamSerializer s(stream);
+    KVBinaryInputStreamSerializer s(buf.data(), buf.size());
     serialize(v, s);
     return true;
   } catch (std::exception&) {
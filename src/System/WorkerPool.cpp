@@ -0,0 +1,131 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "WorkerPool.h"
+#include <cassert>
+#include <exception>
+#include <System/Dispatcher.h>
+#include <System/Event.h>
+#include <System/InterruptedException.h>
+
+namespace System {
+
+WorkerPool::WorkerPool(size_t threads, size_t maxQueueSize) : maxQueueSize(maxQueueSize), queueSize(0), stopped(false) {
+  assert(threads > 0);
+  for (size_t i = 0; i < threads; ++i) {
+    workers.emplace_back(&WorkerPool::workerProcedure, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+  }
+
+  condition.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+bool WorkerPool::run(Dispatcher& dispatcher, const std::function<void()>& procedure) {
+  return run(dispatcher, std::string(), procedure);
+}
+
+bool WorkerPool::run(Dispatcher& dispatcher, const std::string& key, const std::function<void()>& procedure) {
+  Event done(dispatcher);
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopped || queueSize >= maxQueueSize) {
+      return false;
+    }
+
+    auto& queue = queues[key];
+    if (queue.empty()) {
+      turns.push_back(key);
+    }
+
+    ++queueSize;
+    queue.emplace_back([&] {
+      try {
+        procedure();
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      dispatcher.remoteSpawn([&done] { done.set(); });
+    });
+  }
+
+  condition.notify_one();
+
+  // Queued procedure refers to this frame, so it has to be waited for even if the context is interrupted
+  bool interrupted = false;
+  while (!done.get()) {
+    try {
+      done.wait();
+    } catch (InterruptedException&) {
+      interrupted = true;
+    }
+  }
+
+  if (interrupted) {
+    dispatcher.interrupt();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  return true;
+}
+
+size_t WorkerPool::getQueueSize() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return queueSize;
+}
+
+void WorkerPool::workerProcedure() {
+  for (;;) {
+    std::function<void()> procedure;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      condition.wait(lock, [this] { return stopped || queueSize != 0; });
+      if (queueSize == 0) {
+        return;
+      }
+
+      std::string key = std::move(turns.front());
+      turns.pop_front();
+      auto it = queues.find(key);
+      procedure = std::move(it->second.front());
+      it->second.pop_front();
+      --queueSize;
+      if (it->second.empty()) {
+        queues.erase(it);
+      } else {
+        turns.push_back(std::move(key));
+      }
+    }
+
+    procedure();
+  }
+}
+
+}
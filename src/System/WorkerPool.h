@@ -0,0 +1,64 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace System {
+
+class Dispatcher;
+
+// Fixed set of threads executing procedures on behalf of dispatcher contexts.
+// Unlike RemoteContext it never starts new threads and refuses work once
+// maxQueueSize procedures are waiting for a free thread. Waiting procedures are
+// queued per key and the keys take turns, so one submitter can't starve the others.
+class WorkerPool {
+public:
+  WorkerPool(size_t threads, size_t maxQueueSize);
+  WorkerPool(const WorkerPool&) = delete;
+  ~WorkerPool();
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  // Runs procedure on a worker thread and suspends the current context of dispatcher until it is done,
+  // exceptions are rethrown in the calling context. Returns false without running procedure if the queue is full.
+  bool run(Dispatcher& dispatcher, const std::function<void()>& procedure);
+  bool run(Dispatcher& dispatcher, const std::string& key, const std::function<void()>& procedure);
+  size_t getQueueSize() const;
+
+private:
+  void workerProcedure();
+
+  const size_t maxQueueSize;
+  mutable std::mutex mutex;
+  std::condition_variable condition;
+  std::unordered_map<std::string, std::deque<std::function<void()>>> queues;
+  // keys with waiting procedures, in the order they are served
+  std::deque<std::string> turns;
+  size_t queueSize;
+  std::vector<std::thread> workers;
+  bool stopped;
+};
+
+}
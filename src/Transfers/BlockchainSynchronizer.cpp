@@ -22,6 +22,7 @@
 #include <functional>
 #include <iostream>
 #include <sstream>
+#include <thread>
 #include <unordered_set>
 
 #include "Common/StreamTools.h"
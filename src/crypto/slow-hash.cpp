@@ -16,6 +16,7 @@
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <assert.h>
+#include <exception>
 #include <new>
 
 #include "hash.h"
@@ -0,0 +1,106 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "CryptoNoteCore/CryptoNoteTools.h"
+
+enum class codec_operation { encode, decode };
+enum class codec_serializer { stream, array };
+
+// Encodes or decodes a transaction with 16 ring inputs, either through the virtual stream serializers
+// or the non-virtual array ones toBinaryArray and fromBinaryArray use.
+template<codec_operation operation, codec_serializer serializer>
+class test_transaction_codec
+{
+public:
+  static const size_t loop_count = 100000;
+  static const size_t input_count = 16;
+  static const size_t ring_size = 4;
+
+  bool init()
+  {
+    m_tx.version = 1;
+    m_tx.unlockTime = 0;
+    for (size_t i = 0; i < input_count; ++i)
+    {
+      CryptoNote::KeyInput input;
+      input.amount = 1000000000 + i;
+      for (size_t j = 0; j < ring_size; ++j)
+      {
+        input.outputIndexes.push_back(static_cast<uint32_t>(100000 * j + i));
+      }
+
+      memset(&input.keyImage, static_cast<int>(i), sizeof(input.keyImage));
+      m_tx.inputs.push_back(input);
+
+      m_tx.signatures.push_back(std::vector<Crypto::Signature>(ring_size));
+      for (size_t j = 0; j < ring_size; ++j)
+      {
+        memset(&m_tx.signatures.back()[j], static_cast<int>(i + j), sizeof(Crypto::Signature));
+      }
+    }
+
+    for (size_t i = 0; i < 2 * input_count; ++i)
+    {
+      CryptoNote::KeyOutput target;
+      memset(&target.key, static_cast<int>(i), sizeof(target.key));
+      m_tx.outputs.push_back({ 10000 * (i + 1), target });
+    }
+
+    m_tx.extra.assign(100, 1);
+    m_blob = CryptoNote::toBinaryArray(m_tx);
+    return !m_blob.empty();
+  }
+
+  bool test()
+  {
+    if (operation == codec_operation::encode)
+    {
+      CryptoNote::BinaryArray blob;
+      if (serializer == codec_serializer::array)
+      {
+        CryptoNote::toBinaryArray(m_tx, blob);
+      }
+      else
+      {
+        Common::VectorOutputStream stream(blob);
+        CryptoNote::BinaryOutputStreamSerializer output(stream);
+        serialize(m_tx, output);
+      }
+
+      return blob.size() == m_blob.size();
+    }
+
+    CryptoNote::Transaction tx;
+    if (serializer == codec_serializer::array)
+    {
+      return CryptoNote::fromBinaryArray(tx, m_blob);
+    }
+
+    Common::MemoryInputStream stream(m_blob.data(), m_blob.size());
+    CryptoNote::BinaryInputStreamSerializer input(stream);
+    serialize(tx, input);
+    return stream.endOfStream();
+  }
+
+  size_t bytes_per_call() const { return m_blob.size(); }
+
+private:
+  CryptoNote::Transaction m_tx;
+  CryptoNote::BinaryArray m_blob;
+};
@@ -0,0 +1,114 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "CryptoNoteConfig.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+
+// Decodes a block and its tx_count transactions, laid out the way SwappedVector stores them: the block followed
+// by the transactions. Every transaction spends two ring inputs into two outputs. With reuse_objects the block
+// is read over the previous one, as SwappedVector does with the cache entry it evicts.
+template<size_t tx_count, bool reuse_objects>
+class test_block_decode
+{
+public:
+  static const size_t loop_count = 1000000 / tx_count;
+
+  bool init()
+  {
+    CryptoNote::Block block;
+    block.majorVersion = CryptoNote::BLOCK_MAJOR_VERSION_5;
+    block.minorVersion = 0;
+    block.timestamp = 1500000000;
+    block.nonce = 0;
+    memset(&block.previousBlockHash, 1, sizeof(block.previousBlockHash));
+    block.baseTransaction = make_transaction(0, true);
+
+    std::vector<CryptoNote::Transaction> transactions;
+    for (size_t i = 0; i < tx_count; ++i)
+    {
+      transactions.push_back(make_transaction(i, false));
+      block.transactionHashes.push_back(CryptoNote::getObjectHash(transactions.back()));
+    }
+
+    CryptoNote::BinaryArrayOutputSerializer serializer(m_blob);
+    serialize(block, serializer);
+    serializer(transactions, "");
+    return true;
+  }
+
+  bool test()
+  {
+    if (reuse_objects)
+    {
+      return decode(m_block, m_transactions);
+    }
+
+    CryptoNote::Block block;
+    std::vector<CryptoNote::Transaction> transactions;
+    return decode(block, transactions);
+  }
+
+  size_t bytes_per_call() const { return m_blob.size(); }
+
+private:
+  bool decode(CryptoNote::Block& block, std::vector<CryptoNote::Transaction>& transactions)
+  {
+    CryptoNote::BinaryArrayInputSerializer serializer(m_blob.data(), m_blob.size());
+    serialize(block, serializer);
+    serializer(transactions, "");
+    return serializer.endOfStream() && transactions.size() == tx_count;
+  }
+
+  static CryptoNote::Transaction make_transaction(size_t index, bool base)
+  {
+    CryptoNote::Transaction tx;
+    tx.version = 1;
+    tx.unlockTime = 0;
+    if (base)
+    {
+      tx.inputs.push_back(CryptoNote::BaseInput{ 500000 });
+    }
+    else
+    {
+      for (size_t i = 0; i < 2; ++i)
+      {
+        CryptoNote::KeyInput input;
+        input.amount = 1000000 * (i + 1);
+        input.outputIndexes = { 100, 2000, 30000, static_cast<uint32_t>(index) };
+        memset(&input.keyImage, static_cast<int>(index + i), sizeof(input.keyImage));
+        tx.inputs.push_back(input);
+        tx.signatures.push_back(std::vector<Crypto::Signature>(input.outputIndexes.size()));
+      }
+    }
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+      CryptoNote::KeyOutput target;
+      memset(&target.key, static_cast<int>(index + i), sizeof(target.key));
+      tx.outputs.push_back({ 1000000 * (i + 1), target });
+    }
+
+    tx.extra.assign(33, 1);
+    return tx;
+  }
+
+  CryptoNote::BinaryArray m_blob;
+  CryptoNote::Block m_block;
+  std::vector<CryptoNote::Transaction> m_transactions;
+};
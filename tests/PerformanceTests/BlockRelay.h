@@ -0,0 +1,402 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "Common/StringTools.h"
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/Core.h"
+#include "CryptoNoteCore/CoreConfig.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/MinerConfig.h"
+#include "CryptoNoteCore/TransactionExtra.h"
+#include "CryptoNoteCore/VerificationContext.h"
+#include "CryptoNoteProtocol/CryptoNoteProtocolHandler.h"
+#include "Logging/LoggerGroup.h"
+#include "P2p/NetNode.h"
+#include "P2p/NetNodeConfig.h"
+#include "System/Dispatcher.h"
+#include "crypto/crypto.h"
+
+// A full node on its own dispatcher thread: the chain and the pool of the node are filled with the given blocks
+// and transactions before it listens on 127.0.0.1:port and connects to peer_ports
+class block_relay_node
+{
+public:
+  block_relay_node(const CryptoNote::Currency& currency, uint16_t port, const std::vector<uint16_t>& peer_ports, bool relay_before_validation) :
+    m_currency(currency), m_port(port), m_peer_ports(peer_ports), m_relay_before_validation(relay_before_validation),
+    m_dispatcher(nullptr), m_core(nullptr), m_protocol(nullptr), m_server(nullptr)
+  {
+  }
+
+  ~block_relay_node()
+  {
+    if (m_thread.joinable())
+    {
+      m_server->sendStopSignal();
+      m_thread.join();
+    }
+
+    boost::system::error_code ignored_error;
+    boost::filesystem::remove_all(m_folder, ignored_error);
+  }
+
+  bool start(const std::vector<CryptoNote::Block>& blocks, const std::vector<CryptoNote::BinaryArray>& transactions)
+  {
+    m_folder = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("block_relay_%%%%%%%%")).string();
+    std::promise<bool> started;
+    std::future<bool> result = started.get_future();
+    m_thread = std::thread([this, &started, &blocks, &transactions] { run(started, blocks, transactions); });
+    if (result.get())
+      return true;
+
+    m_thread.join();
+    return false;
+  }
+
+  // Adds the block to the chain on the node thread and relays it as the miner of the node would
+  void submit(CryptoNote::Block block)
+  {
+    CryptoNote::Core* core = m_core;
+    m_dispatcher->remoteSpawn([core, block]() mutable { core->handle_block_found(block); });
+  }
+
+  CryptoNote::Core& core() { return *m_core; }
+  size_t peer_count() const { return m_protocol->getPeerCount(); }
+  // The height of the chain of the peers, it grows when a block arrives and before it is validated
+  uint32_t observed_height() const { return m_protocol->getObservedHeight(); }
+
+private:
+  void run(std::promise<bool>& started, const std::vector<CryptoNote::Block>& blocks, const std::vector<CryptoNote::BinaryArray>& transactions)
+  {
+    System::Dispatcher dispatcher;
+    CryptoNote::Core core(m_currency, nullptr, m_logger, dispatcher, false);
+    CryptoNote::CoreConfig core_config;
+    core_config.configFolder = m_folder;
+    if (!core.init(core_config, CryptoNote::MinerConfig(), false))
+    {
+      started.set_value(false);
+      return;
+    }
+
+    for (const auto& block : blocks)
+    {
+      CryptoNote::block_verification_context bvc = boost::value_initialized<CryptoNote::block_verification_context>();
+      core.handle_incoming_block(block, bvc, false, false);
+    }
+
+    for (const auto& transaction : transactions)
+    {
+      CryptoNote::tx_verification_context tvc = boost::value_initialized<CryptoNote::tx_verification_context>();
+      core.handle_incoming_tx(transaction, tvc, false);
+    }
+
+    CryptoNote::CryptoNoteProtocolHandler protocol(m_currency, dispatcher, core, nullptr, m_logger);
+    CryptoNote::NodeServer server(dispatcher, protocol, m_logger);
+    protocol.set_p2p_endpoint(&server);
+    protocol.setRelayBeforeValidation(m_relay_before_validation);
+    core.set_cryptonote_protocol(&protocol);
+
+    std::vector<CryptoNote::NetworkAddress> exclusive_nodes;
+    for (uint16_t peer_port : m_peer_ports)
+    {
+      CryptoNote::NetworkAddress address;
+      Common::parseIpAddressAndPort(address.ip, address.port, "127.0.0.1:" + std::to_string(peer_port));
+      exclusive_nodes.push_back(address);
+    }
+
+    CryptoNote::NetNodeConfig config;
+    config.setTestnet(true);
+    config.setBindIp("127.0.0.1");
+    config.setBindPort(m_port);
+    config.setExternalPort(0);
+    config.setAllowLocalIp(true);
+    config.setHideMyPort(false);
+    config.setConfigFolder(m_folder);
+    config.setExclusiveNodes(exclusive_nodes);
+
+    if (core.getCurrentBlockchainHeight() != blocks.size() + 1 || core.getPoolTransactionsCount() != transactions.size() ||
+        !server.init(config))
+    {
+      core.set_cryptonote_protocol(nullptr);
+      core.deinit();
+      started.set_value(false);
+      return;
+    }
+
+    m_dispatcher = &dispatcher;
+    m_core = &core;
+    m_protocol = &protocol;
+    m_server = &server;
+    started.set_value(true);
+
+    server.run();
+    server.deinit();
+    core.set_cryptonote_protocol(nullptr);
+    protocol.set_p2p_endpoint(nullptr);
+    core.deinit();
+  }
+
+  Logging::LoggerGroup m_logger;
+  const CryptoNote::Currency& m_currency;
+  uint16_t m_port;
+  std::vector<uint16_t> m_peer_ports;
+  bool m_relay_before_validation;
+  std::string m_folder;
+  std::thread m_thread;
+  System::Dispatcher* m_dispatcher;
+  CryptoNote::Core* m_core;
+  CryptoNote::CryptoNoteProtocolHandler* m_protocol;
+  CryptoNote::NodeServer* m_server;
+};
+
+// Blocks mined by the first node of a line of node_count nodes on loopback. The time of a call is the time the block
+// takes to arrive at the last node, the time the nodes take to add it afterwards isn't counted. The blocks are full of
+// transactions with rings of up to sixteen outputs, which every pool has already, so that they are relayed as lite
+// blocks and their validation is dominated by the ring signature checks. An item is a hop: 1000 / rate is the latency
+// of a hop in milliseconds. The main network currency keeps the first block version for all the blocks, the nodes use
+// the test network only not to look for seed nodes.
+template<size_t node_count, bool relay_before_validation>
+class test_block_relay
+{
+public:
+  static const size_t loop_count = 5;
+  static const size_t premined_blocks = 90;
+  static const size_t ring_size = 16;
+  static const uint16_t base_port = 38000 + node_count * 10 + (relay_before_validation ? 5 : 0);
+
+  test_block_relay() :
+    m_currency(CryptoNote::CurrencyBuilder(m_logger).currency()),
+    m_seed_core(m_currency, nullptr, m_logger, m_dispatcher, false), m_elapsed(0)
+  {
+  }
+
+  ~test_block_relay()
+  {
+    m_nodes.clear();
+    m_seed_core.deinit();
+    boost::system::error_code ignored_error;
+    boost::filesystem::remove_all(m_seed_config.configFolder, ignored_error);
+  }
+
+  bool init()
+  {
+    m_seed_config.configFolder = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("block_relay_%%%%%%%%")).string();
+    if (!m_seed_core.init(m_seed_config, CryptoNote::MinerConfig(), false))
+      return false;
+
+    m_miner.generate();
+    std::vector<CryptoNote::Block> blocks;
+    while (m_seed_core.getCurrentBlockchainHeight() <= premined_blocks)
+    {
+      CryptoNote::Block block;
+      if (!make_block(m_seed_core, block) || !m_seed_core.handle_block_found(block))
+        return false;
+
+      blocks.push_back(block);
+    }
+
+    std::vector<CryptoNote::BinaryArray> transactions;
+    if (!make_transactions(blocks, transactions))
+      return false;
+
+    std::vector<uint16_t> peer_ports;
+    for (size_t i = 0; i < node_count; ++i)
+    {
+      m_nodes.emplace_back(new block_relay_node(m_currency, static_cast<uint16_t>(base_port + i), peer_ports, relay_before_validation));
+      if (!m_nodes.back()->start(blocks, transactions))
+        return false;
+
+      peer_ports.assign(1, static_cast<uint16_t>(base_port + i));
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    for (size_t i = 0; i < node_count; ++i)
+    {
+      size_t peers = (i == 0 || i == node_count - 1) ? 1 : 2;
+      while (m_nodes[i]->peer_count() < peers)
+      {
+        if (std::chrono::steady_clock::now() > deadline)
+          return false;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    }
+
+    // the handshakes end before the connections can relay, a first block shows that every one of them can
+    bool relayed = relay();
+    m_elapsed = 0;
+    return relayed;
+  }
+
+  bool test()
+  {
+    return relay();
+  }
+
+  int elapsed_ms() const { return static_cast<int>(m_elapsed); }
+  size_t items_per_call() const { return node_count - 1; }
+
+private:
+  bool relay()
+  {
+    CryptoNote::Block block;
+    if (!make_block(m_nodes.front()->core(), block))
+      return false;
+
+    uint32_t height = m_nodes.front()->core().getCurrentBlockchainHeight() + 1;
+    auto start = std::chrono::steady_clock::now();
+    m_nodes.front()->submit(block);
+
+    auto deadline = start + std::chrono::seconds(60);
+    while (m_nodes.back()->observed_height() < height)
+    {
+      if (std::chrono::steady_clock::now() > deadline)
+        return false;
+
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    m_elapsed += std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    // the next block is mined on top of this one everywhere
+    for (auto& node : m_nodes)
+    {
+      while (node->core().getCurrentBlockchainHeight() < height)
+      {
+        if (std::chrono::steady_clock::now() > deadline)
+          return false;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+
+    return true;
+  }
+
+  // blocks an hour apart keep the difficulty at its minimum, so the first nonces are enough
+  bool make_block(CryptoNote::Core& core, CryptoNote::Block& block)
+  {
+    CryptoNote::difficulty_type difficulty;
+    uint32_t height;
+    if (!core.get_block_template(block, m_miner.getAccountKeys().address, difficulty, height, CryptoNote::BinaryArray()))
+      return false;
+
+    block.timestamp = m_currency.genesisBlock().timestamp + height * 3600;
+    Crypto::Hash proof_of_work;
+    while (!m_currency.checkProofOfWork(m_cn_context, block, difficulty, proof_of_work))
+      ++block.nonce;
+
+    return true;
+  }
+
+  // A transaction for every unlocked miner output worth more than the fee, with the outputs of the same amount next
+  // to it in its ring
+  bool make_transactions(const std::vector<CryptoNote::Block>& blocks, std::vector<CryptoNote::BinaryArray>& transactions)
+  {
+    using namespace CryptoNote;
+
+    struct output_entry
+    {
+      uint32_t global_index;
+      Crypto::PublicKey key;
+      Crypto::PublicKey transaction_key;
+      size_t index_in_transaction;
+    };
+
+    uint64_t fee = m_seed_core.getMinimalFee();
+    std::map<uint64_t, std::vector<output_entry>> outputs;
+    for (size_t i = 0; i + m_currency.minedMoneyUnlockWindow() < blocks.size(); ++i)
+    {
+      const Transaction& base = blocks[i].baseTransaction;
+      std::vector<uint32_t> global_indexes;
+      if (!m_seed_core.get_tx_outputs_gindexs(getObjectHash(base), global_indexes))
+        return false;
+
+      for (size_t j = 0; j < base.outputs.size(); ++j)
+      {
+        if (base.outputs[j].amount > fee)
+        {
+          output_entry entry = { global_indexes[j], boost::get<KeyOutput>(base.outputs[j].target).key,
+                                 getTransactionPublicKeyFromExtra(base.extra), j };
+          outputs[base.outputs[j].amount].push_back(entry);
+        }
+      }
+    }
+
+    for (const auto& amount_outputs : outputs)
+    {
+      const std::vector<output_entry>& entries = amount_outputs.second;
+      for (size_t i = 0; i < entries.size(); ++i)
+      {
+        size_t ring = std::min(entries.size(), static_cast<size_t>(ring_size));
+        size_t ring_begin = std::min(i - i % ring, entries.size() - ring);
+        size_t ring_end = ring_begin + ring;
+
+        TransactionSourceEntry source;
+        for (size_t k = ring_begin; k < ring_end; ++k)
+        {
+          source.outputs.push_back(std::make_pair(entries[k].global_index, entries[k].key));
+        }
+
+        source.realOutput = i - ring_begin;
+        source.realTransactionPublicKey = entries[i].transaction_key;
+        source.realOutputIndexInTransaction = entries[i].index_in_transaction;
+        source.amount = amount_outputs.first;
+
+        std::vector<TransactionDestinationEntry> destinations(1, TransactionDestinationEntry(source.amount - fee, m_miner.getAccountKeys().address));
+        Transaction tx;
+        Crypto::SecretKey tx_key;
+        if (!constructTransaction(m_miner.getAccountKeys(), { source }, destinations, std::vector<uint8_t>(), tx, 0, tx_key, m_logger))
+          return false;
+
+        tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+        BinaryArray transaction = toBinaryArray(tx);
+        if (!m_seed_core.handle_incoming_tx(transaction, tvc, false) || !tvc.m_added_to_pool)
+          return false;
+
+        transactions.push_back(transaction);
+      }
+    }
+
+    return true;
+  }
+
+  Logging::LoggerGroup m_logger;
+  System::Dispatcher m_dispatcher;
+  CryptoNote::Currency m_currency;
+  CryptoNote::Core m_seed_core;
+  CryptoNote::CoreConfig m_seed_config;
+  CryptoNote::AccountBase m_miner;
+  Crypto::cn_context m_cn_context;
+  std::vector<std::unique_ptr<block_relay_node>> m_nodes;
+  int64_t m_elapsed;
+};
@@ -0,0 +1,206 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <limits>
+#include <memory>
+
+#include <boost/filesystem.hpp>
+
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/Core.h"
+#include "CryptoNoteCore/CoreConfig.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/MinerConfig.h"
+#include "CryptoNoteCore/TransactionPool.h"
+#include "Logging/LoggerGroup.h"
+#include "System/Dispatcher.h"
+#include "crypto/crypto.h"
+
+#include "../UnitTests/ICoreStub.h"
+
+// Accepts every transaction, the benchmark measures the pool and not input checks
+class accepting_validator : public CryptoNote::ITransactionValidator
+{
+public:
+  virtual bool checkTransactionInputs(const CryptoNote::Transaction& tx, CryptoNote::BlockInfo& maxUsedBlock) override { return true; }
+  virtual bool checkTransactionInputs(const CryptoNote::Transaction& tx, CryptoNote::BlockInfo& maxUsedBlock, CryptoNote::BlockInfo& lastFailed) override { return true; }
+  virtual bool haveSpentKeyImages(const CryptoNote::Transaction& tx) override { return false; }
+  virtual bool checkTransactionSize(size_t blobSize) override { return true; }
+};
+
+// Block templates from a pool of pool_size transactions with different fees, every template takes the
+// best 127 of them. The pool doesn't change between templates, as between two blocks on a miner.
+template<size_t pool_size>
+class test_fill_block_template
+{
+public:
+  static const size_t loop_count = 10;
+  static const size_t templates_per_call = 100;
+  static const size_t transactions_per_template = 127;
+
+  test_fill_block_template() : m_currency(CryptoNote::CurrencyBuilder(m_logger).currency())
+  {
+  }
+
+  bool init()
+  {
+    using namespace CryptoNote;
+
+    m_pool.reset(new tx_memory_pool(m_currency, m_validator, m_core, m_time_provider, m_logger, false));
+
+    for (size_t i = 0; i < pool_size; ++i)
+    {
+      KeyInput input;
+      input.amount = m_currency.coin();
+      input.outputIndexes.push_back(static_cast<uint32_t>(i));
+      input.keyImage = reinterpret_cast<const Crypto::KeyImage&>(generateKeyPair().publicKey);
+
+      KeyOutput target;
+      target.key = generateKeyPair().publicKey;
+
+      TransactionOutput output;
+      output.amount = input.amount - m_currency.minimumFee() * (1 + i % 10);
+      output.target = target;
+
+      Transaction tx;
+      tx.version = CURRENT_TRANSACTION_VERSION;
+      tx.unlockTime = 0;
+      tx.inputs.push_back(input);
+      tx.outputs.push_back(output);
+      tx.signatures.resize(1, std::vector<Crypto::Signature>(1));
+
+      tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+      if (!m_pool->add_tx(tx, tvc, false) || !tvc.m_added_to_pool)
+        return false;
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    for (size_t i = 0; i < templates_per_call; ++i)
+    {
+      CryptoNote::Block block;
+      size_t total_size;
+      uint64_t fee;
+      if (!m_pool->fill_block_template(block, std::numeric_limits<uint32_t>::max(), std::numeric_limits<size_t>::max(), 0, total_size, fee))
+        return false;
+
+      if (block.transactionHashes.size() != std::min(pool_size, transactions_per_template))
+        return false;
+    }
+
+    return true;
+  }
+
+  size_t items_per_call() const { return templates_per_call; }
+
+private:
+  Logging::LoggerGroup m_logger;
+  CryptoNote::Currency m_currency;
+  ICoreStub m_core;
+  CryptoNote::RealTimeProvider m_time_provider;
+  accepting_validator m_validator;
+  std::unique_ptr<CryptoNote::tx_memory_pool> m_pool;
+};
+
+// getblocktemplate requests of a mining pool: every worker asks for a template with its own extra nonce
+// on top of a chain of chain_length blocks, nothing changes between the requests.
+template<size_t chain_length>
+class test_get_block_template
+{
+public:
+  static const size_t loop_count = 10;
+  static const size_t templates_per_call = 1000;
+
+  test_get_block_template() :
+    m_currency(CryptoNote::CurrencyBuilder(m_logger).currency()),
+    m_core(m_currency, nullptr, m_logger, m_dispatcher, false)
+  {
+  }
+
+  ~test_get_block_template()
+  {
+    m_core.deinit();
+    boost::system::error_code ignored_error;
+    boost::filesystem::remove_all(m_config.configFolder, ignored_error);
+  }
+
+  bool init()
+  {
+    m_config.configFolder = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("block_template_%%%%%%%%")).string();
+    if (!m_core.init(m_config, CryptoNote::MinerConfig(), false))
+      return false;
+
+    m_miner.generate();
+    while (m_core.getCurrentBlockchainHeight() < chain_length)
+    {
+      CryptoNote::Block block;
+      CryptoNote::difficulty_type difficulty;
+      uint32_t height;
+      if (!m_core.get_block_template(block, m_miner.getAccountKeys().address, difficulty, height, CryptoNote::BinaryArray()))
+        return false;
+
+      // blocks an hour apart keep the difficulty at its minimum, so the first nonces are enough
+      block.timestamp = m_currency.genesisBlock().timestamp + height * 3600;
+      Crypto::Hash proof_of_work;
+      Crypto::cn_context context;
+      while (!m_currency.checkProofOfWork(context, block, difficulty, proof_of_work))
+        ++block.nonce;
+
+      if (!m_core.handle_block_found(block))
+        return false;
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    CryptoNote::BinaryArray extra_nonce(8);
+    for (size_t i = 0; i < templates_per_call; ++i)
+    {
+      memcpy(extra_nonce.data(), &i, sizeof(i) < extra_nonce.size() ? sizeof(i) : extra_nonce.size());
+
+      CryptoNote::Block block;
+      CryptoNote::difficulty_type difficulty;
+      uint32_t height;
+      if (!m_core.get_block_template(block, m_miner.getAccountKeys().address, difficulty, height, extra_nonce))
+        return false;
+
+      if (height != chain_length)
+        return false;
+    }
+
+    return true;
+  }
+
+  size_t items_per_call() const { return templates_per_call; }
+
+private:
+  Logging::LoggerGroup m_logger;
+  System::Dispatcher m_dispatcher;
+  CryptoNote::Currency m_currency;
+  CryptoNote::Core m_core;
+  CryptoNote::CoreConfig m_config;
+  CryptoNote::AccountBase m_miner;
+};
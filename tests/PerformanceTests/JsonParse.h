@@ -0,0 +1,64 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+
+#include "Common/JsonValue.h"
+#include "Rpc/CoreRpcServerCommandsDefinitions.h"
+#include "Serialization/SerializationTools.h"
+
+// Parses a getblockslist JSON-RPC response carrying block_count blocks, as a wallet or explorer receives it,
+// and loads it into the response structure.
+template<size_t block_count>
+class test_json_parse
+{
+public:
+  static const size_t loop_count = 10000;
+
+  bool init()
+  {
+    CryptoNote::COMMAND_RPC_GET_BLOCKS_LIST::response result;
+    for (size_t i = 0; i < block_count; ++i)
+    {
+      CryptoNote::block_short_response block;
+      block.timestamp = 1500000000 + i * 240;
+      block.height = static_cast<uint32_t>(500000 + i);
+      block.hash = std::string(64, 'a' + i % 6);
+      block.transactions_count = 1 + i % 10;
+      block.cumulative_size = 400 + i * 13;
+      block.difficulty = 100000000 + i;
+      result.blocks.push_back(block);
+    }
+
+    result.status = CORE_RPC_STATUS_OK;
+    m_body = "{\"jsonrpc\":\"2.0\",\"id\":0,\"result\":" + CryptoNote::storeToJson(result) + "}";
+    return true;
+  }
+
+  bool test()
+  {
+    Common::JsonValue body = Common::JsonValue::fromString(m_body);
+    CryptoNote::COMMAND_RPC_GET_BLOCKS_LIST::response result;
+    CryptoNote::loadFromJsonValue(result, body("result"));
+    return result.blocks.size() == block_count;
+  }
+
+private:
+  std::string m_body;
+};
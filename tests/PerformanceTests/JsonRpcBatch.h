@@ -0,0 +1,189 @@
+// Copyright (c) 2012-2016, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Common/StreamTools.h"
+#include "Rpc/CoreRpcServerCommandsDefinitions.h"
+#include "Rpc/JsonRpc.h"
+#include "System/TcpStream.h"
+
+#include "LoopbackTransfer.h"
+
+// JSON-RPC batching: 1000 getblockheaderbyheight calls per test call, sent batch_size calls per HTTP request.
+// The server side parses and answers calls with the same primitives RpcServer uses for batches.
+// Messages are sent with a single write, TcpStreambuf flushes in 1 KiB pieces and Nagle would stall them.
+template<size_t batch_size>
+class test_json_rpc_batch : public test_loopback_base<false>
+{
+public:
+  static const size_t loop_count = 100;
+  static const size_t calls_per_call = 1000;
+
+  bool init()
+  {
+    if (!this->init_loopback())
+    {
+      return false;
+    }
+
+    std::string call = "{\"jsonrpc\":\"2.0\",\"id\":0,\"method\":\"getblockheaderbyheight\",\"params\":{\"height\":1000}}";
+    if (batch_size == 1)
+    {
+      m_body = call;
+    }
+    else
+    {
+      m_body = "[";
+      for (size_t i = 0; i < batch_size; ++i)
+      {
+        m_body += (i == 0 ? "" : ",") + call;
+      }
+
+      m_body += "]";
+    }
+
+    CryptoNote::HttpRequest request;
+    request.setUrl("/json_rpc");
+    request.setHost("127.0.0.1");
+    request.addHeader("Content-Type", "application/json");
+    request.setBody(m_body);
+
+    std::ostringstream requestStream;
+    requestStream << request;
+    m_request = requestStream.str();
+
+    m_client_streambuf.reset(new System::TcpStreambuf(this->m_client));
+    m_client_stream.reset(new std::iostream(m_client_streambuf.get()));
+    return true;
+  }
+
+  bool test()
+  {
+    CryptoNote::HttpParser parser;
+    for (size_t i = 0; i < calls_per_call / batch_size; ++i)
+    {
+      loopback_write_all(this->m_client, reinterpret_cast<const uint8_t*>(m_request.data()), m_request.size());
+
+      CryptoNote::HttpResponse response;
+      parser.receiveResponse(*m_client_stream, response);
+      if (response.getBody().empty())
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  ~test_json_rpc_batch()
+  {
+    m_client_stream.reset();
+    m_client_streambuf.reset();
+  }
+
+private:
+  static void answer(Common::JsonValue&& call, CryptoNote::JsonRpc::JsonRpcResponse& response)
+  {
+    CryptoNote::JsonRpc::JsonRpcRequest request;
+    request.parseRequest(std::move(call));
+    response.setId(request.getId());
+
+    CryptoNote::COMMAND_RPC_GET_BLOCK_HEADER_BY_HEIGHT::request params;
+    request.loadParams(params);
+
+    CryptoNote::COMMAND_RPC_GET_BLOCK_HEADER_BY_HEIGHT::response result = {};
+    result.block_header.height = params.height;
+    result.block_header.hash = std::string(64, 'a');
+    result.block_header.prev_hash = std::string(64, 'b');
+    result.status = CORE_RPC_STATUS_OK;
+    response.setResult(std::move(result));
+  }
+
+  void serve() override
+  {
+    System::TcpStreambuf streambuf(this->m_server);
+    std::iostream stream(&streambuf);
+    CryptoNote::HttpParser parser;
+    for (;;)
+    {
+      CryptoNote::HttpRequest request;
+      parser.receiveRequest(stream, request);
+
+      Common::JsonValue body = Common::JsonValue::fromString(request.getBody());
+      auto responses = std::make_shared<std::vector<CryptoNote::JsonRpc::JsonRpcResponse>>(body.isArray() ? body.size() : 1);
+      if (body.isArray())
+      {
+        for (size_t i = 0; i < body.size(); ++i)
+        {
+          answer(std::move(body[i]), (*responses)[i]);
+        }
+      }
+      else
+      {
+        answer(std::move(body), responses->front());
+      }
+
+      bool batch = body.isArray();
+      CryptoNote::HttpResponse response;
+      response.addHeader("Content-Type", "application/json");
+      response.setBodyWriter([responses, batch](Common::IOutputStream& output)
+      {
+        if (batch)
+        {
+          Common::write(output, std::string("["));
+        }
+
+        for (size_t i = 0; i < responses->size(); ++i)
+        {
+          if (i != 0)
+          {
+            Common::write(output, std::string(","));
+          }
+
+          (*responses)[i].writeBody(output);
+        }
+
+        if (batch)
+        {
+          Common::write(output, std::string("]"));
+        }
+      });
+
+      std::ostringstream responseStream;
+      responseStream << response;
+      std::string data = responseStream.str();
+      loopback_write_all(this->m_server, reinterpret_cast<const uint8_t*>(data.data()), data.size());
+
+      if (stream.peek() == std::iostream::traits_type::eof())
+      {
+        break;
+      }
+    }
+  }
+
+  std::string m_body;
+  std::string m_request;
+  std::unique_ptr<System::TcpStreambuf> m_client_streambuf;
+  std::unique_ptr<std::iostream> m_client_stream;
+};
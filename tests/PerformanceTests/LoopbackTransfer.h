@@ -0,0 +1,244 @@
+// Copyright (c) 2012-2016, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <System/ContextGroup.h>
+#include <System/Dispatcher.h>
+#include <System/InterruptedException.h>
+#include <System/Ipv4Address.h>
+#include <System/TcpConnection.h>
+#include <System/TcpConnector.h>
+#include <System/TcpListener.h>
+#include <System/TcpStream.h>
+
+#include "HTTP/HttpParser.h"
+#include "HTTP/HttpRequest.h"
+#include "HTTP/HttpResponse.h"
+
+// Loopback benchmarks of the System layer. The template argument selects the dispatcher
+// backend, io_uring is used only when the build enables it, otherwise both variants run on epoll.
+template<bool use_io_uring>
+class test_loopback_base
+{
+public:
+  static const uint16_t port = use_io_uring ? 16971 : 16970;
+
+  bool init_loopback()
+  {
+    if (use_io_uring)
+    {
+      unsetenv("KARBO_DISABLE_IO_URING");
+    }
+    else
+    {
+      setenv("KARBO_DISABLE_IO_URING", "1", 1);
+    }
+
+    m_dispatcher.reset(new System::Dispatcher);
+    m_workers.reset(new System::ContextGroup(*m_dispatcher));
+    m_listener = System::TcpListener(*m_dispatcher, System::Ipv4Address("127.0.0.1"), port);
+    m_workers->spawn([this] {
+      try
+      {
+        m_server = m_listener.accept();
+        serve();
+      }
+      catch (System::InterruptedException&)
+      {
+      }
+      catch (std::exception& e)
+      {
+        std::cerr << "Loopback server failed: " << e.what() << std::endl;
+      }
+    });
+
+    m_client = System::TcpConnector(*m_dispatcher).connect(System::Ipv4Address("127.0.0.1"), port);
+    return true;
+  }
+
+  ~test_loopback_base()
+  {
+    if (m_workers)
+    {
+      m_workers->interrupt();
+      m_workers->wait();
+    }
+  }
+
+protected:
+  virtual void serve() = 0;
+
+  std::unique_ptr<System::Dispatcher> m_dispatcher;
+  std::unique_ptr<System::ContextGroup> m_workers;
+  System::TcpListener m_listener;
+  System::TcpConnection m_server;
+  System::TcpConnection m_client;
+};
+
+inline void loopback_read_all(System::TcpConnection& connection, uint8_t* data, size_t size)
+{
+  while (size > 0)
+  {
+    size_t transferred = connection.read(data, size);
+    if (transferred == 0)
+    {
+      throw std::runtime_error("Connection closed");
+    }
+
+    data += transferred;
+    size -= transferred;
+  }
+}
+
+inline void loopback_write_all(System::TcpConnection& connection, const uint8_t* data, size_t size)
+{
+  while (size > 0)
+  {
+    size_t transferred = connection.write(data, size);
+    data += transferred;
+    size -= transferred;
+  }
+}
+
+// P2P message rate: ping-pong of Levin sized frames, one call is 1000 round trips.
+template<bool use_io_uring>
+class test_loopback_message_rate : public test_loopback_base<use_io_uring>
+{
+public:
+  static const size_t loop_count = 100;
+  static const size_t messages_per_call = 1000;
+  static const size_t message_size = 33 + 256;
+
+  bool init()
+  {
+    m_message.assign(message_size, 0x5a);
+    m_reply.resize(message_size);
+    return this->init_loopback();
+  }
+
+  bool test()
+  {
+    for (size_t i = 0; i < messages_per_call; ++i)
+    {
+      loopback_write_all(this->m_client, m_message.data(), m_message.size());
+      loopback_read_all(this->m_client, m_reply.data(), m_reply.size());
+    }
+
+    return m_reply == m_message;
+  }
+
+private:
+  void serve() override
+  {
+    std::vector<uint8_t> buffer(message_size);
+    for (;;)
+    {
+      loopback_read_all(this->m_server, buffer.data(), buffer.size());
+      loopback_write_all(this->m_server, buffer.data(), buffer.size());
+    }
+  }
+
+  std::vector<uint8_t> m_message;
+  std::vector<uint8_t> m_reply;
+};
+
+// RPC request rate: keep-alive JSON-RPC exchanges parsed the same way HttpServer does, one call is 1000 requests.
+template<bool use_io_uring>
+class test_loopback_rpc_rate : public test_loopback_base<use_io_uring>
+{
+public:
+  static const size_t loop_count = 100;
+  static const size_t requests_per_call = 1000;
+
+  bool init()
+  {
+    if (!this->init_loopback())
+    {
+      return false;
+    }
+
+    m_client_streambuf.reset(new System::TcpStreambuf(this->m_client));
+    m_client_stream.reset(new std::iostream(m_client_streambuf.get()));
+    return true;
+  }
+
+  bool test()
+  {
+    CryptoNote::HttpRequest request;
+    request.setUrl("/json_rpc");
+    request.setHost("127.0.0.1");
+    request.addHeader("Content-Type", "application/json");
+    request.setBody("{\"jsonrpc\":\"2.0\",\"id\":\"0\",\"method\":\"getblockcount\",\"params\":{}}");
+
+    CryptoNote::HttpParser parser;
+    for (size_t i = 0; i < requests_per_call; ++i)
+    {
+      *m_client_stream << request;
+      m_client_stream->flush();
+
+      CryptoNote::HttpResponse response;
+      parser.receiveResponse(*m_client_stream, response);
+      if (response.getBody().empty())
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  ~test_loopback_rpc_rate()
+  {
+    m_client_stream.reset();
+    m_client_streambuf.reset();
+  }
+
+private:
+  void serve() override
+  {
+    System::TcpStreambuf streambuf(this->m_server);
+    std::iostream stream(&streambuf);
+    CryptoNote::HttpParser parser;
+    for (;;)
+    {
+      CryptoNote::HttpRequest request;
+      parser.receiveRequest(stream, request);
+
+      CryptoNote::HttpResponse response;
+      response.addHeader("Content-Type", "application/json");
+      response.setBody("{\"jsonrpc\":\"2.0\",\"id\":\"0\",\"result\":{\"count\":1,\"status\":\"OK\"}}");
+      stream << response;
+      stream.flush();
+
+      if (stream.peek() == std::iostream::traits_type::eof())
+      {
+        break;
+      }
+    }
+  }
+
+  std::unique_ptr<System::TcpStreambuf> m_client_streambuf;
+  std::unique_ptr<std::iostream> m_client_stream;
+};
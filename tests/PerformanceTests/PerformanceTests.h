@@ -17,11 +17,31 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdlib>
 #include <iostream>
+#include <new>
 #include <stdint.h>
 
 #include <boost/chrono.hpp>
 
+// Every allocation of the process is counted, tests report how many they make per call
+std::atomic<uint64_t> allocation_count(0);
+
+void* operator new(size_t size)
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void* result = std::malloc(size != 0 ? size : 1);
+  if (result == nullptr)
+    throw std::bad_alloc();
+  return result;
+}
+
+void operator delete(void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
 class performance_timer
 {
 public:
@@ -55,6 +75,9 @@ class test_runner
 public:
   test_runner()
     : m_elapsed(0)
+    , m_allocations(0)
+    , m_bytes_per_call(0)
+    , m_items_per_call(0)
   {
   }
 
@@ -69,18 +92,24 @@ public:
     warm_up();
     std::cout << "Warm up: " << timer.elapsed_ms() << " ms" << std::endl;
 
+    uint64_t allocations = allocation_count.load(std::memory_order_relaxed);
     timer.start();
     for (size_t i = 0; i < T::loop_count; ++i)
     {
       if (!test.test())
         return false;
     }
-    m_elapsed = timer.elapsed_ms();
+    m_elapsed = elapsed_ms(test, 0, timer.elapsed_ms());
+    m_allocations = allocation_count.load(std::memory_order_relaxed) - allocations;
+    m_bytes_per_call = bytes_per_call(test, 0);
+    m_items_per_call = items_per_call(test, 0);
 
     return true;
   }
 
   int elapsed_time() const { return m_elapsed; }
+  size_t bytes_per_call() const { return m_bytes_per_call; }
+  size_t items_per_call() const { return m_items_per_call; }
 
   int time_per_call() const
   {
@@ -88,7 +117,48 @@ public:
     return m_elapsed / T::loop_count;
   }
 
+  double allocations_per_call() const
+  {
+    return static_cast<double>(m_allocations) / T::loop_count;
+  }
+
 private:
+  // Tests that process a known amount of data per call report it with a bytes_per_call() method
+  template <typename U>
+  static auto bytes_per_call(const U& test, int) -> decltype(test.bytes_per_call())
+  {
+    return test.bytes_per_call();
+  }
+
+  static size_t bytes_per_call(const T&, long)
+  {
+    return 0;
+  }
+
+  // Tests that handle a known number of items per call, e.g. transactions, report it with items_per_call()
+  template <typename U>
+  static auto items_per_call(const U& test, int) -> decltype(test.items_per_call())
+  {
+    return test.items_per_call();
+  }
+
+  static size_t items_per_call(const T&, long)
+  {
+    return 0;
+  }
+
+  // Tests that time a part of every call only, e.g. not the time a network takes to settle, report it with elapsed_ms()
+  template <typename U>
+  static auto elapsed_ms(const U& test, int, int elapsed) -> decltype(test.elapsed_ms())
+  {
+    return test.elapsed_ms();
+  }
+
+  static int elapsed_ms(const T&, long, int elapsed)
+  {
+    return elapsed;
+  }
+
   /**
    * Warm up processor core, enabling turbo boost, etc.
    */
@@ -106,6 +176,9 @@ private:
 private:
   volatile uint64_t m_warm_up;  ///<! This field is intended for preclude compiler optimizations
   int m_elapsed;
+  uint64_t m_allocations;
+  size_t m_bytes_per_call;
+  size_t m_items_per_call;
 };
 
 template <typename T>
@@ -117,7 +190,21 @@ void run_test(const char* test_name)
     std::cout << test_name << " - OK:\n";
     std::cout << "  loop count:    " << T::loop_count << '\n';
     std::cout << "  elapsed:       " << runner.elapsed_time() << " ms\n";
-    std::cout << "  time per call: " << runner.time_per_call() << " ms/call\n" << std::endl;
+    std::cout << "  time per call: " << runner.time_per_call() << " ms/call\n";
+    std::cout << "  allocations:   " << runner.allocations_per_call() << " per call\n";
+    if (runner.bytes_per_call() != 0 && runner.elapsed_time() != 0)
+    {
+      double megabytes = static_cast<double>(runner.bytes_per_call()) * T::loop_count / (1024 * 1024);
+      std::cout << "  throughput:    " << megabytes * 1000 / runner.elapsed_time() << " MB/s\n";
+    }
+
+    if (runner.items_per_call() != 0 && runner.elapsed_time() != 0)
+    {
+      double items = static_cast<double>(runner.items_per_call()) * T::loop_count;
+      std::cout << "  rate:          " << items * 1000 / runner.elapsed_time() << " per second\n";
+    }
+
+    std::cout << std::endl;
   }
   else
   {
@@ -47,6 +47,24 @@ void set_process_affinity(int core)
 #endif
 }
 
+// Lets a thread started by a test run on every core again, threads inherit the affinity set for the process
+void reset_thread_affinity()
+{
+#if defined(BOOST_HAS_PTHREADS) && !defined(__APPLE__) && !defined(BOOST_WINDOWS)
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (int core = 0; core < CPU_SETSIZE; ++core)
+  {
+    CPU_SET(core, &cpuset);
+  }
+
+  if (0 != ::pthread_setaffinity_np(::pthread_self(), sizeof(cpuset), &cpuset))
+  {
+    std::cout << "pthread_setaffinity_np - ERROR" << std::endl;
+  }
+#endif
+}
+
 void set_thread_high_priority()
 {
 #if defined(__APPLE__)
@@ -0,0 +1,191 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/TransactionExtra.h"
+#include "CryptoNoteCore/TransactionPool.h"
+#include "Logging/LoggerGroup.h"
+#include "crypto/crypto.h"
+
+#include "../UnitTests/ICoreStub.h"
+
+#include "PerformanceUtils.h"
+
+// Checks inputs the way Blockchain does for pool transactions: the ring is copied under the chain lock
+// and the ring signature is verified after releasing it.
+class ring_signature_validator : public CryptoNote::ITransactionValidator
+{
+public:
+  void add_ring(const Crypto::KeyImage& key_image, const std::vector<Crypto::PublicKey>& ring)
+  {
+    m_rings[key_image] = ring;
+  }
+
+  virtual bool checkTransactionInputs(const CryptoNote::Transaction& tx, CryptoNote::BlockInfo& maxUsedBlock) override
+  {
+    Crypto::Hash prefix_hash = CryptoNote::getObjectHash(*static_cast<const CryptoNote::TransactionPrefix*>(&tx));
+    for (size_t i = 0; i < tx.inputs.size(); ++i)
+    {
+      const CryptoNote::KeyInput& input = boost::get<CryptoNote::KeyInput>(tx.inputs[i]);
+      std::vector<Crypto::PublicKey> ring;
+      {
+        std::lock_guard<std::mutex> lock(m_chain_lock);
+        auto it = m_rings.find(input.keyImage);
+        if (it == m_rings.end())
+          return false;
+
+        ring = it->second;
+      }
+
+      std::vector<const Crypto::PublicKey*> ring_pointers;
+      for (const auto& key : ring)
+        ring_pointers.push_back(&key);
+
+      if (!Crypto::check_ring_signature(prefix_hash, input.keyImage, ring_pointers, tx.signatures[i].data()))
+        return false;
+    }
+
+    return true;
+  }
+
+  virtual bool checkTransactionInputs(const CryptoNote::Transaction& tx, CryptoNote::BlockInfo& maxUsedBlock, CryptoNote::BlockInfo& lastFailed) override
+  {
+    return checkTransactionInputs(tx, maxUsedBlock);
+  }
+
+  virtual bool haveSpentKeyImages(const CryptoNote::Transaction& tx) override { return false; }
+  virtual bool checkTransactionSize(size_t blobSize) override { return true; }
+
+private:
+  std::mutex m_chain_lock;
+  std::unordered_map<Crypto::KeyImage, std::vector<Crypto::PublicKey>> m_rings;
+};
+
+// Transaction flood: thread_count threads admit the same set of transactions into an empty pool, every one of
+// them spends its own output with a ring of ring_size, so all of them have to be accepted.
+template<size_t thread_count>
+class test_tx_pool_flood
+{
+public:
+  static const size_t loop_count = 10;
+  static const size_t ring_size = 4;
+  static const size_t transactions_per_call = 512;
+
+  test_tx_pool_flood() : m_currency(CryptoNote::CurrencyBuilder(m_logger).currency())
+  {
+  }
+
+  bool init()
+  {
+    using namespace CryptoNote;
+
+    std::vector<Crypto::PublicKey> decoys;
+    for (size_t i = 0; i + 1 < ring_size; ++i)
+    {
+      KeyPair decoy = generateKeyPair();
+      decoys.push_back(decoy.publicKey);
+    }
+
+    AccountBase receiver;
+    receiver.generate();
+    for (size_t i = 0; i < transactions_per_call; ++i)
+    {
+      AccountBase sender;
+      sender.generate();
+
+      Transaction miner_tx;
+      if (!m_currency.constructMinerTx(BLOCK_MAJOR_VERSION_1, 0, 0, 0, 2, 0, sender.getAccountKeys().address, miner_tx))
+        return false;
+
+      TransactionSourceEntry source;
+      source.amount = miner_tx.outputs[0].amount;
+      source.realTransactionPublicKey = getTransactionPublicKeyFromExtra(miner_tx.extra);
+      source.realOutputIndexInTransaction = 0;
+      source.realOutput = ring_size / 2;
+
+      std::vector<Crypto::PublicKey> ring(decoys);
+      ring.insert(ring.begin() + source.realOutput, boost::get<KeyOutput>(miner_tx.outputs[0].target).key);
+      for (uint32_t j = 0; j < ring_size; ++j)
+        source.outputs.push_back(std::make_pair(j, ring[j]));
+
+      std::vector<TransactionDestinationEntry> destinations;
+      destinations.push_back(TransactionDestinationEntry(source.amount - m_currency.minimumFee(), receiver.getAccountKeys().address));
+
+      Transaction tx;
+      Crypto::SecretKey tx_key;
+      if (!constructTransaction(sender.getAccountKeys(), std::vector<TransactionSourceEntry>(1, source), destinations, std::vector<uint8_t>(), tx, 0, tx_key, m_logger))
+        return false;
+
+      m_validator.add_ring(boost::get<KeyInput>(tx.inputs[0]).keyImage, ring);
+      m_transactions.push_back(tx);
+      m_hashes.push_back(getObjectHash(tx));
+      m_sizes.push_back(getObjectBinarySize(tx));
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    CryptoNote::RealTimeProvider time_provider;
+    CryptoNote::tx_memory_pool pool(m_currency, m_validator, m_core, time_provider, m_logger, false);
+
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> accepted(0);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+      threads.emplace_back([&] {
+        // the benchmark process is pinned to a single core
+        reset_thread_affinity();
+        for (size_t j = next++; j < m_transactions.size(); j = next++)
+        {
+          CryptoNote::tx_verification_context tvc = boost::value_initialized<CryptoNote::tx_verification_context>();
+          if (pool.add_tx(m_transactions[j], m_hashes[j], m_sizes[j], tvc, false) && tvc.m_added_to_pool)
+            ++accepted;
+        }
+      });
+    }
+
+    for (auto& thread : threads)
+      thread.join();
+
+    return accepted == transactions_per_call && pool.get_transactions_count() == transactions_per_call;
+  }
+
+  size_t items_per_call() const { return transactions_per_call; }
+
+private:
+  Logging::LoggerGroup m_logger;
+  CryptoNote::Currency m_currency;
+  ICoreStub m_core;
+  ring_signature_validator m_validator;
+  std::vector<CryptoNote::Transaction> m_transactions;
+  std::vector<Crypto::Hash> m_hashes;
+  std::vector<size_t> m_sizes;
+};
@@ -0,0 +1,326 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "Common/Metrics.h"
+#include "Common/StringTools.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/VerificationContext.h"
+#include "CryptoNoteProtocol/CryptoNoteProtocolHandler.h"
+#include "Logging/LoggerGroup.h"
+#include "P2p/NetNode.h"
+#include "P2p/NetNodeConfig.h"
+#include "System/Dispatcher.h"
+#include "crypto/crypto.h"
+
+#include "../UnitTests/ICoreStub.h"
+
+// Keeps every new transaction and asks to relay it, the relay benchmark measures the network and not the
+// transaction checks. Used by the node thread and by the benchmark thread.
+class relay_core_stub : public ICoreStub
+{
+public:
+  explicit relay_core_stub(const CryptoNote::Block& genesis) : ICoreStub(genesis), m_count(0)
+  {
+  }
+
+  virtual bool handle_incoming_tx(const CryptoNote::BinaryArray& tx_blob, CryptoNote::tx_verification_context& tvc, bool keeped_by_block) override
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_transactions.emplace(CryptoNote::getBinaryArrayHash(tx_blob), tx_blob).second)
+    {
+      tvc.m_added_to_pool = true;
+      tvc.m_should_be_relayed = true;
+      ++m_count;
+    }
+
+    return true;
+  }
+
+  virtual bool haveTransaction(const Crypto::Hash& id) override
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_transactions.count(id) != 0;
+  }
+
+  virtual bool getPoolTransaction(const Crypto::Hash& tx_hash, CryptoNote::Transaction& transaction) override
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_transactions.find(tx_hash);
+    return it != m_transactions.end() && CryptoNote::fromBinaryArray(transaction, it->second);
+  }
+
+  size_t transaction_count() const { return m_count; }
+
+private:
+  std::mutex m_mutex;
+  std::unordered_map<Crypto::Hash, CryptoNote::BinaryArray> m_transactions;
+  std::atomic<size_t> m_count;
+};
+
+// A NodeServer on its own dispatcher thread, listening on 127.0.0.1:port and connecting only to peer_ports
+class relay_node
+{
+public:
+  relay_node(const CryptoNote::Currency& currency, uint16_t port, const std::vector<uint16_t>& peer_ports) :
+    m_currency(currency), m_core(currency.genesisBlock()), m_port(port), m_peer_ports(peer_ports),
+    m_protocol(nullptr), m_server(nullptr)
+  {
+  }
+
+  ~relay_node()
+  {
+    if (m_thread.joinable())
+    {
+      m_server->sendStopSignal();
+      m_thread.join();
+    }
+
+    boost::system::error_code ignored_error;
+    boost::filesystem::remove_all(m_folder, ignored_error);
+  }
+
+  bool start()
+  {
+    m_folder = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("tx_relay_%%%%%%%%")).string();
+    std::promise<bool> started;
+    std::future<bool> result = started.get_future();
+    m_thread = std::thread([this, &started] { run(started); });
+    if (result.get())
+      return true;
+
+    m_thread.join();
+    return false;
+  }
+
+  // Adds the transactions to the node and relays them as a wallet of the node would
+  void relay(const std::vector<CryptoNote::BinaryArray>& transactions)
+  {
+    CryptoNote::NOTIFY_NEW_TRANSACTIONS::request notification;
+    notification.stem = false;
+    for (const auto& transaction : transactions)
+    {
+      CryptoNote::tx_verification_context tvc = boost::value_initialized<CryptoNote::tx_verification_context>();
+      m_core.handle_incoming_tx(transaction, tvc, false);
+      notification.txs.push_back(Common::asString(transaction));
+    }
+
+    static_cast<CryptoNote::i_cryptonote_protocol*>(m_protocol)->relay_transactions(notification);
+  }
+
+  size_t peer_count() const { return m_protocol->getPeerCount(); }
+  size_t transaction_count() const { return m_core.transaction_count(); }
+
+private:
+  void run(std::promise<bool>& started)
+  {
+    System::Dispatcher dispatcher;
+    CryptoNote::CryptoNoteProtocolHandler protocol(m_currency, dispatcher, m_core, nullptr, m_logger);
+    CryptoNote::NodeServer server(dispatcher, protocol, m_logger);
+    protocol.set_p2p_endpoint(&server);
+
+    std::vector<CryptoNote::NetworkAddress> exclusive_nodes;
+    for (uint16_t peer_port : m_peer_ports)
+    {
+      CryptoNote::NetworkAddress address;
+      Common::parseIpAddressAndPort(address.ip, address.port, "127.0.0.1:" + std::to_string(peer_port));
+      exclusive_nodes.push_back(address);
+    }
+
+    CryptoNote::NetNodeConfig config;
+    config.setTestnet(true);
+    config.setBindIp("127.0.0.1");
+    config.setBindPort(m_port);
+    config.setExternalPort(0);
+    config.setAllowLocalIp(true);
+    config.setHideMyPort(false);
+    config.setConfigFolder(m_folder);
+    config.setExclusiveNodes(exclusive_nodes);
+
+    if (!server.init(config))
+    {
+      started.set_value(false);
+      return;
+    }
+
+    m_protocol = &protocol;
+    m_server = &server;
+    started.set_value(true);
+
+    server.run();
+    server.deinit();
+    protocol.set_p2p_endpoint(nullptr);
+  }
+
+  Logging::LoggerGroup m_logger;
+  const CryptoNote::Currency& m_currency;
+  relay_core_stub m_core;
+  uint16_t m_port;
+  std::vector<uint16_t> m_peer_ports;
+  std::string m_folder;
+  std::thread m_thread;
+  CryptoNote::CryptoNoteProtocolHandler* m_protocol;
+  CryptoNote::NodeServer* m_server;
+};
+
+// Transactions sent by a wallet of one node of a full mesh of node_count nodes on loopback, a call ends when every
+// node has all of them. The time per call is the propagation delay of a batch, the throughput counts the bytes of
+// all the transaction relay messages sent by all the nodes.
+template<size_t node_count>
+class test_tx_relay
+{
+public:
+  static const size_t loop_count = 5;
+  static const size_t transactions_per_call = 100;
+  static const uint16_t base_port = 39000 + node_count * 10;
+
+  test_tx_relay() : m_currency(CryptoNote::CurrencyBuilder(m_logger).testnet(true).currency()), m_relayed(0), m_relay_bytes(0)
+  {
+  }
+
+  bool init()
+  {
+    std::vector<uint16_t> peer_ports;
+    for (size_t i = 0; i < node_count; ++i)
+    {
+      m_nodes.emplace_back(new relay_node(m_currency, static_cast<uint16_t>(base_port + i), peer_ports));
+      if (!m_nodes.back()->start())
+        return false;
+
+      peer_ports.push_back(static_cast<uint16_t>(base_port + i));
+    }
+
+    for (size_t i = 0; i < loop_count * transactions_per_call + 1; ++i)
+    {
+      m_transactions.push_back(make_transaction());
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    for (auto& node : m_nodes)
+    {
+      while (node->peer_count() < node_count - 1)
+      {
+        if (std::chrono::steady_clock::now() > deadline)
+          return false;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    }
+
+    // the handshakes end before the connections can relay, a first transaction shows that every one of them can
+    return relay(1);
+  }
+
+  bool test()
+  {
+    uint64_t bytes = relay_bytes();
+    if (!relay(transactions_per_call))
+      return false;
+
+    m_relay_bytes += relay_bytes() - bytes;
+    return true;
+  }
+
+  size_t bytes_per_call() const { return static_cast<size_t>(m_relay_bytes / loop_count); }
+  size_t items_per_call() const { return transactions_per_call; }
+
+private:
+  bool relay(size_t count)
+  {
+    std::vector<CryptoNote::BinaryArray> batch(m_transactions.begin() + m_relayed, m_transactions.begin() + m_relayed + count);
+    m_relayed += count;
+    m_nodes.front()->relay(batch);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+    for (auto& node : m_nodes)
+    {
+      while (node->transaction_count() < m_relayed)
+      {
+        if (std::chrono::steady_clock::now() > deadline)
+          return false;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+
+    return true;
+  }
+
+  // Transactions with two inputs of ring size four and two outputs, the size of an ordinary transfer
+  CryptoNote::BinaryArray make_transaction()
+  {
+    using namespace CryptoNote;
+
+    Transaction tx;
+    tx.version = CURRENT_TRANSACTION_VERSION;
+    tx.unlockTime = 0;
+    for (size_t i = 0; i < 2; ++i)
+    {
+      KeyInput input;
+      input.amount = m_currency.coin();
+      input.outputIndexes.assign({ 1, 2, 3, 4 });
+      input.keyImage = reinterpret_cast<const Crypto::KeyImage&>(generateKeyPair().publicKey);
+      tx.inputs.push_back(input);
+
+      KeyOutput target;
+      target.key = generateKeyPair().publicKey;
+      TransactionOutput output;
+      output.amount = input.amount - m_currency.minimumFee();
+      output.target = target;
+      tx.outputs.push_back(output);
+    }
+
+    tx.signatures.resize(2, std::vector<Crypto::Signature>(4));
+    return toBinaryArray(tx);
+  }
+
+  static uint64_t relay_bytes()
+  {
+    uint64_t bytes = 0;
+    for (int command : { CryptoNote::NOTIFY_NEW_TRANSACTIONS::ID, CryptoNote::NOTIFY_TX_INVENTORY::ID,
+                         CryptoNote::NOTIFY_REQUEST_TXS::ID, CryptoNote::NOTIFY_RESPONSE_TXS::ID })
+    {
+      bytes += Common::MetricsRegistry::instance().counter("p2p_bytes_total",
+        "direction=\"out\",command=\"" + std::to_string(command) + "\"").get();
+    }
+
+    return bytes;
+  }
+
+  Logging::LoggerGroup m_logger;
+  CryptoNote::Currency m_currency;
+  std::vector<std::unique_ptr<relay_node>> m_nodes;
+  std::vector<CryptoNote::BinaryArray> m_transactions;
+  size_t m_relayed;
+  uint64_t m_relay_bytes;
+};
@@ -19,6 +19,9 @@
 #include "PerformanceUtils.h"
 
 // tests
+#include "BinaryCodec.h"
+#include "BlockTemplate.h"
+#include "BlockDecode.h"
 #include "ConstructTransaction.h"
 #include "CheckRingSignature.h"
 #include "CryptoNoteSlowHash.h"
@@ -28,6 +31,12 @@
 #include "GenerateKeyImage.h"
 #include "GenerateKeyImageHelper.h"
 #include "IsOutToAccount.h"
+#include "JsonParse.h"
+#include "JsonRpcBatch.h"
+#include "LoopbackTransfer.h"
+#include "TxPoolFlood.h"
+#include "TxRelay.h"
+#include "BlockRelay.h"
 
 int main(int argc, char** argv)
 {
@@ -72,6 +81,45 @@ int main(int argc, char** argv)
 
   TEST_PERFORMANCE0(test_cn_slow_hash);
 
+  TEST_PERFORMANCE1(test_loopback_message_rate, false);
+  TEST_PERFORMANCE1(test_loopback_message_rate, true);
+  TEST_PERFORMANCE1(test_loopback_rpc_rate, false);
+  TEST_PERFORMANCE1(test_loopback_rpc_rate, true);
+
+  TEST_PERFORMANCE1(test_json_rpc_batch, 1);
+  TEST_PERFORMANCE1(test_json_rpc_batch, 10);
+  TEST_PERFORMANCE1(test_json_rpc_batch, 100);
+  TEST_PERFORMANCE1(test_json_rpc_batch, 1000);
+
+  TEST_PERFORMANCE1(test_json_parse, 1);
+  TEST_PERFORMANCE1(test_json_parse, 10);
+  TEST_PERFORMANCE1(test_json_parse, 100);
+
+  TEST_PERFORMANCE2(test_transaction_codec, codec_operation::encode, codec_serializer::stream);
+  TEST_PERFORMANCE2(test_transaction_codec, codec_operation::encode, codec_serializer::array);
+  TEST_PERFORMANCE2(test_transaction_codec, codec_operation::decode, codec_serializer::stream);
+  TEST_PERFORMANCE2(test_transaction_codec, codec_operation::decode, codec_serializer::array);
+
+  TEST_PERFORMANCE2(test_block_decode, 1, false);
+  TEST_PERFORMANCE2(test_block_decode, 100, false);
+  TEST_PERFORMANCE2(test_block_decode, 1000, false);
+  TEST_PERFORMANCE2(test_block_decode, 100, true);
+  TEST_PERFORMANCE2(test_block_decode, 1000, true);
+
+  TEST_PERFORMANCE1(test_tx_pool_flood, 1);
+  TEST_PERFORMANCE1(test_tx_pool_flood, 2);
+  TEST_PERFORMANCE1(test_tx_pool_flood, 4);
+
+  TEST_PERFORMANCE1(test_fill_block_template, 1000);
+  TEST_PERFORMANCE1(test_fill_block_template, 10000);
+  TEST_PERFORMANCE1(test_get_block_template, 100);
+
+  TEST_PERFORMANCE1(test_tx_relay, 4);
+  TEST_PERFORMANCE1(test_tx_relay, 8);
+
+  TEST_PERFORMANCE2(test_block_relay, 5, false);
+  TEST_PERFORMANCE2(test_block_relay, 5, true);
+
   std::cout << "Tests finished. Elapsed time: " << timer.elapsed_ms() / 1000 << " sec" << std::endl;
 
   return 0;
@@ -0,0 +1,100 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <atomic>
+#include <thread>
+#include <System/ContextGroup.h>
+#include <System/Dispatcher.h>
+#include <System/WorkerPool.h>
+#include <gtest/gtest.h>
+
+using namespace System;
+
+class WorkerPoolTests : public testing::Test {
+public:
+  Dispatcher dispatcher;
+};
+
+TEST_F(WorkerPoolTests, runExecutesProcedureOnAnotherThread) {
+  WorkerPool pool(1, 1);
+  std::thread::id workerId;
+  ASSERT_TRUE(pool.run(dispatcher, [&] { workerId = std::this_thread::get_id(); }));
+  ASSERT_NE(std::this_thread::get_id(), workerId);
+}
+
+TEST_F(WorkerPoolTests, runRethrowsException) {
+  WorkerPool pool(1, 1);
+  ASSERT_THROW(pool.run(dispatcher, [] { throw std::string("Hi there!"); }), std::string);
+}
+
+TEST_F(WorkerPoolTests, runKeepsDispatcherServingOtherContexts) {
+  WorkerPool pool(1, 1);
+  bool otherDone = false;
+  ContextGroup cg(dispatcher);
+  cg.spawn([&] {
+    pool.run(dispatcher, [] { std::this_thread::sleep_for(std::chrono::milliseconds(20)); });
+  });
+
+  cg.spawn([&] {
+    otherDone = true;
+  });
+
+  cg.wait();
+  ASSERT_TRUE(otherDone);
+}
+
+TEST_F(WorkerPoolTests, runRefusesWhenQueueIsFull) {
+  WorkerPool pool(1, 1);
+  std::atomic<bool> release(false);
+  size_t accepted = 0;
+  size_t refused = 0;
+  ContextGroup cg(dispatcher);
+  for (size_t i = 0; i < 4; ++i) {
+    cg.spawn([&] {
+      if (pool.run(dispatcher, [&] { while (!release) std::this_thread::yield(); })) {
+        ++accepted;
+      } else {
+        ++refused;
+      }
+    });
+  }
+
+  // First procedure occupies the worker or the queue, second one may wait in the queue, the rest are refused
+  dispatcher.yield();
+  release = true;
+  cg.wait();
+  ASSERT_EQ(4, accepted + refused);
+  ASSERT_LE(2, refused);
+}
+
+TEST_F(WorkerPoolTests, interruptDoesNotAbandonRunningProcedure) {
+  WorkerPool pool(1, 1);
+  std::atomic<bool> finished(false);
+  ContextGroup cg(dispatcher);
+  cg.spawn([&] {
+    pool.run(dispatcher, [&] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      finished = true;
+    });
+
+    ASSERT_TRUE(finished);
+    ASSERT_TRUE(dispatcher.interrupted());
+  });
+
+  cg.interrupt();
+  cg.wait();
+}
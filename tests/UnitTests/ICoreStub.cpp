@@ -160,6 +160,11 @@ bool ICoreStub::queryBlocksLite(const std::vector<Crypto::Hash>& block_ids, uint
   return true;
 }
 
+bool ICoreStub::getRawBlocks(uint32_t startIndex, uint32_t count, std::vector<CryptoNote::block_complete_entry>& blocks) {
+  //stub
+  return true;
+}
+
 std::vector<Crypto::Hash> ICoreStub::buildSparseChain() {
   std::vector<Crypto::Hash> result;
   result.reserve(blockHashByHeightIndex.size());
@@ -254,6 +259,10 @@ bool ICoreStub::getBlockSize(const Crypto::Hash& hash, size_t& size) {
   return true;
 }
 
+bool ICoreStub::getBlockProofOfWork(const Crypto::Hash& hash, Crypto::Hash& proofOfWork) {
+  return false;
+}
+
 bool ICoreStub::getAlreadyGeneratedCoins(const Crypto::Hash& hash, uint64_t& generatedCoins) {
   return true;
 }
@@ -53,6 +53,7 @@ public:
     uint32_t& start_height, uint32_t& current_height, uint32_t& full_offset, std::vector<CryptoNote::BlockFullInfo>& entries) override;
   virtual bool queryBlocksLite(const std::vector<Crypto::Hash>& block_ids, uint64_t timestamp,
     uint32_t& start_height, uint32_t& current_height, uint32_t& full_offset, std::vector<CryptoNote::BlockShortInfo>& entries) override;
+  virtual bool getRawBlocks(uint32_t startIndex, uint32_t count, std::vector<CryptoNote::block_complete_entry>& blocks) override;
 
   virtual bool have_block(const Crypto::Hash& id) override;
   std::vector<Crypto::Hash> buildSparseChain() override;
@@ -73,6 +74,7 @@ public:
   virtual void getTransactions(const std::vector<Crypto::Hash>& txs_ids, std::list<CryptoNote::Transaction>& txs, std::list<Crypto::Hash>& missed_txs, bool checkTxPool = false) override;
   virtual bool getBackwardBlocksSizes(uint32_t fromHeight, std::vector<size_t>& sizes, size_t count) override;
   virtual bool getBlockSize(const Crypto::Hash& hash, size_t& size) override;
+  virtual bool getBlockProofOfWork(const Crypto::Hash& hash, Crypto::Hash& proofOfWork) override;
   virtual bool getAlreadyGeneratedCoins(const Crypto::Hash& hash, uint64_t& generatedCoins) override;
   virtual bool getBlockReward(uint8_t blockMajorVersion, size_t medianSize, size_t currentBlockSize, uint64_t alreadyGeneratedCoins, uint64_t fee,
     uint64_t& reward, int64_t& emissionChange) override;
@@ -98,6 +100,33 @@ public:
   virtual uint8_t getBlockMajorVersionForHeight(uint32_t height) override;
   virtual uint8_t getCurrentBlockMajorVersion() override;
 
+  virtual bool haveTransaction(const Crypto::Hash& id) override { return transactions.count(id) != 0; }
+  virtual bool handle_incoming_block(const CryptoNote::Block& b, CryptoNote::block_verification_context& bvc, bool control_miner, bool relay_block) override { return false; }
+  virtual bool prevalidateBlock(const CryptoNote::Block& b, size_t cumulativeSize) override { return false; }
+  virtual bool getPoolTransaction(const Crypto::Hash& tx_hash, CryptoNote::Transaction& transaction) override { return false; }
+  virtual bool getTransactionHeight(const Crypto::Hash &txId, uint32_t& blockHeight) override { return false; }
+  virtual bool getTransactionsWithOutputGlobalIndexes(const std::vector<Crypto::Hash>& txs_ids, std::list<Crypto::Hash>& missed_txs,
+    std::vector<std::pair<CryptoNote::Transaction, std::vector<uint32_t>>>& txs) override { return false; }
+  virtual bool getTransaction(const Crypto::Hash& id, CryptoNote::Transaction& tx, bool checkTxPool = false) override { return false; }
+  virtual bool getBlockCumulativeDifficulty(uint32_t height, CryptoNote::difficulty_type& difficulty) override { return false; }
+  virtual bool getBlockTimestamp(uint32_t height, uint64_t& timestamp) override { return false; }
+  virtual CryptoNote::difficulty_type getAvgDifficulty(uint32_t height, size_t window) override { return 0; }
+  virtual CryptoNote::difficulty_type getAvgDifficulty(uint32_t height) override { return 0; }
+  virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) override { return std::vector<Crypto::Hash>(); }
+  virtual uint64_t getNextBlockDifficulty() override { return 0; }
+  virtual uint64_t getTotalGeneratedAmount() override { return 0; }
+  virtual bool check_tx_fee(const CryptoNote::Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, CryptoNote::tx_verification_context& tvc, uint32_t height) override { return true; }
+  virtual size_t getPoolTransactionsCount() override { return transactionPool.size(); }
+  virtual size_t getBlockchainTotalTransactions() override { return transactions.size(); }
+  virtual uint32_t getCurrentBlockchainHeight() override { return topHeight + 1; }
+  virtual size_t getAlternativeBlocksCount() override { return 0; }
+  virtual bool getblockEntry(uint32_t height, uint64_t& block_cumulative_size, CryptoNote::difficulty_type& difficulty, uint64_t& already_generated_coins,
+    uint64_t& reward, uint64_t& transactions_count, uint64_t& timestamp) override { return false; }
+  virtual void rollbackBlockchain(const uint32_t height) override {}
+  virtual bool saveBlockchain() override { return true; }
+  virtual bool getMixin(const CryptoNote::Transaction& transaction, uint64_t& mixin) override { return false; }
+  virtual bool isInCheckpointZone(uint32_t height) const override { return false; }
+
   void set_blockchain_top(uint32_t height, const Crypto::Hash& top_id);
   void set_outputs_gindexs(const std::vector<uint32_t>& indexs, bool result);
   void set_random_outs(const CryptoNote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_response& resp, bool result);
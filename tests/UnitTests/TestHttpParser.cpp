@@ -0,0 +1,152 @@
+// Copyright (c) 2016-2020, The Karbo developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+#include "HTTP/HttpParser.h"
+#include "HTTP/HttpParserErrorCodes.h"
+#include "HTTP/HttpRequestParser.h"
+#include "HTTP/HttpResponse.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+// What a client reads back from a response the server sends
+HttpResponse::HTTP_STATUS roundTripStatus(HttpResponse::HTTP_STATUS status) {
+  HttpResponse response;
+  response.setStatus(status);
+  response.setBody("busy");
+
+  std::stringstream stream;
+  stream << response;
+
+  HttpResponse received;
+  HttpParser().receiveResponse(stream, received);
+  return received.getStatus();
+}
+
+// The error parseHead throws on the given input, success if it doesn't throw
+std::error_code parseHeadError(const std::string& data) {
+  try {
+    HttpRequestParser().parseHead(data.data(), data.size());
+  } catch (std::system_error& e) {
+    return e.code();
+  }
+
+  return std::error_code();
+}
+
+}
+
+TEST(HttpParser, parsesServiceUnavailable) {
+  ASSERT_EQ(HttpResponse::STATUS_503, HttpParser::parseResponseStatusFromString("503 Service Unavailable"));
+}
+
+TEST(HttpParser, receivesBusyReplies) {
+  ASSERT_EQ(HttpResponse::STATUS_503, roundTripStatus(HttpResponse::STATUS_503));
+  ASSERT_EQ(HttpResponse::STATUS_429, roundTripStatus(HttpResponse::STATUS_429));
+}
+
+TEST(HttpParser, rejectsUnknownStatus) {
+  ASSERT_ANY_THROW(HttpParser::parseResponseStatusFromString("418 I'm a teapot"));
+}
+
+TEST(HttpRequestParser, parsesRequest) {
+  std::string data = "POST /json_rpc HTTP/1.1\r\nHost: localhost\r\nContent-Length: 4\r\n\r\nbody";
+  HttpRequestParser parser;
+  size_t headSize = parser.parseHead(data.data(), data.size());
+  ASSERT_EQ(data.size() - 4, headSize);
+  ASSERT_EQ(4, parser.getContentLength());
+
+  HttpRequest request;
+  parser.fillRequest(request, Common::StringView(data.data() + headSize, parser.getContentLength()));
+  ASSERT_EQ("POST", request.getMethod());
+  ASSERT_EQ("/json_rpc", request.getUrl());
+  ASSERT_EQ("HTTP/1.1", request.getVersion());
+  ASSERT_EQ("localhost", request.getHeaders().at("host"));
+  ASSERT_EQ("body", request.getBody());
+}
+
+TEST(HttpRequestParser, waitsForCompleteHead) {
+  std::string data = "GET / HTTP/1.1\r\nHost: localhost\r\n\r";
+  ASSERT_EQ(0, HttpRequestParser().parseHead(data.data(), data.size()));
+  ASSERT_EQ(0, HttpRequestParser().parseHead(data.data(), 0));
+}
+
+TEST(HttpRequestParser, rejectsBareCarriageReturn) {
+  ASSERT_EQ(error::UNEXPECTED_SYMBOL, parseHeadError("GET / HTTP/1.1\rHost: localhost\r\n\r\n").value());
+}
+
+TEST(HttpRequestParser, rejectsBareLineFeed) {
+  ASSERT_EQ(error::UNEXPECTED_SYMBOL, parseHeadError("GET / HTTP/1.1\nHost: localhost\n\n").value());
+  ASSERT_EQ(error::UNEXPECTED_SYMBOL, parseHeadError("GET / HTTP/1.1\r\nHost: localhost\n\r\n").value());
+}
+
+TEST(HttpRequestParser, rejectsEmptyHeaderName) {
+  ASSERT_EQ(error::EMPTY_HEADER, parseHeadError("GET / HTTP/1.1\r\n: value\r\n\r\n").value());
+}
+
+TEST(HttpRequestParser, rejectsMissingVersion) {
+  ASSERT_EQ(error::UNEXPECTED_SYMBOL, parseHeadError("GET /\r\n\r\n").value());
+  ASSERT_EQ(error::UNEXPECTED_SYMBOL, parseHeadError("GET / \r\n\r\n").value());
+  ASSERT_EQ(error::UNEXPECTED_SYMBOL, parseHeadError("GET  HTTP/1.1\r\n\r\n").value());
+}
+
+TEST(HttpRequestParser, rejectsNonNumericContentLength) {
+  ASSERT_EQ(error::UNEXPECTED_SYMBOL, parseHeadError("POST / HTTP/1.1\r\nContent-Length: 12a\r\n\r\n").value());
+  ASSERT_EQ(error::UNEXPECTED_SYMBOL, parseHeadError("POST / HTTP/1.1\r\nContent-Length: -1\r\n\r\n").value());
+  ASSERT_EQ(error::UNEXPECTED_SYMBOL, parseHeadError("POST / HTTP/1.1\r\nContent-Length:\r\n\r\n").value());
+  ASSERT_EQ(error::UNEXPECTED_SYMBOL,
+    parseHeadError("POST / HTTP/1.1\r\nContent-Length: 99999999999999999999999\r\n\r\n").value());
+}
+
+TEST(HttpRequestParser, reportsTruncatedBody) {
+  // the head is complete, the caller waits until the body is received
+  std::string data = "POST / HTTP/1.1\r\nContent-Length: 10\r\n\r\nshort";
+  HttpRequestParser parser;
+  size_t headSize = parser.parseHead(data.data(), data.size());
+  ASSERT_EQ(data.size() - 5, headSize);
+  ASSERT_EQ(10, parser.getContentLength());
+  ASSERT_LT(data.size(), headSize + parser.getContentLength());
+}
+
+TEST(HttpRequestParser, parsesPipelinedRequests) {
+  std::string data =
+    "POST /first HTTP/1.1\r\nContent-Length: 3\r\n\r\none"
+    "\r\n"
+    "GET /second HTTP/1.1\r\nHost: localhost\r\n\r\n"
+    "GET /third HTTP/1.0\r\n";
+
+  HttpRequestParser parser;
+  size_t begin = 0;
+  size_t headSize = parser.parseHead(data.data() + begin, data.size() - begin);
+  ASSERT_NE(0, headSize);
+  ASSERT_EQ("/first", std::string(parser.getUrl().getData(), parser.getUrl().getSize()));
+  ASSERT_EQ(3, parser.getContentLength());
+  begin += headSize + parser.getContentLength();
+
+  headSize = parser.parseHead(data.data() + begin, data.size() - begin);
+  ASSERT_NE(0, headSize);
+  ASSERT_EQ("/second", std::string(parser.getUrl().getData(), parser.getUrl().getSize()));
+  ASSERT_EQ(0, parser.getContentLength());
+  begin += headSize;
+
+  ASSERT_EQ(0, parser.parseHead(data.data() + begin, data.size() - begin));
+}
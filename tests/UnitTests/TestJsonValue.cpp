@@ -16,6 +16,7 @@
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "gtest/gtest.h"
+#include <limits>
 #include <Common/JsonValue.h>
 
 using Common::JsonValue;
@@ -65,3 +66,71 @@ TEST(JsonValue, testBadPatterns) {
   }
 }
 
+
+TEST(JsonValue, keepsMembersInInsertionOrder) {
+  ASSERT_EQ("{\"b\":1,\"a\":[2,1],\"c\":{\"z\":3,\"y\":4}}", JsonValue::fromString("{\"b\": 1, \"a\": [2, 1], \"c\": {\"z\": 3, \"y\": 4}}").toString());
+
+  JsonValue value(JsonValue::OBJECT);
+  value.insert("second", JsonValue(static_cast<JsonValue::Integer>(2)));
+  value.insert("first", JsonValue(static_cast<JsonValue::Integer>(1)));
+  ASSERT_EQ("{\"second\":2,\"first\":1}", value.toString());
+}
+
+TEST(JsonValue, lastRepeatedMemberWins) {
+  JsonValue value = JsonValue::fromString("{\"a\": 1, \"b\": 2, \"a\": 3}");
+  ASSERT_EQ("{\"a\":3,\"b\":2}", value.toString());
+}
+
+TEST(JsonValue, lastRepeatedMemberWinsInLargeObject) {
+  // names past the first 16 members are checked once the object is complete
+  std::string source = "{";
+  for (int i = 0; i < 20; ++i) {
+    source += "\"k" + std::to_string(i) + "\": " + std::to_string(i) + ", ";
+  }
+
+  source += "\"k3\": 100, \"k18\": 200, \"k3\": 300, \"k20\": 20}";
+
+  JsonValue value = JsonValue::fromString(source);
+  const JsonValue::Object& object = value.getObject();
+  ASSERT_EQ(21, object.size());
+  for (size_t i = 0; i < object.size(); ++i) {
+    ASSERT_EQ("k" + std::to_string(i), (object.begin() + i)->first);
+  }
+
+  ASSERT_EQ(300, value("k3").getInteger());
+  ASSERT_EQ(200, value("k18").getInteger());
+  ASSERT_EQ(19, value("k19").getInteger());
+  ASSERT_EQ(20, value("k20").getInteger());
+}
+
+TEST(JsonValue, limitsNesting) {
+  ASSERT_NO_THROW(JsonValue::fromString(std::string(512, '[') + std::string(512, ']')));
+  ASSERT_ANY_THROW(JsonValue::fromString(std::string(513, '[') + std::string(513, ']')));
+
+  std::string objects;
+  for (int i = 0; i < 513; ++i) {
+    objects += "{\"a\":";
+  }
+
+  ASSERT_ANY_THROW(JsonValue::fromString(objects + "1" + std::string(513, '}')));
+  ASSERT_NO_THROW(JsonValue::fromString(objects.substr(5) + "1" + std::string(512, '}')));
+}
+
+TEST(JsonValue, clampsIntegerOverflow) {
+  const JsonValue::Integer max = std::numeric_limits<JsonValue::Integer>::max();
+  const JsonValue::Integer min = std::numeric_limits<JsonValue::Integer>::min();
+
+  ASSERT_EQ(max, JsonValue::fromString("9223372036854775807").getInteger());
+  ASSERT_EQ(max, JsonValue::fromString("9223372036854775808").getInteger());
+  ASSERT_EQ(max, JsonValue::fromString("123456789012345678901234567890").getInteger());
+  ASSERT_EQ(min, JsonValue::fromString("-9223372036854775808").getInteger());
+  ASSERT_EQ(min, JsonValue::fromString("-9223372036854775809").getInteger());
+  ASSERT_EQ(min, JsonValue::fromString("-123456789012345678901234567890").getInteger());
+}
+
+TEST(JsonValue, keepsEscapes) {
+  std::string source = "{\"k\\\"ey\":\"a\\\"b\\\\c\\u0041\\n\"}";
+  JsonValue value = JsonValue::fromString(source);
+  ASSERT_EQ("a\\\"b\\\\c\\u0041\\n", value("k\\\"ey").getString());
+  ASSERT_EQ(source, value.toString());
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2012-2016, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "P2p/RollingHashFilter.h"
+#include "crypto/hash.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+Crypto::Hash makeHash(uint32_t i) {
+  return Crypto::cn_fast_hash(&i, sizeof(i));
+}
+
+}
+
+TEST(RollingHashFilter, emptyFilterContainsNothing) {
+  RollingHashFilter filter(100);
+  ASSERT_FALSE(filter.contains(makeHash(0)));
+}
+
+TEST(RollingHashFilter, remembersLastHalfOfCapacity) {
+  RollingHashFilter filter(1000);
+  for (uint32_t i = 0; i < 10000; ++i) {
+    filter.insert(makeHash(i));
+  }
+
+  for (uint32_t i = 10000 - 500; i < 10000; ++i) {
+    ASSERT_TRUE(filter.contains(makeHash(i)));
+  }
+}
+
+TEST(RollingHashFilter, forgetsOldHashes) {
+  RollingHashFilter filter(1000);
+  for (uint32_t i = 0; i < 10000; ++i) {
+    filter.insert(makeHash(i));
+  }
+
+  size_t remembered = 0;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    remembered += filter.contains(makeHash(i)) ? 1 : 0;
+  }
+
+  ASSERT_LT(remembered, 10);
+}
+
+TEST(RollingHashFilter, fewFalsePositives) {
+  RollingHashFilter filter(1000);
+  for (uint32_t i = 0; i < 1000; ++i) {
+    filter.insert(makeHash(i));
+  }
+
+  size_t falsePositives = 0;
+  for (uint32_t i = 1000; i < 101000; ++i) {
+    falsePositives += filter.contains(makeHash(i)) ? 1 : 0;
+  }
+
+  ASSERT_LT(falsePositives, 500);
+}
+
+TEST(RollingHashFilter, clearForgetsEverything) {
+  RollingHashFilter filter(100);
+  filter.insert(makeHash(1));
+  filter.clear();
+  ASSERT_FALSE(filter.contains(makeHash(1)));
+}
@@ -145,7 +145,7 @@ size_t TestTransactionBuilder::addFakeMultisignatureInput(uint64_t amount, uint3
     accs.push_back(generateAccount());
   }
 
-  msigInputs[idx] = MsigInfo{ Crypto::rand<PublicKey>(), 0, std::move(accs) };
+  msigInputs[idx] = MsigInfo{ generateRandom<PublicKey>(), 0, std::move(accs) };
   return idx;
 }
 
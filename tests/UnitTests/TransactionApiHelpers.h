@@ -20,6 +20,7 @@
 #include "CryptoTypes.h"
 #include "ITransaction.h"
 #include "crypto/crypto.h"
+#include "crypto/random.h"
 
 #include "CryptoNoteCore/Account.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
@@ -32,6 +33,13 @@ namespace {
   using namespace CryptoNote;
   using namespace Crypto;
 
+  template <typename T>
+  T generateRandom() {
+    T value;
+    Random::randomBytes(sizeof(value), reinterpret_cast<uint8_t*>(&value));
+    return value;
+  }
+
   inline AccountKeys accountKeysFromKeypairs(
     const KeyPair& viewKeys, 
     const KeyPair& spendKeys) {
@@ -62,7 +70,7 @@ namespace {
   }
   
   KeyImage generateKeyImage() {
-    return Crypto::rand<KeyImage>();
+    return generateRandom<KeyImage>();
   }
 
   KeyImage generateKeyImage(const AccountKeys& keys, size_t idx, const PublicKey& txPubKey) {
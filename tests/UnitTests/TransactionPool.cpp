@@ -18,6 +18,9 @@
 #include "gtest/gtest.h"
 
 #include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <thread>
 
 #include <boost/filesystem/operations.hpp>
 
@@ -54,6 +57,17 @@ class TransactionValidator : public CryptoNote::ITransactionValidator {
   }
 };
 
+class KeyImageSpendingValidator : public TransactionValidator {
+public:
+  KeyImageSpendingValidator() : keyImagesSpent(false) {}
+
+  virtual bool haveSpentKeyImages(const CryptoNote::Transaction& tx) override {
+    return keyImagesSpent;
+  }
+
+  bool keyImagesSpent;
+};
+
 class FakeTimeProvider : public ITimeProvider {
 public:
   FakeTimeProvider(time_t currentTime = time(nullptr))
@@ -123,7 +137,8 @@ public:
       destinations.push_back(TransactionDestinationEntry(amountPerOut, rv_acc.getAccountKeys().address));
     }
 
-    constructTransaction(m_realSenderKeys, m_sources, destinations, std::vector<uint8_t>(), tx, 0, m_logger);
+    Crypto::SecretKey txKey;
+    constructTransaction(m_realSenderKeys, m_sources, destinations, std::vector<uint8_t>(), tx, 0, txKey, m_logger);
   }
 
   std::vector<AccountBase> m_miners;
@@ -274,6 +289,66 @@ TEST_F(tx_pool, double_spend_tx)
   ASSERT_TRUE(tvc.m_verification_failed);
 }
 
+TEST_F(tx_pool, concurrentDoubleSpendsAreAdmittedOnce)
+{
+  TxTestBase test(1);
+  std::vector<Transaction> txs(8);
+  for (auto& tx : txs) {
+    test.txGenerator.rv_acc.generate();
+    test.construct(test.m_currency.minimumFee(), 1, tx);
+  }
+
+  std::atomic<size_t> added(0);
+  std::vector<std::thread> threads;
+  for (const auto& tx : txs) {
+    threads.emplace_back([&test, &tx, &added] {
+      tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+      if (test.pool.add_tx(tx, tvc, false) && tvc.m_added_to_pool) {
+        ++added;
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(1, added);
+  ASSERT_EQ(1, test.pool.get_transactions_count());
+}
+
+TEST_F(tx_pool, concurrentCopiesOfTransactionAreAdmittedOnce)
+{
+  TxTestBase test(1);
+  Transaction tx;
+  test.construct(test.m_currency.minimumFee(), 1, tx);
+
+  std::atomic<size_t> added(0);
+  std::atomic<size_t> failed(0);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < 8; ++i) {
+    threads.emplace_back([&test, &tx, &added, &failed] {
+      tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+      test.pool.add_tx(tx, tvc, false);
+      if (tvc.m_added_to_pool) {
+        ++added;
+      }
+
+      if (tvc.m_verification_failed) {
+        ++failed;
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(1, added);
+  ASSERT_EQ(0, failed);
+  ASSERT_EQ(1, test.pool.get_transactions_count());
+}
+
 
 TEST_F(tx_pool, fillblock_same_fee)
 {
@@ -387,6 +462,123 @@ TEST_F(tx_pool, fillblock_same_size)
 
 }
 
+TEST_F(tx_pool, transactionSpentByNewBlockIsLeftOutOfBlockTemplateUntilBlockIsPopped)
+{
+  TestPool<KeyImageSpendingValidator, RealTimeProvider> pool(currency, logger);
+
+  Transaction tx;
+  GenerateTransaction(currency, tx, currency.minimumFee(), 1);
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(tx, tvc, false));
+
+  Block bl;
+  InitBlock(bl);
+  size_t totalSize = 0;
+  uint64_t txFee = 0;
+
+  ASSERT_TRUE(pool.fill_block_template(bl, 5000, textMaxCumulativeSize, 0, totalSize, txFee));
+  ASSERT_EQ(1, bl.transactionHashes.size());
+
+  pool.validator.keyImagesSpent = true;
+  pool.on_blockchain_inc(1, NULL_HASH);
+
+  ASSERT_TRUE(pool.fill_block_template(bl, 5000, textMaxCumulativeSize, 0, totalSize, txFee));
+  ASSERT_TRUE(bl.transactionHashes.empty());
+
+  pool.validator.keyImagesSpent = false;
+  pool.on_blockchain_dec(0, NULL_HASH);
+
+  ASSERT_TRUE(pool.fill_block_template(bl, 5000, textMaxCumulativeSize, 0, totalSize, txFee));
+  ASSERT_EQ(1, bl.transactionHashes.size());
+  ASSERT_EQ(getObjectHash(tx), bl.transactionHashes.front());
+}
+
+TEST_F(tx_pool, changesSinceKnownSequenceAreOnlyTheDelta)
+{
+  TestPool<TransactionValidator, RealTimeProvider> pool(currency, logger);
+
+  Transaction tx1;
+  GenerateTransaction(currency, tx1, currency.minimumFee(), 1);
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(tx1, tvc, false));
+
+  std::vector<Crypto::Hash> added;
+  std::vector<Crypto::Hash> deleted;
+  uint64_t sequence;
+  pool.get_difference(std::vector<Crypto::Hash>(), added, deleted, sequence);
+  ASSERT_EQ(1, added.size());
+
+  Transaction tx2;
+  GenerateTransaction(currency, tx2, currency.minimumFee(), 1);
+  ASSERT_TRUE(pool.add_tx(tx2, tvc, false));
+
+  Transaction takenTx;
+  size_t blobSize;
+  uint64_t fee;
+  ASSERT_TRUE(pool.take_tx(getObjectHash(tx1), takenTx, blobSize, fee));
+
+  added.clear();
+  uint64_t nextSequence;
+  ASSERT_TRUE(pool.get_changes_since(sequence, added, deleted, nextSequence));
+  ASSERT_EQ(std::vector<Crypto::Hash>{getObjectHash(tx2)}, added);
+  ASSERT_EQ(std::vector<Crypto::Hash>{getObjectHash(tx1)}, deleted);
+
+  added.clear();
+  deleted.clear();
+  ASSERT_TRUE(pool.get_changes_since(nextSequence, added, deleted, sequence));
+  ASSERT_EQ(nextSequence, sequence);
+  ASSERT_TRUE(added.empty());
+  ASSERT_TRUE(deleted.empty());
+
+  // a number the pool never gave out, e.g. from before a restart
+  ASSERT_FALSE(pool.get_changes_since(sequence + 1, added, deleted, sequence));
+  ASSERT_EQ(std::vector<Crypto::Hash>{getObjectHash(tx2)}, added);
+  ASSERT_TRUE(deleted.empty());
+}
+
+TEST_F(tx_pool, fullPoolEvictsTransactionsPayingLeastPerByte)
+{
+  TestPool<TransactionValidator, RealTimeProvider> pool(currency, logger);
+  const uint64_t fee = currency.minimumFee();
+
+  std::vector<Transaction> txs(5);
+  size_t maxTxSize = 0;
+  for (size_t i = 0; i < txs.size(); ++i) {
+    GenerateTransaction(currency, txs[i], fee * (i + 1), 1);
+    maxTxSize = std::max(maxTxSize, getObjectBinarySize(txs[i]));
+  }
+
+  pool.setMaxSize(2 * maxTxSize);
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(txs[1], tvc, false));
+  ASSERT_TRUE(pool.add_tx(txs[2], tvc, false));
+  ASSERT_NE(0, pool.getMinimalFeePerByte());
+
+  tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_FALSE(pool.add_tx(txs[0], tvc, false));
+  ASSERT_TRUE(tvc.m_tx_fee_too_small);
+  ASSERT_FALSE(pool.have_tx(getObjectHash(txs[0])));
+
+  tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(txs[3], tvc, false));
+  ASSERT_FALSE(pool.have_tx(getObjectHash(txs[1])));
+  ASSERT_TRUE(pool.have_tx(getObjectHash(txs[2])));
+  ASSERT_TRUE(pool.have_tx(getObjectHash(txs[3])));
+
+  // transactions of popped blocks get in anyway and stay
+  tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(txs[0], tvc, true));
+  ASSERT_TRUE(pool.have_tx(getObjectHash(txs[0])));
+  ASSERT_LE(pool.getSize(), 2 * maxTxSize);
+
+  tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(txs[4], tvc, false));
+  ASSERT_TRUE(pool.have_tx(getObjectHash(txs[0])));
+  ASSERT_TRUE(pool.have_tx(getObjectHash(txs[4])));
+  ASSERT_EQ(2, pool.get_transactions_count());
+}
 
 TEST_F(tx_pool, cleanup_stale_tx)
 {
@@ -662,6 +854,65 @@ TEST_F(tx_pool, RecentlyDeletedTxInfoIsSerializedAndDeserialized) {
   ASSERT_EQ(1, pool->get_transactions_count());
 }
 
+TEST_F(tx_pool, TransactionsAreReplayedFromJournalWithoutDeinit) {
+  TransactionValidator validator;
+  FakeTimeProvider timeProvider;
+  std::unique_ptr<tx_memory_pool> pool(new tx_memory_pool(currency, validator, coreStub, timeProvider, logger, false));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+
+  Transaction tx1;
+  Transaction tx2;
+  GenerateTransaction(currency, tx1, currency.minimumFee(), 1);
+  GenerateTransaction(currency, tx2, currency.minimumFee(), 1);
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool->add_tx(tx1, tvc, false));
+  ASSERT_TRUE(pool->add_tx(tx2, tvc, false));
+
+  Transaction takenTx;
+  size_t blobSize;
+  uint64_t fee;
+  ASSERT_TRUE(pool->take_tx(getObjectHash(tx2), takenTx, blobSize, fee));
+  pool.reset();
+
+  // a record torn by the crash is dropped
+  boost::filesystem::path journal = m_configDir / boost::filesystem::path(currency.txPoolFileName()).replace_extension(".journal");
+  std::ofstream(journal.string(), std::ios::binary | std::ios::app) << "\x01torn";
+
+  pool.reset(new tx_memory_pool(currency, validator, coreStub, timeProvider, logger, false));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+  ASSERT_EQ(1, pool->get_transactions_count());
+  ASSERT_TRUE(pool->have_tx(getObjectHash(tx1)));
+  pool.reset();
+
+  // confirmed in the chain while the node was stopped
+  KeyImageSpendingValidator spendingValidator;
+  spendingValidator.keyImagesSpent = true;
+  pool.reset(new tx_memory_pool(currency, spendingValidator, coreStub, timeProvider, logger, false));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+  ASSERT_EQ(0, pool->get_transactions_count());
+}
+
+TEST_F(tx_pool, TransactionsReturnedBeforeInitAreJournaled) {
+  TransactionValidator validator;
+  FakeTimeProvider timeProvider;
+  std::unique_ptr<tx_memory_pool> pool(new tx_memory_pool(currency, validator, coreStub, timeProvider, logger, false));
+
+  // as the chain returns the transactions of the blocks it pops while it loads
+  Transaction tx;
+  GenerateTransaction(currency, tx, currency.minimumFee(), 1);
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool->add_tx(tx, tvc, true));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+  ASSERT_EQ(1, pool->get_transactions_count());
+  pool.reset();
+
+  pool.reset(new tx_memory_pool(currency, validator, coreStub, timeProvider, logger, false));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+  ASSERT_EQ(1, pool->get_transactions_count());
+  ASSERT_TRUE(pool->have_tx(getObjectHash(tx)));
+}
+
 TEST_F(tx_pool, TxPoolAcceptsValidFusionTransaction) {
   TransactionValidator validator;
   FakeTimeProvider timeProvider;